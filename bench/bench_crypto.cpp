@@ -0,0 +1,422 @@
+/*
+ * VOS Benchmark — Crypto
+ *
+ * Default: sweeps the Crypto API (encrypt, decrypt, hmac, hmac_verify,
+ * random_bytes; encrypt_gcm / decrypt_gcm with AES-256-GCM selected) over message sizes 16 B .. 16 MB and reports throughput and
+ * cycles/byte. Cycles come from the TSC on x86 (reference cycles, not
+ * core cycles) and are reported as 0 elsewhere.
+ *
+ * --kernels: per-kernel ChaCha20 / AEAD / AES-GCM / SHA-256 tables, session vs raw
+ * key, batch vs single records, CSPRNG.
+ *
+ *   vos_bench_crypto [--seconds S] [--max-size BYTES] [--quick] [--repeat N]
+ *                    [--json FILE|-] [--baseline FILE [--tolerance F]]
+ *   vos_bench_crypto --kernels [--size BYTES] [--seconds S]
+ *
+ * --baseline compares MB/s against a JSON file written earlier with
+ * --json and exits 1 if any (op, size) present in both is more than
+ * `tolerance` (default 0.30) slower. Baselines are machine-specific and
+ * only meaningful from an optimized build. --repeat N keeps the best of N
+ * runs per point, which steadies the comparison on a busy machine.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <memory>
+#include "core/crypto.h"
+#include "core/chacha20.h"
+#include "core/aead.h"
+#include "core/sha256.h"
+#include "core/crypto_session.h"
+#include "core/cpu_features.h"
+#include "vos/log.h"
+
+#if defined(VOS_ARCH_X86)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+using namespace vos;
+
+static const chacha20::Impl ALL_IMPLS[] = {
+    chacha20::Impl::SCALAR, chacha20::Impl::SSE2,
+    chacha20::Impl::AVX2,   chacha20::Impl::NEON,
+};
+
+static uint64_t cycles_now() {
+#if defined(VOS_ARCH_X86)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+struct Sample {
+    double bytes_per_sec   = 0;
+    double cycles_per_byte = 0;
+};
+
+// Run fn repeatedly for ~`seconds` (at least once after a warm-up call),
+// doubling the batch between clock reads so huge messages are not
+// over-run and tiny ones are not dominated by the clock.
+template<typename Fn>
+static Sample measure(size_t bytes_per_call, double seconds, Fn&& fn) {
+    fn(); // warm-up
+    size_t calls = 0, batch = 1;
+    auto     t0 = Clock::now();
+    uint64_t c0 = cycles_now();
+    double elapsed = 0;
+    do {
+        for (size_t i = 0; i < batch; i++) fn();
+        calls += batch;
+        if (batch < 4096) batch *= 2;
+        elapsed = std::chrono::duration<double>(Clock::now() - t0).count();
+    } while (elapsed < seconds);
+    uint64_t cycles = cycles_now() - c0;
+
+    Sample r;
+    double bytes      = (double)calls * (double)bytes_per_call;
+    r.bytes_per_sec   = bytes / elapsed;
+    r.cycles_per_byte = bytes > 0 ? (double)cycles / bytes : 0;
+    return r;
+}
+
+// ─── Kernel Tables (--kernels) ───────────────────────────────
+
+static void kernel_report(size_t size, double seconds) {
+    Crypto crypto;
+    crypto.init();
+    ByteBuffer key   = crypto.generate_key();
+    ByteBuffer nonce = crypto.random_bytes(aead::NONCE_SIZE);
+    ByteBuffer buf   = crypto.random_bytes(size);
+    uint8_t tag[aead::TAG_SIZE];
+
+    printf("ChaCha20-Poly1305 throughput, %zu-byte messages (best kernel: %s)\n",
+           size, chacha20::impl_name(chacha20::best_impl()));
+    printf("%-8s %14s %14s\n", "kernel", "chacha20 GB/s", "aead GB/s");
+
+    for (auto impl : ALL_IMPLS) {
+        if (!chacha20::impl_available(impl)) {
+            printf("%-8s %14s %14s\n", chacha20::impl_name(impl), "n/a", "n/a");
+            continue;
+        }
+        double xor_bps = measure(size, seconds, [&] {
+            chacha20::xor_stream(key.data(), nonce.data(), 1, buf.data(), buf.data(), size, impl);
+        }).bytes_per_sec;
+        double seal_bps = measure(size, seconds, [&] {
+            aead::chacha20_poly1305_seal(key.data(), nonce.data(), nullptr, 0,
+                                         buf.data(), buf.data(), size, tag, impl);
+        }).bytes_per_sec;
+        printf("%-8s %14.2f %14.2f\n", chacha20::impl_name(impl), xor_bps / 1e9, seal_bps / 1e9);
+    }
+
+    printf("\nAES-256-GCM throughput, %zu-byte messages (best kernel: %s)\n",
+           size, aes_gcm::impl_name(aes_gcm::best_impl()));
+    printf("%-8s %14s %14s\n", "kernel", "seal GB/s", "open GB/s");
+    {
+        aes_gcm::KeySchedule ks;
+        aes_gcm::expand_key(ks, key.data());
+        for (auto impl : { aes_gcm::Impl::SOFTWARE, aes_gcm::Impl::AESNI }) {
+            if (!aes_gcm::impl_available(impl)) {
+                printf("%-8s %14s %14s\n", aes_gcm::impl_name(impl), "n/a", "n/a");
+                continue;
+            }
+            double seal_bps = measure(size, seconds, [&] {
+                aes_gcm::seal(ks, nonce.data(), nullptr, 0, buf.data(), buf.data(), size, tag, impl);
+            }).bytes_per_sec;
+            // Open a valid record out of place so every pass verifies and decrypts
+            ByteBuffer ct(size), pt(size);
+            aes_gcm::seal(ks, nonce.data(), nullptr, 0, buf.data(), ct.data(), size, tag, impl);
+            double open_bps = measure(size, seconds, [&] {
+                aes_gcm::open(ks, nonce.data(), nullptr, 0, ct.data(), pt.data(), size, tag, impl);
+            }).bytes_per_sec;
+            printf("%-8s %14.2f %14.2f\n", aes_gcm::impl_name(impl), seal_bps / 1e9, open_bps / 1e9);
+        }
+    }
+
+    // Streaming hash / MAC: same total bytes fed as one update vs 4 KiB updates
+    const size_t piece = 4096;
+    uint8_t digest[Sha256::DIGEST_SIZE];
+    printf("\nSHA-256 / HMAC-SHA256, %zu-byte messages\n", size);
+    printf("%-8s %14s %14s %14s\n", "kernel", "sha256 GB/s", "4K-chunk GB/s", "hmac GB/s");
+    for (auto impl : { Sha256::Impl::SCALAR, Sha256::Impl::SHANI }) {
+        if (!Sha256::impl_available(impl)) {
+            printf("%-8s %14s %14s %14s\n", Sha256::impl_name(impl), "n/a", "n/a", "n/a");
+            continue;
+        }
+        double one_bps = measure(size, seconds, [&] {
+            Sha256 h(impl);
+            h.update(buf.data(), size);
+            h.finish(digest);
+        }).bytes_per_sec;
+        double chunk_bps = measure(size, seconds, [&] {
+            Sha256 h(impl);
+            for (size_t off = 0; off < size; off += piece) {
+                h.update(buf.data() + off, std::min(piece, size - off));
+            }
+            h.finish(digest);
+        }).bytes_per_sec;
+        // HMAC keyed once; the per-message cost is what the mesh pays
+        HmacSha256 mac(key.data(), key.size(), impl);
+        double mac_bps = measure(size, seconds, [&] {
+            mac.update(buf.data(), size);
+            mac.finish(digest);
+        }).bytes_per_sec;
+        printf("%-8s %14.2f %14.2f %14.2f\n", Sha256::impl_name(impl),
+               one_bps / 1e9, chunk_bps / 1e9, mac_bps / 1e9);
+    }
+
+    // Raw-key API vs a session with the key schedule cached, on a
+    // chat-sized message where per-call key setup dominates
+    {
+        const size_t msg_len = 64;
+        ByteBuffer record(Crypto::OVERHEAD + msg_len);
+        uint8_t mac[Crypto::MAC_SIZE];
+        CryptoSession session(key);
+        double raw_ops = measure(1, seconds, [&] {
+            crypto.seal_in_place(record, key);
+            crypto.hmac_into(record, key, ByteSpan(mac, sizeof(mac)));
+        }).bytes_per_sec;
+        double sess_ops = measure(1, seconds, [&] {
+            session.seal_in_place(record);
+            session.mac_into(record, ByteSpan(mac, sizeof(mac)));
+        }).bytes_per_sec;
+        printf("\nseal+mac, %zu-byte messages: raw key %.2f M/s, session %.2f M/s\n",
+               msg_len, raw_ops / 1e6, sess_ops / 1e6);
+    }
+
+    // Many small records: one at a time vs batched across SIMD lanes
+    {
+        const size_t msg_len = 64, count = 256;
+        std::vector<ByteBuffer> bufs(count, ByteBuffer(Crypto::OVERHEAD + msg_len));
+        std::vector<ByteSpan>   recs(bufs.begin(), bufs.end());
+        std::unique_ptr<bool[]> ok(new bool[count]);
+        CryptoSession session(key);
+        printf("\n%zu x %zu-byte records (payload GB/s)\n", count, msg_len);
+        printf("%-8s %14s %14s %14s\n", "kernel", "seal 1-by-1", "seal batch", "open batch");
+        for (auto impl : ALL_IMPLS) {
+            if (!chacha20::impl_available(impl)) continue;
+            session.set_cipher_impl(impl);
+            double one = measure(count * msg_len, seconds, [&] {
+                for (auto& r : recs) session.seal_in_place(r);
+            }).bytes_per_sec;
+            double seal = measure(count * msg_len, seconds, [&] {
+                session.seal_batch(recs.data(), count);
+            }).bytes_per_sec;
+
+            // open decrypts in place, so each pass restores the sealed
+            // records first (a 16 KiB memcpy, small next to the crypto)
+            session.seal_batch(recs.data(), count);
+            std::vector<ByteBuffer> sealed = bufs;
+            double open = measure(count * msg_len, seconds, [&] {
+                for (size_t i = 0; i < count; i++) {
+                    std::memcpy(bufs[i].data(), sealed[i].data(), bufs[i].size());
+                }
+                session.open_batch(recs.data(), count, ok.get());
+            }).bytes_per_sec;
+            printf("%-8s %14.2f %14.2f %14.2f\n", chacha20::impl_name(impl),
+                   one / 1e9, seal / 1e9, open / 1e9);
+        }
+    }
+
+    // CSPRNG: nonce-sized draws (the per-packet cost) and bulk fills
+    uint8_t small[Crypto::NONCE_SIZE];
+    double nonce_bps = measure(sizeof(small), seconds, [&] {
+        crypto.random_fill(ByteSpan(small, sizeof(small)));
+    }).bytes_per_sec;
+    double bulk_bps = measure(size, seconds, [&] { crypto.random_fill(buf); }).bytes_per_sec;
+    printf("\nrandom_fill: %.1f M nonces/s, %.2f GB/s bulk\n",
+           nonce_bps / sizeof(small) / 1e6, bulk_bps / 1e9);
+}
+
+// ─── API Sweep ───────────────────────────────────────────────
+
+struct Point {
+    std::string op;
+    size_t      size;
+    Sample      s;
+};
+
+static void write_json(FILE* f, const std::vector<Point>& results, double seconds) {
+    fprintf(f, "{\n");
+    fprintf(f, "  \"bench\": \"crypto\",\n");
+    fprintf(f, "  \"cipher_kernel\": \"%s\",\n", chacha20::impl_name(chacha20::best_impl()));
+    fprintf(f, "  \"aes_gcm_kernel\": \"%s\",\n", aes_gcm::impl_name(aes_gcm::best_impl()));
+    fprintf(f, "  \"hash_kernel\": \"%s\",\n", Sha256::impl_name(Sha256::best_impl()));
+    fprintf(f, "  \"seconds_per_point\": %.3f,\n", seconds);
+    fprintf(f, "  \"results\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        const Point& r = results[i];
+        // One result per line: --baseline reads them back line by line
+        fprintf(f, "    {\"op\": \"%s\", \"size\": %zu, \"mb_per_s\": %.3f, "
+                   "\"cycles_per_byte\": %.3f}%s\n",
+                r.op.c_str(), r.size, r.s.bytes_per_sec / 1e6, r.s.cycles_per_byte,
+                i + 1 < results.size() ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+}
+
+// Lines written by write_json(); anything else is skipped
+static bool read_baseline(const char* path, std::vector<Point>& out) {
+    FILE* f = std::fopen(path, "r");
+    if (!f) return false;
+    char line[512];
+    while (std::fgets(line, sizeof(line), f)) {
+        char op[64];
+        unsigned long long size;
+        double mbps;
+        if (std::sscanf(line, " {\"op\": \"%63[^\"]\", \"size\": %llu, \"mb_per_s\": %lf",
+                        op, &size, &mbps) == 3) {
+            Point r;
+            r.op = op;
+            r.size = (size_t)size;
+            r.s.bytes_per_sec = mbps * 1e6;
+            out.push_back(r);
+        }
+    }
+    std::fclose(f);
+    return true;
+}
+
+// Returns the number of regressions beyond `tolerance`
+static int compare_baseline(const std::vector<Point>& now,
+                            const std::vector<Point>& base, double tolerance) {
+    int regressions = 0, compared = 0;
+    printf("\nBaseline comparison (tolerance %.0f%%)\n", tolerance * 100);
+    for (const auto& b : base) {
+        for (const auto& r : now) {
+            if (r.op != b.op || r.size != b.size) continue;
+            compared++;
+            double ratio = r.s.bytes_per_sec / b.s.bytes_per_sec;
+            bool   bad   = ratio < 1.0 - tolerance;
+            if (bad) {
+                regressions++;
+                printf("  REGRESSION %-12s %9zu B: %10.2f MB/s vs %10.2f baseline (%.0f%%)\n",
+                       r.op.c_str(), r.size, r.s.bytes_per_sec / 1e6,
+                       b.s.bytes_per_sec / 1e6, ratio * 100);
+            }
+        }
+    }
+    printf("  %d points compared, %d regressions\n", compared, regressions);
+    return regressions;
+}
+
+static std::vector<Point> sweep(size_t max_size, double seconds, int repeat) {
+    Crypto crypto, gcm;
+    crypto.init();
+    gcm.init();
+    gcm.set_algorithm(CipherAlgo::AES_256_GCM);
+    ByteBuffer key = crypto.generate_key();
+
+    std::vector<Point> results;
+    printf("Crypto API sweep (cipher %s, aes-gcm %s, hash %s)\n",
+           chacha20::impl_name(chacha20::best_impl()), aes_gcm::impl_name(aes_gcm::best_impl()),
+           Sha256::impl_name(Sha256::best_impl()));
+    printf("%-12s %10s %12s %12s\n", "op", "size", "MB/s", "cycles/B");
+
+    for (size_t size = 16; size <= max_size; size *= 4) {
+        ByteBuffer plain  = crypto.random_bytes(size);
+        ByteBuffer sealed = crypto.encrypt(plain, key);
+        ByteBuffer sealed_gcm = gcm.encrypt(plain, key);
+        ByteBuffer mac    = crypto.hmac(plain, key);
+
+        // Best of `repeat` runs: noise only ever makes a run slower
+        auto run = [&](const char* op, auto&& fn) {
+            Point r{op, size, measure(size, seconds, fn)};
+            for (int i = 1; i < repeat; i++) {
+                Sample s = measure(size, seconds, fn);
+                if (s.bytes_per_sec > r.s.bytes_per_sec) r.s = s;
+            }
+            printf("%-12s %10zu %12.2f %12.2f\n", op, size,
+                   r.s.bytes_per_sec / 1e6, r.s.cycles_per_byte);
+            results.push_back(r);
+        };
+        run("encrypt",      [&] { ByteBuffer c = crypto.encrypt(plain, key); });
+        run("decrypt",      [&] { auto p = crypto.decrypt(sealed, key); });
+        run("encrypt_gcm",  [&] { ByteBuffer c = gcm.encrypt(plain, key); });
+        run("decrypt_gcm",  [&] { auto p = gcm.decrypt(sealed_gcm, key); });
+        run("hmac",         [&] { ByteBuffer m = crypto.hmac(plain, key); });
+        run("hmac_verify",  [&] { crypto.hmac_verify(plain, key, mac); });
+        run("random_bytes", [&] { ByteBuffer b = crypto.random_bytes(size); });
+    }
+    return results;
+}
+
+// ─── Main ────────────────────────────────────────────────────
+
+int main(int argc, char** argv) {
+    log::g_min_level = log::Level::WARN;
+
+    size_t      size      = 64 * 1024;
+    size_t      max_size  = 16 * 1024 * 1024;
+    double      seconds   = -1;
+    bool        kernels   = false;
+    const char* json_path = nullptr;
+    const char* baseline  = nullptr;
+    double      tolerance = 0.30;
+    int         repeat    = 1;
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--size") && i + 1 < argc) {
+            size = (size_t)std::strtoull(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "--seconds") && i + 1 < argc) {
+            seconds = std::atof(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--max-size") && i + 1 < argc) {
+            max_size = (size_t)std::strtoull(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "--quick")) {
+            max_size = 1024 * 1024;
+            if (seconds < 0) seconds = 0.05;
+        } else if (!std::strcmp(argv[i], "--repeat") && i + 1 < argc) {
+            repeat = std::max(1, std::atoi(argv[++i]));
+        } else if (!std::strcmp(argv[i], "--kernels")) {
+            kernels = true;
+        } else if (!std::strcmp(argv[i], "--json") && i + 1 < argc) {
+            json_path = argv[++i];
+        } else if (!std::strcmp(argv[i], "--baseline") && i + 1 < argc) {
+            baseline = argv[++i];
+        } else if (!std::strcmp(argv[i], "--tolerance") && i + 1 < argc) {
+            tolerance = std::atof(argv[++i]);
+        } else {
+            fprintf(stderr,
+                    "usage: %s [--seconds S] [--max-size BYTES] [--quick] [--repeat N]\n"
+                    "          [--json FILE|-] [--baseline FILE [--tolerance F]]\n"
+                    "       %s --kernels [--size BYTES] [--seconds S]\n",
+                    argv[0], argv[0]);
+            return 2;
+        }
+    }
+
+    if (kernels) {
+        kernel_report(size, seconds < 0 ? 0.5 : seconds);
+        return 0;
+    }
+
+    if (seconds < 0) seconds = 0.2;
+    std::vector<Point> results = sweep(max_size, seconds, repeat);
+
+    if (json_path) {
+        FILE* f = !std::strcmp(json_path, "-") ? stdout : std::fopen(json_path, "w");
+        if (!f) {
+            fprintf(stderr, "cannot write %s\n", json_path);
+            return 2;
+        }
+        write_json(f, results, seconds);
+        if (f != stdout) std::fclose(f);
+    }
+
+    if (baseline) {
+        std::vector<Point> base;
+        if (!read_baseline(baseline, base) || base.empty()) {
+            fprintf(stderr, "cannot read baseline %s\n", baseline);
+            return 2;
+        }
+        return compare_baseline(results, base, tolerance) == 0 ? 0 : 1;
+    }
+    return 0;
+}
@@ -0,0 +1,380 @@
+/*
+ * VOS Benchmark — MeshNet end to end on loopback
+ *
+ * K MeshNet instances on their own loopback ports, each a peer of every
+ * other, driven through the public API alone, so the whole network path
+ * is timed: sealing, the send queues, the socket, the event loop,
+ * opening and the callback worker.
+ *
+ * Workloads:
+ *   text   every node calls send_text() at a fixed rate, to the others in
+ *          turn. Each message carries its send time, so the receiver's
+ *          on_message callback measures the end-to-end latency.
+ *   file   every node send_file()s to its neighbour in a ring, back to
+ *          back, for the duration; the latency is per file.
+ *   mixed  both at once: message latency with bulk transfers in the way.
+ *
+ * Reported per workload: messages and file bytes delivered per second,
+ * p50/p99/max latency, loss (messages never delivered, and chunk
+ * retransmissions per chunk sent), and process CPU time per datagram
+ * sent, kernel included, all nodes together. --loss drops that share of
+ * datagrams each way with the loss shim.
+ *
+ *   vos_bench_mesh [--nodes K] [--workload text|file|mixed|all] [--seconds S]
+ *                  [--rate MSGS_PER_S] [--size BYTES] [--file-kb KB] [--loss P]
+ *                  [--quick] [--json FILE|-]
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "core/mesh_net.h"
+#include "core/vfs.h"
+#include "vos/log.h"
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+using namespace vos;
+
+#ifndef _WIN32
+
+namespace {
+
+struct Config {
+    size_t nodes    = 4;
+    double seconds  = 2.0;
+    double rate     = 1000;   // messages per second from each node
+    size_t size     = 64;     // bytes per message
+    size_t file_kb  = 1024;
+    double loss     = 0;
+};
+
+struct Latency {
+    double p50_ms = 0, p99_ms = 0, max_ms = 0;
+};
+
+struct Row {
+    std::string workload;
+    double      secs           = 0;
+    uint64_t    msgs_sent      = 0;
+    uint64_t    msgs_delivered = 0;
+    uint64_t    files_sent     = 0;
+    uint64_t    files_failed   = 0;
+    double      msgs_per_s     = 0;
+    double      mb_per_s       = 0;   // file bytes delivered
+    Latency     msg_latency;
+    Latency     file_latency;
+    double      msg_loss       = 0;
+    double      retransmits    = 0;   // per chunk sent
+    uint64_t    datagrams      = 0;
+    double      cpu_ns_pp      = 0;
+    uint64_t    txq_wait_p99_us = 0;  // worst node
+};
+
+// An ephemeral port that is free right now
+uint16_t free_port() {
+    int         fd = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(fd, (sockaddr*)&addr, sizeof(addr));
+    socklen_t len = sizeof(addr);
+    getsockname(fd, (sockaddr*)&addr, &len);
+    close(fd);
+    return ntohs(addr.sin_port);
+}
+
+double cpu_seconds() {
+    timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int64_t now_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now().time_since_epoch()).count();
+}
+
+Latency percentiles(std::vector<double> ms) {
+    Latency l;
+    if (ms.empty()) return l;
+    std::sort(ms.begin(), ms.end());
+    auto at  = [&](double q) { return ms[std::min(ms.size() - 1, (size_t)(q * ms.size()))]; };
+    l.p50_ms = at(0.50);
+    l.p99_ms = at(0.99);
+    l.max_ms = ms.back();
+    return l;
+}
+
+std::string node_id(size_t i) { return "B" + std::to_string(i); }
+
+// K fully meshed instances sharing one session key
+class Cluster {
+public:
+    Cluster(Crypto& crypto, const ByteBuffer& key, const Config& cfg) : m_ok(true) {
+        std::vector<uint16_t> ports;
+        for (size_t i = 0; i < cfg.nodes; i++) {
+            m_nodes.emplace_back(new Node);
+            Node& n = *m_nodes.back();
+            uint16_t port = free_port();
+            n.net.set_own_id(node_id(i));
+            if (cfg.loss > 0) n.net.set_loss_simulation(cfg.loss, cfg.loss, 1 + i);
+            m_ok = m_ok && n.net.init(&crypto, port).ok() && n.net.set_session_key(key).ok();
+            n.vfs.init();
+            n.net.set_file_store(&n.vfs);
+            n.net.on_message([this](const std::string&, const ByteBuffer& msg) { received(msg); });
+            ports.push_back(port);
+        }
+        for (size_t i = 0; i < cfg.nodes; i++)
+            for (size_t j = 0; j < cfg.nodes; j++)
+                if (i != j) m_nodes[i]->net.add_peer(node_id(j), "127.0.0.1", ports[j]);
+    }
+    ~Cluster() {
+        for (auto& n : m_nodes) n->net.shutdown();
+    }
+
+    bool     ok() const { return m_ok; }
+    size_t   size() const { return m_nodes.size(); }
+    MeshNet& net(size_t i) { return m_nodes[i]->net; }
+
+    uint64_t delivered() const { return m_delivered.load(); }
+    std::vector<double> latencies() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_latency_ms;
+    }
+
+private:
+    struct Node {
+        MeshNet   net;
+        VirtualFS vfs;
+    };
+
+    // [SENT_US:8] then padding
+    void received(const ByteBuffer& msg) {
+        if (msg.size() < 8) return;
+        int64_t sent;
+        std::memcpy(&sent, msg.data(), 8);
+        double ms = (now_us() - sent) / 1000.0;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_latency_ms.push_back(ms);
+        m_delivered++;
+    }
+
+    bool                               m_ok;
+    std::vector<std::unique_ptr<Node>> m_nodes;
+    std::mutex                         m_mutex;
+    std::vector<double>                m_latency_ms;
+    std::atomic<uint64_t>              m_delivered{0};
+};
+
+Row run(Crypto& crypto, const ByteBuffer& key, const Config& cfg, const std::string& workload) {
+    Row row;
+    row.workload = workload;
+    Cluster c(crypto, key, cfg);
+    if (!c.ok()) {
+        fprintf(stderr, "cannot start %zu nodes\n", cfg.nodes);
+        return row;
+    }
+    const bool text  = workload != "file";
+    const bool files = workload != "text";
+    const size_t K   = c.size();
+
+    ByteBuffer file(cfg.file_kb * 1024);
+    for (size_t i = 0; i < file.size(); i++) file[i] = (uint8_t)(i * 151 + (i >> 12));
+
+    std::vector<MeshStats> before;
+    for (size_t i = 0; i < K; i++) before.push_back(c.net(i).get_stats());
+
+    std::atomic<uint64_t>    sent{0}, files_ok{0}, files_failed{0};
+    std::mutex               file_mutex;
+    std::vector<double>      file_ms;
+    std::vector<std::thread> threads;
+    const double cpu0 = cpu_seconds();
+    const auto   t0   = Clock::now();
+    const auto   end  = t0 + std::chrono::duration_cast<Duration>(std::chrono::duration<double>(cfg.seconds));
+
+    if (text) {
+        for (size_t i = 0; i < K; i++) {
+            threads.emplace_back([&, i] {
+                // Open loop: a late message does not push back the ones after it
+                const auto  gap = std::chrono::duration_cast<Duration>(std::chrono::duration<double>(1.0 / cfg.rate));
+                std::string msg(std::max<size_t>(cfg.size, 8), 'm');
+                auto        next = t0;
+                for (uint64_t k = 0; next < end; k++, next += gap) {
+                    std::this_thread::sleep_until(next);
+                    int64_t us = now_us();
+                    std::memcpy(&msg[0], &us, 8);
+                    size_t to = (i + 1 + k % (K - 1)) % K;
+                    if (c.net(i).send_text(node_id(to), msg).ok()) sent++;
+                }
+            });
+        }
+    }
+    if (files) {
+        for (size_t i = 0; i < K; i++) {
+            threads.emplace_back([&, i] {
+                std::string to = node_id((i + 1) % K), name = "from" + std::to_string(i) + ".bin";
+                while (Clock::now() < end) {
+                    auto f0 = Clock::now();
+                    bool ok = c.net(i).send_file(to, name, file).ok();
+                    double ms = std::chrono::duration<double, std::milli>(Clock::now() - f0).count();
+                    if (!ok) {
+                        files_failed++;
+                        continue;
+                    }
+                    files_ok++;
+                    std::lock_guard<std::mutex> lock(file_mutex);
+                    file_ms.push_back(ms);
+                }
+            });
+        }
+    }
+    for (auto& t : threads) t.join();
+    row.secs = std::chrono::duration<double>(Clock::now() - t0).count();
+
+    // Stragglers: until deliveries stop, at most a second
+    for (int i = 0; i < 100 && c.delivered() < sent.load(); i++) {
+        for (size_t n = 0; n < K; n++) c.net(n).drain_callbacks();
+        std::this_thread::sleep_for(Millis(10));
+    }
+    const double cpu = cpu_seconds() - cpu0;
+
+    uint64_t chunks = 0, retransmits = 0;
+    for (size_t i = 0; i < K; i++) {
+        MeshStats s = c.net(i).get_stats();
+        row.datagrams      += s.tx_packets - before[i].tx_packets;
+        chunks             += s.file_chunks_sent - before[i].file_chunks_sent;
+        retransmits        += s.file_retransmits - before[i].file_retransmits;
+        row.txq_wait_p99_us = std::max(row.txq_wait_p99_us, s.txq_wait_p99_us);
+    }
+    row.msgs_sent      = sent.load();
+    row.msgs_delivered = c.delivered();
+    row.files_sent     = files_ok.load();
+    row.files_failed   = files_failed.load();
+    row.msgs_per_s     = row.msgs_delivered / row.secs;
+    row.mb_per_s       = row.files_sent * file.size() / row.secs / 1e6;
+    row.msg_latency    = percentiles(c.latencies());
+    row.file_latency   = percentiles(file_ms);
+    row.msg_loss       = row.msgs_sent ? 1.0 - (double)row.msgs_delivered / row.msgs_sent : 0;
+    row.retransmits    = chunks ? (double)retransmits / chunks : 0;
+    row.cpu_ns_pp      = row.datagrams ? cpu * 1e9 / row.datagrams : 0;
+    return row;
+}
+
+void print_latency(FILE* f, const char* name, const Latency& l) {
+    fprintf(f, "\"%s\": {\"p50\": %.3f, \"p99\": %.3f, \"max\": %.3f}", name, l.p50_ms, l.p99_ms, l.max_ms);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    log::g_min_level = log::Level::WARN;
+
+    Config      cfg;
+    std::string workload  = "all";
+    const char* json_path = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if      (!std::strcmp(argv[i], "--nodes")    && i + 1 < argc) cfg.nodes   = (size_t)std::atol(argv[++i]);
+        else if (!std::strcmp(argv[i], "--workload") && i + 1 < argc) workload    = argv[++i];
+        else if (!std::strcmp(argv[i], "--seconds")  && i + 1 < argc) cfg.seconds = std::atof(argv[++i]);
+        else if (!std::strcmp(argv[i], "--rate")     && i + 1 < argc) cfg.rate    = std::atof(argv[++i]);
+        else if (!std::strcmp(argv[i], "--size")     && i + 1 < argc) cfg.size    = (size_t)std::atol(argv[++i]);
+        else if (!std::strcmp(argv[i], "--file-kb")  && i + 1 < argc) cfg.file_kb = (size_t)std::atol(argv[++i]);
+        else if (!std::strcmp(argv[i], "--loss")     && i + 1 < argc) cfg.loss    = std::atof(argv[++i]);
+        else if (!std::strcmp(argv[i], "--quick")) {
+            cfg.seconds = 0.5;
+            cfg.file_kb = 256;
+        }
+        else if (!std::strcmp(argv[i], "--json")     && i + 1 < argc) json_path = argv[++i];
+        else {
+            fprintf(stderr,
+                    "usage: %s [--nodes K] [--workload text|file|mixed|all] [--seconds S] [--rate MSGS_PER_S]\n"
+                    "          [--size BYTES] [--file-kb KB] [--loss P] [--quick] [--json FILE|-]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    cfg.nodes = std::max<size_t>(cfg.nodes, 2);
+    cfg.rate  = std::max(cfg.rate, 1.0);
+    cfg.size  = std::min<size_t>(std::max<size_t>(cfg.size, 8), 60000);
+    std::vector<std::string> workloads =
+        workload == "all" ? std::vector<std::string>{"text", "file", "mixed"} : std::vector<std::string>{workload};
+    for (const auto& w : workloads) {
+        if (w != "text" && w != "file" && w != "mixed") {
+            fprintf(stderr, "unknown workload '%s'\n", w.c_str());
+            return 2;
+        }
+    }
+
+    Crypto crypto;
+    crypto.init();
+    ByteBuffer key = crypto.generate_key();
+
+    printf("%zu MeshNet nodes on loopback, %u CPUs, %.1f s per workload\n", cfg.nodes,
+           std::thread::hardware_concurrency(), cfg.seconds);
+    printf("  text: %.0f msgs/s per node, %zu bytes; file: %zu KiB ring; simulated loss %.1f%%\n\n", cfg.rate,
+           cfg.size, cfg.file_kb, cfg.loss * 100);
+    printf("%-6s | %9s %7s %8s %8s %8s | %6s %8s %8s | %8s %10s\n", "", "msgs/s", "loss", "p50 ms", "p99 ms",
+           "max ms", "files", "MB/s", "p99 ms", "retx", "cpu ns/pkt");
+
+    std::vector<Row> rows;
+    for (const auto& w : workloads) {
+        Row r = run(crypto, key, cfg, w);
+        printf("%-6s | %9.0f %6.2f%% %8.3f %8.3f %8.3f | %6llu %8.1f %8.1f | %7.2f%% %10.0f\n", r.workload.c_str(),
+               r.msgs_per_s, r.msg_loss * 100, r.msg_latency.p50_ms, r.msg_latency.p99_ms, r.msg_latency.max_ms,
+               (unsigned long long)r.files_sent, r.mb_per_s, r.file_latency.p99_ms, r.retransmits * 100,
+               r.cpu_ns_pp);
+        if (r.files_failed) printf("       %llu file sends failed\n", (unsigned long long)r.files_failed);
+        rows.push_back(r);
+    }
+
+    if (json_path) {
+        FILE* f = std::strcmp(json_path, "-") == 0 ? stdout : std::fopen(json_path, "w");
+        if (!f) {
+            fprintf(stderr, "cannot write %s\n", json_path);
+            return 1;
+        }
+        fprintf(f, "{\n  \"bench\": \"mesh\",\n  \"nodes\": %zu,\n  \"cpus\": %u,\n  \"seconds\": %.2f,\n"
+                   "  \"rate_per_node\": %.0f,\n  \"msg_bytes\": %zu,\n  \"file_kb\": %zu,\n  \"loss_sim\": %.4f,\n"
+                   "  \"workloads\": [\n",
+                cfg.nodes, std::thread::hardware_concurrency(), cfg.seconds, cfg.rate, cfg.size, cfg.file_kb,
+                cfg.loss);
+        for (size_t i = 0; i < rows.size(); i++) {
+            const Row& r = rows[i];
+            fprintf(f, "    {\"workload\": \"%s\", \"seconds\": %.3f, \"msgs_sent\": %llu, \"msgs_delivered\": %llu, "
+                       "\"msgs_per_s\": %.1f, \"msg_loss\": %.5f, ",
+                    r.workload.c_str(), r.secs, (unsigned long long)r.msgs_sent,
+                    (unsigned long long)r.msgs_delivered, r.msgs_per_s, r.msg_loss);
+            print_latency(f, "msg_latency_ms", r.msg_latency);
+            fprintf(f, ", \"files\": %llu, \"files_failed\": %llu, \"mb_per_s\": %.2f, ",
+                    (unsigned long long)r.files_sent, (unsigned long long)r.files_failed, r.mb_per_s);
+            print_latency(f, "file_latency_ms", r.file_latency);
+            fprintf(f, ", \"retransmits_per_chunk\": %.5f, \"datagrams\": %llu, \"cpu_ns_per_pkt\": %.0f, "
+                       "\"txq_wait_p99_us\": %llu}%s\n",
+                    r.retransmits, (unsigned long long)r.datagrams, r.cpu_ns_pp,
+                    (unsigned long long)r.txq_wait_p99_us, i + 1 < rows.size() ? "," : "");
+        }
+        fprintf(f, "  ]\n}\n");
+        if (f != stdout) std::fclose(f);
+    }
+    return 0;
+}
+
+#else
+
+int main() {
+    printf("vos_bench_mesh: needs POSIX sockets for its loopback ports\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,269 @@
+/*
+ * VOS Benchmark — Mesh discovery traffic
+ *
+ * Simulates N peers on one broadcast domain, in simulated time, under the
+ * old discovery (DISCOVER every 5 s from every peer, an ACK to each new
+ * peer) and the Trickle schedule MeshNet uses now. The adaptive side runs
+ * the same mesh_discovery::Trickle and should_ack() as MeshNet, with
+ * MeshNet's default MeshDiscoveryConfig.
+ *
+ * Timeline: the peers join one by one over the first minute, the mesh
+ * then stays put, and at 10 min five peers leave; the others notice 30 s
+ * later (liveness eviction) and the five come back at 11 min.
+ *
+ * Reported per phase: DISCOVER + ACK datagrams sent and received per
+ * minute, and how long until every peer knew every other one again.
+ *
+ *   vos_bench_mesh_discovery [--peers N] [--seed S] [--json FILE|-]
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include "core/mesh_net.h"
+#include "core/mesh_discovery.h"
+
+using namespace vos;
+using namespace mesh_discovery;
+
+namespace {
+
+constexpr int64_t TICK_MS   = 10;
+constexpr int64_t JOIN_MS   = 60000;    // joins spread over this
+constexpr int64_t LEAVE_MS  = 600000;
+constexpr int64_t NOTICE_MS = 30000;    // until the others evict a peer that left
+constexpr int64_t BACK_MS   = 660000;
+constexpr int64_t END_MS    = 900000;
+constexpr size_t  CHURN     = 5;
+constexpr auto    LEGACY_INTERVAL = Millis(5000);
+
+struct Phase {
+    const char* name;
+    int64_t     from_ms, to_ms;
+};
+const Phase PHASES[] = {
+    {"join",   0,        JOIN_MS},
+    {"steady", JOIN_MS,  LEAVE_MS},
+    {"churn",  LEAVE_MS, END_MS},
+};
+constexpr size_t NPHASES = sizeof(PHASES) / sizeof(PHASES[0]);
+
+struct SimResult {
+    uint64_t sent[NPHASES]     = {};
+    uint64_t received[NPHASES] = {};
+    double   settle_join_s     = -1;   // from the first join until all know all
+    double   settle_churn_s    = -1;   // from the rejoin until all know all
+};
+
+struct Peer {
+    bool                     alive = false;
+    std::vector<char>        knows;
+    std::unique_ptr<Trickle> trickle;
+    TimePoint                legacy_next;
+};
+
+class Sim {
+public:
+    Sim(size_t n, bool adaptive, uint64_t seed) : m_peers(n), m_adaptive(adaptive), m_rng(seed | 1) {
+        for (auto& p : m_peers) p.knows.assign(n, 0);
+    }
+
+    SimResult run() {
+        const MeshDiscoveryConfig cfg;
+        const TimePoint           t0 = TimePoint() + Seconds(3600);
+        const size_t              n  = m_peers.size();
+        SimResult                    res;
+        bool                      churned = false;
+
+        for (int64_t ms = 0; ms < END_MS; ms += TICK_MS) {
+            TimePoint now = t0 + Millis(ms);
+            m_phase       = phase_of(ms);
+
+            for (size_t i = 0; i < n; i++) {
+                if (ms == (int64_t)(i * JOIN_MS / n)) start(i, now, cfg);
+            }
+            if (ms == LEAVE_MS) {
+                for (size_t i = 0; i < CHURN; i++) m_peers[i].alive = false;
+                churned = true;
+            }
+            if (ms == LEAVE_MS + NOTICE_MS) {
+                // Liveness evicts the departed: a change, so Trickle resets
+                for (size_t i = CHURN; i < n; i++) {
+                    for (size_t j = 0; j < CHURN; j++) m_peers[i].knows[j] = 0;
+                    if (m_adaptive) m_peers[i].trickle->reset(now);
+                }
+            }
+            if (ms == BACK_MS) {
+                for (size_t i = 0; i < CHURN; i++) start(i, now, cfg);
+            }
+
+            for (size_t i = 0; i < n; i++) {
+                Peer& p = m_peers[i];
+                if (!p.alive) continue;
+                bool due;
+                if (m_adaptive) {
+                    due = p.trickle->poll(now);
+                } else {
+                    due = now >= p.legacy_next;
+                    if (due) p.legacy_next += LEGACY_INTERVAL;
+                }
+                if (due) broadcast(i, now, cfg);
+            }
+
+            if (ms % 100 == 0) {
+                bool all = everyone_knows_everyone();
+                if (res.settle_join_s < 0 && ms >= JOIN_MS && all) res.settle_join_s = ms / 1000.0;
+                if (churned && ms >= BACK_MS && res.settle_churn_s < 0 && all)
+                    res.settle_churn_s = (ms - BACK_MS) / 1000.0;
+            }
+        }
+        for (size_t k = 0; k < NPHASES; k++) {
+            res.sent[k]     = m_sent[k];
+            res.received[k] = m_received[k];
+        }
+        return res;
+    }
+
+private:
+    static size_t phase_of(int64_t ms) {
+        for (size_t k = 0; k < NPHASES; k++)
+            if (ms < PHASES[k].to_ms) return k;
+        return NPHASES - 1;
+    }
+
+    uint32_t random() {
+        m_rng ^= m_rng >> 12;
+        m_rng ^= m_rng << 25;
+        m_rng ^= m_rng >> 27;
+        return (uint32_t)((m_rng * 0x2545F4914F6CDD1Dull) >> 32);
+    }
+
+    void start(size_t i, TimePoint now, const MeshDiscoveryConfig& cfg) {
+        Peer& p = m_peers[i];
+        p.alive = true;
+        std::fill(p.knows.begin(), p.knows.end(), 0);
+        p.trickle.reset(new Trickle(cfg.interval_min, cfg.interval_max, cfg.redundancy,
+                                    ((uint64_t)random() << 32) | random()));
+        p.trickle->reset(now);
+        // The old timer fired at start, then every 5 s
+        p.legacy_next = now;
+    }
+
+    size_t known(size_t i) const {
+        size_t c = 0;
+        for (char k : m_peers[i].knows) c += k;
+        return c;
+    }
+
+    // `i` learns of `j`; true if it was news
+    bool learn(size_t i, size_t j, TimePoint now) {
+        Peer& p = m_peers[i];
+        if (p.knows[j]) return false;
+        p.knows[j] = 1;
+        if (m_adaptive) p.trickle->reset(now);
+        return true;
+    }
+
+    void broadcast(size_t from, TimePoint now, const MeshDiscoveryConfig& cfg) {
+        m_sent[m_phase]++;
+        for (size_t i = 0; i < m_peers.size(); i++) {
+            Peer& p = m_peers[i];
+            if (i == from || !p.alive) continue;
+            m_received[m_phase]++;
+            bool fresh = learn(i, from, now);
+            bool ack;
+            if (m_adaptive) {
+                if (!fresh) p.trickle->heard();
+                ack = fresh || should_ack(known(i) - 1, cfg.ack_fanout, random());
+            } else {
+                ack = fresh;
+            }
+            if (ack) {
+                m_sent[m_phase]++;
+                m_received[m_phase]++;
+                learn(from, i, now);
+            }
+        }
+    }
+
+    bool everyone_knows_everyone() const {
+        for (size_t i = 0; i < m_peers.size(); i++) {
+            if (!m_peers[i].alive) continue;
+            for (size_t j = 0; j < m_peers.size(); j++)
+                if (j != i && m_peers[j].alive && !m_peers[i].knows[j]) return false;
+        }
+        return true;
+    }
+
+    std::vector<Peer> m_peers;
+    bool              m_adaptive;
+    uint64_t          m_rng;
+    size_t            m_phase = 0;
+    uint64_t          m_sent[NPHASES]     = {};
+    uint64_t          m_received[NPHASES] = {};
+};
+
+double per_min(uint64_t count, const Phase& ph) {
+    return count * 60000.0 / (double)(ph.to_ms - ph.from_ms);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t      peers     = 50;
+    uint64_t    seed      = 1;
+    const char* json_path = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if      (!std::strcmp(argv[i], "--peers") && i + 1 < argc) peers = (size_t)std::atol(argv[++i]);
+        else if (!std::strcmp(argv[i], "--seed")  && i + 1 < argc) seed  = (uint64_t)std::atoll(argv[++i]);
+        else if (!std::strcmp(argv[i], "--json")  && i + 1 < argc) json_path = argv[++i];
+        else {
+            fprintf(stderr, "usage: %s [--peers N] [--seed S] [--json FILE|-]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (peers <= CHURN) peers = CHURN + 1;
+
+    const MeshDiscoveryConfig cfg;
+    SimResult fixed    = Sim(peers, false, seed).run();
+    SimResult adaptive = Sim(peers, true, seed).run();
+
+    printf("Discovery traffic, %zu simulated peers\n", peers);
+    printf("  fixed:    DISCOVER every %lld s, ACK to new peers\n", (long long)LEGACY_INTERVAL.count() / 1000);
+    printf("  adaptive: Trickle %lld ms .. %lld s, redundancy %d, ACK fanout %zu\n\n",
+           (long long)cfg.interval_min.count(), (long long)(cfg.interval_max.count() / 1000), cfg.redundancy,
+           cfg.ack_fanout);
+    printf("%-8s | %12s %12s | %12s %12s\n", "phase", "fixed sent", "received", "adapt sent", "received");
+    printf("%-8s | %12s %12s | %12s %12s\n", "", "/min", "/min", "/min", "/min");
+    for (size_t k = 0; k < NPHASES; k++) {
+        const Phase& ph = PHASES[k];
+        printf("%-8s | %12.0f %12.0f | %12.0f %12.0f\n", ph.name, per_min(fixed.sent[k], ph),
+               per_min(fixed.received[k], ph), per_min(adaptive.sent[k], ph), per_min(adaptive.received[k], ph));
+    }
+    printf("\nAll peers known to all: fixed %.1f s / adaptive %.1f s after the joins,\n"
+           "                        fixed %.1f s / adaptive %.1f s after %zu peers rejoin\n",
+           fixed.settle_join_s, adaptive.settle_join_s, fixed.settle_churn_s, adaptive.settle_churn_s, CHURN);
+
+    if (json_path) {
+        FILE* f = std::strcmp(json_path, "-") == 0 ? stdout : std::fopen(json_path, "w");
+        if (!f) {
+            fprintf(stderr, "cannot write %s\n", json_path);
+            return 1;
+        }
+        fprintf(f, "{\n  \"bench\": \"mesh_discovery\",\n  \"peers\": %zu,\n  \"phases\": [\n", peers);
+        for (size_t k = 0; k < NPHASES; k++) {
+            const Phase& ph = PHASES[k];
+            fprintf(f, "    {\"phase\": \"%s\", \"fixed_sent_per_min\": %.1f, \"fixed_received_per_min\": %.1f, "
+                       "\"adaptive_sent_per_min\": %.1f, \"adaptive_received_per_min\": %.1f}%s\n",
+                    ph.name, per_min(fixed.sent[k], ph), per_min(fixed.received[k], ph),
+                    per_min(adaptive.sent[k], ph), per_min(adaptive.received[k], ph), k + 1 < NPHASES ? "," : "");
+        }
+        fprintf(f, "  ],\n  \"settle_s\": {\"fixed_join\": %.1f, \"adaptive_join\": %.1f, "
+                   "\"fixed_rejoin\": %.1f, \"adaptive_rejoin\": %.1f}\n}\n",
+                fixed.settle_join_s, adaptive.settle_join_s, fixed.settle_churn_s, adaptive.settle_churn_s);
+        if (f != stdout) std::fclose(f);
+    }
+    return 0;
+}
@@ -0,0 +1,718 @@
+/*
+ * VOS Benchmark — Mesh receive path
+ *
+ * Receive: the old listener loop (recvfrom into a 64 KB buffer, copy into
+ * a ByteBuffer, deserialize the copy) against the batched path MeshNet
+ * uses now (recvmmsg into a RecvBatch pool, MeshPacketView parse in
+ * place). Bursts of mesh packets are queued on a loopback socket, then
+ * only the drain is timed, so the numbers are receive-side packets per
+ * second and heap allocations per packet.
+ *
+ * Parse: the header parse alone on a resident packet, MeshPacket::
+ * deserialize (payload and MAC copied out) against MeshPacketView::parse
+ * (spans into the buffer). Nanoseconds and allocations per packet.
+ *
+ * Send: file-sized runs of FILE_CHUNK packets sent one sendto() each (the
+ * old send_file) against SendBatch flushes with plain sendmmsg and with
+ * UDP GSO.
+ *
+ * Backends: the same receive drains and file sends through recvmmsg /
+ * sendmmsg and through io_uring (multishot recvmsg, linked sendmsg), with
+ * process CPU time per packet next to the rates.
+ *
+ * Lookup: resolving a datagram's sender among N peers, the old way
+ * (inet_ntop, then a scan comparing address strings) against the
+ * MeshAddr index MeshNet keeps now.
+ *
+ * Chat: bursts of short send_text() messages between two MeshNet
+ * instances, sent one per datagram and coalesced into BUNDLEs with a 2 ms
+ * window. Datagrams and MAC operations (the AEAD tag, one per
+ * datagram) per message, and the delay from send to callback.
+ *
+ * Goodput: send_file() between two MeshNet instances on loopback, with
+ * the loss shim dropping 0/1/5/10% of datagrams each way (chunks one way,
+ * ACKs the other). File bytes delivered per second, retransmissions and
+ * timer expiries per transfer.
+ *
+ * Download: download_file() of one file held by 1, 2 and 3 MeshNet peers,
+ * each pacing its uplink to a fixed rate (set_rate_simulation), so the
+ * speedup from pulling stripes in parallel shows even on one CPU.
+ *
+ *   vos_bench_mesh_io [--seconds S] [--burst N] [--quick] [--json FILE|-]
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "core/mesh_net.h"
+#include "core/mesh_io.h"
+#include "core/mesh_uring.h"
+#include "core/vfs.h"
+#include "vos/log.h"
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+using namespace vos;
+
+// Heap allocations, to show what the receive path costs per packet
+static std::atomic<size_t> g_allocs{0};
+
+void* operator new(size_t n) {
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+#ifndef _WIN32
+
+struct Loopback {
+    int         rx = -1, tx = -1;
+    sockaddr_in dest{};
+};
+
+static Loopback open_loopback() {
+    Loopback l;
+    l.rx = socket(AF_INET, SOCK_DGRAM, 0);
+    l.tx = socket(AF_INET, SOCK_DGRAM, 0);
+
+    sockaddr_in addr{};
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(l.rx, (sockaddr*)&addr, sizeof(addr));
+    socklen_t len = sizeof(addr);
+    getsockname(l.rx, (sockaddr*)&addr, &len);
+    l.dest = addr;
+
+    // Room for a whole burst; FORCE needs CAP_NET_ADMIN, the plain call is
+    // capped at net.core.rmem_max
+    int rcvbuf = 32 << 20;
+#ifdef SO_RCVBUFFORCE
+    if (setsockopt(l.rx, SOL_SOCKET, SO_RCVBUFFORCE, &rcvbuf, sizeof(rcvbuf)) != 0)
+#endif
+        setsockopt(l.rx, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+    // Drains stop at EAGAIN instead of waiting out a timeout
+    fcntl(l.rx, F_SETFL, fcntl(l.rx, F_GETFL) | O_NONBLOCK);
+    return l;
+}
+
+static void close_loopback(Loopback& l) {
+    close(l.rx);
+    close(l.tx);
+}
+
+// An ephemeral port that is free right now
+static uint16_t free_port() {
+    int         fd = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(fd, (sockaddr*)&addr, sizeof(addr));
+    socklen_t len = sizeof(addr);
+    getsockname(fd, (sockaddr*)&addr, &len);
+    close(fd);
+    return ntohs(addr.sin_port);
+}
+
+static ByteBuffer make_packet(size_t payload_len) {
+    MeshPacket pkt;
+    pkt.magic       = MESH_MAGIC;
+    pkt.version     = MESH_VERSION;
+    pkt.type        = MeshMsgType::FILE_CHUNK;
+    pkt.payload     = ByteBuffer(payload_len, 0xAB);
+    pkt.payload_len = (uint32_t)payload_len;
+    return pkt.serialize();
+}
+
+struct RxSample {
+    double pps         = 0;
+    double syscalls_pp = 0;   // receive calls per packet
+    double allocs_pp   = 0;
+    double cpu_ns_pp   = 0;   // process CPU time per packet, kernel included
+};
+
+static double cpu_seconds() {
+    timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// `drain` empties the socket and returns {packets, syscalls}
+template<typename Drain>
+static RxSample run(Loopback& l, const ByteBuffer& wire, size_t burst, double seconds,
+                   Drain&& drain) {
+    size_t packets = 0, calls = 0, allocs = 0;
+    double timed = 0, cpu = 0;
+    auto   start = Clock::now();
+    while (std::chrono::duration<double>(Clock::now() - start).count() < seconds) {
+        for (size_t i = 0; i < burst; i++) {
+            sendto(l.tx, wire.data(), wire.size(), 0, (sockaddr*)&l.dest, sizeof(l.dest));
+        }
+        size_t a0 = g_allocs.load();
+        double c0 = cpu_seconds();
+        auto   t0 = Clock::now();
+        auto   r  = drain();
+        timed += std::chrono::duration<double>(Clock::now() - t0).count();
+        cpu   += cpu_seconds() - c0;
+        allocs  += g_allocs.load() - a0;
+        packets += r.first;
+        calls   += r.second;
+    }
+    RxSample out;
+    if (packets == 0) return out;
+    out.pps         = packets / timed;
+    out.syscalls_pp = (double)calls / packets;
+    out.allocs_pp   = (double)allocs / packets;
+    out.cpu_ns_pp   = cpu * 1e9 / packets;
+    return out;
+}
+
+int main(int argc, char** argv) {
+    log::g_min_level = log::Level::WARN;
+
+    double      seconds   = 1.0;
+    size_t      burst     = 256;
+    const char* json_path = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if      (!std::strcmp(argv[i], "--seconds") && i + 1 < argc) seconds = std::atof(argv[++i]);
+        else if (!std::strcmp(argv[i], "--burst")   && i + 1 < argc) burst   = (size_t)std::atol(argv[++i]);
+        else if (!std::strcmp(argv[i], "--quick"))                   seconds = 0.2;
+        else if (!std::strcmp(argv[i], "--json")    && i + 1 < argc) json_path = argv[++i];
+        else {
+            fprintf(stderr, "usage: %s [--seconds S] [--burst N] [--quick] [--json FILE|-]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    // Chat-sized, mid-size, MTU-sized and a full 8 KB file chunk
+    const size_t payloads[] = {64, 512, 1400, MESH_FILE_CHUNK + Crypto::OVERHEAD};
+
+    struct Row { size_t size; RxSample legacy, batched; };
+    std::vector<Row> rows;
+
+    printf("Mesh receive path, bursts of %zu packets on loopback\n", burst);
+    printf("%8s | %12s %8s %9s | %12s %8s %9s | %7s\n", "bytes",
+           "recvfrom pps", "sys/pkt", "alloc/pkt", "recvmmsg pps", "sys/pkt", "alloc/pkt", "speedup");
+
+    for (size_t payload : payloads) {
+        Loopback   l    = open_loopback();
+        ByteBuffer wire = make_packet(payload);
+
+        // Old listener_loop body
+        ByteBuffer buf(65535);
+        RxSample legacy = run(l, wire, burst, seconds, [&] {
+            size_t n = 0, calls = 0;
+            for (;;) {
+                sockaddr_in from{};
+                socklen_t   from_len = sizeof(from);
+                ssize_t r = recvfrom(l.rx, buf.data(), buf.size(), 0, (sockaddr*)&from, &from_len);
+                calls++;
+                if (r <= 0) break;
+                ByteBuffer data(buf.begin(), buf.begin() + r);
+                auto res = MeshPacket::deserialize(data);
+                if (res.ok()) n++;
+            }
+            return std::make_pair(n, calls);
+        });
+
+        mesh_io::RecvBatch batch;
+        RxSample batched = run(l, wire, burst, seconds, [&] {
+            size_t n = 0, calls = 0;
+            for (;;) {
+                int got = batch.recv(l.rx);
+                calls++;
+                if (got <= 0) break;
+                for (size_t i = 0; i < batch.count(); i++) {
+                    auto res = MeshPacketView::parse(batch.packet(i));
+                    if (res.ok()) n++;
+                }
+            }
+            return std::make_pair(n, calls);
+        });
+
+        printf("%8zu | %12.0f %8.3f %9.2f | %12.0f %8.3f %9.2f | %6.2fx\n", wire.size(),
+               legacy.pps, legacy.syscalls_pp, legacy.allocs_pp,
+               batched.pps, batched.syscalls_pp, batched.allocs_pp,
+               legacy.pps > 0 ? batched.pps / legacy.pps : 0);
+        rows.push_back({wire.size(), legacy, batched});
+        close_loopback(l);
+    }
+
+    // ─── Parse ───
+    struct PaRow { size_t size; double copy_ns, view_ns, copy_allocs, view_allocs; };
+    std::vector<PaRow> pa_rows;
+    {
+        const size_t parses = seconds < 0.5 ? 200000 : 1000000;
+        printf("\nPacket parse, %zu parses of one resident packet\n", parses);
+        printf("%8s | %12s %11s | %12s %11s\n", "bytes", "copy ns", "copy alloc", "view ns", "view alloc");
+        for (size_t payload : payloads) {
+            ByteBuffer wire = make_packet(payload);
+            wire.resize(wire.size() + 32, 0xCD);   // a trailing MAC
+            size_t ok = 0;
+
+            size_t a0 = g_allocs.load();
+            auto   t0 = Clock::now();
+            for (size_t k = 0; k < parses; k++) {
+                auto res = MeshPacket::deserialize(wire);
+                ok += res.ok() && res.value.hmac.size() == 32;
+            }
+            double copy_ns     = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / parses;
+            double copy_allocs = (double)(g_allocs.load() - a0) / parses;
+
+            a0 = g_allocs.load();
+            t0 = Clock::now();
+            for (size_t k = 0; k < parses; k++) {
+                auto res = MeshPacketView::parse(ByteSpan(wire));
+                ok += res.ok() && res.value.mac.size() == 32;
+            }
+            double view_ns     = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / parses;
+            double view_allocs = (double)(g_allocs.load() - a0) / parses;
+            if (ok != 2 * parses) printf("  parse mismatch!\n");
+
+            PaRow row{wire.size(), copy_ns, view_ns, copy_allocs, view_allocs};
+            printf("%8zu | %12.1f %11.2f | %12.1f %11.2f\n", row.size, row.copy_ns, row.copy_allocs,
+                   row.view_ns, row.view_allocs);
+            pa_rows.push_back(row);
+        }
+    }
+
+    // ─── Send path ───
+    struct TxRow { const char* mode; double pps, sys_pp; };
+    std::vector<TxRow> tx_rows;
+    {
+        const size_t chunk = MESH_HEADER_SIZE + Crypto::OVERHEAD + MESH_FILE_CHUNK;
+        const size_t file_chunks = 128; // 1 MiB file
+        Loopback     l = open_loopback();
+        ByteBuffer   wire = make_packet(MESH_FILE_CHUNK + Crypto::OVERHEAD);
+        ByteBuffer   sink(65536);
+        auto drain_rx = [&] {
+            while (recv(l.rx, sink.data(), sink.size(), 0) > 0) {}
+        };
+
+        auto time_send = [&](const char* mode, auto&& send_file) {
+            size_t chunks = 0, calls = 0;
+            double timed  = 0;
+            auto   start  = Clock::now();
+            while (std::chrono::duration<double>(Clock::now() - start).count() < seconds) {
+                auto t0 = Clock::now();
+                calls  += send_file();
+                timed  += std::chrono::duration<double>(Clock::now() - t0).count();
+                chunks += file_chunks;
+                drain_rx();
+            }
+            tx_rows.push_back({mode, chunks / timed, (double)calls / chunks});
+        };
+
+        time_send("sendto", [&] {
+            for (size_t i = 0; i < file_chunks; i++) {
+                sendto(l.tx, wire.data(), wire.size(), 0, (sockaddr*)&l.dest, sizeof(l.dest));
+            }
+            return file_chunks;
+        });
+        for (bool gso : {false, true}) {
+            mesh_io::SendBatch batch(64, chunk);
+            batch.set_gso(gso);
+            time_send(gso ? "sendmmsg+gso" : "sendmmsg", [&] {
+                uint64_t c0 = batch.syscalls();
+                for (size_t i = 0; i < file_chunks; i++) {
+                    if (batch.pending() == batch.capacity()) batch.flush(l.tx);
+                    ByteSpan p = batch.push(wire.size(), l.dest);
+                    std::memcpy(p.data(), wire.data(), wire.size());
+                }
+                batch.flush(l.tx);
+                return (size_t)(batch.syscalls() - c0);
+            });
+            if (gso && !batch.gso()) tx_rows.back().mode = "sendmmsg+gso (fell back)";
+        }
+        close_loopback(l);
+
+        printf("\nMesh send path, 1 MiB files as %zu-byte FILE_CHUNK packets\n", wire.size());
+        printf("%-26s %12s %10s\n", "mode", "chunks/s", "sys/chunk");
+        for (const auto& r : tx_rows) printf("%-26s %12.0f %10.3f\n", r.mode, r.pps, r.sys_pp);
+    }
+
+    // ─── Backends: syscalls vs io_uring ───
+    struct BeRow { const char* dir; size_t size; const char* mode; double pps, sys_pp, cpu_ns; };
+    std::vector<BeRow> be_rows;
+    if (!mesh_io::Uring::supported()) {
+        printf("\nio_uring backend: not supported by this kernel, skipped\n");
+    }
+#if VOS_HAVE_IO_URING
+    else {
+        printf("\nBackends, bursts of %zu packets / 1 MiB of file chunks on loopback\n", burst);
+        printf("%4s %8s %-16s | %12s %8s %10s\n", "dir", "bytes", "mode", "pkts/s", "sys/pkt", "cpu ns/pkt");
+        for (size_t payload : {size_t(64), size_t(1400), MESH_FILE_CHUNK + Crypto::OVERHEAD}) {
+            Loopback   l    = open_loopback();
+            ByteBuffer wire = make_packet(payload);
+
+            mesh_io::RecvBatch batch;
+            RxSample mm = run(l, wire, burst, seconds, [&] {
+                size_t n = 0, calls = 0;
+                for (;;) {
+                    int got = batch.recv(l.rx, false);
+                    calls++;
+                    if (got <= 0) break;
+                    for (size_t i = 0; i < batch.count(); i++) n += MeshPacketView::parse(batch.packet(i)).ok();
+                }
+                return std::make_pair(n, calls);
+            });
+            // Buffers for a whole burst, as the socket buffer holds one
+            mesh_io::UringRecv ring(l.rx, burst * 2, wire.size());
+            ring.start();
+            RxSample ur = run(l, wire, burst, seconds, [&] {
+                size_t   n = 0;
+                uint64_t calls0 = ring.syscalls();
+                while (ring.recv() > 0) {
+                    for (size_t i = 0; i < ring.count(); i++) n += MeshPacketView::parse(ring.packet(i)).ok();
+                }
+                return std::make_pair(n, (size_t)(ring.syscalls() - calls0));
+            });
+            for (auto& [mode, r] : {std::make_pair("recvmmsg", mm), std::make_pair("io_uring", ur)}) {
+                be_rows.push_back({"rx", wire.size(), mode, r.pps, r.syscalls_pp, r.cpu_ns_pp});
+            }
+            close_loopback(l);
+        }
+
+        const size_t chunk = MESH_HEADER_SIZE + Crypto::OVERHEAD + MESH_FILE_CHUNK;
+        const size_t file_chunks = 128;
+        Loopback     l    = open_loopback();
+        ByteBuffer   wire = make_packet(MESH_FILE_CHUNK + Crypto::OVERHEAD);
+        ByteBuffer   sink(65536);
+        mesh_io::Uring ring(64);
+        for (bool use_ring : {false, true}) {
+            mesh_io::SendBatch batch(64, chunk);
+            if (use_ring) batch.set_ring(&ring, l.tx);
+            size_t chunks = 0;
+            double timed = 0, cpu = 0;
+            uint64_t calls0 = batch.syscalls();
+            auto start = Clock::now();
+            while (std::chrono::duration<double>(Clock::now() - start).count() < seconds) {
+                double c0 = cpu_seconds();
+                auto   t0 = Clock::now();
+                for (size_t i = 0; i < file_chunks; i++) {
+                    if (batch.pending() == batch.capacity()) batch.flush(l.tx);
+                    ByteSpan p = batch.push(wire.size(), l.dest);
+                    std::memcpy(p.data(), wire.data(), wire.size());
+                }
+                batch.flush(l.tx);
+                timed += std::chrono::duration<double>(Clock::now() - t0).count();
+                cpu   += cpu_seconds() - c0;
+                chunks += file_chunks;
+                while (recv(l.rx, sink.data(), sink.size(), 0) > 0) {}
+            }
+            be_rows.push_back({"tx", wire.size(), use_ring ? "io_uring+gso" : "sendmmsg+gso", chunks / timed,
+                               (double)(batch.syscalls() - calls0) / chunks, cpu * 1e9 / chunks});
+        }
+        close_loopback(l);
+
+        for (const auto& r : be_rows) {
+            printf("%4s %8zu %-16s | %12.0f %8.3f %10.0f\n", r.dir, r.size, r.mode, r.pps, r.sys_pp, r.cpu_ns);
+        }
+    }
+#endif
+
+    // ─── Sender lookup ───
+    struct LkRow { size_t peers; double scan_ns, index_ns, scan_allocs, index_allocs; };
+    std::vector<LkRow> lk_rows;
+    {
+        printf("\nSender lookup per packet: inet_ntop + scan vs MeshAddr index\n");
+        printf("%6s | %10s %10s | %12s %12s\n", "peers", "scan ns", "index ns", "scan allocs", "index allocs");
+        for (size_t peers : {size_t(10), size_t(100), size_t(1000)}) {
+            std::unordered_map<std::string, MeshPeer>               table;
+            std::unordered_map<MeshAddr, std::string, MeshAddrHash> index;
+            std::vector<sockaddr_in>                                from(peers);
+            for (size_t i = 0; i < peers; i++) {
+                std::string ip = "10.0." + std::to_string(i / 250) + "." + std::to_string(i % 250 + 1);
+                MeshPeer&   p  = table["P" + std::to_string(i)];
+                p.peer_id  = "P" + std::to_string(i);
+                p.address  = ip;
+                p.port     = 5055;
+                p.endpoint = MeshAddr::parse(ip, 5055);
+                index[p.endpoint] = p.peer_id;
+                p.endpoint.to_sockaddr(from[i]);
+            }
+            const size_t lookups = peers >= 1000 ? 20000 : 200000;
+            size_t       hits    = 0;
+
+            size_t a0 = g_allocs.load();
+            auto   t0 = Clock::now();
+            for (size_t k = 0; k < lookups; k++) {
+                const sockaddr_in& sa = from[(k * 7919) % peers];
+                char ip[INET_ADDRSTRLEN];
+                inet_ntop(AF_INET, &sa.sin_addr, ip, INET_ADDRSTRLEN);
+                std::string addr(ip);
+                uint16_t    port = ntohs(sa.sin_port);
+                for (const auto& [id, p] : table) {
+                    if (p.address == addr && p.port == port) { hits++; break; }
+                }
+            }
+            double scan_ns     = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / lookups;
+            double scan_allocs = (double)(g_allocs.load() - a0) / lookups;
+
+            a0 = g_allocs.load();
+            t0 = Clock::now();
+            for (size_t k = 0; k < lookups; k++) {
+                auto it = index.find(MeshAddr::from(from[(k * 7919) % peers]));
+                hits += it != index.end();
+            }
+            double index_ns     = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / lookups;
+            double index_allocs = (double)(g_allocs.load() - a0) / lookups;
+            if (hits != 2 * lookups) printf("  lookup mismatch!\n");
+
+            LkRow row{peers, scan_ns, index_ns, scan_allocs, index_allocs};
+            printf("%6zu | %10.1f %10.1f | %12.2f %12.2f\n", row.peers, row.scan_ns, row.index_ns,
+                   row.scan_allocs, row.index_allocs);
+            lk_rows.push_back(row);
+        }
+    }
+
+    // ─── Chat coalescing ───
+    struct ChRow { int64_t window_us; double pkts_pm, macs_pm, msgs_per_s, lat_avg_us; bool ok; };
+    std::vector<ChRow> ch_rows;
+    {
+        const size_t msgs = seconds < 0.5 ? 2000 : 10000;
+        printf("\nChat, %zu 48-byte send_text() messages in bursts of 50\n", msgs);
+        printf("%9s | %8s %8s | %10s %12s\n", "window", "pkt/msg", "MAC/msg", "msgs/s", "avg delay us");
+
+        Crypto crypto;
+        crypto.init();
+        ByteBuffer key = crypto.generate_key();
+        for (int64_t window_us : {int64_t(0), int64_t(2000)}) {
+            MeshNet  a, b;
+            uint16_t pa = free_port(), pb = free_port();
+            bool     ok = a.init(&crypto, pa).ok() && b.init(&crypto, pb).ok();
+            a.set_session_key(key);
+            b.set_session_key(key);
+            a.add_peer("B", "127.0.0.1", pb);
+            a.set_coalesce_window(std::chrono::microseconds(window_us));
+
+            // Each message carries its send time
+            std::atomic<size_t> got{0};
+            std::atomic<double> delay_us{0};
+            b.on_message([&](const std::string&, const ByteBuffer& text) {
+                long long sent_ns = std::atoll(std::string(text.begin(), text.end()).c_str());
+                long long now_ns  = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                        Clock::now().time_since_epoch()).count();
+                delay_us.store(delay_us.load() + (now_ns - sent_ns) / 1e3);
+                got++;
+            });
+
+            auto t0 = Clock::now();
+            for (size_t i = 0; ok && i < msgs; i++) {
+                char text[48];
+                long long now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                       Clock::now().time_since_epoch()).count();
+                std::snprintf(text, sizeof(text), "%lld %-*s", now_ns, 24, "chat");
+                ok = a.send_text("B", std::string(text, 47)).ok();
+                // A short pause between bursts, as people type
+                if (i % 50 == 49) std::this_thread::sleep_for(std::chrono::microseconds(500));
+            }
+            for (int i = 0; i < 2000 && got.load() < msgs; i++) std::this_thread::sleep_for(Millis(1));
+            double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+            ok = ok && got.load() == msgs;
+
+            MeshStats s = a.get_stats();
+            ChRow row{window_us, (double)s.tx_packets / msgs, (double)s.tx_packets / msgs,
+                      got.load() / secs, got.load() ? delay_us.load() / got.load() : 0, ok};
+            printf("%7.1fms | %8.3f %8.3f | %10.0f %12.0f%s\n", window_us / 1e3, row.pkts_pm,
+                   row.macs_pm, row.msgs_per_s, row.lat_avg_us, ok ? "" : "  FAILED");
+            ch_rows.push_back(row);
+            a.shutdown();
+            b.shutdown();
+        }
+    }
+
+    // ─── Reliable transfer goodput ───
+    struct GpRow { double loss, mbps; size_t files; double retx, rto; bool ok; };
+    std::vector<GpRow> gp_rows;
+    {
+        const size_t file_size = seconds < 0.5 ? (2u << 20) : (8u << 20);
+        ByteBuffer   file(file_size);
+        for (size_t i = 0; i < file.size(); i++) file[i] = (uint8_t)(i * 131 + (i >> 13));
+
+        printf("\nReliable send_file goodput, %zu MiB files on loopback\n", file_size >> 20);
+        printf("%6s | %9s %6s | %11s %9s\n", "loss", "MB/s", "files", "retx/file", "rto/file");
+
+        for (double loss : {0.0, 0.01, 0.05, 0.10}) {
+            Crypto    crypto;
+            VirtualFS vfs;
+            MeshNet   a, b;
+            crypto.init();
+            vfs.init();
+            uint16_t pa = free_port(), pb = free_port();
+            bool ok = a.init(&crypto, pa).ok() && b.init(&crypto, pb).ok();
+            ByteBuffer key = crypto.generate_key();
+            a.set_session_key(key);
+            b.set_session_key(key);
+            a.add_peer("B", "127.0.0.1", pb);
+            b.set_file_store(&vfs);
+            a.set_loss_simulation(loss, 0, 1);
+            b.set_loss_simulation(loss, 0, 2);
+
+            size_t files = 0;
+            double timed = 0;
+            auto   start = Clock::now();
+            while (ok && (files == 0 || std::chrono::duration<double>(Clock::now() - start).count() < seconds)) {
+                auto t0 = Clock::now();
+                ok = a.send_file("B", "bench.bin", file).ok();
+                timed += std::chrono::duration<double>(Clock::now() - t0).count();
+                if (ok) files++;
+            }
+            auto rd = vfs.read_file("/home/downloads/bench.bin");
+            ok = ok && rd.ok() && rd.value == file;
+
+            MeshStats s = a.get_stats();
+            GpRow row{loss, files ? files * file_size / timed / 1e6 : 0, files,
+                      files ? (double)s.file_retransmits / files : 0,
+                      files ? (double)s.file_timeouts / files : 0, ok};
+            printf("%5.0f%% | %9.1f %6zu | %11.1f %9.2f%s\n", loss * 100, row.mbps, row.files,
+                   row.retx, row.rto, ok ? "" : "  FAILED");
+            gp_rows.push_back(row);
+            a.shutdown();
+            b.shutdown();
+        }
+    }
+
+    // ─── Multi-peer download ───
+    struct DlRow { size_t peers; double secs, mbps; bool ok; };
+    std::vector<DlRow> dl_rows;
+    {
+        const size_t file_size = seconds < 0.5 ? (1u << 20) : (4u << 20);
+        const double uplink    = 4e6;
+        ByteBuffer   file(file_size);
+        for (size_t i = 0; i < file.size(); i++) file[i] = (uint8_t)(i * 167 + (i >> 11));
+
+        printf("\nMulti-peer download_file, %zu MiB file, each source paced to %.0f MB/s\n",
+               file_size >> 20, uplink / 1e6);
+        printf("%6s | %8s %9s\n", "peers", "seconds", "MB/s");
+
+        Crypto crypto;
+        crypto.init();
+        ByteBuffer key = crypto.generate_key();
+        for (size_t peers = 1; peers <= 3; peers++) {
+            VirtualFS                vfs[4];
+            MeshNet                  net[4];
+            uint16_t                 port[4];
+            std::vector<std::string> ids;
+            bool ok = true;
+            for (size_t i = 0; i < 4; i++) {
+                vfs[i].init();
+                port[i] = free_port();
+                ok = ok && net[i].init(&crypto, port[i]).ok();
+                net[i].set_session_key(key);
+                net[i].set_file_store(&vfs[i]);
+            }
+            for (size_t i = 1; i <= peers; i++) {
+                std::string id = "S" + std::to_string(i);
+                vfs[i].write_file("/home/downloads/dl.bin", file);
+                net[i].set_rate_simulation(uplink);
+                net[0].add_peer(id, "127.0.0.1", port[i]);
+                ids.push_back(id);
+            }
+
+            auto t0 = Clock::now();
+            ok = ok && net[0].download_file("dl.bin", ids).ok();
+            double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+            auto   rd   = vfs[0].read_file("/home/downloads/dl.bin");
+            ok = ok && rd.ok() && rd.value == file;
+
+            DlRow row{peers, secs, file_size / secs / 1e6, ok};
+            printf("%6zu | %8.2f %9.1f%s\n", row.peers, row.secs, row.mbps, ok ? "" : "  FAILED");
+            dl_rows.push_back(row);
+            for (auto& n : net) n.shutdown();
+        }
+    }
+
+    if (json_path) {
+        FILE* f = std::strcmp(json_path, "-") == 0 ? stdout : std::fopen(json_path, "w");
+        if (!f) {
+            fprintf(stderr, "cannot write %s\n", json_path);
+            return 1;
+        }
+        fprintf(f, "{\n  \"bench\": \"mesh_io\",\n  \"burst\": %zu,\n  \"results\": [\n", burst);
+        for (size_t i = 0; i < rows.size(); i++) {
+            const Row& r = rows[i];
+            fprintf(f, "    {\"size\": %zu, \"recvfrom_pps\": %.0f, \"recvmmsg_pps\": %.0f, "
+                       "\"recvfrom_allocs_per_pkt\": %.2f, \"recvmmsg_allocs_per_pkt\": %.2f}%s\n",
+                    r.size, r.legacy.pps, r.batched.pps, r.legacy.allocs_pp, r.batched.allocs_pp,
+                    i + 1 < rows.size() ? "," : "");
+        }
+        fprintf(f, "  ],\n  \"parse\": [\n");
+        for (size_t i = 0; i < pa_rows.size(); i++) {
+            const PaRow& r = pa_rows[i];
+            fprintf(f, "    {\"size\": %zu, \"copy_ns\": %.1f, \"view_ns\": %.1f, "
+                       "\"copy_allocs_per_pkt\": %.2f, \"view_allocs_per_pkt\": %.2f}%s\n",
+                    r.size, r.copy_ns, r.view_ns, r.copy_allocs, r.view_allocs,
+                    i + 1 < pa_rows.size() ? "," : "");
+        }
+        fprintf(f, "  ],\n  \"send\": [\n");
+        for (size_t i = 0; i < tx_rows.size(); i++) {
+            fprintf(f, "    {\"mode\": \"%s\", \"chunks_per_s\": %.0f, \"syscalls_per_chunk\": %.3f}%s\n",
+                    tx_rows[i].mode, tx_rows[i].pps, tx_rows[i].sys_pp,
+                    i + 1 < tx_rows.size() ? "," : "");
+        }
+        fprintf(f, "  ],\n  \"backends\": [\n");
+        for (size_t i = 0; i < be_rows.size(); i++) {
+            const BeRow& r = be_rows[i];
+            fprintf(f, "    {\"dir\": \"%s\", \"size\": %zu, \"mode\": \"%s\", \"pps\": %.0f, "
+                       "\"syscalls_per_pkt\": %.3f, \"cpu_ns_per_pkt\": %.0f}%s\n",
+                    r.dir, r.size, r.mode, r.pps, r.sys_pp, r.cpu_ns, i + 1 < be_rows.size() ? "," : "");
+        }
+        fprintf(f, "  ],\n  \"lookup\": [\n");
+        for (size_t i = 0; i < lk_rows.size(); i++) {
+            const LkRow& r = lk_rows[i];
+            fprintf(f, "    {\"peers\": %zu, \"scan_ns\": %.1f, \"index_ns\": %.1f, "
+                       "\"scan_allocs\": %.2f, \"index_allocs\": %.2f}%s\n",
+                    r.peers, r.scan_ns, r.index_ns, r.scan_allocs, r.index_allocs,
+                    i + 1 < lk_rows.size() ? "," : "");
+        }
+        fprintf(f, "  ],\n  \"chat\": [\n");
+        for (size_t i = 0; i < ch_rows.size(); i++) {
+            const ChRow& r = ch_rows[i];
+            fprintf(f, "    {\"window_us\": %lld, \"packets_per_msg\": %.3f, \"macs_per_msg\": %.3f, "
+                       "\"msgs_per_s\": %.0f, \"avg_delay_us\": %.0f, \"ok\": %s}%s\n",
+                    (long long)r.window_us, r.pkts_pm, r.macs_pm, r.msgs_per_s, r.lat_avg_us,
+                    r.ok ? "true" : "false", i + 1 < ch_rows.size() ? "," : "");
+        }
+        fprintf(f, "  ],\n  \"goodput\": [\n");
+        for (size_t i = 0; i < gp_rows.size(); i++) {
+            const GpRow& r = gp_rows[i];
+            fprintf(f, "    {\"loss\": %.2f, \"mb_per_s\": %.1f, \"retransmits_per_file\": %.1f, "
+                       "\"timeouts_per_file\": %.2f, \"ok\": %s}%s\n",
+                    r.loss, r.mbps, r.retx, r.rto, r.ok ? "true" : "false",
+                    i + 1 < gp_rows.size() ? "," : "");
+        }
+        fprintf(f, "  ],\n  \"download\": [\n");
+        for (size_t i = 0; i < dl_rows.size(); i++) {
+            const DlRow& r = dl_rows[i];
+            fprintf(f, "    {\"peers\": %zu, \"seconds\": %.3f, \"mb_per_s\": %.1f, \"ok\": %s}%s\n",
+                    r.peers, r.secs, r.mbps, r.ok ? "true" : "false",
+                    i + 1 < dl_rows.size() ? "," : "");
+        }
+        fprintf(f, "  ]\n}\n");
+        if (f != stdout) std::fclose(f);
+    }
+    return 0;
+}
+
+#else
+
+int main() {
+    printf("vos_bench_mesh_io: recvmmsg comparison is not available on Windows\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,272 @@
+/*
+ * VOS Benchmark — Mesh receive load from many senders
+ *
+ * A loopback load generator for a MeshNet receiver spread over 1, 2 and 4
+ * SO_REUSEPORT receive shards (MeshNet::set_rx_shards).
+ *
+ * Blast: K sender threads, each with its own socket, send sealed 8 KB
+ * FILE_CHUNK packets as fast as SendBatch flushes them. The receiver
+ * decrypts and dispatches every one (they belong to no transfer, so
+ * nothing is written). Reported: packets the receiver took per second,
+ * the share the kernel dropped, and how the shards split the load.
+ *
+ * Files: K MeshNet senders run send_file() into the receiver at the same
+ * time; reported is the aggregate goodput.
+ *
+ * Throughput scales with shards only up to the cores there are to run
+ * them; on one core the rows show the overhead of sharding instead.
+ *
+ *   vos_bench_mesh_load [--senders K] [--shards N] [--seconds S] [--quick] [--json FILE|-]
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include "core/mesh_net.h"
+#include "core/mesh_io.h"
+#include "core/crypto_session.h"
+#include "core/mesh_transfer.h"
+#include "core/vfs.h"
+#include "vos/log.h"
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <unistd.h>
+#endif
+
+using namespace vos;
+
+#ifndef _WIN32
+
+// An ephemeral port that is free right now
+static uint16_t free_port() {
+    int         fd = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(fd, (sockaddr*)&addr, sizeof(addr));
+    socklen_t len = sizeof(addr);
+    getsockname(fd, (sockaddr*)&addr, &len);
+    close(fd);
+    return ntohs(addr.sin_port);
+}
+
+// A sealed FILE_CHUNK for a transfer the receiver does not know
+static ByteBuffer sealed_chunk(const CryptoSession& session, uint32_t index) {
+    const size_t plain_len   = mesh_xfer::CHUNK_FIXED + MESH_FILE_CHUNK;
+    const size_t payload_len = Crypto::OVERHEAD + plain_len;
+    ByteBuffer   wire(MESH_HEADER_SIZE + payload_len, 0x5A);
+    MeshPacket::write_header(wire.data(), MeshMsgType::FILE_CHUNK, (uint32_t)payload_len);
+
+    uint8_t* plain = wire.data() + MESH_HEADER_SIZE + Crypto::NONCE_SIZE;
+    uint32_t id = 0xB1A57000u, ts = 0;
+    std::memcpy(plain, &id, 4);
+    std::memcpy(plain + 4, &index, 4);
+    std::memcpy(plain + 8, &ts, 4);
+    session.seal_in_place(ByteSpan(wire.data() + MESH_HEADER_SIZE, payload_len));
+    return wire;
+}
+
+struct BlastRow { size_t shards; double pps, mbps, loss; std::vector<uint64_t> split; };
+
+static BlastRow blast(Crypto& crypto, const ByteBuffer& key, size_t shards, size_t senders,
+                      double seconds) {
+    MeshNet rx;
+    rx.set_rx_shards(shards);
+    uint16_t port = free_port();
+    rx.init(&crypto, port);
+    rx.set_session_key(key);
+
+    // Sixteen distinct packets per sender, sent round and round
+    CryptoSession session(key);
+    std::vector<ByteBuffer> wire;
+    for (uint32_t i = 0; i < 16; i++) wire.push_back(sealed_chunk(session, i));
+
+    sockaddr_in dest{};
+    dest.sin_family      = AF_INET;
+    dest.sin_port        = htons(port);
+    dest.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    std::atomic<bool>     stop{false};
+    std::atomic<uint64_t> sent{0};
+    std::vector<std::thread> threads;
+    MeshStats before = rx.get_stats();
+    for (size_t s = 0; s < senders; s++) {
+        threads.emplace_back([&] {
+            int fd = socket(AF_INET, SOCK_DGRAM, 0);
+            mesh_io::SendBatch batch(32, wire[0].size());
+            uint64_t n = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                for (size_t k = 0; k < batch.capacity(); k++) {
+                    const ByteBuffer& w = wire[(n + k) % wire.size()];
+                    ByteSpan out = batch.push(w.size(), dest);
+                    std::memcpy(out.data(), w.data(), w.size());
+                }
+                auto r = batch.flush(fd);
+                n += r.ok() ? r.value : 0;
+            }
+            sent.fetch_add(n);
+            close(fd);
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop.store(true);
+    for (auto& t : threads) t.join();
+    // Let the shards finish what is queued
+    for (int i = 0; i < 200; i++) {
+        uint64_t n0 = rx.get_stats().rx_packets;
+        std::this_thread::sleep_for(Millis(5));
+        if (rx.get_stats().rx_packets == n0) break;
+    }
+    MeshStats after = rx.get_stats();
+    rx.shutdown();
+
+    BlastRow row;
+    uint64_t got = after.rx_packets - before.rx_packets;
+    row.shards   = shards;
+    row.pps      = got / seconds;
+    row.mbps     = got * (double)MESH_FILE_CHUNK / seconds / 1e6;
+    row.loss     = sent.load() ? 1.0 - (double)got / sent.load() : 0;
+    for (size_t i = 0; i < after.shard_rx_packets.size(); i++)
+        row.split.push_back(after.shard_rx_packets[i] -
+                            (i < before.shard_rx_packets.size() ? before.shard_rx_packets[i] : 0));
+    return row;
+}
+
+struct FileRow { size_t shards; double secs, mbps; bool ok; };
+
+static FileRow files(Crypto& crypto, const ByteBuffer& key, size_t shards, size_t senders,
+                     const ByteBuffer& file) {
+    VirtualFS vfs;
+    MeshNet   rx;
+    vfs.init();
+    rx.set_rx_shards(shards);
+    uint16_t port = free_port();
+    bool     ok   = rx.init(&crypto, port).ok();
+    rx.set_session_key(key);
+    rx.set_file_store(&vfs);
+
+    std::vector<std::unique_ptr<MeshNet>> tx;
+    for (size_t s = 0; s < senders; s++) {
+        tx.emplace_back(new MeshNet);
+        ok = ok && tx[s]->init(&crypto, free_port()).ok();
+        tx[s]->set_session_key(key);
+        tx[s]->add_peer("RX", "127.0.0.1", port);
+    }
+
+    std::atomic<int>         failed{0};
+    std::vector<std::thread> threads;
+    auto t0 = Clock::now();
+    for (size_t s = 0; s < senders; s++) {
+        threads.emplace_back([&, s] {
+            if (!tx[s]->send_file("RX", "load" + std::to_string(s) + ".bin", file).ok()) failed++;
+        });
+    }
+    for (auto& t : threads) t.join();
+    double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+
+    ok = ok && failed.load() == 0;
+    for (size_t s = 0; ok && s < senders; s++) {
+        auto rd = vfs.read_file("/home/downloads/load" + std::to_string(s) + ".bin");
+        ok = rd.ok() && rd.value == file;
+    }
+    for (auto& n : tx) n->shutdown();
+    rx.shutdown();
+    return FileRow{shards, secs, senders * file.size() / secs / 1e6, ok};
+}
+
+int main(int argc, char** argv) {
+    log::g_min_level = log::Level::WARN;
+
+    double      seconds   = 1.0;
+    size_t      senders   = 8;
+    size_t      only      = 0;
+    const char* json_path = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if      (!std::strcmp(argv[i], "--seconds") && i + 1 < argc) seconds = std::atof(argv[++i]);
+        else if (!std::strcmp(argv[i], "--senders") && i + 1 < argc) senders = (size_t)std::atol(argv[++i]);
+        else if (!std::strcmp(argv[i], "--shards")  && i + 1 < argc) only    = (size_t)std::atol(argv[++i]);
+        else if (!std::strcmp(argv[i], "--quick"))                   seconds = 0.2;
+        else if (!std::strcmp(argv[i], "--json")    && i + 1 < argc) json_path = argv[++i];
+        else {
+            fprintf(stderr, "usage: %s [--senders K] [--shards N] [--seconds S] [--quick] [--json FILE|-]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    if (senders == 0) senders = 1;
+    std::vector<size_t> shard_counts = only ? std::vector<size_t>{only} : std::vector<size_t>{1, 2, 4};
+
+    Crypto crypto;
+    crypto.init();
+    ByteBuffer key = crypto.generate_key();
+    printf("%u CPUs\n", std::thread::hardware_concurrency());
+
+    // ─── Blast ───
+    std::vector<BlastRow> blast_rows;
+    printf("\nReceive load: %zu senders blasting 8 KB FILE_CHUNKs for %.1f s\n", senders, seconds);
+    printf("%6s | %10s %8s %6s | %s\n", "shards", "rx pps", "MB/s", "loss", "per shard");
+    for (size_t n : shard_counts) {
+        BlastRow row = blast(crypto, key, n, senders, seconds);
+        printf("%6zu | %10.0f %8.1f %5.1f%% |", row.shards, row.pps, row.mbps, row.loss * 100);
+        for (uint64_t p : row.split) printf(" %llu", (unsigned long long)p);
+        printf("\n");
+        blast_rows.push_back(row);
+    }
+
+    // ─── Concurrent send_file ───
+    std::vector<FileRow> file_rows;
+    {
+        const size_t file_size = seconds < 0.5 ? (512u << 10) : (2u << 20);
+        ByteBuffer   file(file_size);
+        for (size_t i = 0; i < file.size(); i++) file[i] = (uint8_t)(i * 151 + (i >> 12));
+
+        printf("\nConcurrent send_file: %zu senders x %zu KiB\n", senders, file_size >> 10);
+        printf("%6s | %8s %9s\n", "shards", "seconds", "MB/s");
+        for (size_t n : shard_counts) {
+            FileRow row = files(crypto, key, n, senders, file);
+            printf("%6zu | %8.2f %9.1f%s\n", row.shards, row.secs, row.mbps, row.ok ? "" : "  FAILED");
+            file_rows.push_back(row);
+        }
+    }
+
+    if (json_path) {
+        FILE* f = std::strcmp(json_path, "-") == 0 ? stdout : std::fopen(json_path, "w");
+        if (!f) {
+            fprintf(stderr, "cannot write %s\n", json_path);
+            return 1;
+        }
+        fprintf(f, "{\n  \"bench\": \"mesh_load\",\n  \"senders\": %zu,\n  \"cpus\": %u,\n  \"blast\": [\n",
+                senders, std::thread::hardware_concurrency());
+        for (size_t i = 0; i < blast_rows.size(); i++) {
+            const BlastRow& r = blast_rows[i];
+            fprintf(f, "    {\"shards\": %zu, \"rx_pps\": %.0f, \"mb_per_s\": %.1f, \"loss\": %.4f, \"per_shard\": [",
+                    r.shards, r.pps, r.mbps, r.loss);
+            for (size_t k = 0; k < r.split.size(); k++)
+                fprintf(f, "%s%llu", k ? ", " : "", (unsigned long long)r.split[k]);
+            fprintf(f, "]}%s\n", i + 1 < blast_rows.size() ? "," : "");
+        }
+        fprintf(f, "  ],\n  \"files\": [\n");
+        for (size_t i = 0; i < file_rows.size(); i++) {
+            const FileRow& r = file_rows[i];
+            fprintf(f, "    {\"shards\": %zu, \"seconds\": %.3f, \"mb_per_s\": %.1f, \"ok\": %s}%s\n",
+                    r.shards, r.secs, r.mbps, r.ok ? "true" : "false", i + 1 < file_rows.size() ? "," : "");
+        }
+        fprintf(f, "  ]\n}\n");
+        if (f != stdout) std::fclose(f);
+    }
+    return 0;
+}
+
+#else
+
+int main() {
+    printf("vos_bench_mesh_load: SO_REUSEPORT sharding is not available on Windows\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,313 @@
+/*
+ * VOS Benchmark — VFS Persistence
+ *
+ * Generates synthetic VFS trees and measures save/load throughput,
+ * peak RSS and time-to-first-read.
+ *
+ *   vos_bench_persist                 run all tree shapes
+ *   vos_bench_persist --quick         smaller trees (CI / smoke)
+ *   vos_bench_persist --stress N      N randomized save/load round-trips
+ *   vos_bench_persist --seed S        RNG seed for tree generation
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <map>
+#include <random>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include "core/vfs.h"
+#include "core/vfs_persist.h"
+#include "core/crypto.h"
+#include "vos/log.h"
+
+#ifdef __linux__
+#include <fstream>
+#endif
+
+using namespace vos;
+
+// ─── Helpers ─────────────────────────────────────────────────
+
+static double seconds_since(TimePoint t0) {
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+// Reset the kernel's peak-RSS watermark so each scenario reports its own peak.
+static void reset_peak_rss() {
+#ifdef __linux__
+    std::ofstream f("/proc/self/clear_refs");
+    if (f.is_open()) f << "5";
+#endif
+}
+
+static size_t peak_rss_kb() {
+#ifdef __linux__
+    std::ifstream f("/proc/self/status");
+    std::string line;
+    while (std::getline(f, line)) {
+        if (line.rfind("VmHWM:", 0) == 0) {
+            return (size_t)std::strtoull(line.c_str() + 6, nullptr, 10);
+        }
+    }
+#endif
+    return 0;
+}
+
+static ByteBuffer random_data(std::mt19937_64& rng, size_t n) {
+    ByteBuffer b(n);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint64_t v = rng();
+        std::memcpy(b.data() + i, &v, 8);
+    }
+    for (; i < n; i++) b[i] = (uint8_t)rng();
+    return b;
+}
+
+// ─── Tree Generators ─────────────────────────────────────────
+
+static void gen_many_small(VirtualFS& vfs, std::mt19937_64& rng, size_t files) {
+    std::uniform_int_distribution<size_t> size_dist(16, 2048);
+    for (size_t d = 0; d < 64; d++) {
+        vfs.mkdir("/home/d" + std::to_string(d));
+    }
+    for (size_t i = 0; i < files; i++) {
+        std::string path = "/home/d" + std::to_string(i % 64) + "/f" + std::to_string(i) + ".txt";
+        vfs.write_file(path, random_data(rng, size_dist(rng)));
+    }
+}
+
+static void gen_few_huge(VirtualFS& vfs, std::mt19937_64& rng, size_t files, size_t file_size) {
+    for (size_t i = 0; i < files; i++) {
+        vfs.write_file("/home/huge" + std::to_string(i) + ".bin", random_data(rng, file_size));
+    }
+}
+
+static void gen_deep(VirtualFS& vfs, std::mt19937_64& rng, size_t branches, size_t depth) {
+    std::uniform_int_distribution<size_t> size_dist(64, 4096);
+    for (size_t b = 0; b < branches; b++) {
+        std::string path = "/home/b" + std::to_string(b);
+        vfs.mkdir(path);
+        for (size_t d = 0; d < depth; d++) {
+            path += "/level" + std::to_string(d);
+            vfs.mkdir(path);
+            vfs.write_file(path + "/data.bin", random_data(rng, size_dist(rng)));
+        }
+    }
+}
+
+// Random shape mixing all of the above, sized for fast round-trips.
+static void gen_random(VirtualFS& vfs, std::mt19937_64& rng) {
+    std::uniform_int_distribution<int>    n_dist(0, 40);
+    std::uniform_int_distribution<int>    depth_dist(0, 12);
+    std::uniform_int_distribution<size_t> size_dist(0, 4096);
+    std::uniform_int_distribution<int>    coin(0, 9);
+
+    int n = n_dist(rng);
+    for (int i = 0; i < n; i++) {
+        std::string path = "/home";
+        int depth = depth_dist(rng);
+        for (int d = 0; d < depth; d++) {
+            path += "/n" + std::to_string(rng() % 8);
+            if (!vfs.exists(path)) vfs.mkdir(path);
+        }
+        if (coin(rng) == 0) {
+            vfs.mkdir(path + "/empty" + std::to_string(i));
+            continue;
+        }
+        // Occasionally a large file or an empty one
+        size_t sz = size_dist(rng);
+        if (coin(rng) == 0) sz = 64 * 1024 + (rng() % (256 * 1024));
+        if (coin(rng) == 1) sz = 0;
+        vfs.write_file(path + "/file" + std::to_string(i), random_data(rng, sz));
+    }
+}
+
+// ─── State Comparison ────────────────────────────────────────
+
+static std::map<std::string, const VFSEntry*> index_entries(const VirtualFS& vfs,
+                                                            std::vector<VFSEntry>& storage) {
+    storage.clear();
+    vfs.for_each_entry([&](const VFSEntry& e) { storage.push_back(e); });
+    std::map<std::string, const VFSEntry*> idx;
+    for (const auto& e : storage) idx[e.name] = &e;
+    return idx;
+}
+
+static bool same_state(const VirtualFS& a, const VirtualFS& b, std::string& why) {
+    std::vector<VFSEntry> sa, sb;
+    auto ia = index_entries(a, sa);
+    auto ib = index_entries(b, sb);
+    if (ia.size() != ib.size()) {
+        why = "entry count " + std::to_string(ia.size()) + " != " + std::to_string(ib.size());
+        return false;
+    }
+    for (const auto& [path, ea] : ia) {
+        auto it = ib.find(path);
+        if (it == ib.end()) { why = "missing " + path; return false; }
+        const VFSEntry* eb = it->second;
+        if (ea->is_dir != eb->is_dir || ea->data != eb->data ||
+            ea->created != eb->created || ea->modified != eb->modified) {
+            why = "mismatch at " + path;
+            return false;
+        }
+    }
+    return true;
+}
+
+// ─── Scenarios ───────────────────────────────────────────────
+
+struct Scenario {
+    const char* name;
+    std::function<void(VirtualFS&, std::mt19937_64&)> gen;
+};
+
+static int run_bench(uint64_t seed, bool quick) {
+    Crypto crypto;
+    crypto.init();
+    VFSPersistence persist(&crypto);
+    ByteBuffer key = crypto.generate_key();
+
+    std::string file = (std::filesystem::temp_directory_path() / "vos_bench_persist.vfs").string();
+
+    size_t small_files = quick ? 2000 : 50000;
+    size_t huge_files  = quick ? 2 : 4;
+    size_t huge_size   = quick ? (4u << 20) : (64u << 20);
+    size_t branches    = quick ? 4 : 16;
+    size_t depth       = quick ? 32 : 128;
+
+    std::vector<Scenario> scenarios = {
+        { "many_small", [&](VirtualFS& v, std::mt19937_64& r) { gen_many_small(v, r, small_files); } },
+        { "few_huge",   [&](VirtualFS& v, std::mt19937_64& r) { gen_few_huge(v, r, huge_files, huge_size); } },
+        { "deep",       [&](VirtualFS& v, std::mt19937_64& r) { gen_deep(v, r, branches, depth); } },
+    };
+
+    printf("%-12s %8s %10s %10s %10s %10s %10s %12s\n",
+           "scenario", "entries", "MiB", "save MB/s", "load MB/s", "save RSS", "load RSS", "first read");
+
+    for (const auto& sc : scenarios) {
+        std::mt19937_64 rng(seed);
+        std::string probe;
+        size_t bytes = 0, entries = 0, save_rss = 0, load_rss = 0;
+        double save_s = 0, load_s = 0, first_read_s = 0;
+
+        {
+            VirtualFS vfs;
+            vfs.init();
+            sc.gen(vfs, rng);
+            bytes   = vfs.total_size();
+            vfs.for_each_entry([&](const VFSEntry& e) {
+                entries++;
+                if (probe.empty() && !e.is_dir) probe = e.name;
+            });
+
+            reset_peak_rss();
+            auto t0 = Clock::now();
+            auto r = persist.save(file, vfs, key);
+            save_s = seconds_since(t0);
+            save_rss = peak_rss_kb();
+            if (!r.ok()) {
+                fprintf(stderr, "%s: save failed: %s\n", sc.name, status_to_string(r.status));
+                return 1;
+            }
+        }
+
+        {
+            VirtualFS loaded;
+            reset_peak_rss();
+            auto t0 = Clock::now();
+            auto r = persist.load(file, loaded, key);
+            load_s = seconds_since(t0);
+            if (!r.ok()) {
+                fprintf(stderr, "%s: load failed: %s\n", sc.name, status_to_string(r.status));
+                return 1;
+            }
+            if (!probe.empty() && !loaded.read_file(probe).ok()) {
+                fprintf(stderr, "%s: first read of %s failed\n", sc.name, probe.c_str());
+                return 1;
+            }
+            first_read_s = seconds_since(t0);
+            load_rss = peak_rss_kb();
+        }
+
+        double mib = (double)bytes / (1024.0 * 1024.0);
+        printf("%-12s %8zu %10.1f %10.1f %10.1f %8zuMB %8zuMB %10.2fms\n",
+               sc.name, entries, mib,
+               (double)bytes / 1e6 / save_s, (double)bytes / 1e6 / load_s,
+               save_rss / 1024, load_rss / 1024, first_read_s * 1e3);
+    }
+
+    std::filesystem::remove(file);
+    return 0;
+}
+
+static int run_stress(uint64_t seed, int rounds) {
+    Crypto crypto;
+    crypto.init();
+    VFSPersistence persist(&crypto);
+
+    std::string file = (std::filesystem::temp_directory_path() /
+                        ("vos_stress_persist_" + std::to_string(seed) + ".vfs")).string();
+    std::mt19937_64 rng(seed);
+
+    for (int i = 0; i < rounds; i++) {
+        ByteBuffer key = crypto.generate_key();
+
+        VirtualFS saved;
+        saved.init();
+        gen_random(saved, rng);
+
+        auto s = persist.save(file, saved, key);
+        if (!s.ok()) {
+            fprintf(stderr, "[FAIL] round %d: save: %s\n", i, status_to_string(s.status));
+            return 1;
+        }
+
+        VirtualFS loaded;
+        auto l = persist.load(file, loaded, key);
+        if (!l.ok()) {
+            fprintf(stderr, "[FAIL] round %d: load: %s\n", i, status_to_string(l.status));
+            return 1;
+        }
+
+        std::string why;
+        if (!same_state(saved, loaded, why)) {
+            fprintf(stderr, "[FAIL] round %d (seed %llu): %s\n",
+                    i, (unsigned long long)seed, why.c_str());
+            return 1;
+        }
+    }
+
+    std::filesystem::remove(file);
+    printf("[PASS] %d randomized persistence round-trips (seed %llu)\n",
+           rounds, (unsigned long long)seed);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    log::g_min_level = log::Level::WARN;
+
+    uint64_t seed   = 0x564F53;
+    int      stress = 0;
+    bool     quick  = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--stress") && i + 1 < argc) {
+            stress = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--seed") && i + 1 < argc) {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "--quick")) {
+            quick = true;
+        } else {
+            fprintf(stderr, "usage: %s [--quick] [--seed S] [--stress N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (stress > 0) return run_stress(seed, stress);
+    return run_bench(seed, quick);
+}
@@ -12,6 +12,7 @@
 #include <memory>
 #include <chrono>
 #include <mutex>
+#include <type_traits>
 
 namespace vos {
 
@@ -28,7 +29,8 @@ enum class StatusCode {
     ERR_ALREADY_EXISTS,
     ERR_NOT_INITIALIZED,
     ERR_LOCKDOWN_ACTIVE,
-    ERR_INTERNAL
+    ERR_INTERNAL,
+    ERR_CANCELLED
 };
 
 inline const char* status_to_string(StatusCode s) {
@@ -45,6 +47,7 @@ inline const char* status_to_string(StatusCode s) {
         case StatusCode::ERR_NOT_INITIALIZED:return "Not Initialized";
         case StatusCode::ERR_LOCKDOWN_ACTIVE:return "Lockdown Active";
         case StatusCode::ERR_INTERNAL:       return "Internal Error";
+        case StatusCode::ERR_CANCELLED:      return "Cancelled";
         default:                             return "Unknown";
     }
 }
@@ -78,6 +81,44 @@ using Millis    = std::chrono::milliseconds;
 // ─── Byte Buffer ─────────────────────────────────────────────
 using ByteBuffer = std::vector<uint8_t>;
 
+// ─── Byte Spans ──────────────────────────────────────────────
+// Non-owning views for the allocation-free paths (no std::span in C++17).
+template<typename T>
+class BasicByteSpan {
+public:
+    BasicByteSpan() = default;
+    BasicByteSpan(T* data, size_t size) : m_data(data), m_size(size) {}
+    BasicByteSpan(ByteBuffer& b) : m_data(b.data()), m_size(b.size()) {}
+
+    // Mutable span converts to const span, never the reverse
+    template<typename U = T, typename = std::enable_if_t<std::is_const<U>::value>>
+    BasicByteSpan(const ByteBuffer& b) : m_data(b.data()), m_size(b.size()) {}
+    template<typename U = T, typename = std::enable_if_t<std::is_const<U>::value>>
+    BasicByteSpan(const BasicByteSpan<uint8_t>& s) : m_data(s.data()), m_size(s.size()) {}
+
+    T*     data()  const { return m_data; }
+    size_t size()  const { return m_size; }
+    bool   empty() const { return m_size == 0; }
+    T*     begin() const { return m_data; }
+    T*     end()   const { return m_data + m_size; }
+    T&     operator[](size_t i) const { return m_data[i]; }
+
+    BasicByteSpan subspan(size_t offset, size_t count = SIZE_MAX) const {
+        if (offset > m_size) offset = m_size;
+        if (count > m_size - offset) count = m_size - offset;
+        return { m_data + offset, count };
+    }
+
+    ByteBuffer to_buffer() const { return ByteBuffer(begin(), end()); }
+
+private:
+    T*     m_data{nullptr};
+    size_t m_size{0};
+};
+
+using ByteSpan      = BasicByteSpan<uint8_t>;
+using ConstByteSpan = BasicByteSpan<const uint8_t>;
+
 // ─── Process / App IDs ───────────────────────────────────────
 using ProcessId = uint32_t;
 using AppId     = uint16_t;
@@ -0,0 +1,213 @@
+#include "aead.h"
+#include "poly1305.h"
+#include <algorithm>
+#include <cstring>
+
+namespace vos {
+namespace aead {
+
+// RFC 8439 §2.8 tag from the one-time key (first 32 bytes of block 0)
+static void poly_tag(const uint8_t otk[32], const uint8_t* aad, size_t aad_len,
+                     const uint8_t* ct, size_t len, uint8_t tag[TAG_SIZE]) {
+    static const uint8_t zeros[16] = {};
+
+    Poly1305 mac(otk);
+    mac.update(aad, aad_len);
+    if (aad_len % 16) mac.update(zeros, 16 - aad_len % 16);
+    mac.update(ct, len);
+    if (len % 16) mac.update(zeros, 16 - len % 16);
+
+    uint8_t lens[16];
+    uint64_t a = aad_len, c = len;
+    for (int i = 0; i < 8; i++) {
+        lens[i]     = (uint8_t)(a >> (8 * i));
+        lens[8 + i] = (uint8_t)(c >> (8 * i));
+    }
+    mac.update(lens, 16);
+    mac.finish(tag);
+}
+
+static void wipe(uint8_t* p, size_t len) {
+    volatile uint8_t* v = p;
+    for (size_t i = 0; i < len; i++) v[i] = 0;
+}
+
+static void compute_tag(const chacha20::KeySchedule& ks, const uint8_t nonce[NONCE_SIZE],
+                        const uint8_t* aad, size_t aad_len,
+                        const uint8_t* ct, size_t len, uint8_t tag[TAG_SIZE]) {
+    // One-time Poly1305 key = first half of keystream block 0
+    uint8_t otk[chacha20::BLOCK_SIZE];
+    chacha20::block(ks, nonce, 0, otk);
+    poly_tag(otk, aad, aad_len, ct, len, tag);
+    wipe(otk, sizeof(otk));
+}
+
+void chacha20_poly1305_seal(const chacha20::KeySchedule& ks, const uint8_t nonce[NONCE_SIZE],
+                            const uint8_t* aad, size_t aad_len,
+                            const uint8_t* in, uint8_t* out, size_t len,
+                            uint8_t tag[TAG_SIZE], chacha20::Impl impl) {
+    chacha20::xor_stream(ks, nonce, 1, in, out, len, impl);
+    compute_tag(ks, nonce, aad, aad_len, out, len, tag);
+}
+
+bool chacha20_poly1305_open(const chacha20::KeySchedule& ks, const uint8_t nonce[NONCE_SIZE],
+                            const uint8_t* aad, size_t aad_len,
+                            const uint8_t* in, uint8_t* out, size_t len,
+                            const uint8_t tag[TAG_SIZE], chacha20::Impl impl) {
+    uint8_t expected[TAG_SIZE];
+    compute_tag(ks, nonce, aad, aad_len, in, len, expected);
+    if (!equal(expected, tag, TAG_SIZE)) return false;
+    chacha20::xor_stream(ks, nonce, 1, in, out, len, impl);
+    return true;
+}
+
+void chacha20_poly1305_seal(const uint8_t key[KEY_SIZE], const uint8_t nonce[NONCE_SIZE],
+                            const uint8_t* aad, size_t aad_len,
+                            const uint8_t* in, uint8_t* out, size_t len,
+                            uint8_t tag[TAG_SIZE], chacha20::Impl impl) {
+    chacha20::KeySchedule ks;
+    chacha20::expand_key(ks, key);
+    chacha20_poly1305_seal(ks, nonce, aad, aad_len, in, out, len, tag, impl);
+}
+
+bool chacha20_poly1305_open(const uint8_t key[KEY_SIZE], const uint8_t nonce[NONCE_SIZE],
+                            const uint8_t* aad, size_t aad_len,
+                            const uint8_t* in, uint8_t* out, size_t len,
+                            const uint8_t tag[TAG_SIZE], chacha20::Impl impl) {
+    chacha20::KeySchedule ks;
+    chacha20::expand_key(ks, key);
+    return chacha20_poly1305_open(ks, nonce, aad, aad_len, in, out, len, tag, impl);
+}
+
+// ─── Batch ───────────────────────────────────────────────────
+
+namespace {
+
+// Queues (record, block counter) jobs and runs them through the
+// independent-lane kernels LANES at a time; apply() consumes each block.
+template<typename Apply>
+class LaneQueue {
+public:
+    static constexpr size_t LANES = 16;
+
+    LaneQueue(const chacha20::KeySchedule& ks, chacha20::Impl impl, Apply apply)
+        : m_ks(ks), m_impl(impl), m_apply(apply) {}
+    ~LaneQueue() { wipe(m_stream, sizeof(m_stream)); }
+
+    void push(size_t record, uint32_t counter, const uint8_t* nonce) {
+        chacha20::set_lane(m_lanes[m_count], counter, nonce);
+        m_record[m_count]  = record;
+        m_counter[m_count] = counter;
+        if (++m_count == LANES) flush();
+    }
+
+    void flush() {
+        if (m_count == 0) return;
+        chacha20::keystream_lanes(m_ks, m_lanes, m_count, m_stream, m_impl);
+        for (size_t j = 0; j < m_count; j++) {
+            m_apply(m_record[j], m_counter[j], m_stream + j * chacha20::BLOCK_SIZE);
+        }
+        m_count = 0;
+    }
+
+private:
+    const chacha20::KeySchedule& m_ks;
+    chacha20::Impl      m_impl;
+    Apply               m_apply;
+    chacha20::LaneWords m_lanes[LANES];
+    size_t              m_record[LANES];
+    uint32_t            m_counter[LANES];
+    size_t              m_count{0};
+    uint8_t             m_stream[LANES * chacha20::BLOCK_SIZE];
+};
+
+template<typename Apply>
+LaneQueue<Apply> make_queue(const chacha20::KeySchedule& ks, chacha20::Impl impl, Apply apply) {
+    return LaneQueue<Apply>(ks, impl, apply);
+}
+
+// XOR one keystream block into a record body
+inline void xor_block(const ByteSpan& rec, uint32_t counter, const uint8_t* ks) {
+    size_t len = rec.size() - NONCE_SIZE - TAG_SIZE;
+    size_t off = (size_t)(counter - 1) * chacha20::BLOCK_SIZE;
+    size_t n   = std::min<size_t>(chacha20::BLOCK_SIZE, len - off);
+    uint8_t* body = rec.data() + NONCE_SIZE + off;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint64_t a, b;
+        std::memcpy(&a, body + i, 8);
+        std::memcpy(&b, ks + i, 8);
+        a ^= b;
+        std::memcpy(body + i, &a, 8);
+    }
+    for (; i < n; i++) body[i] ^= ks[i];
+}
+
+inline size_t body_blocks(const ByteSpan& rec) {
+    size_t len = rec.size() - NONCE_SIZE - TAG_SIZE;
+    return (len + chacha20::BLOCK_SIZE - 1) / chacha20::BLOCK_SIZE;
+}
+
+} // namespace
+
+void chacha20_poly1305_seal_batch(const chacha20::KeySchedule& ks, const ByteSpan* records,
+                                  size_t count, chacha20::Impl impl) {
+    // Encrypt every body, then derive every one-time key and tag
+    auto enc = make_queue(ks, impl, [&](size_t r, uint32_t ctr, const uint8_t* k) {
+        xor_block(records[r], ctr, k);
+    });
+    for (size_t r = 0; r < count; r++) {
+        size_t nb = body_blocks(records[r]);
+        for (size_t b = 1; b <= nb; b++) enc.push(r, (uint32_t)b, records[r].data());
+    }
+    enc.flush();
+
+    auto mac = make_queue(ks, impl, [&](size_t r, uint32_t, const uint8_t* otk) {
+        const ByteSpan& rec = records[r];
+        size_t len = rec.size() - NONCE_SIZE - TAG_SIZE;
+        const uint8_t* ct = rec.data() + NONCE_SIZE;
+        poly_tag(otk, nullptr, 0, ct, len, rec.data() + NONCE_SIZE + len);
+    });
+    for (size_t r = 0; r < count; r++) mac.push(r, 0, records[r].data());
+    mac.flush();
+}
+
+size_t chacha20_poly1305_open_batch(const chacha20::KeySchedule& ks, const ByteSpan* records,
+                                    size_t count, bool* ok, chacha20::Impl impl) {
+    // Verify every tag first; only records that pass are decrypted
+    auto mac = make_queue(ks, impl, [&](size_t r, uint32_t, const uint8_t* otk) {
+        const ByteSpan& rec = records[r];
+        size_t len = rec.size() - NONCE_SIZE - TAG_SIZE;
+        const uint8_t* ct = rec.data() + NONCE_SIZE;
+        uint8_t expected[TAG_SIZE];
+        poly_tag(otk, nullptr, 0, ct, len, expected);
+        ok[r] = equal(expected, ct + len, TAG_SIZE);
+    });
+    for (size_t r = 0; r < count; r++) {
+        ok[r] = false;
+        if (records[r].size() >= NONCE_SIZE + TAG_SIZE) mac.push(r, 0, records[r].data());
+    }
+    mac.flush();
+
+    size_t passed = 0;
+    auto dec = make_queue(ks, impl, [&](size_t r, uint32_t ctr, const uint8_t* k) {
+        xor_block(records[r], ctr, k);
+    });
+    for (size_t r = 0; r < count; r++) {
+        if (!ok[r]) continue;
+        passed++;
+        size_t nb = body_blocks(records[r]);
+        for (size_t b = 1; b <= nb; b++) dec.push(r, (uint32_t)b, records[r].data());
+    }
+    dec.flush();
+    return passed;
+}
+
+bool equal(const uint8_t* a, const uint8_t* b, size_t len) {
+    uint8_t diff = 0;
+    for (size_t i = 0; i < len; i++) diff |= a[i] ^ b[i];
+    return diff == 0;
+}
+
+} // namespace aead
+} // namespace vos
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "vos/types.h"
+#include "chacha20.h"
+
+namespace vos {
+namespace aead {
+
+/*
+ * ChaCha20-Poly1305 AEAD (RFC 8439 §2.8).
+ * Raw-pointer primitives; Crypto wraps them in the ByteBuffer API.
+ */
+
+constexpr size_t KEY_SIZE   = 32;
+constexpr size_t NONCE_SIZE = 12;
+constexpr size_t TAG_SIZE   = 16;
+
+// Encrypt `len` bytes (out may alias in) and produce the tag over aad + ciphertext.
+void chacha20_poly1305_seal(const uint8_t key[KEY_SIZE], const uint8_t nonce[NONCE_SIZE],
+                            const uint8_t* aad, size_t aad_len,
+                            const uint8_t* in, uint8_t* out, size_t len,
+                            uint8_t tag[TAG_SIZE],
+                            chacha20::Impl impl = chacha20::Impl::AUTO);
+
+// Verify the tag, then decrypt. Returns false (and leaves out untouched) on mismatch.
+bool chacha20_poly1305_open(const uint8_t key[KEY_SIZE], const uint8_t nonce[NONCE_SIZE],
+                            const uint8_t* aad, size_t aad_len,
+                            const uint8_t* in, uint8_t* out, size_t len,
+                            const uint8_t tag[TAG_SIZE],
+                            chacha20::Impl impl = chacha20::Impl::AUTO);
+
+// Same, with the ChaCha20 key already expanded (see CryptoSession)
+void chacha20_poly1305_seal(const chacha20::KeySchedule& ks, const uint8_t nonce[NONCE_SIZE],
+                            const uint8_t* aad, size_t aad_len,
+                            const uint8_t* in, uint8_t* out, size_t len,
+                            uint8_t tag[TAG_SIZE],
+                            chacha20::Impl impl = chacha20::Impl::AUTO);
+bool chacha20_poly1305_open(const chacha20::KeySchedule& ks, const uint8_t nonce[NONCE_SIZE],
+                            const uint8_t* aad, size_t aad_len,
+                            const uint8_t* in, uint8_t* out, size_t len,
+                            const uint8_t tag[TAG_SIZE],
+                            chacha20::Impl impl = chacha20::Impl::AUTO);
+
+// Batch AEAD over independent records under one key, each laid out
+// [NONCE:12][DATA:N][TAG:16] (the Crypto::seal_in_place layout), processed
+// in place. Keystream blocks from different records share SIMD lanes, so
+// many short records cost about what one long one does.
+// seal: nonces must already be filled in; every record >= NONCE+TAG bytes.
+// open: verifies every tag before decrypting anything; only records that
+//       pass are decrypted. ok[i] gets each outcome; returns the pass count.
+void   chacha20_poly1305_seal_batch(const chacha20::KeySchedule& ks, const ByteSpan* records,
+                                    size_t count, chacha20::Impl impl = chacha20::Impl::AUTO);
+size_t chacha20_poly1305_open_batch(const chacha20::KeySchedule& ks, const ByteSpan* records,
+                                    size_t count, bool* ok,
+                                    chacha20::Impl impl = chacha20::Impl::AUTO);
+
+// Constant-time comparison
+bool equal(const uint8_t* a, const uint8_t* b, size_t len);
+
+} // namespace aead
+} // namespace vos
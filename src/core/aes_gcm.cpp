@@ -0,0 +1,271 @@
+#include "aes_gcm.h"
+#include "aead.h"
+#include "cpu_features.h"
+#include <cstring>
+
+namespace vos {
+namespace aes_gcm {
+
+static const uint8_t SBOX[256] = {
+    0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+    0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+    0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+    0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+    0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+    0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+    0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+    0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+    0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+    0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+    0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+    0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+    0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+    0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+    0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+    0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16,
+};
+
+static inline uint8_t xtime(uint8_t x) {
+    return (uint8_t)((x << 1) ^ ((x >> 7) * 0x1b));
+}
+
+static inline uint64_t load64_be(const uint8_t* p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; i++) v = (v << 8) | p[i];
+    return v;
+}
+
+static inline void store64_be(uint8_t* p, uint64_t v) {
+    for (int i = 7; i >= 0; i--) { p[i] = (uint8_t)v; v >>= 8; }
+}
+
+static inline void store32_be(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 24); p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);  p[3] = (uint8_t)v;
+}
+
+static void wipe(void* p, size_t len) {
+    volatile uint8_t* v = static_cast<volatile uint8_t*>(p);
+    for (size_t i = 0; i < len; i++) v[i] = 0;
+}
+
+// ─── Software AES ────────────────────────────────────────────
+
+static void encrypt_block(const KeySchedule& ks, const uint8_t in[16], uint8_t out[16]) {
+    const uint8_t* rk = ks.round_keys;
+    uint8_t s[16], t[16];
+    for (int i = 0; i < 16; i++) s[i] = in[i] ^ rk[i];
+
+    for (int round = 1; round <= ROUNDS; round++) {
+        // SubBytes + ShiftRows (state is column-major: s[row + 4*col])
+        for (int c = 0; c < 4; c++) {
+            for (int r = 0; r < 4; r++) t[r + 4 * c] = SBOX[s[r + 4 * ((c + r) & 3)]];
+        }
+        rk += 16;
+        if (round == ROUNDS) {
+            for (int i = 0; i < 16; i++) out[i] = t[i] ^ rk[i];
+            break;
+        }
+        // MixColumns + AddRoundKey
+        for (int c = 0; c < 4; c++) {
+            uint8_t a0 = t[4 * c], a1 = t[4 * c + 1], a2 = t[4 * c + 2], a3 = t[4 * c + 3];
+            uint8_t x = a0 ^ a1 ^ a2 ^ a3;
+            s[4 * c]     = a0 ^ x ^ xtime(a0 ^ a1) ^ rk[4 * c];
+            s[4 * c + 1] = a1 ^ x ^ xtime(a1 ^ a2) ^ rk[4 * c + 1];
+            s[4 * c + 2] = a2 ^ x ^ xtime(a2 ^ a3) ^ rk[4 * c + 2];
+            s[4 * c + 3] = a3 ^ x ^ xtime(a3 ^ a0) ^ rk[4 * c + 3];
+        }
+    }
+    wipe(s, sizeof(s));
+    wipe(t, sizeof(t));
+}
+
+// ─── Software GHASH ──────────────────────────────────────────
+
+// x * y in GF(2^128) with GCM's bit order (SP 800-38D Algorithm 1).
+// Branch-free, so the key-dependent H never steers control flow.
+static void gf_mul(const uint8_t x[16], const uint8_t y[16], uint8_t out[16]) {
+    uint64_t x_hi = load64_be(x), x_lo = load64_be(x + 8);
+    uint64_t v_hi = load64_be(y), v_lo = load64_be(y + 8);
+    uint64_t z_hi = 0, z_lo = 0;
+    for (int i = 0; i < 128; i++) {
+        uint64_t bit  = i < 64 ? (x_hi >> (63 - i)) & 1 : (x_lo >> (127 - i)) & 1;
+        uint64_t mask = 0 - bit;
+        z_hi ^= v_hi & mask;
+        z_lo ^= v_lo & mask;
+        uint64_t carry = 0 - (v_lo & 1);
+        v_lo = (v_lo >> 1) | (v_hi << 63);
+        v_hi = (v_hi >> 1) ^ (0xE100000000000000ULL & carry);
+    }
+    store64_be(out, z_hi);
+    store64_be(out + 8, z_lo);
+}
+
+namespace detail {
+
+void ctr_soft(const KeySchedule& ks, const uint8_t nonce[NONCE_SIZE], uint32_t ctr,
+              const uint8_t* in, uint8_t* out, size_t len) {
+    uint8_t block[16], stream[16];
+    std::memcpy(block, nonce, NONCE_SIZE);
+    while (len > 0) {
+        store32_be(block + 12, ctr++);
+        encrypt_block(ks, block, stream);
+        size_t n = len < 16 ? len : 16;
+        for (size_t i = 0; i < n; i++) out[i] = in[i] ^ stream[i];
+        in  += n;
+        out += n;
+        len -= n;
+    }
+    wipe(stream, sizeof(stream));
+}
+
+void ghash_soft(const KeySchedule& ks, uint8_t y[BLOCK_SIZE], const uint8_t* data, size_t len) {
+    for (; len >= 16; data += 16, len -= 16) {
+        for (int i = 0; i < 16; i++) y[i] ^= data[i];
+        gf_mul(y, ks.h_powers[0], y);
+    }
+}
+
+void h_powers_soft(KeySchedule& ks) {
+    static const uint8_t zero[16] = {};
+    encrypt_block(ks, zero, ks.h_powers[0]);
+    for (int i = 1; i < 4; i++) gf_mul(ks.h_powers[i - 1], ks.h_powers[0], ks.h_powers[i]);
+}
+
+} // namespace detail
+
+// ─── Key Schedule ────────────────────────────────────────────
+
+void expand_key(KeySchedule& ks, const uint8_t key[KEY_SIZE]) {
+    // FIPS-197 §5.2, Nk = 8: 60 words, kept as bytes so AES-NI can load them directly
+    uint8_t* w = ks.round_keys;
+    std::memcpy(w, key, KEY_SIZE);
+    uint8_t rcon = 0x01;
+    for (int i = 8; i < 4 * (ROUNDS + 1); i++) {
+        uint8_t t[4];
+        std::memcpy(t, w + 4 * (i - 1), 4);
+        if (i % 8 == 0) {
+            uint8_t t0 = t[0];
+            t[0] = SBOX[t[1]] ^ rcon;
+            t[1] = SBOX[t[2]];
+            t[2] = SBOX[t[3]];
+            t[3] = SBOX[t0];
+            rcon = xtime(rcon);
+        } else if (i % 8 == 4) {
+            for (int j = 0; j < 4; j++) t[j] = SBOX[t[j]];
+        }
+        for (int j = 0; j < 4; j++) w[4 * i + j] = w[4 * (i - 8) + j] ^ t[j];
+    }
+
+    // H = E(K, 0^128) and its powers; raw-key callers pay this per record,
+    // so use the hardware when it is there
+    if (best_impl() == Impl::AESNI) detail::h_powers_aesni(ks);
+    else                            detail::h_powers_soft(ks);
+}
+
+// ─── Dispatch ────────────────────────────────────────────────
+
+const char* impl_name(Impl impl) {
+    switch (impl) {
+        case Impl::SOFTWARE: return "software";
+        case Impl::AESNI:    return "aes-ni";
+        case Impl::AUTO:     return impl_name(best_impl());
+    }
+    return "unknown";
+}
+
+bool impl_available(Impl impl) {
+    const CpuFeatures& f = cpu_features();
+    switch (impl) {
+        case Impl::SOFTWARE: return true;
+        case Impl::AESNI:    return f.aesni && f.pclmul && f.sse41 && f.ssse3;
+        case Impl::AUTO:     return true;
+    }
+    return false;
+}
+
+Impl best_impl() {
+    static const Impl best = impl_available(Impl::AESNI) ? Impl::AESNI : Impl::SOFTWARE;
+    return best;
+}
+
+namespace {
+
+struct Kernels {
+    void (*ctr)(const KeySchedule&, const uint8_t*, uint32_t, const uint8_t*, uint8_t*, size_t);
+    void (*ghash)(const KeySchedule&, uint8_t*, const uint8_t*, size_t);
+};
+
+Kernels kernels(Impl impl) {
+    if (impl == Impl::AUTO || !impl_available(impl)) impl = best_impl();
+    if (impl == Impl::AESNI) return { detail::ctr_aesni, detail::ghash_aesni };
+    return { detail::ctr_soft, detail::ghash_soft };
+}
+
+// GHASH over data of any length, zero-padding the last block
+void ghash_padded(const Kernels& k, const KeySchedule& ks, uint8_t y[16],
+                  const uint8_t* data, size_t len) {
+    size_t whole = len & ~(size_t)15;
+    if (whole) k.ghash(ks, y, data, whole);
+    if (len > whole) {
+        uint8_t last[16] = {};
+        std::memcpy(last, data + whole, len - whole);
+        k.ghash(ks, y, last, 16);
+    }
+}
+
+// Final GHASH block (bit lengths) and tag = GHASH ^ E(K, J0)
+void finish_tag(const Kernels& k, const KeySchedule& ks, const uint8_t nonce[NONCE_SIZE],
+                uint8_t y[16], size_t aad_len, size_t len, uint8_t tag[TAG_SIZE]) {
+    uint8_t lens[16];
+    store64_be(lens,     (uint64_t)aad_len * 8);
+    store64_be(lens + 8, (uint64_t)len * 8);
+    k.ghash(ks, y, lens, 16);
+
+    static const uint8_t zero[16] = {};
+    uint8_t ek0[16];
+    k.ctr(ks, nonce, 1, zero, ek0, 16);
+    for (int i = 0; i < 16; i++) tag[i] = y[i] ^ ek0[i];
+    wipe(ek0, sizeof(ek0));
+}
+
+// Encrypt and hash in slices so the ciphertext is still in L1 when GHASH reads it
+constexpr size_t SLICE = 4096;
+
+} // namespace
+
+void seal(const KeySchedule& ks, const uint8_t nonce[NONCE_SIZE],
+          const uint8_t* aad, size_t aad_len,
+          const uint8_t* in, uint8_t* out, size_t len,
+          uint8_t tag[TAG_SIZE], Impl impl) {
+    Kernels k = kernels(impl);
+    uint8_t y[16] = {};
+    ghash_padded(k, ks, y, aad, aad_len);
+
+    for (size_t off = 0; off < len; off += SLICE) {
+        size_t n = len - off < SLICE ? len - off : SLICE;
+        k.ctr(ks, nonce, 2 + (uint32_t)(off / 16), in + off, out + off, n);
+        ghash_padded(k, ks, y, out + off, n);
+    }
+    finish_tag(k, ks, nonce, y, aad_len, len, tag);
+}
+
+bool open(const KeySchedule& ks, const uint8_t nonce[NONCE_SIZE],
+          const uint8_t* aad, size_t aad_len,
+          const uint8_t* in, uint8_t* out, size_t len,
+          const uint8_t tag[TAG_SIZE], Impl impl) {
+    Kernels k = kernels(impl);
+    uint8_t y[16] = {};
+    ghash_padded(k, ks, y, aad, aad_len);
+    ghash_padded(k, ks, y, in, len);
+
+    uint8_t expected[TAG_SIZE];
+    finish_tag(k, ks, nonce, y, aad_len, len, expected);
+    if (!aead::equal(expected, tag, TAG_SIZE)) return false;
+
+    k.ctr(ks, nonce, 2, in, out, len);
+    return true;
+}
+
+} // namespace aes_gcm
+} // namespace vos
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "vos/types.h"
+
+namespace vos {
+namespace aes_gcm {
+
+/*
+ * AES-256-GCM (NIST SP 800-38D) with a 96-bit nonce and 128-bit tag.
+ * Two kernels compute the same result: AES-NI + PCLMULQDQ where the CPU
+ * has them, and a portable software path so data sealed on one machine
+ * still opens on another. The software AES uses S-box lookups and is not
+ * hardened against cache-timing attacks — Crypto only picks AES-GCM by
+ * default when the hardware path is present.
+ */
+
+constexpr size_t KEY_SIZE   = 32;
+constexpr size_t NONCE_SIZE = 12;
+constexpr size_t TAG_SIZE   = 16;
+constexpr size_t BLOCK_SIZE = 16;
+constexpr int    ROUNDS     = 14;
+
+enum class Impl : uint8_t {
+    SOFTWARE = 0,   // Portable C++
+    AESNI,          // AES-NI + PCLMULQDQ, 8 blocks per iteration
+    AUTO = 0xFF     // Best available
+};
+
+const char* impl_name(Impl impl);
+bool        impl_available(Impl impl);
+Impl        best_impl();
+
+// Expanded key: AES round keys plus the GHASH key H and its powers
+// (H^1..H^4, for the 4-way aggregated GHASH). Same layout for both kernels.
+struct KeySchedule {
+    alignas(16) uint8_t round_keys[(ROUNDS + 1) * BLOCK_SIZE];
+    alignas(16) uint8_t h_powers[4][BLOCK_SIZE];
+};
+
+void expand_key(KeySchedule& ks, const uint8_t key[KEY_SIZE]);
+
+// Encrypt `len` bytes (out may alias in) and produce the tag over aad + ciphertext.
+void seal(const KeySchedule& ks, const uint8_t nonce[NONCE_SIZE],
+          const uint8_t* aad, size_t aad_len,
+          const uint8_t* in, uint8_t* out, size_t len,
+          uint8_t tag[TAG_SIZE], Impl impl = Impl::AUTO);
+
+// Verify the tag, then decrypt. Returns false (and leaves out untouched) on mismatch.
+bool open(const KeySchedule& ks, const uint8_t nonce[NONCE_SIZE],
+          const uint8_t* aad, size_t aad_len,
+          const uint8_t* in, uint8_t* out, size_t len,
+          const uint8_t tag[TAG_SIZE], Impl impl = Impl::AUTO);
+
+// ─── Kernels ─────────────────────────────────────────────────
+// ctr_*:   counter mode from block nonce||be32(ctr); len need not be whole blocks.
+// ghash_*: absorb `len` bytes (a multiple of 16) into the running hash y.
+// h_powers_*: fill h_powers from round_keys (the tail of expand_key).
+namespace detail {
+void ctr_soft(const KeySchedule& ks, const uint8_t nonce[NONCE_SIZE], uint32_t ctr,
+              const uint8_t* in, uint8_t* out, size_t len);
+void ghash_soft(const KeySchedule& ks, uint8_t y[BLOCK_SIZE], const uint8_t* data, size_t len);
+void h_powers_soft(KeySchedule& ks);
+
+// aes_gcm_ni.cpp
+void ctr_aesni(const KeySchedule& ks, const uint8_t nonce[NONCE_SIZE], uint32_t ctr,
+               const uint8_t* in, uint8_t* out, size_t len);
+void ghash_aesni(const KeySchedule& ks, uint8_t y[BLOCK_SIZE], const uint8_t* data, size_t len);
+void h_powers_aesni(KeySchedule& ks);
+} // namespace detail
+
+} // namespace aes_gcm
+} // namespace vos
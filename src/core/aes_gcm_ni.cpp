@@ -0,0 +1,195 @@
+/*
+ * AES-GCM kernels using AES-NI and PCLMULQDQ.
+ * CTR runs 8 independent counter blocks through the rounds together to
+ * hide AESENC latency. GHASH works on byte-reflected values and folds 4
+ * blocks per reduction using the precomputed powers of H.
+ */
+#include "aes_gcm.h"
+#include "cpu_features.h"
+
+#if defined(VOS_ARCH_X86)
+#include <immintrin.h>
+#endif
+
+namespace vos {
+namespace aes_gcm {
+namespace detail {
+
+#if defined(VOS_ARCH_X86)
+
+#define VOS_AESNI_TARGET VOS_TARGET("aes,pclmul,sse4.1,ssse3")
+
+static inline uint32_t bswap32(uint32_t v) {
+    return (v >> 24) | ((v >> 8) & 0xff00) | ((v << 8) & 0xff0000) | (v << 24);
+}
+
+VOS_AESNI_TARGET
+void ctr_aesni(const KeySchedule& ks, const uint8_t nonce[NONCE_SIZE], uint32_t ctr,
+               const uint8_t* in, uint8_t* out, size_t len) {
+    __m128i rk[ROUNDS + 1];
+    for (int i = 0; i <= ROUNDS; i++) {
+        rk[i] = _mm_loadu_si128((const __m128i*)(ks.round_keys + 16 * i));
+    }
+    // nonce || 0, with the big-endian counter inserted per block
+    uint8_t base_bytes[16] = {};
+    for (size_t i = 0; i < NONCE_SIZE; i++) base_bytes[i] = nonce[i];
+    const __m128i base = _mm_loadu_si128((const __m128i*)base_bytes);
+
+    while (len >= 8 * BLOCK_SIZE) {
+        __m128i b[8];
+        for (int j = 0; j < 8; j++) {
+            b[j] = _mm_xor_si128(_mm_insert_epi32(base, (int)bswap32(ctr + (uint32_t)j), 3), rk[0]);
+        }
+        for (int r = 1; r < ROUNDS; r++) {
+            for (int j = 0; j < 8; j++) b[j] = _mm_aesenc_si128(b[j], rk[r]);
+        }
+        for (int j = 0; j < 8; j++) {
+            b[j] = _mm_aesenclast_si128(b[j], rk[ROUNDS]);
+            __m128i m = _mm_loadu_si128((const __m128i*)(in + 16 * j));
+            _mm_storeu_si128((__m128i*)(out + 16 * j), _mm_xor_si128(m, b[j]));
+        }
+        ctr += 8;
+        in  += 8 * BLOCK_SIZE;
+        out += 8 * BLOCK_SIZE;
+        len -= 8 * BLOCK_SIZE;
+    }
+
+    while (len > 0) {
+        __m128i b = _mm_xor_si128(_mm_insert_epi32(base, (int)bswap32(ctr++), 3), rk[0]);
+        for (int r = 1; r < ROUNDS; r++) b = _mm_aesenc_si128(b, rk[r]);
+        b = _mm_aesenclast_si128(b, rk[ROUNDS]);
+        if (len >= BLOCK_SIZE) {
+            __m128i m = _mm_loadu_si128((const __m128i*)in);
+            _mm_storeu_si128((__m128i*)out, _mm_xor_si128(m, b));
+            in  += BLOCK_SIZE;
+            out += BLOCK_SIZE;
+            len -= BLOCK_SIZE;
+        } else {
+            alignas(16) uint8_t stream[16];
+            _mm_store_si128((__m128i*)stream, b);
+            for (size_t i = 0; i < len; i++) out[i] = in[i] ^ stream[i];
+            _mm_store_si128((__m128i*)stream, _mm_setzero_si128());
+            len = 0;
+        }
+    }
+}
+
+// Carry-less 128x128 -> 256-bit product, unreduced (lo, hi)
+VOS_AESNI_TARGET
+static inline void clmul(__m128i a, __m128i b, __m128i& lo, __m128i& hi) {
+    __m128i t0 = _mm_clmulepi64_si128(a, b, 0x00);
+    __m128i t1 = _mm_clmulepi64_si128(a, b, 0x10);
+    __m128i t2 = _mm_clmulepi64_si128(a, b, 0x01);
+    __m128i t3 = _mm_clmulepi64_si128(a, b, 0x11);
+    t1 = _mm_xor_si128(t1, t2);
+    lo = _mm_xor_si128(t0, _mm_slli_si128(t1, 8));
+    hi = _mm_xor_si128(t3, _mm_srli_si128(t1, 8));
+}
+
+// Shift the reflected 256-bit product left by one and reduce modulo
+// x^128 + x^7 + x^2 + x + 1 (Intel CLMUL white paper, algorithm 5)
+VOS_AESNI_TARGET
+static inline __m128i reduce(__m128i lo, __m128i hi) {
+    __m128i c_lo = _mm_srli_epi32(lo, 31);
+    __m128i c_hi = _mm_srli_epi32(hi, 31);
+    lo = _mm_slli_epi32(lo, 1);
+    hi = _mm_slli_epi32(hi, 1);
+    __m128i carry = _mm_srli_si128(c_lo, 12);
+    c_hi = _mm_slli_si128(c_hi, 4);
+    c_lo = _mm_slli_si128(c_lo, 4);
+    lo = _mm_or_si128(lo, c_lo);
+    hi = _mm_or_si128(hi, c_hi);
+    hi = _mm_or_si128(hi, carry);
+
+    __m128i a = _mm_slli_epi32(lo, 31);
+    __m128i b = _mm_slli_epi32(lo, 30);
+    __m128i c = _mm_slli_epi32(lo, 25);
+    a = _mm_xor_si128(a, b);
+    a = _mm_xor_si128(a, c);
+    b = _mm_srli_si128(a, 4);
+    a = _mm_slli_si128(a, 12);
+    lo = _mm_xor_si128(lo, a);
+
+    __m128i d = _mm_srli_epi32(lo, 1);
+    __m128i e = _mm_srli_epi32(lo, 2);
+    __m128i f = _mm_srli_epi32(lo, 7);
+    d = _mm_xor_si128(d, e);
+    d = _mm_xor_si128(d, f);
+    d = _mm_xor_si128(d, b);
+    lo = _mm_xor_si128(lo, d);
+    return _mm_xor_si128(hi, lo);
+}
+
+VOS_AESNI_TARGET
+void ghash_aesni(const KeySchedule& ks, uint8_t y[BLOCK_SIZE], const uint8_t* data, size_t len) {
+    const __m128i BSWAP = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    __m128i h[4];
+    for (int i = 0; i < 4; i++) {
+        h[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)ks.h_powers[i]), BSWAP);
+    }
+    __m128i acc = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)y), BSWAP);
+
+    // Y' = (Y ^ X1)·H^4 ^ X2·H^3 ^ X3·H^2 ^ X4·H, one reduction per 4 blocks
+    while (len >= 4 * BLOCK_SIZE) {
+        __m128i lo, hi, l, hh;
+        __m128i x0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data)),      BSWAP);
+        __m128i x1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 16)), BSWAP);
+        __m128i x2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 32)), BSWAP);
+        __m128i x3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 48)), BSWAP);
+        clmul(_mm_xor_si128(acc, x0), h[3], lo, hi);
+        clmul(x1, h[2], l, hh); lo = _mm_xor_si128(lo, l); hi = _mm_xor_si128(hi, hh);
+        clmul(x2, h[1], l, hh); lo = _mm_xor_si128(lo, l); hi = _mm_xor_si128(hi, hh);
+        clmul(x3, h[0], l, hh); lo = _mm_xor_si128(lo, l); hi = _mm_xor_si128(hi, hh);
+        acc = reduce(lo, hi);
+        data += 4 * BLOCK_SIZE;
+        len  -= 4 * BLOCK_SIZE;
+    }
+    for (; len >= BLOCK_SIZE; data += BLOCK_SIZE, len -= BLOCK_SIZE) {
+        __m128i lo, hi;
+        __m128i x = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)data), BSWAP);
+        clmul(_mm_xor_si128(acc, x), h[0], lo, hi);
+        acc = reduce(lo, hi);
+    }
+    _mm_storeu_si128((__m128i*)y, _mm_shuffle_epi8(acc, BSWAP));
+}
+
+VOS_AESNI_TARGET
+void h_powers_aesni(KeySchedule& ks) {
+    const __m128i BSWAP = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    __m128i b = _mm_loadu_si128((const __m128i*)ks.round_keys);
+    for (int r = 1; r < ROUNDS; r++) {
+        b = _mm_aesenc_si128(b, _mm_loadu_si128((const __m128i*)(ks.round_keys + 16 * r)));
+    }
+    b = _mm_aesenclast_si128(b, _mm_loadu_si128((const __m128i*)(ks.round_keys + 16 * ROUNDS)));
+
+    __m128i h = _mm_shuffle_epi8(b, BSWAP), p = h;
+    _mm_storeu_si128((__m128i*)ks.h_powers[0], b);
+    for (int i = 1; i < 4; i++) {
+        __m128i lo, hi;
+        clmul(p, h, lo, hi);
+        p = reduce(lo, hi);
+        _mm_storeu_si128((__m128i*)ks.h_powers[i], _mm_shuffle_epi8(p, BSWAP));
+    }
+}
+
+#else
+
+// No AES-NI on this target — impl_available() never selects these.
+void ctr_aesni(const KeySchedule& ks, const uint8_t nonce[NONCE_SIZE], uint32_t ctr,
+               const uint8_t* in, uint8_t* out, size_t len) {
+    ctr_soft(ks, nonce, ctr, in, out, len);
+}
+
+void ghash_aesni(const KeySchedule& ks, uint8_t y[BLOCK_SIZE], const uint8_t* data, size_t len) {
+    ghash_soft(ks, y, data, len);
+}
+
+void h_powers_aesni(KeySchedule& ks) {
+    h_powers_soft(ks);
+}
+
+#endif
+
+} // namespace detail
+} // namespace aes_gcm
+} // namespace vos
@@ -0,0 +1,242 @@
+#include "chacha20.h"
+#include "cpu_features.h"
+#include <cstring>
+
+namespace vos {
+namespace chacha20 {
+
+static inline uint32_t load32_le(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline void store32_le(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v;         p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16); p[3] = (uint8_t)(v >> 24);
+}
+
+static inline uint32_t rotl32(uint32_t v, int n) {
+    return (v << n) | (v >> (32 - n));
+}
+
+#define QR(a, b, c, d)                          \
+    a += b; d ^= a; d = rotl32(d, 16);          \
+    c += d; b ^= c; b = rotl32(b, 12);          \
+    a += b; d ^= a; d = rotl32(d, 8);           \
+    c += d; b ^= c; b = rotl32(b, 7)
+
+void expand_key(KeySchedule& ks, const uint8_t key[KEY_SIZE]) {
+    ks.words[0] = 0x61707865; ks.words[1] = 0x3320646e;
+    ks.words[2] = 0x79622d32; ks.words[3] = 0x6b206574;
+    for (int i = 0; i < 8; i++) ks.words[4 + i] = load32_le(key + 4 * i);
+}
+
+static void init_state(uint32_t s[16], const KeySchedule& ks,
+                       const uint8_t nonce[NONCE_SIZE], uint32_t counter) {
+    std::memcpy(s, ks.words, sizeof(ks.words));
+    s[12] = counter;
+    s[13] = load32_le(nonce);
+    s[14] = load32_le(nonce + 4);
+    s[15] = load32_le(nonce + 8);
+}
+
+static void core(const uint32_t in[16], uint8_t out[BLOCK_SIZE]) {
+    uint32_t x[16];
+    std::memcpy(x, in, sizeof(x));
+    for (int i = 0; i < 10; i++) {
+        QR(x[0], x[4], x[8],  x[12]);
+        QR(x[1], x[5], x[9],  x[13]);
+        QR(x[2], x[6], x[10], x[14]);
+        QR(x[3], x[7], x[11], x[15]);
+        QR(x[0], x[5], x[10], x[15]);
+        QR(x[1], x[6], x[11], x[12]);
+        QR(x[2], x[7], x[8],  x[13]);
+        QR(x[3], x[4], x[9],  x[14]);
+    }
+    for (int i = 0; i < 16; i++) store32_le(out + 4 * i, x[i] + in[i]);
+}
+
+#undef QR
+
+namespace detail {
+
+void xor_blocks_scalar(const uint32_t state[16], const uint8_t* in, uint8_t* out, size_t nblocks) {
+    uint32_t s[16];
+    std::memcpy(s, state, sizeof(s));
+    uint8_t ks[BLOCK_SIZE];
+    for (size_t b = 0; b < nblocks; b++) {
+        core(s, ks);
+        for (size_t i = 0; i < BLOCK_SIZE; i++) out[i] = in[i] ^ ks[i];
+        in  += BLOCK_SIZE;
+        out += BLOCK_SIZE;
+        s[12]++;
+    }
+}
+
+void keystream_lanes_scalar(const uint32_t key_words[12], const uint32_t (*lanes)[4],
+                            uint8_t* out, size_t nlanes) {
+    uint32_t s[16];
+    std::memcpy(s, key_words, 12 * sizeof(uint32_t));
+    for (size_t i = 0; i < nlanes; i++) {
+        std::memcpy(s + 12, lanes[i], 4 * sizeof(uint32_t));
+        core(s, out + i * BLOCK_SIZE);
+    }
+}
+
+} // namespace detail
+
+// ─── Dispatch ────────────────────────────────────────────────
+
+const char* impl_name(Impl impl) {
+    switch (impl) {
+        case Impl::SCALAR: return "scalar";
+        case Impl::SSE2:   return "sse2";
+        case Impl::AVX2:   return "avx2";
+        case Impl::NEON:   return "neon";
+        case Impl::AUTO:   return impl_name(best_impl());
+    }
+    return "unknown";
+}
+
+bool impl_available(Impl impl) {
+    const CpuFeatures& f = cpu_features();
+    switch (impl) {
+        case Impl::SCALAR: return true;
+        case Impl::SSE2:   return f.sse2;
+        case Impl::AVX2:   return f.avx2;
+        case Impl::NEON:   return f.neon;
+        case Impl::AUTO:   return true;
+    }
+    return false;
+}
+
+Impl best_impl() {
+    static const Impl best = [] {
+        if (impl_available(Impl::AVX2)) return Impl::AVX2;
+        if (impl_available(Impl::SSE2)) return Impl::SSE2;
+        if (impl_available(Impl::NEON)) return Impl::NEON;
+        return Impl::SCALAR;
+    }();
+    return best;
+}
+
+void block(const KeySchedule& ks, const uint8_t nonce[NONCE_SIZE],
+           uint32_t counter, uint8_t out[BLOCK_SIZE]) {
+    uint32_t s[16];
+    init_state(s, ks, nonce, counter);
+    core(s, out);
+}
+
+void block(const uint8_t key[KEY_SIZE], const uint8_t nonce[NONCE_SIZE],
+           uint32_t counter, uint8_t out[BLOCK_SIZE]) {
+    KeySchedule ks;
+    expand_key(ks, key);
+    block(ks, nonce, counter, out);
+}
+
+void xor_stream(const uint8_t key[KEY_SIZE], const uint8_t nonce[NONCE_SIZE],
+                uint32_t counter, const uint8_t* in, uint8_t* out, size_t len,
+                Impl impl) {
+    KeySchedule ks;
+    expand_key(ks, key);
+    xor_stream(ks, nonce, counter, in, out, len, impl);
+}
+
+void xor_stream(const KeySchedule& ks, const uint8_t nonce[NONCE_SIZE],
+                uint32_t counter, const uint8_t* in, uint8_t* out, size_t len,
+                Impl impl) {
+    if (impl == Impl::AUTO || !impl_available(impl)) impl = best_impl();
+
+    uint32_t s[16];
+    init_state(s, ks, nonce, counter);
+
+    size_t nblocks = len / BLOCK_SIZE;
+
+    // Wide kernels take whole groups; narrower ones mop up the rest.
+    auto run = [&](size_t width,
+                   void (*fn)(const uint32_t*, const uint8_t*, uint8_t*, size_t)) {
+        size_t n = (nblocks / width) * width;
+        if (n == 0) return;
+        fn(s, in, out, n);
+        in      += n * BLOCK_SIZE;
+        out     += n * BLOCK_SIZE;
+        s[12]   += (uint32_t)n;
+        nblocks -= n;
+    };
+
+    switch (impl) {
+        case Impl::AVX2:
+            run(8, detail::xor_blocks_avx2);
+            run(4, detail::xor_blocks_sse2);
+            break;
+        case Impl::SSE2:
+            run(4, detail::xor_blocks_sse2);
+            break;
+        case Impl::NEON:
+            run(4, detail::xor_blocks_neon);
+            break;
+        default:
+            break;
+    }
+    run(1, detail::xor_blocks_scalar);
+
+    size_t tail = len % BLOCK_SIZE;
+    if (tail > 0) {
+        uint8_t ks[BLOCK_SIZE];
+        core(s, ks);
+        for (size_t i = 0; i < tail; i++) out[i] = in[i] ^ ks[i];
+    }
+}
+
+// ─── Independent Blocks ──────────────────────────────────────
+
+void set_lane(LaneWords lane, uint32_t counter, const uint8_t nonce[NONCE_SIZE]) {
+    lane[0] = counter;
+    lane[1] = load32_le(nonce);
+    lane[2] = load32_le(nonce + 4);
+    lane[3] = load32_le(nonce + 8);
+}
+
+size_t lane_width(Impl impl) {
+    if (impl == Impl::AUTO || !impl_available(impl)) impl = best_impl();
+    switch (impl) {
+        case Impl::AVX2: return 8;
+        case Impl::SSE2:
+        case Impl::NEON: return 4;
+        default:         return 1;
+    }
+}
+
+void keystream_lanes(const KeySchedule& ks, const LaneWords* lanes, size_t nlanes,
+                     uint8_t* out, Impl impl) {
+    if (impl == Impl::AUTO || !impl_available(impl)) impl = best_impl();
+
+    auto run = [&](size_t width,
+                   void (*fn)(const uint32_t*, const uint32_t (*)[4], uint8_t*, size_t)) {
+        size_t n = (nlanes / width) * width;
+        if (n == 0) return;
+        fn(ks.words, lanes, out, n);
+        lanes  += n;
+        out    += n * BLOCK_SIZE;
+        nlanes -= n;
+    };
+
+    switch (impl) {
+        case Impl::AVX2:
+            run(8, detail::keystream_lanes_avx2);
+            run(4, detail::keystream_lanes_sse2);
+            break;
+        case Impl::SSE2:
+            run(4, detail::keystream_lanes_sse2);
+            break;
+        case Impl::NEON:
+            run(4, detail::keystream_lanes_neon);
+            break;
+        default:
+            break;
+    }
+    run(1, detail::keystream_lanes_scalar);
+}
+
+} // namespace chacha20
+} // namespace vos
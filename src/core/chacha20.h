@@ -0,0 +1,90 @@
+#pragma once
+
+#include "vos/types.h"
+
+namespace vos {
+namespace chacha20 {
+
+/*
+ * ChaCha20 stream cipher (RFC 8439).
+ * Several kernels compute the same keystream; the widest one the CPU
+ * supports is picked once at runtime. Any kernel can be forced for
+ * cross-checking and benchmarking.
+ */
+
+constexpr size_t KEY_SIZE   = 32;
+constexpr size_t NONCE_SIZE = 12;
+constexpr size_t BLOCK_SIZE = 64;
+
+enum class Impl : uint8_t {
+    SCALAR = 0,   // Portable C++
+    SSE2,         // 4 blocks per iteration
+    AVX2,         // 8 blocks per iteration
+    NEON,         // 4 blocks per iteration
+    AUTO  = 0xFF  // Best available
+};
+
+// Expanded key: constant + key words of the initial state, so repeated
+// calls under one key only fill in the counter and nonce.
+struct KeySchedule {
+    uint32_t words[12];
+};
+
+void expand_key(KeySchedule& ks, const uint8_t key[KEY_SIZE]);
+
+const char* impl_name(Impl impl);
+bool        impl_available(Impl impl);
+Impl        best_impl();
+
+// XOR `len` bytes of keystream into `in`, writing `out` (may alias `in`).
+// The keystream starts at block `counter`.
+void xor_stream(const uint8_t key[KEY_SIZE], const uint8_t nonce[NONCE_SIZE],
+                uint32_t counter, const uint8_t* in, uint8_t* out, size_t len,
+                Impl impl = Impl::AUTO);
+
+void xor_stream(const KeySchedule& ks, const uint8_t nonce[NONCE_SIZE],
+                uint32_t counter, const uint8_t* in, uint8_t* out, size_t len,
+                Impl impl = Impl::AUTO);
+
+// Single keystream block (used for the Poly1305 one-time key).
+void block(const uint8_t key[KEY_SIZE], const uint8_t nonce[NONCE_SIZE],
+           uint32_t counter, uint8_t out[BLOCK_SIZE]);
+void block(const KeySchedule& ks, const uint8_t nonce[NONCE_SIZE],
+           uint32_t counter, uint8_t out[BLOCK_SIZE]);
+
+// ─── Independent Blocks ──────────────────────────────────────
+// One keystream block per lane, each lane with its own counter and nonce
+// (state words 12..15), all under one key. Lets many short messages fill
+// the SIMD registers that a single short message would leave mostly empty.
+
+using LaneWords = uint32_t[4];
+
+void   set_lane(LaneWords lane, uint32_t counter, const uint8_t nonce[NONCE_SIZE]);
+size_t lane_width(Impl impl);   // blocks per kernel call (1, 4 or 8)
+
+// Write `nlanes` 64-byte keystream blocks to out, one per lane
+void keystream_lanes(const KeySchedule& ks, const LaneWords* lanes, size_t nlanes,
+                     uint8_t* out, Impl impl = Impl::AUTO);
+
+// ─── Kernels (chacha20_simd.cpp) ─────────────────────────────
+// Each processes `nblocks` whole blocks starting at state[12].
+// Only called through xor_stream() once the kernel is known to be available.
+namespace detail {
+void xor_blocks_scalar(const uint32_t state[16], const uint8_t* in, uint8_t* out, size_t nblocks);
+void xor_blocks_sse2(const uint32_t state[16], const uint8_t* in, uint8_t* out, size_t nblocks);
+void xor_blocks_avx2(const uint32_t state[16], const uint8_t* in, uint8_t* out, size_t nblocks);
+void xor_blocks_neon(const uint32_t state[16], const uint8_t* in, uint8_t* out, size_t nblocks);
+
+// Independent-lane variants; nlanes is a multiple of the kernel width
+void keystream_lanes_scalar(const uint32_t key_words[12], const uint32_t (*lanes)[4],
+                            uint8_t* out, size_t nlanes);
+void keystream_lanes_sse2(const uint32_t key_words[12], const uint32_t (*lanes)[4],
+                          uint8_t* out, size_t nlanes);
+void keystream_lanes_avx2(const uint32_t key_words[12], const uint32_t (*lanes)[4],
+                          uint8_t* out, size_t nlanes);
+void keystream_lanes_neon(const uint32_t key_words[12], const uint32_t (*lanes)[4],
+                          uint8_t* out, size_t nlanes);
+} // namespace detail
+
+} // namespace chacha20
+} // namespace vos
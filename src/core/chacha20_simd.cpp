@@ -0,0 +1,320 @@
+/*
+ * ChaCha20 SIMD kernels.
+ * Each vector register holds the same state word for 4 (SSE2/NEON) or
+ * 8 (AVX2) consecutive blocks, so the rounds run on all blocks at once and
+ * a transpose at the end turns lanes back into contiguous keystream.
+ * The keystream_lanes kernels fill the counter/nonce words per lane
+ * instead, so unrelated messages under one key share the registers.
+ */
+#include "chacha20.h"
+#include "cpu_features.h"
+
+#if defined(VOS_ARCH_X86)
+#include <immintrin.h>
+#elif defined(VOS_ARCH_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace vos {
+namespace chacha20 {
+namespace detail {
+
+#define DOUBLE_ROUND(QR, x)                 \
+    QR(x[0], x[4], x[8],  x[12]);           \
+    QR(x[1], x[5], x[9],  x[13]);           \
+    QR(x[2], x[6], x[10], x[14]);           \
+    QR(x[3], x[7], x[11], x[15]);           \
+    QR(x[0], x[5], x[10], x[15]);           \
+    QR(x[1], x[6], x[11], x[12]);           \
+    QR(x[2], x[7], x[8],  x[13]);           \
+    QR(x[3], x[4], x[9],  x[14])
+
+#if defined(VOS_ARCH_X86)
+
+// ─── SSE2: 4 blocks ──────────────────────────────────────────
+
+#define SSE_ROTL(v, n)  _mm_or_si128(_mm_slli_epi32(v, n), _mm_srli_epi32(v, 32 - (n)))
+#define SSE_ROTL16(v)   _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xB1), 0xB1)
+
+#define SSE_QR(a, b, c, d)                                                  \
+    a = _mm_add_epi32(a, b); d = _mm_xor_si128(d, a); d = SSE_ROTL16(d);    \
+    c = _mm_add_epi32(c, d); b = _mm_xor_si128(b, c); b = SSE_ROTL(b, 12);  \
+    a = _mm_add_epi32(a, b); d = _mm_xor_si128(d, a); d = SSE_ROTL(d, 8);   \
+    c = _mm_add_epi32(c, d); b = _mm_xor_si128(b, c); b = SSE_ROTL(b, 7)
+
+// Rounds + feed-forward on 4 word-sliced states, then transpose and write
+// 4 blocks: out = in ^ keystream, or the bare keystream when in is null.
+VOS_TARGET("sse2")
+static inline void sse2_blocks(const __m128i s[16], const uint8_t* in, uint8_t* out) {
+    __m128i x[16];
+    for (int i = 0; i < 16; i++) x[i] = s[i];
+    for (int r = 0; r < 10; r++) {
+        DOUBLE_ROUND(SSE_QR, x);
+    }
+    for (int i = 0; i < 16; i++) x[i] = _mm_add_epi32(x[i], s[i]);
+
+    // Transpose each group of 4 words into 16 bytes of each block
+    for (int g = 0; g < 4; g++) {
+        __m128i t0 = _mm_unpacklo_epi32(x[4 * g],     x[4 * g + 1]);
+        __m128i t1 = _mm_unpacklo_epi32(x[4 * g + 2], x[4 * g + 3]);
+        __m128i t2 = _mm_unpackhi_epi32(x[4 * g],     x[4 * g + 1]);
+        __m128i t3 = _mm_unpackhi_epi32(x[4 * g + 2], x[4 * g + 3]);
+        __m128i b[4] = {
+            _mm_unpacklo_epi64(t0, t1), _mm_unpackhi_epi64(t0, t1),
+            _mm_unpacklo_epi64(t2, t3), _mm_unpackhi_epi64(t2, t3),
+        };
+        for (int j = 0; j < 4; j++) {
+            size_t off = (size_t)j * BLOCK_SIZE + 16 * (size_t)g;
+            if (in) b[j] = _mm_xor_si128(b[j], _mm_loadu_si128((const __m128i*)(in + off)));
+            _mm_storeu_si128((__m128i*)(out + off), b[j]);
+        }
+    }
+}
+
+VOS_TARGET("sse2")
+void xor_blocks_sse2(const uint32_t state[16], const uint8_t* in, uint8_t* out, size_t nblocks) {
+    uint32_t ctr = state[12];
+    for (size_t n = 0; n < nblocks; n += 4) {
+        __m128i s[16];
+        for (int i = 0; i < 16; i++) s[i] = _mm_set1_epi32((int)state[i]);
+        s[12] = _mm_setr_epi32((int)ctr, (int)(ctr + 1), (int)(ctr + 2), (int)(ctr + 3));
+        sse2_blocks(s, in, out);
+
+        in  += 4 * BLOCK_SIZE;
+        out += 4 * BLOCK_SIZE;
+        ctr += 4;
+    }
+}
+
+VOS_TARGET("sse2")
+void keystream_lanes_sse2(const uint32_t key_words[12], const uint32_t (*lanes)[4],
+                          uint8_t* out, size_t nlanes) {
+    for (size_t n = 0; n < nlanes; n += 4, lanes += 4, out += 4 * BLOCK_SIZE) {
+        __m128i s[16];
+        for (int i = 0; i < 12; i++) s[i] = _mm_set1_epi32((int)key_words[i]);
+        for (int w = 0; w < 4; w++) {
+            s[12 + w] = _mm_setr_epi32((int)lanes[0][w], (int)lanes[1][w],
+                                       (int)lanes[2][w], (int)lanes[3][w]);
+        }
+        sse2_blocks(s, nullptr, out);
+    }
+}
+
+// ─── AVX2: 8 blocks ──────────────────────────────────────────
+
+#define AVX_ROTL(v, n)    _mm256_or_si256(_mm256_slli_epi32(v, n), _mm256_srli_epi32(v, 32 - (n)))
+#define AVX_ROTB(v, mask) _mm256_shuffle_epi8(v, mask)
+
+#define AVX_QR(a, b, c, d)                                                          \
+    a = _mm256_add_epi32(a, b); d = _mm256_xor_si256(d, a); d = AVX_ROTB(d, rot16); \
+    c = _mm256_add_epi32(c, d); b = _mm256_xor_si256(b, c); b = AVX_ROTL(b, 12);    \
+    a = _mm256_add_epi32(a, b); d = _mm256_xor_si256(d, a); d = AVX_ROTB(d, rot8);  \
+    c = _mm256_add_epi32(c, d); b = _mm256_xor_si256(b, c); b = AVX_ROTL(b, 7)
+
+// As sse2_blocks, for 8 states
+VOS_TARGET("avx2")
+static inline void avx2_blocks(const __m256i s[16], const uint8_t* in, uint8_t* out) {
+    const __m256i rot16 = _mm256_setr_epi8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13,
+                                           2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+    const __m256i rot8  = _mm256_setr_epi8(3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14,
+                                           3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14);
+    __m256i x[16];
+    for (int i = 0; i < 16; i++) x[i] = s[i];
+    for (int r = 0; r < 10; r++) {
+        DOUBLE_ROUND(AVX_QR, x);
+    }
+    for (int i = 0; i < 16; i++) x[i] = _mm256_add_epi32(x[i], s[i]);
+
+    // 4x4 transpose inside each 128-bit half: after this, v[g][j] holds
+    // words 4g..4g+3 of block j (low half) and of block j+4 (high half).
+    __m256i v[4][4];
+    for (int g = 0; g < 4; g++) {
+        __m256i t0 = _mm256_unpacklo_epi32(x[4 * g],     x[4 * g + 1]);
+        __m256i t1 = _mm256_unpacklo_epi32(x[4 * g + 2], x[4 * g + 3]);
+        __m256i t2 = _mm256_unpackhi_epi32(x[4 * g],     x[4 * g + 1]);
+        __m256i t3 = _mm256_unpackhi_epi32(x[4 * g + 2], x[4 * g + 3]);
+        v[g][0] = _mm256_unpacklo_epi64(t0, t1);
+        v[g][1] = _mm256_unpackhi_epi64(t0, t1);
+        v[g][2] = _mm256_unpacklo_epi64(t2, t3);
+        v[g][3] = _mm256_unpackhi_epi64(t2, t3);
+    }
+
+    // Pair word groups (0,1) and (2,3) into 32 contiguous bytes per block
+    for (int j = 0; j < 4; j++) {
+        for (int h = 0; h < 2; h++) {
+            __m256i lo = _mm256_permute2x128_si256(v[2 * h][j], v[2 * h + 1][j], 0x20);
+            __m256i hi = _mm256_permute2x128_si256(v[2 * h][j], v[2 * h + 1][j], 0x31);
+
+            size_t off_lo = (size_t)j * BLOCK_SIZE + 32 * (size_t)h;
+            size_t off_hi = (size_t)(j + 4) * BLOCK_SIZE + 32 * (size_t)h;
+            if (in) {
+                lo = _mm256_xor_si256(lo, _mm256_loadu_si256((const __m256i*)(in + off_lo)));
+                hi = _mm256_xor_si256(hi, _mm256_loadu_si256((const __m256i*)(in + off_hi)));
+            }
+            _mm256_storeu_si256((__m256i*)(out + off_lo), lo);
+            _mm256_storeu_si256((__m256i*)(out + off_hi), hi);
+        }
+    }
+}
+
+VOS_TARGET("avx2")
+void xor_blocks_avx2(const uint32_t state[16], const uint8_t* in, uint8_t* out, size_t nblocks) {
+    uint32_t ctr = state[12];
+    for (size_t n = 0; n < nblocks; n += 8) {
+        __m256i s[16];
+        for (int i = 0; i < 16; i++) s[i] = _mm256_set1_epi32((int)state[i]);
+        s[12] = _mm256_setr_epi32((int)ctr,       (int)(ctr + 1), (int)(ctr + 2), (int)(ctr + 3),
+                                  (int)(ctr + 4), (int)(ctr + 5), (int)(ctr + 6), (int)(ctr + 7));
+        avx2_blocks(s, in, out);
+
+        in  += 8 * BLOCK_SIZE;
+        out += 8 * BLOCK_SIZE;
+        ctr += 8;
+    }
+}
+
+VOS_TARGET("avx2")
+void keystream_lanes_avx2(const uint32_t key_words[12], const uint32_t (*lanes)[4],
+                          uint8_t* out, size_t nlanes) {
+    for (size_t n = 0; n < nlanes; n += 8, lanes += 8, out += 8 * BLOCK_SIZE) {
+        __m256i s[16];
+        for (int i = 0; i < 12; i++) s[i] = _mm256_set1_epi32((int)key_words[i]);
+        for (int w = 0; w < 4; w++) {
+            s[12 + w] = _mm256_setr_epi32((int)lanes[0][w], (int)lanes[1][w], (int)lanes[2][w],
+                                          (int)lanes[3][w], (int)lanes[4][w], (int)lanes[5][w],
+                                          (int)lanes[6][w], (int)lanes[7][w]);
+        }
+        avx2_blocks(s, nullptr, out);
+    }
+}
+
+void xor_blocks_neon(const uint32_t state[16], const uint8_t* in, uint8_t* out, size_t nblocks) {
+    xor_blocks_scalar(state, in, out, nblocks);
+}
+
+void keystream_lanes_neon(const uint32_t key_words[12], const uint32_t (*lanes)[4],
+                          uint8_t* out, size_t nlanes) {
+    keystream_lanes_scalar(key_words, lanes, out, nlanes);
+}
+
+#elif defined(VOS_ARCH_NEON)
+
+// ─── NEON: 4 blocks ──────────────────────────────────────────
+
+#define NEON_ROTL(v, n) vsriq_n_u32(vshlq_n_u32(v, n), v, 32 - (n))
+#define NEON_ROTL16(v)  vreinterpretq_u32_u16(vrev32q_u16(vreinterpretq_u16_u32(v)))
+
+#define NEON_QR(a, b, c, d)                                           \
+    a = vaddq_u32(a, b); d = veorq_u32(d, a); d = NEON_ROTL16(d);     \
+    c = vaddq_u32(c, d); b = veorq_u32(b, c); b = NEON_ROTL(b, 12);   \
+    a = vaddq_u32(a, b); d = veorq_u32(d, a); d = NEON_ROTL(d, 8);    \
+    c = vaddq_u32(c, d); b = veorq_u32(b, c); b = NEON_ROTL(b, 7)
+
+// As sse2_blocks, for NEON
+static inline void neon_blocks(const uint32x4_t s[16], const uint8_t* in, uint8_t* out) {
+    uint32x4_t x[16];
+    for (int i = 0; i < 16; i++) x[i] = s[i];
+    for (int r = 0; r < 10; r++) {
+        DOUBLE_ROUND(NEON_QR, x);
+    }
+    for (int i = 0; i < 16; i++) x[i] = vaddq_u32(x[i], s[i]);
+
+    for (int g = 0; g < 4; g++) {
+        uint32x4x2_t ab = vtrnq_u32(x[4 * g],     x[4 * g + 1]);
+        uint32x4x2_t cd = vtrnq_u32(x[4 * g + 2], x[4 * g + 3]);
+        uint32x4_t b[4] = {
+            vcombine_u32(vget_low_u32(ab.val[0]),  vget_low_u32(cd.val[0])),
+            vcombine_u32(vget_low_u32(ab.val[1]),  vget_low_u32(cd.val[1])),
+            vcombine_u32(vget_high_u32(ab.val[0]), vget_high_u32(cd.val[0])),
+            vcombine_u32(vget_high_u32(ab.val[1]), vget_high_u32(cd.val[1])),
+        };
+        for (int j = 0; j < 4; j++) {
+            size_t off = (size_t)j * BLOCK_SIZE + 16 * (size_t)g;
+            uint8x16_t k = vreinterpretq_u8_u32(b[j]);
+            if (in) k = veorq_u8(k, vld1q_u8(in + off));
+            vst1q_u8(out + off, k);
+        }
+    }
+}
+
+void xor_blocks_neon(const uint32_t state[16], const uint8_t* in, uint8_t* out, size_t nblocks) {
+    uint32_t ctr = state[12];
+    for (size_t n = 0; n < nblocks; n += 4) {
+        uint32x4_t s[16];
+        for (int i = 0; i < 16; i++) s[i] = vdupq_n_u32(state[i]);
+        const uint32_t ctrs[4] = { ctr, ctr + 1, ctr + 2, ctr + 3 };
+        s[12] = vld1q_u32(ctrs);
+        neon_blocks(s, in, out);
+
+        in  += 4 * BLOCK_SIZE;
+        out += 4 * BLOCK_SIZE;
+        ctr += 4;
+    }
+}
+
+void keystream_lanes_neon(const uint32_t key_words[12], const uint32_t (*lanes)[4],
+                          uint8_t* out, size_t nlanes) {
+    for (size_t n = 0; n < nlanes; n += 4, lanes += 4, out += 4 * BLOCK_SIZE) {
+        uint32x4_t s[16];
+        for (int i = 0; i < 12; i++) s[i] = vdupq_n_u32(key_words[i]);
+        for (int w = 0; w < 4; w++) {
+            const uint32_t v[4] = { lanes[0][w], lanes[1][w], lanes[2][w], lanes[3][w] };
+            s[12 + w] = vld1q_u32(v);
+        }
+        neon_blocks(s, nullptr, out);
+    }
+}
+
+void xor_blocks_sse2(const uint32_t state[16], const uint8_t* in, uint8_t* out, size_t nblocks) {
+    xor_blocks_scalar(state, in, out, nblocks);
+}
+
+void xor_blocks_avx2(const uint32_t state[16], const uint8_t* in, uint8_t* out, size_t nblocks) {
+    xor_blocks_scalar(state, in, out, nblocks);
+}
+
+void keystream_lanes_sse2(const uint32_t key_words[12], const uint32_t (*lanes)[4],
+                          uint8_t* out, size_t nlanes) {
+    keystream_lanes_scalar(key_words, lanes, out, nlanes);
+}
+
+void keystream_lanes_avx2(const uint32_t key_words[12], const uint32_t (*lanes)[4],
+                          uint8_t* out, size_t nlanes) {
+    keystream_lanes_scalar(key_words, lanes, out, nlanes);
+}
+
+#else
+
+// No SIMD on this target — impl_available() never selects these.
+void xor_blocks_sse2(const uint32_t state[16], const uint8_t* in, uint8_t* out, size_t nblocks) {
+    xor_blocks_scalar(state, in, out, nblocks);
+}
+
+void xor_blocks_avx2(const uint32_t state[16], const uint8_t* in, uint8_t* out, size_t nblocks) {
+    xor_blocks_scalar(state, in, out, nblocks);
+}
+
+void xor_blocks_neon(const uint32_t state[16], const uint8_t* in, uint8_t* out, size_t nblocks) {
+    xor_blocks_scalar(state, in, out, nblocks);
+}
+
+void keystream_lanes_sse2(const uint32_t key_words[12], const uint32_t (*lanes)[4],
+                          uint8_t* out, size_t nlanes) {
+    keystream_lanes_scalar(key_words, lanes, out, nlanes);
+}
+
+void keystream_lanes_avx2(const uint32_t key_words[12], const uint32_t (*lanes)[4],
+                          uint8_t* out, size_t nlanes) {
+    keystream_lanes_scalar(key_words, lanes, out, nlanes);
+}
+
+void keystream_lanes_neon(const uint32_t key_words[12], const uint32_t (*lanes)[4],
+                          uint8_t* out, size_t nlanes) {
+    keystream_lanes_scalar(key_words, lanes, out, nlanes);
+}
+
+#endif
+
+} // namespace detail
+} // namespace chacha20
+} // namespace vos
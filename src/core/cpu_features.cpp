@@ -0,0 +1,68 @@
+#include "cpu_features.h"
+#include <cstdint>
+
+#if defined(VOS_ARCH_X86)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace vos {
+
+#if defined(VOS_ARCH_X86)
+static void cpuid(unsigned leaf, unsigned sub, unsigned r[4]) {
+#if defined(_MSC_VER)
+    __cpuidex(reinterpret_cast<int*>(r), (int)leaf, (int)sub);
+#else
+    __cpuid_count(leaf, sub, r[0], r[1], r[2], r[3]);
+#endif
+}
+
+// XCR0: which register files the OS saves on context switch
+static uint64_t xgetbv0() {
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    uint32_t lo, hi;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return ((uint64_t)hi << 32) | lo;
+#endif
+}
+#endif
+
+static CpuFeatures detect() {
+    CpuFeatures f;
+#if defined(VOS_ARCH_X86)
+    unsigned r[4];
+    cpuid(0, 0, r);
+    unsigned max_leaf = r[0];
+
+    cpuid(1, 0, r);
+    f.sse2   = (r[3] & (1u << 26)) != 0;
+    f.ssse3  = (r[2] & (1u << 9))  != 0;
+    f.sse41  = (r[2] & (1u << 19)) != 0;
+    f.pclmul = (r[2] & (1u << 1))  != 0;
+    f.aesni  = (r[2] & (1u << 25)) != 0;
+    bool osxsave = (r[2] & (1u << 27)) != 0;
+    bool ymm_ok  = osxsave && ((xgetbv0() & 0x6) == 0x6);
+
+    if (max_leaf >= 7) {
+        cpuid(7, 0, r);
+        f.avx2 = ymm_ok && (r[1] & (1u << 5)) != 0;
+        f.sha  = (r[1] & (1u << 29)) != 0;
+    }
+#elif defined(VOS_ARCH_NEON)
+    // Advanced SIMD is mandatory on AArch64 and was required at build time on ARMv7
+    f.neon = true;
+#endif
+    return f;
+}
+
+const CpuFeatures& cpu_features() {
+    static const CpuFeatures f = detect();
+    return f;
+}
+
+} // namespace vos
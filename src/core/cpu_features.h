@@ -0,0 +1,40 @@
+#pragma once
+
+/*
+ * VOS — Runtime CPU feature detection
+ * Used to pick SIMD / hardware crypto kernels once at startup.
+ */
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define VOS_ARCH_X86 1
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64) || (defined(__ARM_NEON) && defined(__arm__))
+#define VOS_ARCH_NEON 1
+#endif
+
+// Compile a single function for an instruction set the TU is not built for.
+// MSVC exposes all intrinsics unconditionally, so the attribute is a no-op there.
+#if defined(__GNUC__) || defined(__clang__)
+#define VOS_TARGET(isa) __attribute__((target(isa)))
+#else
+#define VOS_TARGET(isa)
+#endif
+
+namespace vos {
+
+struct CpuFeatures {
+    bool sse2    = false;
+    bool ssse3   = false;
+    bool sse41   = false;
+    bool avx2    = false;
+    bool aesni   = false;
+    bool pclmul  = false;
+    bool sha     = false;
+    bool neon    = false;
+};
+
+// Detected once, then cached
+const CpuFeatures& cpu_features();
+
+} // namespace vos
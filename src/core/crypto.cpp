@@ -1,6 +1,7 @@
 #include "crypto.h"
+#include "aead.h"
+#include "drbg.h"
 #include "vos/log.h"
-#include <random>
 #include <algorithm>
 #include <cstring>
 
@@ -8,67 +9,210 @@ namespace vos {
 
 static const char* TAG = "Crypto";
 
+const char* algo_name(CipherAlgo algo) {
+    switch (algo) {
+        case CipherAlgo::CHACHA20_POLY1305: return "ChaCha20-Poly1305";
+        case CipherAlgo::AES_256_GCM:       return "AES-256-GCM";
+    }
+    return "unknown";
+}
+
 Crypto::Crypto() = default;
 
 Result<void> Crypto::init() {
     m_initialized = true;
-    log::info(TAG, "Crypto engine initialized (demo mode — use libsodium for production)");
+    log::info(TAG, "Crypto engine initialized (%s; chacha20 %s, aes-gcm %s)",
+              algo_name(m_algo), chacha20::impl_name(m_impl),
+              aes_gcm::impl_name(aes_gcm::best_impl()));
     return Result<void>::success();
 }
 
+CipherAlgo Crypto::best_algorithm() {
+    return aes_gcm::best_impl() == aes_gcm::Impl::AESNI ? CipherAlgo::AES_256_GCM
+                                                         : CipherAlgo::CHACHA20_POLY1305;
+}
+
 ByteBuffer Crypto::random_bytes(size_t count) {
     ByteBuffer buf(count);
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<uint16_t> dist(0, 255);
-    for (size_t i = 0; i < count; i++) {
-        buf[i] = static_cast<uint8_t>(dist(gen));
-    }
+    random_fill(buf);
     return buf;
 }
 
+void Crypto::random_fill(ByteSpan out) {
+    ChaChaDrbg::thread_local_instance().fill(out);
+}
+
 ByteBuffer Crypto::generate_key() {
     return random_bytes(32); // 256-bit
 }
 
+// ─── AEAD ────────────────────────────────────────────────────
+
+// Raw-key entry points expand the key on every call; CryptoSession keeps
+// the expansion instead.
+static void seal_raw(CipherAlgo algo, chacha20::Impl impl, const uint8_t* key,
+                     const uint8_t* nonce, const uint8_t* in, uint8_t* out, size_t len,
+                     uint8_t* tag) {
+    if (algo == CipherAlgo::AES_256_GCM) {
+        aes_gcm::KeySchedule ks;
+        aes_gcm::expand_key(ks, key);
+        aes_gcm::seal(ks, nonce, nullptr, 0, in, out, len, tag);
+        volatile uint8_t* v = reinterpret_cast<volatile uint8_t*>(&ks);
+        for (size_t i = 0; i < sizeof(ks); i++) v[i] = 0;
+    } else {
+        aead::chacha20_poly1305_seal(key, nonce, nullptr, 0, in, out, len, tag, impl);
+    }
+}
+
+static bool open_raw(CipherAlgo algo, chacha20::Impl impl, const uint8_t* key,
+                     const uint8_t* nonce, const uint8_t* in, uint8_t* out, size_t len,
+                     const uint8_t* tag) {
+    if (algo == CipherAlgo::AES_256_GCM) {
+        aes_gcm::KeySchedule ks;
+        aes_gcm::expand_key(ks, key);
+        bool ok = aes_gcm::open(ks, nonce, nullptr, 0, in, out, len, tag);
+        volatile uint8_t* v = reinterpret_cast<volatile uint8_t*>(&ks);
+        for (size_t i = 0; i < sizeof(ks); i++) v[i] = 0;
+        return ok;
+    }
+    return aead::chacha20_poly1305_open(key, nonce, nullptr, 0, in, out, len, tag, impl);
+}
+
+Result<void> Crypto::seal_in_place(ByteSpan record, const ByteBuffer& key) {
+    if (key.size() != KEY_SIZE || record.size() < OVERHEAD) {
+        return Result<void>::error(StatusCode::ERR_INVALID_ARG);
+    }
+    size_t   len   = record.size() - OVERHEAD;
+    uint8_t* nonce = record.data();
+    uint8_t* body  = nonce + NONCE_SIZE;
+
+    random_fill(ByteSpan(nonce, NONCE_SIZE));
+    seal_raw(m_algo, m_impl, key.data(), nonce, body, body, len, body + len);
+    return Result<void>::success();
+}
+
+Result<ByteSpan> Crypto::open_in_place(ByteSpan record, const ByteBuffer& key) {
+    if (key.size() != KEY_SIZE || record.size() < OVERHEAD) {
+        return Result<ByteSpan>::error(StatusCode::ERR_INVALID_ARG);
+    }
+    size_t   len   = record.size() - OVERHEAD;
+    uint8_t* nonce = record.data();
+    uint8_t* body  = nonce + NONCE_SIZE;
+
+    if (!open_raw(m_algo, m_impl, key.data(), nonce, body, body, len, body + len)) {
+        log::warn(TAG, "decrypt: authentication failed");
+        return Result<ByteSpan>::error(StatusCode::ERR_CRYPTO);
+    }
+    return Result<ByteSpan>::success(ByteSpan(body, len));
+}
+
+Result<void> Crypto::seal_batch(const ByteSpan* records, size_t count, const ByteBuffer& key) {
+    if (key.size() != KEY_SIZE) return Result<void>::error(StatusCode::ERR_INVALID_ARG);
+    for (size_t i = 0; i < count; i++) {
+        if (records[i].size() < OVERHEAD) return Result<void>::error(StatusCode::ERR_INVALID_ARG);
+    }
+    if (m_algo != CipherAlgo::CHACHA20_POLY1305) {
+        // AES-NI already keeps its pipeline full within one record
+        for (size_t i = 0; i < count; i++) seal_in_place(records[i], key);
+        return Result<void>::success();
+    }
+    for (size_t i = 0; i < count; i++) random_fill(ByteSpan(records[i].data(), NONCE_SIZE));
+
+    chacha20::KeySchedule ks;
+    chacha20::expand_key(ks, key.data());
+    aead::chacha20_poly1305_seal_batch(ks, records, count, m_impl);
+    return Result<void>::success();
+}
+
+size_t Crypto::open_batch(const ByteSpan* records, size_t count, bool* ok, const ByteBuffer& key) {
+    if (key.size() != KEY_SIZE) {
+        std::fill(ok, ok + count, false);
+        return 0;
+    }
+    size_t passed = 0;
+    if (m_algo != CipherAlgo::CHACHA20_POLY1305) {
+        for (size_t i = 0; i < count; i++) {
+            ok[i] = open_in_place(records[i], key).ok();
+            passed += ok[i];
+        }
+        return passed;
+    }
+    chacha20::KeySchedule ks;
+    chacha20::expand_key(ks, key.data());
+    passed = aead::chacha20_poly1305_open_batch(ks, records, count, ok, m_impl);
+    if (passed != count) {
+        log::warn(TAG, "open_batch: %zu of %zu records failed authentication",
+                  count - passed, count);
+    }
+    return passed;
+}
+
 ByteBuffer Crypto::encrypt(const ByteBuffer& plaintext, const ByteBuffer& key) {
-    // XOR cipher for demo — replace with AES-256-GCM in production
-    ByteBuffer out(plaintext.size());
-    for (size_t i = 0; i < plaintext.size(); i++) {
-        out[i] = plaintext[i] ^ key[i % key.size()];
+    if (key.size() != KEY_SIZE) {
+        log::error(TAG, "encrypt: key must be %zu bytes (got %zu)", KEY_SIZE, key.size());
+        return {};
+    }
+
+    ByteBuffer out(OVERHEAD + plaintext.size());
+    if (!plaintext.empty()) {
+        std::memcpy(out.data() + NONCE_SIZE, plaintext.data(), plaintext.size());
     }
+    seal_in_place(out, key);
     return out;
 }
 
-ByteBuffer Crypto::decrypt(const ByteBuffer& ciphertext, const ByteBuffer& key) {
-    // XOR is symmetric
-    return encrypt(ciphertext, key);
-}
+Result<ByteBuffer> Crypto::decrypt(const ByteBuffer& ciphertext, const ByteBuffer& key) {
+    if (key.size() != KEY_SIZE || ciphertext.size() < OVERHEAD) {
+        return Result<ByteBuffer>::error(StatusCode::ERR_INVALID_ARG);
+    }
 
-ByteBuffer Crypto::hmac(const ByteBuffer& data, const ByteBuffer& key) {
-    // Simple hash-based MAC for demo
-    // In production: HMAC-SHA256 via libsodium
-    ByteBuffer mac(32, 0);
-    for (size_t i = 0; i < data.size(); i++) {
-        mac[i % 32] ^= data[i] ^ key[i % key.size()];
+    // Verify before decrypting so a forged message never produces plaintext
+    size_t len = ciphertext.size() - OVERHEAD;
+    const uint8_t* nonce = ciphertext.data();
+    const uint8_t* ct    = nonce + NONCE_SIZE;
+    const uint8_t* tag   = ct + len;
+
+    ByteBuffer out(len);
+    if (!open_raw(m_algo, m_impl, key.data(), nonce, ct, out.data(), len, tag)) {
+        log::warn(TAG, "decrypt: authentication failed");
+        return Result<ByteBuffer>::error(StatusCode::ERR_CRYPTO);
     }
-    // Second pass for mixing
-    for (size_t i = 0; i < 32; i++) {
-        mac[i] = static_cast<uint8_t>((mac[i] * 31 + key[i % key.size()]) & 0xFF);
+    return Result<ByteBuffer>::success(std::move(out));
+}
+
+// ─── MAC ─────────────────────────────────────────────────────
+
+ByteBuffer Crypto::hash(const ByteBuffer& data) {
+    ByteBuffer digest(HASH_SIZE);
+    Sha256::hash(data.data(), data.size(), digest.data());
+    return digest;
+}
+
+Result<void> Crypto::hmac_into(ConstByteSpan data, const ByteBuffer& key, ByteSpan mac) {
+    if (key.empty() || mac.size() < MAC_SIZE) {
+        return Result<void>::error(StatusCode::ERR_INVALID_ARG);
     }
+    HmacSha256::mac(key.data(), key.size(), data.data(), data.size(), mac.data());
+    return Result<void>::success();
+}
+
+ByteBuffer Crypto::hmac(const ByteBuffer& data, const ByteBuffer& key) {
+    ByteBuffer mac(MAC_SIZE, 0);
+    hmac_into(data, key, mac);
     return mac;
 }
 
+bool Crypto::hmac_verify(ConstByteSpan data, const ByteBuffer& key, ConstByteSpan expected) {
+    if (expected.size() != MAC_SIZE) return false;
+    uint8_t computed[MAC_SIZE];
+    if (!hmac_into(data, key, ByteSpan(computed, MAC_SIZE)).ok()) return false;
+    // Constant-time comparison
+    return aead::equal(computed, expected.data(), MAC_SIZE);
+}
+
 bool Crypto::hmac_verify(const ByteBuffer& data, const ByteBuffer& key,
                          const ByteBuffer& expected) {
-    auto computed = hmac(data, key);
-    if (computed.size() != expected.size()) return false;
-    // Constant-time comparison
-    uint8_t diff = 0;
-    for (size_t i = 0; i < computed.size(); i++) {
-        diff |= computed[i] ^ expected[i];
-    }
-    return diff == 0;
+    return hmac_verify(ConstByteSpan(data), key, ConstByteSpan(expected));
 }
 
 } // namespace vos
@@ -1,18 +1,47 @@
 #pragma once
 
 #include "vos/types.h"
+#include "chacha20.h"
+#include "aes_gcm.h"
+#include "sha256.h"
 #include <string>
 
 namespace vos {
 
+// Sealed-record algorithms. The values are stored in persisted headers —
+// never renumber.
+enum class CipherAlgo : uint8_t {
+    CHACHA20_POLY1305 = 1,   // Default; fast everywhere via SIMD
+    AES_256_GCM       = 2,   // Fastest where AES-NI + PCLMULQDQ exist
+};
+
+const char* algo_name(CipherAlgo algo);
+
 /*
- * Minimal crypto wrapper.
- * In production, this would wrap libsodium or OpenSSL.
- * For now, we use a simple XOR-based cipher for demonstration,
- * with the interface designed for drop-in replacement.
+ * Crypto engine.
+ * Symmetric encryption is ChaCha20-Poly1305 (RFC 8439) or AES-256-GCM,
+ * chosen per instance with set_algorithm(); both are implemented in-tree
+ * with kernels picked at runtime (see chacha20.h, aes_gcm.h).
+ *
+ * Sealed format produced by encrypt(), identical for both algorithms:
+ * [NONCE:12][CIPHERTEXT:N][TAG:16]. The format does not name the
+ * algorithm; whoever stores records records that (see VFSPersistence).
+ *
+ * MACs are HMAC-SHA256. For data that arrives in pieces, use the streaming
+ * contexts directly (HashContext / MacContext: init, update..., finish).
  */
 class Crypto {
 public:
+    static constexpr size_t KEY_SIZE   = 32;
+    static constexpr size_t NONCE_SIZE = 12;
+    static constexpr size_t TAG_SIZE   = 16;
+    static constexpr size_t OVERHEAD   = NONCE_SIZE + TAG_SIZE;
+    static constexpr size_t MAC_SIZE   = HmacSha256::MAC_SIZE;
+    static constexpr size_t HASH_SIZE  = Sha256::DIGEST_SIZE;
+
+    using HashContext = Sha256;
+    using MacContext  = HmacSha256;
+
     Crypto();
     ~Crypto() = default;
 
@@ -21,20 +50,55 @@ public:
     // Generate a random 256-bit key
     ByteBuffer generate_key();
 
-    // Encrypt/Decrypt with a given key
-    ByteBuffer encrypt(const ByteBuffer& plaintext, const ByteBuffer& key);
-    ByteBuffer decrypt(const ByteBuffer& ciphertext, const ByteBuffer& key);
+    // Authenticated encryption with a 256-bit key.
+    // decrypt() fails with ERR_CRYPTO if the data was tampered with or the key is wrong.
+    ByteBuffer         encrypt(const ByteBuffer& plaintext, const ByteBuffer& key);
+    Result<ByteBuffer> decrypt(const ByteBuffer& ciphertext, const ByteBuffer& key);
+
+    // In-place AEAD on a caller-owned record laid out as
+    // [NONCE:12][PLAINTEXT:N][TAG:16] — seal fills the nonce, encrypts the
+    // middle and writes the tag; open verifies and returns the plaintext
+    // view inside the record. Neither allocates.
+    Result<void>     seal_in_place(ByteSpan record, const ByteBuffer& key);
+    Result<ByteSpan> open_in_place(ByteSpan record, const ByteBuffer& key);
 
-    // HMAC for integrity
-    ByteBuffer hmac(const ByteBuffer& data, const ByteBuffer& key);
-    bool       hmac_verify(const ByteBuffer& data, const ByteBuffer& key,
-                           const ByteBuffer& expected);
+    // Batch form of the above for many small records under one key: the
+    // cipher works on several records at once. seal fills every nonce; open
+    // authenticates every record before decrypting any, sets ok[i] per
+    // record and returns how many passed.
+    Result<void> seal_batch(const ByteSpan* records, size_t count, const ByteBuffer& key);
+    size_t       open_batch(const ByteSpan* records, size_t count, bool* ok,
+                            const ByteBuffer& key);
+
+    // SHA-256
+    ByteBuffer hash(const ByteBuffer& data);
+
+    // HMAC-SHA256 for integrity
+    ByteBuffer   hmac(const ByteBuffer& data, const ByteBuffer& key);
+    Result<void> hmac_into(ConstByteSpan data, const ByteBuffer& key, ByteSpan mac_out);
+    bool         hmac_verify(const ByteBuffer& data, const ByteBuffer& key,
+                             const ByteBuffer& expected);
+    bool         hmac_verify(ConstByteSpan data, const ByteBuffer& key, ConstByteSpan expected);
 
     // Random bytes
     ByteBuffer random_bytes(size_t count);
+    void       random_fill(ByteSpan out);
+
+    // Algorithm for this instance's seal/open/encrypt/decrypt
+    void       set_algorithm(CipherAlgo algo) { m_algo = algo; }
+    CipherAlgo algorithm() const { return m_algo; }
+
+    // AES-256-GCM when the CPU accelerates it, ChaCha20-Poly1305 otherwise
+    static CipherAlgo best_algorithm();
+
+    // ChaCha20 kernel selection (AUTO = widest the CPU supports)
+    void           set_cipher_impl(chacha20::Impl impl) { m_impl = impl; }
+    chacha20::Impl cipher_impl() const { return m_impl; }
 
 private:
-    bool m_initialized = false;
+    bool           m_initialized = false;
+    CipherAlgo     m_algo        = CipherAlgo::CHACHA20_POLY1305;
+    chacha20::Impl m_impl        = chacha20::Impl::AUTO;
 };
 
 } // namespace vos
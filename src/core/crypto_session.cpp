@@ -0,0 +1,209 @@
+#include "crypto_session.h"
+#include "aead.h"
+#include "drbg.h"
+#include "vos/log.h"
+#include <algorithm>
+#include <cstring>
+
+namespace vos {
+
+static const char* TAG = "CryptoSession";
+
+static void wipe(void* p, size_t len) {
+    volatile uint8_t* v = static_cast<volatile uint8_t*>(p);
+    for (size_t i = 0; i < len; i++) v[i] = 0;
+}
+
+CryptoSession::~CryptoSession() {
+    clear();
+}
+
+CryptoSession::CryptoSession(CryptoSession&& other) noexcept {
+    *this = std::move(other);
+}
+
+CryptoSession& CryptoSession::operator=(CryptoSession&& other) noexcept {
+    if (this != &other) {
+        m_cipher = other.m_cipher;
+        m_aes    = other.m_aes;
+        m_mac    = other.m_mac;
+        std::memcpy(m_fingerprint, other.m_fingerprint, FINGERPRINT_SIZE);
+        m_algo   = other.m_algo;
+        m_impl   = other.m_impl;
+        m_valid  = other.m_valid;
+        other.clear();
+    }
+    return *this;
+}
+
+Result<void> CryptoSession::set_key(ConstByteSpan key) {
+    if (key.size() != KEY_SIZE) {
+        log::error(TAG, "Key must be %zu bytes (got %zu)", KEY_SIZE, key.size());
+        clear();
+        return Result<void>::error(StatusCode::ERR_INVALID_ARG);
+    }
+    chacha20::expand_key(m_cipher, key.data());
+    aes_gcm::expand_key(m_aes, key.data());
+    m_mac.init(key.data(), key.size());
+    m_mac.update(key);
+    m_mac.finish(m_fingerprint);
+    m_valid = true;
+    return Result<void>::success();
+}
+
+void CryptoSession::clear() {
+    wipe(&m_cipher, sizeof(m_cipher));
+    wipe(&m_aes, sizeof(m_aes));
+    wipe(m_fingerprint, sizeof(m_fingerprint));
+    m_mac   = HmacSha256();
+    m_valid = false;
+}
+
+// ─── AEAD ────────────────────────────────────────────────────
+
+bool CryptoSession::seal_body(CipherAlgo algo, const uint8_t* nonce, const uint8_t* in,
+                              uint8_t* out, size_t len, uint8_t* tag, ConstByteSpan aad) const {
+    switch (algo) {
+        case CipherAlgo::CHACHA20_POLY1305:
+            aead::chacha20_poly1305_seal(m_cipher, nonce, aad.data(), aad.size(), in, out, len, tag, m_impl);
+            return true;
+        case CipherAlgo::AES_256_GCM:
+            aes_gcm::seal(m_aes, nonce, aad.data(), aad.size(), in, out, len, tag);
+            return true;
+    }
+    return false;
+}
+
+bool CryptoSession::open_body(CipherAlgo algo, const uint8_t* nonce, const uint8_t* in,
+                              uint8_t* out, size_t len, const uint8_t* tag, ConstByteSpan aad) const {
+    switch (algo) {
+        case CipherAlgo::CHACHA20_POLY1305:
+            return aead::chacha20_poly1305_open(m_cipher, nonce, aad.data(), aad.size(),
+                                                in, out, len, tag, m_impl);
+        case CipherAlgo::AES_256_GCM:
+            return aes_gcm::open(m_aes, nonce, aad.data(), aad.size(), in, out, len, tag);
+    }
+    return false;
+}
+
+Result<void> CryptoSession::seal_in_place(ByteSpan record, CipherAlgo algo, ConstByteSpan aad) const {
+    if (!m_valid || record.size() < Crypto::OVERHEAD) {
+        return Result<void>::error(StatusCode::ERR_INVALID_ARG);
+    }
+    size_t   len   = record.size() - Crypto::OVERHEAD;
+    uint8_t* nonce = record.data();
+    uint8_t* body  = nonce + Crypto::NONCE_SIZE;
+
+    secure_random(ByteSpan(nonce, Crypto::NONCE_SIZE));
+    if (!seal_body(algo, nonce, body, body, len, body + len, aad)) {
+        return Result<void>::error(StatusCode::ERR_INVALID_ARG);
+    }
+    return Result<void>::success();
+}
+
+Result<ByteSpan> CryptoSession::open_in_place(ByteSpan record, CipherAlgo algo, ConstByteSpan aad) const {
+    if (!m_valid || record.size() < Crypto::OVERHEAD) {
+        return Result<ByteSpan>::error(StatusCode::ERR_INVALID_ARG);
+    }
+    size_t   len   = record.size() - Crypto::OVERHEAD;
+    uint8_t* nonce = record.data();
+    uint8_t* body  = nonce + Crypto::NONCE_SIZE;
+
+    if (!open_body(algo, nonce, body, body, len, body + len, aad)) {
+        log::warn(TAG, "decrypt: authentication failed");
+        return Result<ByteSpan>::error(StatusCode::ERR_CRYPTO);
+    }
+    return Result<ByteSpan>::success(ByteSpan(body, len));
+}
+
+ByteBuffer CryptoSession::encrypt(ConstByteSpan plaintext) const {
+    if (!m_valid) {
+        log::error(TAG, "encrypt: no key set");
+        return {};
+    }
+    ByteBuffer out(Crypto::OVERHEAD + plaintext.size());
+    if (!plaintext.empty()) {
+        std::memcpy(out.data() + Crypto::NONCE_SIZE, plaintext.data(), plaintext.size());
+    }
+    seal_in_place(out);
+    return out;
+}
+
+Result<ByteBuffer> CryptoSession::decrypt(ConstByteSpan ciphertext) const {
+    if (!m_valid || ciphertext.size() < Crypto::OVERHEAD) {
+        return Result<ByteBuffer>::error(StatusCode::ERR_INVALID_ARG);
+    }
+    size_t len = ciphertext.size() - Crypto::OVERHEAD;
+    const uint8_t* nonce = ciphertext.data();
+    const uint8_t* ct    = nonce + Crypto::NONCE_SIZE;
+
+    ByteBuffer out(len);
+    if (!open_body(m_algo, nonce, ct, out.data(), len, ct + len)) {
+        log::warn(TAG, "decrypt: authentication failed");
+        return Result<ByteBuffer>::error(StatusCode::ERR_CRYPTO);
+    }
+    return Result<ByteBuffer>::success(std::move(out));
+}
+
+Result<void> CryptoSession::seal_batch(const ByteSpan* records, size_t count) const {
+    if (!m_valid) return Result<void>::error(StatusCode::ERR_INVALID_ARG);
+    for (size_t i = 0; i < count; i++) {
+        if (records[i].size() < Crypto::OVERHEAD) {
+            return Result<void>::error(StatusCode::ERR_INVALID_ARG);
+        }
+    }
+    if (m_algo != CipherAlgo::CHACHA20_POLY1305) {
+        // AES-NI already keeps its pipeline full within one record
+        for (size_t i = 0; i < count; i++) seal_in_place(records[i]);
+        return Result<void>::success();
+    }
+    for (size_t i = 0; i < count; i++) {
+        secure_random(ByteSpan(records[i].data(), Crypto::NONCE_SIZE));
+    }
+    aead::chacha20_poly1305_seal_batch(m_cipher, records, count, m_impl);
+    return Result<void>::success();
+}
+
+size_t CryptoSession::open_batch(const ByteSpan* records, size_t count, bool* ok) const {
+    if (!m_valid) {
+        std::fill(ok, ok + count, false);
+        return 0;
+    }
+    size_t passed = 0;
+    if (m_algo != CipherAlgo::CHACHA20_POLY1305) {
+        for (size_t i = 0; i < count; i++) {
+            ok[i] = open_in_place(records[i]).ok();
+            passed += ok[i];
+        }
+        return passed;
+    }
+    passed = aead::chacha20_poly1305_open_batch(m_cipher, records, count, ok, m_impl);
+    if (passed != count) {
+        log::warn(TAG, "open_batch: %zu of %zu records failed authentication",
+                  count - passed, count);
+    }
+    return passed;
+}
+
+// ─── MAC ─────────────────────────────────────────────────────
+
+Result<void> CryptoSession::mac_into(ConstByteSpan data, ByteSpan mac) const {
+    if (!m_valid || mac.size() < Crypto::MAC_SIZE) {
+        return Result<void>::error(StatusCode::ERR_INVALID_ARG);
+    }
+    // Copying the keyed context is a few hundred bytes of memcpy — far
+    // cheaper than rehashing the key — and keeps this const
+    HmacSha256 ctx = m_mac;
+    ctx.update(data);
+    ctx.finish(mac.data());
+    return Result<void>::success();
+}
+
+bool CryptoSession::mac_verify(ConstByteSpan data, ConstByteSpan expected) const {
+    if (expected.size() != Crypto::MAC_SIZE) return false;
+    uint8_t computed[Crypto::MAC_SIZE];
+    if (!mac_into(data, ByteSpan(computed, sizeof(computed))).ok()) return false;
+    return aead::equal(computed, expected.data(), Crypto::MAC_SIZE);
+}
+
+} // namespace vos
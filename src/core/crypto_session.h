@@ -0,0 +1,92 @@
+#pragma once
+
+#include "vos/types.h"
+#include "crypto.h"
+#include "chacha20.h"
+#include "aes_gcm.h"
+#include "sha256.h"
+
+namespace vos {
+
+/*
+ * A key with its schedule precomputed.
+ * set_key() expands the ChaCha20 key, the AES-256 round keys with the
+ * GHASH powers, and the HMAC inner/outer midstates once; every seal/open/MAC afterwards starts from them instead of the raw
+ * bytes. The raw key is not kept, and all key material is wiped on clear()
+ * and destruction.
+ *
+ * Same record formats as Crypto, so the two interoperate:
+ *   sealed record: [NONCE:12][CIPHERTEXT:N][TAG:16]
+ *   MAC:           HMAC-SHA256(key, data)
+ *
+ * Both AEAD algorithms are ready after set_key(); set_algorithm() picks
+ * the default, and the explicit-algorithm overloads serve callers that
+ * store the algorithm next to the record (VFSPersistence).
+ *
+ * Only set_key()/clear()/set_algorithm() modify the session; seal/open/MAC may run from
+ * several threads at once.
+ */
+class CryptoSession {
+public:
+    static constexpr size_t KEY_SIZE         = Crypto::KEY_SIZE;
+    static constexpr size_t FINGERPRINT_SIZE = Crypto::MAC_SIZE;
+
+    CryptoSession() = default;
+    explicit CryptoSession(ConstByteSpan key) { set_key(key); }
+    ~CryptoSession();
+
+    CryptoSession(const CryptoSession&)            = delete;
+    CryptoSession& operator=(const CryptoSession&) = delete;
+    CryptoSession(CryptoSession&& other) noexcept;
+    CryptoSession& operator=(CryptoSession&& other) noexcept;
+
+    // Expand a 256-bit key; ERR_INVALID_ARG for any other length
+    Result<void> set_key(ConstByteSpan key);
+    void         clear();
+    bool         valid() const { return m_valid; }
+
+    // HMAC(key, key): identifies the key without revealing it
+    const uint8_t* fingerprint() const { return m_fingerprint; }
+
+    // AEAD — see Crypto::seal_in_place / open_in_place
+    Result<void>       seal_in_place(ByteSpan record) const { return seal_in_place(record, m_algo); }
+    Result<ByteSpan>   open_in_place(ByteSpan record) const { return open_in_place(record, m_algo); }
+    Result<void>       seal_in_place(ByteSpan record, CipherAlgo algo, ConstByteSpan aad = {}) const;
+    Result<ByteSpan>   open_in_place(ByteSpan record, CipherAlgo algo, ConstByteSpan aad = {}) const;
+    // With associated data: authenticated along with the record but not
+    // carried in it, so the opener must supply the same bytes
+    Result<void>       seal_in_place(ByteSpan record, ConstByteSpan aad) const { return seal_in_place(record, m_algo, aad); }
+    Result<ByteSpan>   open_in_place(ByteSpan record, ConstByteSpan aad) const { return open_in_place(record, m_algo, aad); }
+    ByteBuffer         encrypt(ConstByteSpan plaintext) const;
+    Result<ByteBuffer> decrypt(ConstByteSpan ciphertext) const;
+
+    // Batch AEAD — see Crypto::seal_batch / open_batch
+    Result<void> seal_batch(const ByteSpan* records, size_t count) const;
+    size_t       open_batch(const ByteSpan* records, size_t count, bool* ok) const;
+
+    // HMAC-SHA256
+    Result<void> mac_into(ConstByteSpan data, ByteSpan mac_out) const;
+    bool         mac_verify(ConstByteSpan data, ConstByteSpan expected) const;
+
+    void       set_algorithm(CipherAlgo algo) { m_algo = algo; }
+    CipherAlgo algorithm() const { return m_algo; }
+
+    void           set_cipher_impl(chacha20::Impl impl) { m_impl = impl; }
+    chacha20::Impl cipher_impl() const { return m_impl; }
+
+private:
+    bool seal_body(CipherAlgo algo, const uint8_t* nonce, const uint8_t* in,
+                   uint8_t* out, size_t len, uint8_t* tag, ConstByteSpan aad = {}) const;
+    bool open_body(CipherAlgo algo, const uint8_t* nonce, const uint8_t* in,
+                   uint8_t* out, size_t len, const uint8_t* tag, ConstByteSpan aad = {}) const;
+
+    chacha20::KeySchedule m_cipher{};
+    aes_gcm::KeySchedule  m_aes{};
+    HmacSha256            m_mac;
+    uint8_t               m_fingerprint[FINGERPRINT_SIZE]{};
+    CipherAlgo            m_algo{CipherAlgo::CHACHA20_POLY1305};
+    chacha20::Impl        m_impl{chacha20::Impl::AUTO};
+    bool                  m_valid{false};
+};
+
+} // namespace vos
@@ -0,0 +1,184 @@
+#include "drbg.h"
+#include "chacha20.h"
+#include "vos/log.h"
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <bcrypt.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+namespace vos {
+
+static const char* TAG = "DRBG";
+
+static const uint8_t ZERO_NONCE[chacha20::NONCE_SIZE] = {};
+
+static void wipe(void* p, size_t len) {
+    volatile uint8_t* v = static_cast<volatile uint8_t*>(p);
+    for (size_t i = 0; i < len; i++) v[i] = 0;
+}
+
+// ─── OS Entropy ──────────────────────────────────────────────
+
+bool os_entropy(uint8_t* out, size_t len) {
+#ifdef _WIN32
+    return BCRYPT_SUCCESS(BCryptGenRandom(nullptr, out, (ULONG)len,
+                                          BCRYPT_USE_SYSTEM_PREFERRED_RNG));
+#else
+    size_t got = 0;
+#if defined(SYS_getrandom)
+    // Raw syscall: works on old glibc and on Android before API 28
+    while (got < len) {
+        long r = syscall(SYS_getrandom, out + got, len - got, 0);
+        if (r > 0)                    { got += (size_t)r; continue; }
+        if (r < 0 && errno == EINTR)  continue;
+        break; // ENOSYS on pre-3.17 kernels — fall back below
+    }
+    if (got == len) return true;
+#endif
+    int fd = open("/dev/urandom", O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    while (got < len) {
+        ssize_t r = read(fd, out + got, len - got);
+        if (r > 0)                    { got += (size_t)r; continue; }
+        if (r < 0 && errno == EINTR)  continue;
+        break;
+    }
+    close(fd);
+    return got == len;
+#endif
+}
+
+// ─── Fork Detection ──────────────────────────────────────────
+// A forked child must not replay the parent's keystream.
+
+static std::atomic<uint64_t> g_fork_gen{1};
+
+static uint64_t fork_generation() {
+#ifndef _WIN32
+    static std::once_flag once;
+    std::call_once(once, [] {
+        pthread_atfork(nullptr, nullptr, [] { g_fork_gen.fetch_add(1); });
+    });
+#endif
+    return g_fork_gen.load(std::memory_order_relaxed);
+}
+
+// ─── ChaChaDrbg ──────────────────────────────────────────────
+
+ChaChaDrbg::ChaChaDrbg() = default;
+
+ChaChaDrbg::~ChaChaDrbg() {
+    wipe(m_key, sizeof(m_key));
+    wipe(m_buf, sizeof(m_buf));
+}
+
+ChaChaDrbg& ChaChaDrbg::thread_local_instance() {
+    thread_local ChaChaDrbg drbg;
+    return drbg;
+}
+
+void ChaChaDrbg::reseed() {
+    m_seeded = false;
+}
+
+void ChaChaDrbg::ensure_seeded() {
+    uint64_t gen = fork_generation();
+    if (m_seeded && gen == m_fork_gen && m_since_reseed < RESEED_BYTES) return;
+
+    uint8_t seed[KEY_SIZE];
+    if (!os_entropy(seed, sizeof(seed))) {
+        // No safe way to continue without entropy
+        log::error(TAG, "OS entropy source unavailable");
+        std::abort();
+    }
+
+    // Mix into the existing key rather than replacing it
+    for (size_t i = 0; i < KEY_SIZE; i++) {
+        m_key[i] = m_seeded ? (uint8_t)(m_key[i] ^ seed[i]) : seed[i];
+    }
+    wipe(seed, sizeof(seed));
+
+    // Buffered output predates the reseed (and may be shared with a parent)
+    wipe(m_buf, sizeof(m_buf));
+    m_avail        = 0;
+    m_since_reseed = 0;
+    m_fork_gen     = gen;
+    m_seeded       = true;
+}
+
+void ChaChaDrbg::refill() {
+    // Keystream block 0 becomes the next key; the rest is output
+    std::memset(m_buf, 0, BUF_SIZE);
+    chacha20::xor_stream(m_key, ZERO_NONCE, 0, m_buf, m_buf, BUF_SIZE);
+    std::memcpy(m_key, m_buf, KEY_SIZE);
+    wipe(m_buf, KEY_SIZE);
+    m_avail = BUF_SIZE - KEY_SIZE;
+}
+
+void ChaChaDrbg::fill(uint8_t* out, size_t len) {
+    ensure_seeded();
+    m_since_reseed += len;
+
+    // Small requests come from the buffer
+    if (len <= BUF_SIZE - KEY_SIZE) {
+        if (len > m_avail) refill();
+        uint8_t* src = m_buf + BUF_SIZE - m_avail;
+        std::memcpy(out, src, len);
+        wipe(src, len);
+        m_avail -= len;
+        return;
+    }
+
+    // Bulk: keystream straight into the caller's buffer (SIMD path), then
+    // rekey from block 0, which was never output. Chunked so the 32-bit
+    // block counter cannot wrap.
+    const size_t MAX_CHUNK = (size_t)1 << 30;
+    while (len > 0) {
+        size_t n = len < MAX_CHUNK ? len : MAX_CHUNK;
+        uint8_t next_key[chacha20::BLOCK_SIZE];
+        chacha20::block(m_key, ZERO_NONCE, 0, next_key);
+
+        std::memset(out, 0, n);
+        chacha20::xor_stream(m_key, ZERO_NONCE, 1, out, out, n);
+
+        std::memcpy(m_key, next_key, KEY_SIZE);
+        wipe(next_key, sizeof(next_key));
+        out += n;
+        len -= n;
+    }
+}
+
+uint32_t ChaChaDrbg::next_u32() {
+    uint32_t v;
+    fill(reinterpret_cast<uint8_t*>(&v), sizeof(v));
+    return v;
+}
+
+uint64_t ChaChaDrbg::next_u64() {
+    uint64_t v;
+    fill(reinterpret_cast<uint8_t*>(&v), sizeof(v));
+    return v;
+}
+
+uint32_t ChaChaDrbg::uniform(uint32_t upper_bound) {
+    if (upper_bound < 2) return 0;
+    // Reject the low (2^32 % bound) values so every residue is equally likely
+    uint32_t min = (uint32_t)(-upper_bound) % upper_bound;
+    for (;;) {
+        uint32_t r = next_u32();
+        if (r >= min) return r % upper_bound;
+    }
+}
+
+} // namespace vos
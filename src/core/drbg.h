@@ -0,0 +1,65 @@
+#pragma once
+
+#include "vos/types.h"
+
+namespace vos {
+
+/*
+ * ChaCha20-based DRBG ("fast key erasure").
+ * Output is ChaCha20 keystream; after every request the generator rekeys
+ * itself from its own keystream, so a later state compromise cannot
+ * reveal earlier output. Seeded from the OS (getrandom / BCryptGenRandom),
+ * reseeded every RESEED_BYTES of output and after fork().
+ *
+ * One instance per thread (thread_local()) — no locking on the hot path.
+ */
+class ChaChaDrbg {
+public:
+    static constexpr size_t RESEED_BYTES = 1 << 20;
+
+    ChaChaDrbg();
+    ~ChaChaDrbg();
+
+    ChaChaDrbg(const ChaChaDrbg&)            = delete;
+    ChaChaDrbg& operator=(const ChaChaDrbg&) = delete;
+
+    void fill(uint8_t* out, size_t len);
+    void fill(ByteSpan out) { fill(out.data(), out.size()); }
+
+    uint32_t next_u32();
+    uint64_t next_u64();
+
+    // Uniform in [0, upper_bound) without modulo bias
+    uint32_t uniform(uint32_t upper_bound);
+
+    // Force fresh OS entropy on the next request
+    void reseed();
+
+    // The calling thread's generator
+    static ChaChaDrbg& thread_local_instance();
+
+private:
+    static constexpr size_t KEY_SIZE = 32;
+    static constexpr size_t BUF_SIZE = 512;   // buffered keystream for small requests
+
+    void ensure_seeded();
+    void refill();
+
+    uint8_t  m_key[KEY_SIZE];
+    uint8_t  m_buf[BUF_SIZE];
+    size_t   m_avail{0};           // unread bytes at the end of m_buf
+    size_t   m_since_reseed{0};
+    uint64_t m_fork_gen{0};
+    bool     m_seeded{false};
+};
+
+// Raw OS entropy; false only if the OS source is unusable
+bool os_entropy(uint8_t* out, size_t len);
+
+// Convenience: fill from the calling thread's DRBG
+inline void secure_random(ByteSpan out) { ChaChaDrbg::thread_local_instance().fill(out); }
+inline uint32_t secure_uniform(uint32_t upper_bound) {
+    return ChaChaDrbg::thread_local_instance().uniform(upper_bound);
+}
+
+} // namespace vos
@@ -0,0 +1,74 @@
+#include "mesh_addr.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#endif
+
+namespace vos {
+
+#ifdef _WIN32
+static int addr_pton(int af, const char* text, void* out) { return InetPtonA(af, text, out); }
+static void addr_ntop(int af, const void* in, char* out, size_t len) { InetNtopA(af, (void*)in, out, len); }
+#else
+static int addr_pton(int af, const char* text, void* out) { return inet_pton(af, text, out); }
+static void addr_ntop(int af, const void* in, char* out, size_t len) { inet_ntop(af, in, out, (socklen_t)len); }
+#endif
+
+MeshAddr MeshAddr::from(const sockaddr_in& sa) {
+    MeshAddr a;
+    a.family = 4;
+    a.port   = sa.sin_port;
+    std::memcpy(a.ip, &sa.sin_addr, 4);
+    return a;
+}
+
+MeshAddr MeshAddr::from(const sockaddr_in6& sa) {
+    MeshAddr a;
+    a.family = 6;
+    a.port   = sa.sin6_port;
+    std::memcpy(a.ip, &sa.sin6_addr, 16);
+    return a;
+}
+
+MeshAddr MeshAddr::parse(const std::string& ip, uint16_t host_port) {
+    MeshAddr a;
+    if (addr_pton(AF_INET, ip.c_str(), a.ip) == 1) {
+        a.family = 4;
+    } else if (addr_pton(AF_INET6, ip.c_str(), a.ip) == 1) {
+        a.family = 6;
+    } else {
+        std::memset(a.ip, 0, sizeof(a.ip));
+        return a;
+    }
+    a.port = htons(host_port);
+    return a;
+}
+
+void MeshAddr::to_sockaddr(sockaddr_in& out) const {
+    std::memset(&out, 0, sizeof(out));
+    out.sin_family = AF_INET;
+    out.sin_port   = port;
+    std::memcpy(&out.sin_addr, ip, 4);
+}
+
+uint16_t MeshAddr::host_port() const {
+    return ntohs(port);
+}
+
+void MeshAddr::set_host_port(uint16_t host_port) {
+    port = htons(host_port);
+}
+
+std::string MeshAddr::to_string() const {
+    char text[INET6_ADDRSTRLEN] = "";
+    if (family == 4) addr_ntop(AF_INET, ip, text, sizeof(text));
+    else if (family == 6) addr_ntop(AF_INET6, ip, text, sizeof(text));
+    return text;
+}
+
+} // namespace vos
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "vos/types.h"
+#include <cstring>
+#include <string>
+
+struct sockaddr_in;
+struct sockaddr_in6;
+
+namespace vos {
+
+/*
+ * A peer's UDP endpoint the way the socket calls carry it: IPv4 or IPv6
+ * address and port, both in network byte order. Built straight from the
+ * sockaddr a datagram came with, compared and hashed as plain bytes, so
+ * MeshNet finds a sender and addresses a reply with no text formatting
+ * or parsing. to_string() is for logs and MeshPeer::address only.
+ */
+struct MeshAddr {
+    uint8_t  family = 0;    // 4 or 6; 0 = not an address
+    uint16_t port   = 0;    // network order
+    uint8_t  ip[16] = {};   // IPv4 uses the first 4 bytes
+
+    static MeshAddr from(const sockaddr_in& sa);
+    static MeshAddr from(const sockaddr_in6& sa);
+    // Text form of an IPv4 or IPv6 address; family 0 if it is neither
+    static MeshAddr parse(const std::string& ip, uint16_t host_port);
+
+    bool valid() const { return family != 0; }
+    bool is_v4() const { return family == 4; }
+
+    // IPv4 only: the destination for sendto() on the mesh socket
+    void to_sockaddr(sockaddr_in& out) const;
+
+    uint16_t    host_port() const;
+    void        set_host_port(uint16_t host_port);
+    std::string to_string() const;   // the address, without the port
+
+    bool operator==(const MeshAddr& o) const {
+        return family == o.family && port == o.port && std::memcmp(ip, o.ip, sizeof(ip)) == 0;
+    }
+    bool operator!=(const MeshAddr& o) const { return !(*this == o); }
+};
+
+struct MeshAddrHash {
+    size_t operator()(const MeshAddr& a) const noexcept {
+        uint64_t lo, hi;
+        std::memcpy(&lo, a.ip, 8);
+        std::memcpy(&hi, a.ip + 8, 8);
+        uint64_t h = (lo ^ (hi * 0x9E3779B97F4A7C15ull)) + ((uint64_t)a.port << 8 | a.family);
+        h ^= h >> 31;
+        h *= 0xBF58476D1CE4E5B9ull;
+        return (size_t)(h ^ (h >> 29));
+    }
+};
+
+} // namespace vos
@@ -0,0 +1,52 @@
+#include "mesh_discovery.h"
+#include <algorithm>
+
+namespace vos {
+namespace mesh_discovery {
+
+Trickle::Trickle(Duration imin, Duration imax, int redundancy, uint64_t seed)
+    : m_imin(imin), m_imax(std::max(imin, imax)), m_redundancy(redundancy),
+      m_rng(seed | 1), m_interval(imin) {}
+
+uint64_t Trickle::random() {
+    // xorshift64*
+    m_rng ^= m_rng >> 12;
+    m_rng ^= m_rng << 25;
+    m_rng ^= m_rng >> 27;
+    return m_rng * 0x2545F4914F6CDD1Dull;
+}
+
+void Trickle::begin(TimePoint now) {
+    m_start = now;
+    m_fired = false;
+    m_heard = 0;
+    // Due somewhere in the second half of the interval
+    auto half = m_interval.count() / 2;
+    m_fire_at = Duration(half + (half > 0 ? (int64_t)(random() % (uint64_t)half) : 0));
+}
+
+void Trickle::reset(TimePoint now) {
+    if (m_interval == m_imin && m_start != TimePoint{} && now < m_start + m_interval) return;
+    m_interval = m_imin;
+    begin(now);
+}
+
+bool Trickle::poll(TimePoint now) {
+    if (m_start == TimePoint{}) begin(now);
+    bool due = false;
+    while (now >= next()) {
+        if (!m_fired) {
+            m_fired = true;
+            if (m_redundancy > 0 && m_heard >= m_redundancy) m_suppressed++;
+            else due = true;
+        } else {
+            TimePoint end = m_start + m_interval;
+            m_interval    = std::min(m_interval * 2, m_imax);
+            begin(end);
+        }
+    }
+    return due;
+}
+
+} // namespace mesh_discovery
+} // namespace vos
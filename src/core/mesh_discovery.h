@@ -0,0 +1,64 @@
+#pragma once
+
+#include "vos/types.h"
+
+namespace vos {
+namespace mesh_discovery {
+
+/*
+ * When to broadcast DISCOVER: a Trickle timer (RFC 6206).
+ *
+ * Time runs in intervals of length I, starting at Imin. In each one the
+ * broadcast is due at a random point in [I/2, I), and is skipped if
+ * `redundancy` DISCOVERs from known peers were heard before it: in a
+ * stable mesh only a few instances per interval speak, however many there
+ * are. When an interval ends I doubles, up to Imax. reset() goes back to
+ * Imin when peers appear or go away, so changes spread fast and a quiet
+ * mesh costs next to nothing.
+ *
+ * Not thread-safe. The random points come from a private generator, so a
+ * given seed replays the same schedule.
+ */
+class Trickle {
+public:
+    Trickle(Duration imin, Duration imax, int redundancy, uint64_t seed);
+
+    // Start over from Imin, unless already in a first interval
+    void reset(TimePoint now);
+    // A DISCOVER that told us nothing new
+    void heard() { m_heard++; }
+
+    // Run what is due by `now`; true if a broadcast is due. Call again at next().
+    bool poll(TimePoint now);
+    TimePoint next() const { return m_fired ? m_start + m_interval : m_start + m_fire_at; }
+
+    Duration interval() const { return m_interval; }
+    uint64_t suppressed() const { return m_suppressed; }
+
+private:
+    void begin(TimePoint now);
+    uint64_t random();
+
+    Duration  m_imin;
+    Duration  m_imax;
+    int       m_redundancy;
+    uint64_t  m_rng;
+    Duration  m_interval;
+    Duration  m_fire_at{};
+    TimePoint m_start{};
+    bool      m_fired = false;
+    int       m_heard = 0;
+    uint64_t  m_suppressed = 0;
+};
+
+// Whether to answer a known peer's DISCOVER with an ACK (newcomers are
+// always answered). With `live_peers` around, about `fanout` of them
+// answer, so a peer that restarted relearns the mesh a few peers per
+// DISCOVER rather than from an ACK storm. `rnd` is uniform over 32 bits.
+inline bool should_ack(size_t live_peers, size_t fanout, uint32_t rnd) {
+    if (fanout == 0 || live_peers <= fanout) return true;
+    return (uint64_t)rnd * live_peers < (uint64_t)fanout << 32;
+}
+
+} // namespace mesh_discovery
+} // namespace vos
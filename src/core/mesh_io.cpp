@@ -0,0 +1,623 @@
+#include "mesh_io.h"
+#include "mesh_uring.h"
+#include "vos/log.h"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+#if defined(__linux__)
+#include <netinet/udp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103   // Linux 4.18+; older libc headers lack it
+#endif
+#elif !defined(_WIN32)
+#include <fcntl.h>
+#include <poll.h>
+#endif
+
+namespace vos {
+namespace mesh_io {
+
+static const char* TAG = "MeshIO";
+
+// ─── RecvBatch ───────────────────────────────────────────────
+
+RecvBatch::RecvBatch(size_t slots, size_t slot_size)
+    : m_slots(slots ? slots : 1),
+      m_slot_size(slot_size),
+      // Not value-initialized: pages are touched only as packets arrive
+      m_buf(new uint8_t[m_slots * slot_size]),
+      m_len(m_slots, 0),
+      m_from(m_slots),
+      m_trunc(m_slots, 0) {
+#if defined(__linux__)
+    // The headers point at fixed slots, so they are built once
+    m_msgs.resize(m_slots);
+    m_iov.resize(m_slots);
+    for (size_t i = 0; i < m_slots; i++) {
+        m_iov[i].iov_base = slot(i);
+        m_iov[i].iov_len  = m_slot_size;
+        std::memset(&m_msgs[i], 0, sizeof(m_msgs[i]));
+        m_msgs[i].msg_hdr.msg_iov     = &m_iov[i];
+        m_msgs[i].msg_hdr.msg_iovlen  = 1;
+        m_msgs[i].msg_hdr.msg_name    = &m_from[i];
+    }
+#endif
+}
+
+int RecvBatch::recv(SocketHandle sock, bool wait) {
+    m_count = 0;
+#if defined(__linux__)
+    for (size_t i = 0; i < m_slots; i++) {
+        // The kernel overwrites these on every call
+        m_msgs[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+        m_msgs[i].msg_hdr.msg_flags   = 0;
+    }
+    int n;
+    do {
+        // MSG_WAITFORONE: block for the first packet only
+        n = recvmmsg(sock, m_msgs.data(), (unsigned)m_slots, wait ? MSG_WAITFORONE : MSG_DONTWAIT,
+                     nullptr);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0) return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+
+    for (int i = 0; i < n; i++) {
+        m_len[i]   = m_msgs[i].msg_len;
+        m_trunc[i] = (m_msgs[i].msg_hdr.msg_flags & MSG_TRUNC) ? 1 : 0;
+    }
+    m_count = (size_t)n;
+    return n;
+#else
+    socklen_t from_len = sizeof(sockaddr_in);
+#ifdef _WIN32
+    int flags = 0;   // no per-call non-blocking flag; readiness must come first
+    (void)wait;
+#else
+    int flags = wait ? 0 : MSG_DONTWAIT;
+#endif
+    int r = recvfrom(sock, (char*)slot(0), (int)m_slot_size, flags,
+                     (struct sockaddr*)&m_from[0], &from_len);
+    if (r < 0) {
+#ifdef _WIN32
+        int err = WSAGetLastError();
+        if (err == WSAEMSGSIZE) {
+            m_len[0] = m_slot_size;
+            m_trunc[0] = 1;
+            m_count = 1;
+            return 1;
+        }
+        return err == WSAETIMEDOUT || err == WSAEWOULDBLOCK ? 0 : -1;
+#else
+        return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? 0 : -1;
+#endif
+    }
+    // recvfrom() cannot report truncation portably; treat a full slot as
+    // truncated (MAX_DATAGRAM exceeds any UDP payload, so only smaller
+    // custom slots can hit this)
+    m_len[0]   = (size_t)r;
+    m_trunc[0] = (size_t)r >= m_slot_size ? 1 : 0;
+    m_count    = 1;
+    return 1;
+#endif
+}
+
+// ─── SendBatch ───────────────────────────────────────────────
+
+#if defined(__linux__)
+// Kernel limits for one GSO message (UDP_MAX_SEGMENTS, IPv4 length field)
+static constexpr size_t GSO_MAX_SEGMENTS = 64;
+static constexpr size_t GSO_MAX_BYTES    = 65507;
+static constexpr size_t CMSG_BLOCK       = CMSG_SPACE(sizeof(uint16_t));
+#endif
+
+SendBatch::SendBatch(size_t slots, size_t slot_size)
+    : m_slots(slots ? slots : 1),
+      m_slot_size(slot_size),
+      m_buf(new uint8_t[m_slots * slot_size]),
+      m_len(m_slots, 0),
+      m_dest(m_slots),
+      m_ref(m_slots, nullptr) {
+#if defined(__linux__)
+    m_msgs.resize(m_slots);
+    m_iov.resize(m_slots);
+    m_msg_first.resize(m_slots);
+    m_msg_count.resize(m_slots);
+    m_cmsg.reset(new uint8_t[m_slots * CMSG_BLOCK]);
+#endif
+}
+
+ByteSpan SendBatch::push(size_t len, const sockaddr_in& dest) {
+    if (m_count == m_slots || len > m_slot_size) return ByteSpan();
+    m_len[m_count]  = len;
+    m_dest[m_count] = dest;
+    m_ref[m_count]  = nullptr;
+    return ByteSpan(slot(m_count++), len);
+}
+
+bool SendBatch::push_ref(const uint8_t* data, size_t len, const sockaddr_in& dest) {
+    if (m_count == m_slots || len > MAX_DATAGRAM) return false;
+    m_len[m_count]  = len;
+    m_dest[m_count] = dest;
+    m_ref[m_count++] = data;
+    return true;
+}
+
+#if defined(__linux__)
+static bool same_dest(const sockaddr_in& a, const sockaddr_in& b) {
+    return a.sin_port == b.sin_port && a.sin_addr.s_addr == b.sin_addr.s_addr;
+}
+
+size_t SendBatch::build(size_t first) {
+    size_t nmsg = 0;
+    for (size_t i = first; i < m_count; nmsg++) {
+        // Group: equal-sized packets to one destination; a shorter packet
+        // may end the group (GSO allows a short final segment)
+        size_t n = 1, bytes = m_len[i];
+        if (m_gso) {
+            while (i + n < m_count && n < GSO_MAX_SEGMENTS &&
+                   same_dest(m_dest[i + n], m_dest[i]) &&
+                   m_len[i + n] <= m_len[i] && m_len[i + n] > 0 &&
+                   bytes + m_len[i + n] <= GSO_MAX_BYTES) {
+                size_t next = m_len[i + n++];
+                bytes += next;
+                if (next < m_len[i]) break;
+            }
+        }
+        for (size_t k = 0; k < n; k++) {
+            m_iov[i + k].iov_base = const_cast<uint8_t*>(packet(i + k));
+            m_iov[i + k].iov_len  = m_len[i + k];
+        }
+
+        mmsghdr& m = m_msgs[nmsg];
+        std::memset(&m, 0, sizeof(m));
+        m.msg_hdr.msg_name    = &m_dest[i];
+        m.msg_hdr.msg_namelen = sizeof(sockaddr_in);
+        m.msg_hdr.msg_iov     = &m_iov[i];
+        m.msg_hdr.msg_iovlen  = n;
+        if (n > 1) {
+            uint8_t* ctl = m_cmsg.get() + nmsg * CMSG_BLOCK;
+            std::memset(ctl, 0, CMSG_BLOCK);
+            m.msg_hdr.msg_control    = ctl;
+            m.msg_hdr.msg_controllen = CMSG_BLOCK;
+            cmsghdr* c = CMSG_FIRSTHDR(&m.msg_hdr);
+            c->cmsg_level = SOL_UDP;
+            c->cmsg_type  = UDP_SEGMENT;
+            c->cmsg_len   = CMSG_LEN(sizeof(uint16_t));
+            uint16_t seg  = (uint16_t)m_len[i];
+            std::memcpy(CMSG_DATA(c), &seg, sizeof(seg));
+        }
+        m_msg_first[nmsg] = i;
+        m_msg_count[nmsg] = n;
+        i += n;
+    }
+    return nmsg;
+}
+#endif
+
+Result<size_t> SendBatch::flush(SocketHandle sock) {
+    size_t sent = 0;
+#if VOS_HAVE_IO_URING
+    if (m_ring) return flush_ring();
+#endif
+#if defined(__linux__)
+    size_t nmsg = build(0), done = 0;
+    while (done < nmsg) {
+        int r = sendmmsg(sock, m_msgs.data() + done, (unsigned)(nmsg - done), 0);
+        m_syscalls++;
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            // The route cannot segment for us: fall back to one datagram
+            // per packet from the message that failed
+            if (m_msg_count[done] > 1 && (errno == EINVAL || errno == EIO || errno == EMSGSIZE)) {
+                log::info(TAG, "UDP GSO unavailable on this route (%s); using plain sendmmsg",
+                          std::strerror(errno));
+                m_gso = false;
+                nmsg  = build(m_msg_first[done]);
+                done  = 0;
+                continue;
+            }
+            log::warn(TAG, "sendmmsg failed: %s", std::strerror(errno));
+            m_count = 0;
+            return Result<size_t>::error(StatusCode::ERR_NETWORK);
+        }
+        for (int k = 0; k < r; k++) sent += m_msg_count[done + k];
+        done += (size_t)r;
+    }
+#else
+    for (size_t i = 0; i < m_count; i++) {
+        int r = sendto(sock, (const char*)packet(i), (int)m_len[i], 0,
+                       (const struct sockaddr*)&m_dest[i], sizeof(sockaddr_in));
+        m_syscalls++;
+        if (r < 0) {
+            m_count = 0;
+            return Result<size_t>::error(StatusCode::ERR_NETWORK);
+        }
+        sent++;
+    }
+#endif
+    m_count = 0;
+    return Result<size_t>::success(sent);
+}
+
+// ─── LossShim ────────────────────────────────────────────────
+
+static uint64_t rate_threshold(double rate) {
+    if (rate <= 0) return 0;
+    if (rate >= 1) return UINT64_MAX;
+    return (uint64_t)(rate * 18446744073709551616.0);
+}
+
+LossShim::LossShim(double tx_rate, double rx_rate, uint64_t seed)
+    : m_seed(seed),
+      m_tx_threshold(rate_threshold(tx_rate)),
+      m_rx_threshold(rate_threshold(rx_rate)) {}
+
+bool LossShim::roll(uint64_t threshold) {
+    if (threshold == 0) return false;
+    // splitmix64 over (seed, call number)
+    uint64_t z = m_seed + m_counter.fetch_add(1, std::memory_order_relaxed) * 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    z ^= z >> 31;
+    if (z >= threshold && threshold != UINT64_MAX) return false;
+    m_dropped.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+// ─── Reactor ─────────────────────────────────────────────────
+
+Reactor::Reactor() {
+#if defined(__linux__)
+    m_epoll   = epoll_create1(EPOLL_CLOEXEC);
+    m_event   = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    m_timerfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (m_epoll < 0 || m_event < 0 || m_timerfd < 0) {
+        log::error(TAG, "Cannot create event loop: %s", std::strerror(errno));
+        return;
+    }
+    for (int fd : {m_event, m_timerfd}) {
+        epoll_event ev{};
+        ev.events  = EPOLLIN;
+        ev.data.fd = fd;
+        epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &ev);
+    }
+    m_ok = true;
+#elif !defined(_WIN32)
+    if (pipe(m_pipe) < 0) {
+        log::error(TAG, "Cannot create event loop: %s", std::strerror(errno));
+        return;
+    }
+    for (int fd : m_pipe) fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    m_ok = true;
+#else
+    m_ok = true;
+#endif
+}
+
+Reactor::~Reactor() {
+#if defined(__linux__)
+    for (int fd : {m_epoll, m_event, m_timerfd}) {
+        if (fd >= 0) close(fd);
+    }
+#elif !defined(_WIN32)
+    for (int fd : m_pipe) {
+        if (fd >= 0) close(fd);
+    }
+#endif
+}
+
+bool Reactor::add_socket(SocketHandle sock, Handler on_readable) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+#if defined(__linux__)
+    epoll_event ev{};
+    ev.events  = EPOLLIN;
+    ev.data.fd = sock;
+    if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, sock, &ev) < 0) return false;
+#endif
+    m_sockets[sock] = std::make_shared<Handler>(std::move(on_readable));
+    wake();   // the poll() fallbacks rebuild their set
+    return true;
+}
+
+void Reactor::remove_socket(SocketHandle sock) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+#if defined(__linux__)
+    epoll_ctl(m_epoll, EPOLL_CTL_DEL, sock, nullptr);
+#endif
+    m_sockets.erase(sock);
+    wake();
+}
+
+Reactor::TimerId Reactor::schedule(std::chrono::microseconds delay, Handler fn) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    TimerId id = m_next_timer++;
+    m_timers[id] = Timer{Clock::now() + delay, std::move(fn)};
+    // The loop re-arms before it next waits; from elsewhere it must be woken
+    if (!in_loop()) wake();
+    return id;
+}
+
+void Reactor::cancel(TimerId id) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_timers.erase(id);
+}
+
+void Reactor::post(Handler fn) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_posted.push_back(std::move(fn));
+    wake();
+}
+
+void Reactor::stop() {
+    m_stop.store(true);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    wake();
+}
+
+// Caller holds m_mutex. One pending wake-up is enough, however many
+// reasons there are.
+void Reactor::wake() {
+    if (m_woken) return;
+    m_woken = true;
+#if defined(__linux__)
+    uint64_t one = 1;
+    if (write(m_event, &one, sizeof(one)) < 0) {}
+#elif !defined(_WIN32)
+    char c = 0;
+    if (write(m_pipe[1], &c, 1) < 0) {}
+#endif
+}
+
+int Reactor::wait_timeout_ms(TimePoint now) const {
+    int ms = -1;
+    for (const auto& [id, t] : m_timers) {
+        auto left = std::chrono::duration_cast<std::chrono::microseconds>(t.at - now).count();
+        int  m    = left <= 0 ? 0 : (int)std::min<int64_t>((left + 999) / 1000, 60000);
+        ms = ms < 0 ? m : std::min(ms, m);
+    }
+#ifdef _WIN32
+    ms = ms < 0 ? WAKE_POLL : std::min(ms, WAKE_POLL);
+#endif
+    return ms;
+}
+
+void Reactor::run_due() {
+    std::vector<Handler> posted;
+    std::vector<Timer>   due;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        posted.swap(m_posted);
+        auto now = Clock::now();
+        for (auto it = m_timers.begin(); it != m_timers.end();) {
+            if (it->second.at <= now) {
+                due.push_back(std::move(it->second));
+                it = m_timers.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    for (auto& fn : posted) fn();
+    std::sort(due.begin(), due.end(), [](const Timer& a, const Timer& b) { return a.at < b.at; });
+    for (auto& t : due) t.fn();
+}
+
+void Reactor::run() {
+    m_loop_thread.store(std::this_thread::get_id());
+    while (!m_stop.load()) {
+#if defined(__linux__)
+        {
+            // Keep the timerfd on the earliest deadline
+            std::lock_guard<std::mutex> lock(m_mutex);
+            TimePoint earliest{};
+            for (const auto& [id, t] : m_timers) {
+                if (earliest == TimePoint{} || t.at < earliest) earliest = t.at;
+            }
+            if (earliest != m_armed) {
+                itimerspec its{};
+                if (earliest != TimePoint{}) {
+                    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                  earliest.time_since_epoch()).count();
+                    its.it_value.tv_sec  = (time_t)(ns / 1000000000);
+                    its.it_value.tv_nsec = (long)(ns % 1000000000);
+                    if (ns <= 0) its.it_value.tv_nsec = 1;   // zero would disarm it
+                }
+                timerfd_settime(m_timerfd, TFD_TIMER_ABSTIME, &its, nullptr);
+                m_armed = earliest;
+            }
+        }
+
+        epoll_event ev[32];
+        int n = epoll_wait(m_epoll, ev, 32, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            log::error(TAG, "epoll_wait failed: %s", std::strerror(errno));
+            break;
+        }
+        m_wakeups.fetch_add(1, std::memory_order_relaxed);
+        for (int i = 0; i < n; i++) {
+            int      fd = ev[i].data.fd;
+            uint64_t v;
+            if (fd == m_event) {
+                if (read(m_event, &v, sizeof(v)) < 0) {}
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_woken = false;
+            } else if (fd == m_timerfd) {
+                if (read(m_timerfd, &v, sizeof(v)) < 0) {}
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_armed = TimePoint{};   // one-shot: spent
+            } else {
+                std::shared_ptr<Handler> h;
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    auto it = m_sockets.find(fd);
+                    if (it != m_sockets.end()) h = it->second;
+                }
+                if (h) (*h)();
+            }
+        }
+#else
+  #ifdef _WIN32
+        using PollFd = WSAPOLLFD;
+  #else
+        using PollFd = pollfd;
+  #endif
+        std::vector<PollFd>                   fds;
+        std::vector<std::shared_ptr<Handler>> handlers;
+        int timeout;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+  #ifndef _WIN32
+            fds.push_back(PollFd{m_pipe[0], POLLIN, 0});
+            handlers.push_back(nullptr);
+  #endif
+            for (const auto& [sock, h] : m_sockets) {
+                PollFd p{};
+                p.fd     = sock;
+                p.events = POLLIN;
+                fds.push_back(p);
+                handlers.push_back(h);
+            }
+            timeout = m_posted.empty() ? wait_timeout_ms(Clock::now()) : 0;
+        }
+  #ifdef _WIN32
+        int n = fds.empty() ? (Sleep((DWORD)timeout), 0) : WSAPoll(fds.data(), (ULONG)fds.size(), timeout);
+  #else
+        int n = poll(fds.data(), (nfds_t)fds.size(), timeout);
+        if (n < 0 && errno == EINTR) continue;
+  #endif
+        if (n < 0) {
+            log::error(TAG, "poll failed");
+            break;
+        }
+        m_wakeups.fetch_add(1, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+  #ifndef _WIN32
+            char drain[64];
+            while (read(m_pipe[0], drain, sizeof(drain)) > 0) {}
+  #endif
+            m_woken = false;
+        }
+        for (size_t i = 0; i < fds.size(); i++) {
+            if (handlers[i] && (fds[i].revents & (POLLIN | POLLERR | POLLHUP))) (*handlers[i])();
+        }
+#endif
+        run_due();
+    }
+    m_loop_thread.store(std::thread::id());
+}
+
+// ─── CallbackQueue ───────────────────────────────────────────
+
+CallbackQueue::CallbackQueue(size_t capacity)
+    : m_items(std::max<size_t>(capacity, 1)) {}
+
+CallbackQueue::~CallbackQueue() {
+    stop();
+    if (m_worker.joinable()) {
+        if (in_worker()) m_worker.detach();   // destroyed by its own callback
+        else m_worker.join();
+    }
+}
+
+void CallbackQueue::start() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_worker.joinable() && !m_stop) return;
+    if (m_worker.joinable()) m_worker.join();   // a stop() from a callback left it finishing
+    m_stop   = false;
+    m_worker = std::thread([this] { run(); });
+}
+
+void CallbackQueue::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    if (m_worker.joinable() && !in_worker()) m_worker.join();
+}
+
+bool CallbackQueue::post(Fn fn) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stop || m_count == m_items.size()) {
+            m_dropped++;
+            return false;
+        }
+        Item& it  = m_items[(m_head + m_count) % m_items.size()];
+        it.fn     = std::move(fn);
+        it.posted = Clock::now();
+        m_count++;
+        m_max_depth = std::max(m_max_depth, m_count);
+    }
+    m_cv.notify_one();
+    return true;
+}
+
+void CallbackQueue::drain() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle_cv.wait(lock, [this] { return (m_count == 0 && !m_busy) || !m_worker.joinable(); });
+}
+
+CallbackQueue::Stats CallbackQueue::stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Stats s;
+    s.depth       = m_count;
+    s.max_depth   = m_max_depth;
+    s.delivered   = m_delivered;
+    s.dropped     = m_dropped;
+    s.wait_avg_us = m_delivered ? m_wait_total_us / m_delivered : 0;
+    s.wait_max_us = m_wait_max_us;
+    uint64_t seen = 0, rank = m_delivered - m_delivered / 100;   // 99th percentile
+    for (size_t k = 0; k < WAIT_BUCKETS && m_delivered; k++) {
+        seen += m_wait_buckets[k];
+        if (seen >= rank) {
+            s.wait_p99_us = std::min<uint64_t>(1ull << k, m_wait_max_us);
+            break;
+        }
+    }
+    return s;
+}
+
+void CallbackQueue::run() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_cv.wait(lock, [this] { return m_count > 0 || m_stop; });
+        if (m_count == 0) break;   // stopped and drained
+
+        Item&    it   = m_items[m_head];
+        Fn       fn   = std::move(it.fn);
+        uint64_t wait = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+                            Clock::now() - it.posted).count();
+        it.fn   = nullptr;
+        m_head  = (m_head + 1) % m_items.size();
+        m_count--;
+        m_busy  = true;
+
+        size_t k = 0;
+        while (k + 1 < WAIT_BUCKETS && (1ull << k) <= wait) k++;
+        m_wait_buckets[k]++;
+        m_wait_total_us += wait;
+        m_wait_max_us    = std::max(m_wait_max_us, wait);
+
+        lock.unlock();
+        fn();
+        lock.lock();
+        m_busy = false;
+        m_delivered++;
+        if (m_count == 0) m_idle_cv.notify_all();
+    }
+    m_idle_cv.notify_all();
+}
+
+} // namespace mesh_io
+} // namespace vos
@@ -0,0 +1,327 @@
+#pragma once
+
+#include "vos/types.h"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#endif
+
+namespace vos {
+namespace mesh_io {
+
+/*
+ * Low-level datagram I/O for MeshNet.
+ * Socket calls that move more than one packet at a time live here so the
+ * protocol code in mesh_net.cpp stays platform-neutral.
+ */
+
+#ifdef _WIN32
+using SocketHandle = uintptr_t;
+#else
+using SocketHandle = int;
+#endif
+
+class Uring;
+
+// Largest datagram the receive pool accepts; bigger ones are truncated by
+// the kernel and dropped
+constexpr size_t MAX_DATAGRAM = 65536;
+
+/*
+ * Receive pool: `slots` preallocated datagram buffers filled by one
+ * recvmmsg() call on Linux (one recvfrom() elsewhere). Packets stay valid
+ * until the next recv(), so they can be parsed in place with no per-packet
+ * copy or allocation.
+ */
+class RecvBatch {
+public:
+    explicit RecvBatch(size_t slots = 32, size_t slot_size = MAX_DATAGRAM);
+
+    RecvBatch(const RecvBatch&)            = delete;
+    RecvBatch& operator=(const RecvBatch&) = delete;
+
+    // Take whatever is queued on the socket, up to capacity(). With `wait`
+    // a blocking socket waits (subject to SO_RCVTIMEO) for the first
+    // datagram; without it the call never blocks, for use after a
+    // readiness event. Returns the number received, 0 when nothing came,
+    // -1 on a socket error.
+    int recv(SocketHandle sock, bool wait = true);
+
+    size_t capacity() const { return m_slots; }
+    size_t count()    const { return m_count; }
+
+    // Writable so the receiver can decrypt in place
+    ByteSpan             packet(size_t i) const { return ByteSpan(slot(i), m_len[i]); }
+    const sockaddr_in&   from(size_t i)   const { return m_from[i]; }
+    // The datagram was larger than the slot; packet(i) holds only a prefix
+    bool                 truncated(size_t i) const { return m_trunc[i] != 0; }
+
+private:
+    uint8_t* slot(size_t i) const { return m_buf.get() + i * m_slot_size; }
+
+    size_t                     m_slots;
+    size_t                     m_slot_size;
+    size_t                     m_count{0};
+    std::unique_ptr<uint8_t[]> m_buf;
+    std::vector<size_t>        m_len;
+    std::vector<sockaddr_in>   m_from;
+    std::vector<uint8_t>       m_trunc;
+#if defined(__linux__)
+    std::vector<struct mmsghdr> m_msgs;
+    std::vector<struct iovec>   m_iov;
+#endif
+};
+
+/*
+ * Send pool: packets are built directly in preallocated slots (push()
+ * hands out the space), or queued where they already lie (push_ref()),
+ * and flush() sends everything queued. On Linux a
+ * flush is one sendmmsg() call; runs of equal-sized packets to the same
+ * destination go out as single UDP GSO (UDP_SEGMENT) messages, which the
+ * kernel splits back into datagrams. If the route rejects GSO (segment
+ * larger than the MTU, no checksum offload) the batch turns GSO off and
+ * resends as plain datagrams. Elsewhere flush() is one sendto() per packet.
+ */
+class SendBatch {
+public:
+    explicit SendBatch(size_t slots = 64, size_t slot_size = MAX_DATAGRAM);
+
+    SendBatch(const SendBatch&)            = delete;
+    SendBatch& operator=(const SendBatch&) = delete;
+
+    // Reserve the next slot for a `len`-byte packet to `dest`. Returns an
+    // empty span when the pool is full (flush first) or len > slot_size().
+    ByteSpan push(size_t len, const sockaddr_in& dest);
+    // Queue a packet the caller keeps in place until flush() returns; no
+    // copy is made. False when the pool is full or len > MAX_DATAGRAM.
+    bool     push_ref(const uint8_t* data, size_t len, const sockaddr_in& dest);
+
+    // Send and clear everything pushed. Returns the number of datagrams
+    // the kernel accepted; stops at the first hard socket error.
+    Result<size_t> flush(SocketHandle sock);
+    void           clear() { m_count = 0; }
+
+    size_t pending()   const { return m_count; }
+    size_t capacity()  const { return m_slots; }
+    size_t slot_size() const { return m_slot_size; }
+
+    void set_gso(bool on) { m_gso = on; }
+    bool gso()      const { return m_gso; }
+
+    // Send through an io_uring (see mesh_uring.h) instead of sendmmsg();
+    // nullptr goes back to the syscall. The ring is used only by flush().
+    void set_ring(Uring* ring, SocketHandle sock) { m_ring = ring; m_ring_sock = sock; }
+
+    // Send syscalls made over the batch's lifetime
+    uint64_t syscalls() const { return m_syscalls; }
+
+private:
+    uint8_t*       slot(size_t i) const { return m_buf.get() + i * m_slot_size; }
+    const uint8_t* packet(size_t i) const { return m_ref[i] ? m_ref[i] : slot(i); }
+    size_t         build(size_t first);   // Fill m_msgs from packet `first`; returns message count
+    Result<size_t> flush_ring();          // in mesh_uring.cpp
+
+    size_t                      m_slots;
+    size_t                      m_slot_size;
+    size_t                      m_count{0};
+    std::unique_ptr<uint8_t[]>  m_buf;
+    std::vector<size_t>         m_len;
+    std::vector<sockaddr_in>    m_dest;
+    std::vector<const uint8_t*> m_ref;   // push_ref()'s packet, or nullptr for the slot
+    bool                        m_gso{true};
+    uint64_t                    m_syscalls{0};
+    Uring*                      m_ring{nullptr};
+    SocketHandle                m_ring_sock{};
+#if defined(__linux__)
+    std::vector<struct mmsghdr> m_msgs;
+    std::vector<struct iovec>   m_iov;
+    std::vector<size_t>         m_msg_first;   // first packet of each message
+    std::vector<size_t>         m_msg_count;   // packets carried by each message
+    std::unique_ptr<uint8_t[]>  m_cmsg;        // one UDP_SEGMENT control block per slot
+#endif
+};
+
+/*
+ * Loss injection for exercising recovery: each drop_tx()/drop_rx() call
+ * discards the datagram with the configured probability. Decisions come
+ * from a counter-based hash, so a given seed replays the same loss pattern
+ * for the same traffic and the shim is safe to call from any thread.
+ */
+class LossShim {
+public:
+    LossShim(double tx_rate, double rx_rate, uint64_t seed = 1);
+
+    bool drop_tx() { return roll(m_tx_threshold); }
+    bool drop_rx() { return roll(m_rx_threshold); }
+
+    uint64_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    bool roll(uint64_t threshold);
+
+    uint64_t              m_seed;
+    uint64_t              m_tx_threshold;
+    uint64_t              m_rx_threshold;
+    std::atomic<uint64_t> m_counter{0};
+    std::atomic<uint64_t> m_dropped{0};
+};
+
+/*
+ * Event loop for the mesh sockets. One thread in run() waits on every
+ * registered socket, a timer and a wakeup channel at once, and sleeps
+ * until one of them fires: no polling, so an idle loop costs no CPU.
+ *
+ * Linux: epoll, with an eventfd for wake()/post()/stop() and a timerfd
+ * armed for the earliest timer. Other POSIX systems use poll() with a
+ * pipe for waking; Windows uses WSAPoll() and cannot be woken early, so
+ * there the wait is capped at WAKE_POLL.
+ *
+ * Handlers run on the loop thread. Everything else may be called from any
+ * thread, handlers included.
+ */
+class Reactor {
+public:
+    using Handler = std::function<void()>;
+    using TimerId = uint64_t;
+
+    Reactor();
+    ~Reactor();
+
+    Reactor(const Reactor&)            = delete;
+    Reactor& operator=(const Reactor&) = delete;
+
+    // False if the kernel objects could not be created
+    bool ok() const { return m_ok; }
+
+    // Call `on_readable` whenever `sock` has data queued (level-triggered:
+    // whatever the handler leaves queued fires it again)
+    bool add_socket(SocketHandle sock, Handler on_readable);
+    void remove_socket(SocketHandle sock);
+
+    // Run `fn` once, `delay` from now. Timers re-arm by scheduling again.
+    TimerId schedule(std::chrono::microseconds delay, Handler fn);
+    void    cancel(TimerId id);
+
+    // Run `fn` on the loop thread at its next turn
+    void post(Handler fn);
+
+    // Run the loop on the calling thread until stop()
+    void run();
+    void stop();
+    bool in_loop() const { return std::this_thread::get_id() == m_loop_thread.load(); }
+
+    // Times the loop woke up (events, timers and wake-ups together)
+    uint64_t wakeups() const { return m_wakeups.load(std::memory_order_relaxed); }
+
+#ifdef _WIN32
+    static constexpr int WAKE_POLL = 20;   // ms
+#endif
+
+private:
+    struct Timer { TimePoint at; Handler fn; };
+
+    void wake();
+    void run_due();
+    int  wait_timeout_ms(TimePoint now) const;   // poll() fallback only
+
+    bool                                      m_ok{false};
+    std::atomic<bool>                         m_stop{false};
+    std::atomic<uint64_t>                     m_wakeups{0};
+    std::atomic<std::thread::id>              m_loop_thread{};
+
+    std::mutex                                m_mutex;
+    std::unordered_map<SocketHandle, std::shared_ptr<Handler>> m_sockets;
+    std::map<TimerId, Timer>                  m_timers;
+    TimerId                                   m_next_timer{1};
+    std::vector<Handler>                      m_posted;
+    bool                                      m_woken{false};   // wake() pending
+
+#if defined(__linux__)
+    int       m_epoll{-1};
+    int       m_event{-1};
+    int       m_timerfd{-1};
+    TimePoint m_armed{};   // what the timerfd is set to; {} when disarmed
+#elif !defined(_WIN32)
+    int       m_pipe[2]{-1, -1};
+#endif
+};
+
+/*
+ * Bounded FIFO of callbacks run in order by one worker thread, so user
+ * code (UI, SMS, logging) never runs on the event loop or under MeshNet's
+ * locks. post() never waits: with `capacity` callbacks already queued it
+ * refuses the new one and counts it as dropped.
+ *
+ * Latency is the time from post() until the callback starts.
+ */
+class CallbackQueue {
+public:
+    using Fn = std::function<void()>;
+
+    struct Stats {
+        size_t   depth       = 0;   // queued now
+        size_t   max_depth   = 0;
+        uint64_t delivered   = 0;
+        uint64_t dropped     = 0;   // refused by a full queue
+        uint64_t wait_avg_us = 0;
+        uint64_t wait_p99_us = 0;   // upper bound, from power-of-two buckets
+        uint64_t wait_max_us = 0;
+    };
+
+    explicit CallbackQueue(size_t capacity = 1024);
+    ~CallbackQueue();
+
+    CallbackQueue(const CallbackQueue&)            = delete;
+    CallbackQueue& operator=(const CallbackQueue&) = delete;
+
+    void start();
+    // Run what is queued, then end the worker; later posts are refused.
+    // From a callback it only asks the worker to finish.
+    void stop();
+
+    bool post(Fn fn);
+    // Wait until everything posted so far has run (not from a callback)
+    void drain();
+
+    bool   in_worker() const { return std::this_thread::get_id() == m_worker.get_id(); }
+    size_t capacity()  const { return m_items.size(); }
+    Stats  stats() const;
+
+private:
+    struct Item { Fn fn; TimePoint posted; };
+
+    void run();
+
+    static constexpr size_t WAIT_BUCKETS = 32;   // bucket k: waits below 2^k µs
+
+    mutable std::mutex      m_mutex;
+    std::condition_variable m_cv;        // worker: work or stop
+    std::condition_variable m_idle_cv;   // drain(): queue empty and idle
+    std::vector<Item>       m_items;     // ring of `capacity` slots
+    size_t                  m_head{0};
+    size_t                  m_count{0};
+    bool                    m_busy{false};
+    bool                    m_stop{false};
+    std::thread             m_worker;
+
+    size_t   m_max_depth{0};
+    uint64_t m_delivered{0};
+    uint64_t m_dropped{0};
+    uint64_t m_wait_total_us{0};
+    uint64_t m_wait_max_us{0};
+    uint64_t m_wait_buckets[WAIT_BUCKETS]{};
+};
+
+} // namespace mesh_io
+} // namespace vos
@@ -1,7 +1,16 @@
 #include "mesh_net.h"
+#include "mesh_io.h"
+#include "mesh_uring.h"
+#include "mesh_transfer.h"
+#include "mesh_route.h"
+#include "mesh_discovery.h"
+#include "mesh_sched.h"
+#include "drbg.h"
+#include "vfs.h"
 #include "vos/log.h"
 #include <cstring>
 #include <cstdlib>
+#include <algorithm>
 
 #ifdef _WIN32
 #include <winsock2.h>
@@ -23,19 +32,33 @@ namespace vos {
 
 static const char* TAG = "MeshNet";
 
-// ─── Helper: portable inet_pton wrapper ──────────────────────
-static void vos_inet_pton(const char* cp, void* addr) {
-#ifdef _WIN32
-    InetPtonA(AF_INET, cp, addr);
-#else
-    inet_pton(AF_INET, cp, addr);
-#endif
+
+static sockaddr_in make_dest(const MeshAddr& to) {
+    sockaddr_in dest;
+    to.to_sockaddr(dest);
+    return dest;
+}
+
+// The file name part of a peer-supplied path; empty if there is none.
+// Peers name files, never directories.
+static std::string base_name(const std::string& name) {
+    size_t      slash = name.find_last_of("/\\");
+    std::string base  = slash == std::string::npos ? name : name.substr(slash + 1);
+    return (base == "." || base == "..") ? std::string() : base;
 }
 
 // ─── MeshPacket ──────────────────────────────────────────────
 
+void MeshPacket::write_header(uint8_t* out, MeshMsgType type, uint32_t payload_len) {
+    uint32_t magic = MESH_MAGIC;
+    std::memcpy(out, &magic, 4);
+    out[4] = MESH_VERSION;
+    out[5] = static_cast<uint8_t>(type);
+    std::memcpy(out + 6, &payload_len, 4);
+}
+
 ByteBuffer MeshPacket::serialize() const {
-    size_t total = 4 + 1 + 1 + 4 + payload.size() + hmac.size();
+    size_t total = MESH_HEADER_SIZE + payload.size() + hmac.size();
     ByteBuffer buf(total);
     uint8_t* p = buf.data();
 
@@ -54,53 +77,184 @@ ByteBuffer MeshPacket::serialize() const {
     return buf;
 }
 
-Result<MeshPacket> MeshPacket::deserialize(const ByteBuffer& data) {
-    if (data.size() < 10)
-        return Result<MeshPacket>::error(StatusCode::ERR_INVALID_ARG);
-
+// Magic and length checks shared by both parsers; on success `payload_len`
+// bytes of payload follow the header and the rest of `data` is the MAC
+static bool parse_header(ConstByteSpan data, uint8_t& version, MeshMsgType& type,
+                         uint32_t& payload_len) {
+    if (data.size() < MESH_HEADER_SIZE) return false;
     const uint8_t* p = data.data();
-    MeshPacket pkt;
-
-    std::memcpy(&pkt.magic, p, 4); p += 4;
-    if (pkt.magic != MESH_MAGIC)
-        return Result<MeshPacket>::error(StatusCode::ERR_INVALID_ARG);
-
-    pkt.version = *p++;
-    pkt.type    = static_cast<MeshMsgType>(*p++);
-    std::memcpy(&pkt.payload_len, p, 4); p += 4;
+    uint32_t magic;
+    std::memcpy(&magic, p, 4);
+    if (magic != MESH_MAGIC) return false;
+    version = p[4];
+    type    = static_cast<MeshMsgType>(p[5]);
+    std::memcpy(&payload_len, p + 6, 4);
+    // Compared this way round so a huge length cannot wrap the sum
+    return payload_len <= data.size() - MESH_HEADER_SIZE;
+}
 
-    if (data.size() < 10 + pkt.payload_len)
+Result<MeshPacket> MeshPacket::deserialize(ConstByteSpan data) {
+    MeshPacket pkt;
+    if (!parse_header(data, pkt.version, pkt.type, pkt.payload_len))
         return Result<MeshPacket>::error(StatusCode::ERR_INVALID_ARG);
+    pkt.magic = MESH_MAGIC;
 
+    const uint8_t* p = data.data() + MESH_HEADER_SIZE;
     pkt.payload.assign(p, p + pkt.payload_len);
     p += pkt.payload_len;
 
-    size_t remaining = data.size() - (size_t)(10 + pkt.payload_len);
+    size_t remaining = data.size() - (MESH_HEADER_SIZE + pkt.payload_len);
     if (remaining > 0) {
         pkt.hmac.assign(p, p + remaining);
     }
     return Result<MeshPacket>::success(std::move(pkt));
 }
 
+// ─── MeshPacketView ──────────────────────────────────────────
+
+Result<MeshPacketView> MeshPacketView::parse(ByteSpan data) {
+    MeshPacketView view;
+    uint32_t       payload_len;
+    if (!parse_header(data, view.version, view.type, payload_len))
+        return Result<MeshPacketView>::error(StatusCode::ERR_INVALID_ARG);
+    view.payload = data.subspan(MESH_HEADER_SIZE, payload_len);
+    view.mac     = data.subspan(MESH_HEADER_SIZE + payload_len);
+    view.wire    = data;
+    return Result<MeshPacketView>::success(view);
+}
+
+MeshPacket MeshPacketView::to_packet() const {
+    MeshPacket pkt;
+    pkt.magic       = MESH_MAGIC;
+    pkt.version     = version;
+    pkt.type        = type;
+    pkt.payload_len = (uint32_t)payload.size();
+    pkt.payload     = payload.to_buffer();
+    pkt.hmac        = mac.to_buffer();
+    return pkt;
+}
+
 // ─── MeshNet ─────────────────────────────────────────────────
 
-MeshNet::MeshNet() {
+MeshNet::MeshNet()
+    : m_sched(new mesh_sched::SendScheduler),
+      m_routes(new mesh_route::RouteTable),
+      m_relay_seen(new mesh_route::DupFilter),
+      m_msg_callbacks(std::make_shared<std::vector<MeshMessageFn>>()),
+      m_peer_callbacks(std::make_shared<std::vector<MeshPeerFn>>()),
+      m_file_callbacks(std::make_shared<std::vector<MeshFileFn>>()) {
     // Generate a random peer ID
-    std::srand((unsigned)std::time(nullptr));
-    m_own_id = "PEER_" + std::to_string(std::rand() % 100000);
+    m_own_id = "PEER_" + std::to_string(secure_uniform(100000));
+    set_discovery(m_discovery);
+}
+
+// A fresh seed per instance, so peers that start together spread out
+static uint64_t random_seed() {
+    uint64_t seed;
+    secure_random(ByteSpan((uint8_t*)&seed, sizeof(seed)));
+    return seed;
 }
 
 MeshNet::~MeshNet() {
     shutdown();
 }
 
+// A UDP socket bound to ip:port with the options every mesh socket gets.
+// `reuse_port` lets several sockets share the port, the kernel spreading
+// senders over them. VOS_INVALID_SOCKET on failure.
+static mesh_io::SocketHandle open_socket(const std::string& ip, uint16_t port,
+                                         bool reuse_port = false) {
+    mesh_io::SocketHandle sock = (mesh_io::SocketHandle)socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if ((intptr_t)sock < 0) {
+        log::error(TAG, "Failed to create socket");
+        return (mesh_io::SocketHandle)VOS_INVALID_SOCKET;
+    }
+
+    // Allow address reuse
+    int optval = 1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, (const char*)&optval, sizeof(optval));
+#ifdef SO_REUSEPORT
+    if (reuse_port) setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, (const char*)&optval, sizeof(optval));
+#else
+    (void)reuse_port;
+#endif
+
+    // Enable broadcast
+    int bcast = 1;
+    setsockopt(sock, SOL_SOCKET, SO_BROADCAST, (const char*)&bcast, sizeof(bcast));
+
+    // Room for a full transfer window in flight (capped by the OS limit)
+    int rcvbuf = 4 << 20;
+    setsockopt(sock, SOL_SOCKET, SO_RCVBUF, (const char*)&rcvbuf, sizeof(rcvbuf));
+
+    MeshAddr    local = MeshAddr::parse(ip, port);
+    sockaddr_in addr  = make_dest(local);
+    if (!local.is_v4() || bind(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        log::error(TAG, "Bind to %s:%u failed", ip.c_str(), port);
+        closesocket(sock);
+        return (mesh_io::SocketHandle)VOS_INVALID_SOCKET;
+    }
+    return sock;
+}
+
+/*
+ * One receive socket and the thread that drains it. SO_REUSEPORT hashes
+ * each sender's address onto one socket, so a transfer's META, chunks and
+ * resends all land in the same shard and its state needs no sharing.
+ * Shard 0 runs on the main loop; the others have a loop of their own.
+ */
+struct MeshNet::RxShard {
+    size_t                              index = 0;
+    Socket                              sock{(Socket)-1};
+    mesh_io::Reactor*                   reactor = nullptr;
+    std::unique_ptr<mesh_io::Reactor>   own_reactor;   // shards 1..n-1
+    std::thread                         thread;
+    mesh_io::RecvBatch                  rx;
+    std::unique_ptr<mesh_io::UringRecv> urx;
+
+    // Incoming transfers; taken by this shard's thread, and by nothing
+    // else while traffic flows
+    std::mutex                                                             mutex;
+    std::unordered_map<TransferKey, std::unique_ptr<mesh_xfer::Incoming>, TransferKeyHash> incoming;
+    std::vector<mesh_xfer::Incoming*>                                      ack_due;
+    bool                                                                   expiry_armed = false;
+
+    std::atomic<uint64_t> packets{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> syscalls{0};
+};
+
+/*
+ * Probing state of one peer. A PING carries our microsecond clock and the
+ * PONG echoes it back. Only the echo of the latest probe is an RTT sample
+ * (Karn's rule), but any answer shows the peer is alive.
+ */
+struct MeshNet::Probe {
+    mesh_xfer::RttEstimator rtt;
+    TimePoint               next{};           // next probe or retry; {} = now
+    Millis                  interval{0};      // wait after the next answer
+    uint32_t                sent_ts = 0;      // TS of the probe out now
+    bool                    waiting = false;  // a probe is unanswered
+    int                     missed  = 0;      // unanswered in a row
+};
+
 Result<void> MeshNet::init(Crypto* crypto, uint16_t port) {
     std::lock_guard<std::mutex> lock(m_mutex);
     if (m_running.load()) return Result<void>::error(StatusCode::ERR_ALREADY_EXISTS);
 
     m_crypto      = crypto;
     m_port        = port;
-    m_session_key = m_crypto->generate_key();
+    ByteBuffer key     = m_crypto->generate_key();
+    auto       session = std::make_shared<CryptoSession>(key);
+    std::fill(key.begin(), key.end(), 0);
+    {
+        std::lock_guard<std::mutex> slock(m_session_mutex);
+        m_session = std::move(session);
+    }
+    // Relayed message ids start anywhere, so two instances rarely share one
+    uint64_t seq;
+    secure_random(ByteSpan((uint8_t*)&seq, sizeof(seq)));
+    m_relay_seq.store(seq);
 
 #ifdef _WIN32
     WSADATA wsa;
@@ -110,53 +264,115 @@ Result<void> MeshNet::init(Crypto* crypto, uint16_t port) {
     }
 #endif
 
-    // Create UDP socket
-    m_socket = (uintptr_t)socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-    if ((intptr_t)m_socket < 0) {
-        log::error(TAG, "Failed to create socket");
-        return Result<void>::error(StatusCode::ERR_NETWORK);
+    m_reactor.reset(new mesh_io::Reactor());
+    if (!m_reactor->ok()) return Result<void>::error(StatusCode::ERR_INTERNAL);
+
+    // Counters of the previous run's shards carry over
+    for (auto& shard : m_shards) {
+        m_rx_base[0] += shard->packets.load();
+        m_rx_base[1] += shard->bytes.load();
+        m_rx_base[2] += shard->syscalls.load();
+    }
+    m_shards.clear();
+
+    // No receive timeout: the event loops read only when data is queued
+    size_t shards = m_shard_request;
+    for (size_t i = 0; i < shards; i++) {
+        auto shard   = std::make_unique<RxShard>();
+        shard->index = i;
+        shard->sock  = open_socket("0.0.0.0", m_port, shards > 1);
+        if ((intptr_t)shard->sock < 0) {
+            for (auto& s : m_shards) closesocket(s->sock);
+            m_shards.clear();
+            return Result<void>::error(StatusCode::ERR_NETWORK);
+        }
+        if (i == 0) {
+            shard->reactor = m_reactor.get();
+        } else {
+            shard->own_reactor.reset(new mesh_io::Reactor());
+            shard->reactor = shard->own_reactor.get();
+        }
+        m_shards.push_back(std::move(shard));
+    }
+    m_socket = m_shards[0]->sock;
+
+    m_io_backend.store(MeshIoBackend::SYSCALLS);
+#if VOS_HAVE_IO_URING
+    if (m_io_request != MeshIoBackend::SYSCALLS) {
+        if (mesh_io::Uring::supported()) {
+            bool ok = true;
+            for (auto& shard : m_shards) {
+                shard->urx.reset(new mesh_io::UringRecv(shard->sock));
+                ok = ok && shard->urx->ok();
+            }
+            m_utx.reset(new mesh_io::Uring((unsigned)FILE_TX_SLOTS));
+            if (ok && m_utx->ok()) {
+                m_io_backend.store(MeshIoBackend::IO_URING);
+            } else {
+                for (auto& shard : m_shards) shard->urx.reset();
+                m_utx.reset();
+            }
+        }
+        if (m_io_request == MeshIoBackend::IO_URING && m_io_backend.load() != MeshIoBackend::IO_URING)
+            log::warn(TAG, "io_uring not available here; using socket calls");
+    }
+#endif
+    for (auto& ptr : m_shards) {
+        RxShard& shard = *ptr;
+        if (!shard.reactor->ok()) {
+            for (auto& s : m_shards) closesocket(s->sock);
+            m_shards.clear();
+            return Result<void>::error(StatusCode::ERR_INTERNAL);
+        }
+#if VOS_HAVE_IO_URING
+        if (shard.urx) {
+            // Armed from the shard's own thread, which the kernel then completes on
+            shard.reactor->add_socket(shard.urx->fd(), [this, &shard] { on_ring(shard); });
+            shard.reactor->post([this, &shard] {
+                if (!shard.urx->start()) fall_back_to_syscalls(shard);
+            });
+            continue;
+        }
+#endif
+        Socket sock = shard.sock;
+        shard.reactor->add_socket(sock, [this, &shard, sock] { on_readable(shard, sock); });
     }
+    if (m_discovering.load()) m_reactor->post([this] { discovery_tick(); });
+    if (m_probing.load()) m_reactor->post([this] { liveness_tick(); });
+    if (m_routing.load()) m_reactor->post([this] { route_tick(); });
 
-    // Allow address reuse
-    int optval = 1;
-    setsockopt((int)m_socket, SOL_SOCKET, SO_REUSEADDR,
-               (const char*)&optval, sizeof(optval));
+    m_drain_posted.store(false);
 
-    // Enable broadcast
-    int bcast = 1;
-    setsockopt((int)m_socket, SOL_SOCKET, SO_BROADCAST,
-               (const char*)&bcast, sizeof(bcast));
+    if (!m_dispatch || m_dispatch->capacity() != m_dispatch_capacity)
+        m_dispatch.reset(new mesh_io::CallbackQueue(m_dispatch_capacity));
+    m_dispatch->start();
 
-    // Set non-blocking with timeout for clean shutdown
-#ifdef _WIN32
-    DWORD timeout = 1000;
-    setsockopt((int)m_socket, SOL_SOCKET, SO_RCVTIMEO,
-               (const char*)&timeout, sizeof(timeout));
-#else
-    struct timeval tv;
-    tv.tv_sec  = 1;
-    tv.tv_usec = 0;
-    setsockopt((int)m_socket, SOL_SOCKET, SO_RCVTIMEO,
-               (const char*)&tv, sizeof(tv));
-#endif
+    m_running.store(true);
+    m_loop_thread = std::thread([this] { m_reactor->run(); });
+    for (size_t i = 1; i < m_shards.size(); i++) {
+        RxShard& shard = *m_shards[i];
+        shard.thread   = std::thread([&shard] { shard.reactor->run(); });
+    }
 
-    // Bind
-    sockaddr_in addr{};
-    addr.sin_family      = AF_INET;
-    addr.sin_addr.s_addr = INADDR_ANY;
-    addr.sin_port        = htons(m_port);
+    log::info(TAG, "Mesh network started on port %u (%s, %zu receive shard%s)  |  PeerID: %s",
+              m_port, m_io_backend.load() == MeshIoBackend::IO_URING ? "io_uring" : "socket calls",
+              m_shards.size(), m_shards.size() == 1 ? "" : "s", m_own_id.c_str());
+    return Result<void>::success();
+}
 
-    if (bind((int)m_socket, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
-        log::error(TAG, "Bind to port %u failed", m_port);
-        closesocket((int)m_socket);
+Result<void> MeshNet::add_listener(uint16_t port, const std::string& bind_ip) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_running.load()) return Result<void>::error(StatusCode::ERR_NOT_INITIALIZED);
+
+    Socket sock = open_socket(bind_ip, port);
+    if ((intptr_t)sock < 0) return Result<void>::error(StatusCode::ERR_NETWORK);
+    RxShard& shard = *m_shards[0];
+    if (!m_reactor->add_socket(sock, [this, &shard, sock] { on_readable(shard, sock); })) {
+        closesocket(sock);
         return Result<void>::error(StatusCode::ERR_NETWORK);
     }
-
-    m_running.store(true);
-    m_listener_thread = std::thread(&MeshNet::listener_loop, this);
-
-    log::info(TAG, "Mesh network started on port %u  |  PeerID: %s",
-              m_port, m_own_id.c_str());
+    m_extra_sockets.push_back(sock);
+    log::info(TAG, "Also listening on %s:%u", bind_ip.c_str(), port);
     return Result<void>::success();
 }
 
@@ -166,13 +382,45 @@ void MeshNet::shutdown() {
     m_running.store(false);
     m_discovering.store(false);
 
-    if ((intptr_t)m_socket >= 0) {
-        closesocket((int)m_socket);
-        m_socket = (uintptr_t)-1;
+    // Queued small messages go out while the socket is still open
+    flush_bundles();
+
+    // Wake send_file() callers waiting for ACKs or queue room
+    { std::lock_guard<std::mutex> lock(m_xfer_mutex); }
+    m_xfer_cv.notify_all();
+    { std::lock_guard<std::mutex> lock(m_sched_mutex); }
+    m_sched_cv.notify_all();
+
+    // The loops are woken, not timed out, so this returns at once
+    for (auto& shard : m_shards) shard->reactor->stop();
+    if (m_loop_thread.joinable()) m_loop_thread.join();
+    for (auto& shard : m_shards) {
+        if (shard->thread.joinable()) shard->thread.join();
     }
+    // Nothing posts now; callbacks already queued still run
+    m_dispatch->stop();
 
-    if (m_listener_thread.joinable())   m_listener_thread.join();
-    if (m_discovery_thread.joinable())  m_discovery_thread.join();
+    // One last pass over the send queues, as far as the limits allow
+    drain_sends();
+    {
+        std::lock_guard<std::mutex> lock(m_sched_mutex);
+        m_sched->clear();
+    }
+
+    // Rings go before the sockets they reference
+    {
+        std::lock_guard<std::mutex> lock(m_tx_mutex);
+        m_tx_batch.reset();
+        m_utx.reset();
+    }
+    for (auto& shard : m_shards) {
+        shard->urx.reset();
+        closesocket(shard->sock);
+        shard->sock = (Socket)-1;
+    }
+    m_socket = (Socket)-1;
+    for (auto sock : m_extra_sockets) closesocket(sock);
+    m_extra_sockets.clear();
 
 #ifdef _WIN32
     WSACleanup();
@@ -180,16 +428,24 @@ void MeshNet::shutdown() {
     log::info(TAG, "Mesh network shutdown — discovered %zu peers", m_peers.size());
 }
 
+void MeshNet::set_discovery(const MeshDiscoveryConfig& cfg) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_discovery = cfg;
+    m_trickle.reset(new mesh_discovery::Trickle(cfg.interval_min, cfg.interval_max, cfg.redundancy,
+                                                random_seed()));
+    if (m_discovering.load() && m_running.load()) m_reactor->post([this] { discovery_tick(); });
+}
+
 void MeshNet::start_discovery() {
-    if (m_discovering.load()) return;
-    m_discovering.store(true);
-    m_discovery_thread = std::thread(&MeshNet::discovery_loop, this);
+    if (m_discovering.exchange(true)) return;
+    // Before init() the first broadcast waits for the loop to start
+    if (m_running.load()) m_reactor->post([this] { discovery_tick(); });
     log::info(TAG, "Peer discovery started");
 }
 
 void MeshNet::stop_discovery() {
     m_discovering.store(false);
-    if (m_discovery_thread.joinable()) m_discovery_thread.join();
+    if (m_running.load()) m_reactor->post([this] { m_reactor->cancel(m_discovery_timer); });
     log::info(TAG, "Peer discovery stopped");
 }
 
@@ -203,122 +459,878 @@ std::vector<MeshPeer> MeshNet::get_peers() const {
     return out;
 }
 
+void MeshNet::add_peer(const std::string& peer_id, const std::string& ip, uint16_t port) {
+    // Parsed once here; sends and lookups use the binary form
+    MeshAddr addr = MeshAddr::parse(ip, port);
+    if (!addr.is_v4()) {
+        log::warn(TAG, "Not adding %s: '%s' is not an IPv4 address", peer_id.c_str(), ip.c_str());
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    MeshPeer& peer = m_peers[peer_id];
+    peer.peer_id   = peer_id;
+    index_peer(peer, addr);
+    peer.last_seen = Clock::now();
+    peer.connected = true;
+    // Probe the newcomer now rather than at the next scheduled round
+    if (m_probing.load() && m_running.load()) m_reactor->post([this] { liveness_tick(); });
+    routes_changed();
+    discovery_changed();
+}
+
+// Point `peer` at `addr` and keep m_peer_index in step. The text form in
+// MeshPeer is made here, only when the endpoint changes.
+void MeshNet::index_peer(MeshPeer& peer, const MeshAddr& addr) {
+    if (peer.endpoint == addr && !peer.address.empty()) return;
+    auto old = m_peer_index.find(peer.endpoint);
+    if (old != m_peer_index.end() && old->second == peer.peer_id) m_peer_index.erase(old);
+    peer.endpoint = addr;
+    peer.address  = addr.to_string();
+    peer.port     = addr.host_port();
+    m_peer_index[addr] = peer.peer_id;
+}
+
+// A peer added with port 0 listens on our own mesh port
+static MeshAddr send_to(const MeshPeer& peer, uint16_t default_port) {
+    MeshAddr to = peer.endpoint;
+    if (to.port == 0) to.set_host_port(default_port);
+    return to;
+}
+
 Result<void> MeshNet::send_text(const std::string& peer_id, const std::string& message) {
-    std::string addr_str;
+    ConstByteSpan text((const uint8_t*)message.data(), message.size());
+    MeshAddr      to;
+    bool          relayed;
     {
         std::lock_guard<std::mutex> lock(m_mutex);
-        auto it = m_peers.find(peer_id);
-        if (it == m_peers.end())
+        if (!route_to(peer_id, to, relayed))
             return Result<void>::error(StatusCode::ERR_NOT_FOUND);
-        addr_str = it->second.address;
+    }
+    if (relayed) {
+        auto r = send_relayed(to, peer_id, MeshMsgType::TEXT_MSG, text);
+        if (r.ok()) log::info(TAG, "Sent encrypted message to %s by relay (%zu bytes)",
+                              peer_id.c_str(), message.size());
+        return r;
     }
 
-    // Encrypt payload
-    ByteBuffer plain(message.begin(), message.end());
-    ByteBuffer encrypted = m_crypto->encrypt(plain, m_session_key);
+    if (coalesce(to, MeshMsgType::TEXT_MSG, text)) {
+        log::info(TAG, "Queued encrypted message to %s (%zu bytes)", peer_id.c_str(), message.size());
+        return Result<void>::success();
+    }
 
-    MeshPacket pkt = create_packet(MeshMsgType::TEXT_MSG, encrypted);
-    pkt.hmac = m_crypto->hmac(encrypted, m_session_key);
-    ByteBuffer buf = pkt.serialize();
+    // Build the packet in one buffer: [HEADER][NONCE|TEXT|TAG],
+    // encrypting the text where it lands. The AEAD tag authenticates it.
+    size_t payload_len = Crypto::OVERHEAD + message.size();
+    ByteBuffer buf(MESH_HEADER_SIZE + payload_len);
+    MeshPacket::write_header(buf.data(), MeshMsgType::TEXT_MSG, (uint32_t)payload_len);
 
-    sockaddr_in dest{};
-    dest.sin_family = AF_INET;
-    dest.sin_port   = htons(m_port);
-    vos_inet_pton(addr_str.c_str(), &dest.sin_addr);
+    ByteSpan record(buf.data() + MESH_HEADER_SIZE, payload_len);
+    std::memcpy(record.data() + Crypto::NONCE_SIZE, message.data(), message.size());
+    if (!session()->seal_in_place(record).ok())
+        return Result<void>::error(StatusCode::ERR_CRYPTO);
 
-    sendto((int)m_socket, (const char*)buf.data(), (int)buf.size(), 0,
-           (struct sockaddr*)&dest, sizeof(dest));
+    send_datagram(make_dest(to), buf.data(), buf.size());
 
     log::info(TAG, "Sent encrypted message to %s (%zu bytes)",
               peer_id.c_str(), buf.size());
     return Result<void>::success();
 }
 
+void MeshNet::set_coalesce_window(std::chrono::microseconds window) {
+    m_coalesce_us.store(std::max<int64_t>(window.count(), 0));
+    if (window.count() <= 0) flush_bundles();
+}
+
+// ─── Coalescing ──────────────────────────────────────────────
+
+// BUNDLE record: [TYPE:1][LEN:2][BODY:LEN]
+static constexpr size_t BUNDLE_RECORD_HDR = 3;
+// Record bytes one BUNDLE datagram has room for
+static constexpr size_t BUNDLE_ROOM =
+    MESH_BUNDLE_MAX - MESH_HEADER_SIZE - Crypto::OVERHEAD;
+
+// Queue a message for `to`'s next BUNDLE. False when it has to go out on
+// its own: coalescing is off or the message is too big to share. Anything
+// already queued for `to` is sent first then, so order holds.
+bool MeshNet::coalesce(const MeshAddr& to, MeshMsgType type, ConstByteSpan body) {
+    int64_t window = m_coalesce_us.load();
+    if (window <= 0 || !m_running.load()) return false;
+    if (BUNDLE_RECORD_HDR + body.size() > BUNDLE_ROOM) {
+        flush_bundle(to);
+        return false;
+    }
+
+    Bundle full;   // a bundle this record does not fit in, sent now
+    bool   arm = false;
+    {
+        std::lock_guard<std::mutex> lock(m_bundle_mutex);
+        Bundle& b = m_bundles[to];
+        if (b.records.size() + BUNDLE_RECORD_HDR + body.size() > BUNDLE_ROOM) std::swap(full, b);
+        if (b.count == 0) {
+            b.records.reserve(BUNDLE_ROOM);
+            arm = true;
+        }
+        uint8_t  hdr[BUNDLE_RECORD_HDR];
+        uint16_t len = (uint16_t)body.size();
+        hdr[0] = static_cast<uint8_t>(type);
+        std::memcpy(hdr + 1, &len, 2);
+        b.records.insert(b.records.end(), hdr, hdr + BUNDLE_RECORD_HDR);
+        b.records.insert(b.records.end(), body.begin(), body.end());
+        b.count++;
+    }
+    if (full.count) send_bundle(to, full.records, full.count);
+    // The first record of a bundle starts its window. A timer left by a
+    // bundle that filled up early only sends this one a little sooner.
+    if (arm) m_reactor->schedule(std::chrono::microseconds(window), [this, to] { flush_bundle(to); });
+    return true;
+}
+
+void MeshNet::flush_bundle(const MeshAddr& to) {
+    Bundle b;
+    {
+        std::lock_guard<std::mutex> lock(m_bundle_mutex);
+        auto it = m_bundles.find(to);
+        if (it == m_bundles.end()) return;
+        b = std::move(it->second);
+        m_bundles.erase(it);
+    }
+    if (b.count) send_bundle(to, b.records, b.count);
+}
+
+void MeshNet::flush_bundles() {
+    std::unordered_map<MeshAddr, Bundle, MeshAddrHash> all;
+    {
+        std::lock_guard<std::mutex> lock(m_bundle_mutex);
+        all.swap(m_bundles);
+    }
+    for (auto& kv : all) {
+        if (kv.second.count) send_bundle(kv.first, kv.second.records, kv.second.count);
+    }
+}
+
+void MeshNet::send_bundle(const MeshAddr& to, const ByteBuffer& records, size_t count) {
+    // Same layout as TEXT_MSG: [HEADER][NONCE|RECORDS|TAG]
+    size_t     payload_len = Crypto::OVERHEAD + records.size();
+    ByteBuffer buf(MESH_HEADER_SIZE + payload_len);
+    MeshPacket::write_header(buf.data(), MeshMsgType::BUNDLE, (uint32_t)payload_len);
+
+    ByteSpan record(buf.data() + MESH_HEADER_SIZE, payload_len);
+    std::memcpy(record.data() + Crypto::NONCE_SIZE, records.data(), records.size());
+    if (!session()->seal_in_place(record).ok()) return;
+
+    // Counted first, so the stats never lag behind what a receiver has seen
+    m_tx_bundles.fetch_add(1, std::memory_order_relaxed);
+    m_tx_bundled.fetch_add(count, std::memory_order_relaxed);
+    send_datagram(make_dest(to), buf.data(), buf.size());
+}
+
+void MeshNet::handle_bundle(ByteSpan records, const MeshAddr& from) {
+    std::string sender_id;
+    for (size_t off = 0; off + BUNDLE_RECORD_HDR <= records.size();) {
+        MeshMsgType type = static_cast<MeshMsgType>(records[off]);
+        uint16_t    len;
+        std::memcpy(&len, records.data() + off + 1, 2);
+        off += BUNDLE_RECORD_HDR;
+        if (len > records.size() - off) {
+            m_rx_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        ConstByteSpan body(records.data() + off, len);
+        off += len;
+
+        switch (type) {
+        case MeshMsgType::TEXT_MSG:
+            if (sender_id.empty()) sender_id = peer_at(from);
+            deliver_text(sender_id, body);
+            break;
+        case MeshMsgType::PING:
+            send_pong(from, body);
+            break;
+        default:
+            break;   // from a newer peer: skip it, keep the rest
+        }
+    }
+}
+
+// Give up after this many retransmission timeouts with no progress
+static constexpr int FILE_MAX_SILENT_RTOS = 10;
+
 Result<void> MeshNet::send_file(const std::string& peer_id,
                                 const std::string& filename,
                                 const ByteBuffer& data) {
-    // Send file metadata first, then chunks
-    std::string addr_str;
+    using namespace mesh_xfer;
+
+    MeshAddr     to;
+    RttEstimator rtt;
     {
         std::lock_guard<std::mutex> lock(m_mutex);
         auto it = m_peers.find(peer_id);
         if (it == m_peers.end())
             return Result<void>::error(StatusCode::ERR_NOT_FOUND);
-        addr_str = it->second.address;
+        to = send_to(it->second, m_port);
+        auto probe = m_probes.find(peer_id);
+        if (probe != m_probes.end()) rtt = probe->second->rtt;
     }
+    if (filename.empty() || data.size() > MESH_MAX_FILE)
+        return Result<void>::error(StatusCode::ERR_INVALID_ARG);
+    if (!m_running.load()) return Result<void>::error(StatusCode::ERR_NOT_INITIALIZED);
+
+    Outgoing xfer((uint32_t)((data.size() + MESH_FILE_CHUNK - 1) / MESH_FILE_CHUNK));
+    do {
+        secure_random(ByteSpan((uint8_t*)&xfer.id, sizeof(xfer.id)));
+    } while (xfer.id == 0);
+    xfer.peer = to;
+    xfer.window.seed_rtt(rtt);
+    sockaddr_in dest = make_dest(to);
+
+    std::unique_lock<std::mutex> lk(m_xfer_mutex);
+    m_outgoing[xfer.id] = &xfer;
+
+    auto run = [&]() -> Result<void> {
+        // META, resent on the retransmission timer until acknowledged
+        ByteBuffer meta(META_FIXED + filename.size());
+        uint64_t   size  = data.size();
+        uint32_t   chunk = (uint32_t)MESH_FILE_CHUNK;
+        std::memcpy(meta.data(), &xfer.id, 4);
+        std::memcpy(meta.data() + 8, &size, 8);
+        std::memcpy(meta.data() + 16, &chunk, 4);
+        lk.unlock();
+        Sha256::hash(data.data(), data.size(), meta.data() + 20);
+        lk.lock();
+        std::memcpy(meta.data() + META_FIXED, filename.data(), filename.size());
+
+        for (int attempt = 0; !xfer.meta_acked; attempt++) {
+            if (!m_running.load()) return Result<void>::error(StatusCode::ERR_NETWORK);
+            if (attempt == FILE_MAX_SILENT_RTOS) return Result<void>::error(StatusCode::ERR_TIMEOUT);
+            uint32_t ts = now_us();
+            std::memcpy(meta.data() + 4, &ts, 4);
+            lk.unlock();
+            auto r = send_sealed(dest, MeshMsgType::FILE_META, meta.data(), meta.size());
+            lk.lock();
+            if (!r.ok()) return r;
+
+            auto wait = std::chrono::microseconds((int64_t)xfer.window.rto_us() << std::min(attempt, 4));
+            m_xfer_cv.wait_for(lk, wait, [&] { return xfer.meta_acked || !m_running.load(); });
+        }
 
-    // META packet: filename + size
-    std::string meta = filename + "|" + std::to_string(data.size());
-    ByteBuffer meta_buf(meta.begin(), meta.end());
-    MeshPacket meta_pkt = create_packet(MeshMsgType::FILE_META, meta_buf);
-    ByteBuffer meta_wire = meta_pkt.serialize();
+        // Chunks, as fast as the window opens
+        std::vector<uint32_t> picks(FILE_TX_SLOTS);
+        while (!xfer.window.done()) {
+            if (!m_running.load()) return Result<void>::error(StatusCode::ERR_NETWORK);
+            uint32_t now = now_us();
+            if (xfer.window.check_timeout(now) &&
+                xfer.window.consecutive_timeouts() >= FILE_MAX_SILENT_RTOS) {
+                return Result<void>::error(StatusCode::ERR_TIMEOUT);
+            }
+            size_t n = xfer.window.next_batch(picks.data(), picks.size(), now);
+            if (n > 0) {
+                lk.unlock();
+                auto r = send_chunks(xfer, data, picks.data(), n);
+                lk.lock();
+                if (!r.ok()) return r;
+                continue;
+            }
+            uint64_t seen = xfer.events;
+            auto     wait = std::chrono::microseconds(xfer.window.next_deadline(now) + 1);
+            m_xfer_cv.wait_for(lk, wait, [&] { return xfer.events != seen || !m_running.load(); });
+        }
+        return Result<void>::success();
+    };
+    Result<void> result = run();
+    m_outgoing.erase(xfer.id);
+    lk.unlock();
+
+    m_file_chunks_sent.fetch_add(xfer.window.transmissions(), std::memory_order_relaxed);
+    m_file_retransmits.fetch_add(xfer.window.retransmits(), std::memory_order_relaxed);
+    m_file_timeouts.fetch_add(xfer.window.timeouts(), std::memory_order_relaxed);
+
+    if (!result.ok()) {
+        log::warn(TAG, "File '%s' to %s failed after %u/%u chunks: %s", filename.c_str(),
+                  peer_id.c_str(), xfer.window.acked(), xfer.window.chunks(),
+                  status_to_string(result.status));
+        return result;
+    }
+    log::info(TAG, "Sent file '%s' (%zu bytes) to %s — %llu retransmits, srtt %.2f ms",
+              filename.c_str(), data.size(), peer_id.c_str(),
+              (unsigned long long)xfer.window.retransmits(), xfer.window.srtt_us() / 1000.0);
+    return Result<void>::success();
+}
+
+// ─── Download (pull from several peers) ─────────────────────
+
+// Resume map beside a partial download:
+// [MAGIC:4][SIZE:8][CHUNK_SIZE:4][SHA256:32][one bit per chunk, LSB first]
+static constexpr uint32_t RESUME_MAGIC  = 0x50534F56; // "VOSP"
+static constexpr size_t   RESUME_HEADER = 48;
+
+static void save_resume_map(VirtualFS& store, const std::string& path, const mesh_xfer::Pull& p) {
+    uint32_t   n = p.sched->chunks();
+    ByteBuffer map(RESUME_HEADER + (n + 7) / 8, 0);
+    std::memcpy(map.data(), &RESUME_MAGIC, 4);
+    std::memcpy(map.data() + 4, &p.size, 8);
+    std::memcpy(map.data() + 12, &p.chunk_size, 4);
+    std::memcpy(map.data() + 16, p.digest, mesh_xfer::DIGEST_SIZE);
+    for (uint32_t i = 0; i < n; i++) {
+        if (p.sched->has(i)) map[RESUME_HEADER + i / 8] |= (uint8_t)(1u << (i % 8));
+    }
+    store.write_file(path, map);
+}
+
+// The file a previous attempt was fetching, from its map: size, chunk
+// size and digest, so sources holding something else are not used
+static bool read_resume_header(VirtualFS& store, const std::string& path, mesh_xfer::Pull& p) {
+    auto map = store.read_file(path);
+    if (!map.ok() || map.value.size() < RESUME_HEADER) return false;
+    uint32_t magic, chunk;
+    uint64_t size;
+    std::memcpy(&magic, map.value.data(), 4);
+    std::memcpy(&size, map.value.data() + 4, 8);
+    std::memcpy(&chunk, map.value.data() + 12, 4);
+    if (magic != RESUME_MAGIC || chunk == 0 || chunk > MESH_FILE_CHUNK || size > MESH_MAX_FILE)
+        return false;
+    p.have_meta  = true;
+    p.size       = size;
+    p.chunk_size = chunk;
+    std::memcpy(p.digest, map.value.data() + 16, mesh_xfer::DIGEST_SIZE);
+    return true;
+}
+
+// Mark the chunks a previous attempt stored; false if there is nothing
+// usable (no map, or it describes a different file)
+static bool load_resume_map(VirtualFS& store, const std::string& path, mesh_xfer::Pull& p) {
+    auto map  = store.read_file(path);
+    auto part = store.file_size(p.part_path);
+    if (!map.ok() || !part.ok() || part.value != p.size) return false;
+    uint32_t n = p.sched->chunks();
+    if (map.value.size() != RESUME_HEADER + (n + 7) / 8) return false;
+
+    uint32_t magic, chunk;
+    uint64_t size;
+    std::memcpy(&magic, map.value.data(), 4);
+    std::memcpy(&size, map.value.data() + 4, 8);
+    std::memcpy(&chunk, map.value.data() + 12, 4);
+    if (magic != RESUME_MAGIC || size != p.size || chunk != p.chunk_size ||
+        std::memcmp(map.value.data() + 16, p.digest, mesh_xfer::DIGEST_SIZE) != 0) {
+        return false;
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        if (map.value[RESUME_HEADER + i / 8] & (1u << (i % 8))) p.sched->mark_have(i);
+    }
+    return true;
+}
+
+Result<void> MeshNet::download_file(const std::string& name,
+                                    const std::vector<std::string>& peer_ids,
+                                    MeshProgressFn progress) {
+    using namespace mesh_xfer;
+
+    Pull        pull;
+    VirtualFS*  store;
+    std::string dir;
+    pull.name = base_name(name);
+    if (pull.name.empty()) return Result<void>::error(StatusCode::ERR_INVALID_ARG);
+    {
+        std::lock_guard<std::mutex> lock(m_store_mutex);
+        if (!m_store) return Result<void>::error(StatusCode::ERR_NOT_INITIALIZED);
+        store = m_store;
+        dir   = m_store_dir;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::vector<Pull::Source> stale;
+        for (const auto& id : peer_ids) {
+            auto it = m_peers.find(id);
+            if (it == m_peers.end()) continue;
+            Pull::Source src;
+            src.peer_id = id;
+            src.addr    = send_to(it->second, m_port);
+            auto probe  = m_probes.find(id);
+            if (probe != m_probes.end()) src.rtt = probe->second->rtt;
+            (it->second.connected ? pull.sources : stale).push_back(src);
+        }
+        // Stale peers are asked only when no live one is left
+        if (pull.sources.empty()) pull.sources = std::move(stale);
+    }
+    if (pull.sources.empty()) return Result<void>::error(StatusCode::ERR_NOT_FOUND);
+    if (!m_running.load()) return Result<void>::error(StatusCode::ERR_NOT_INITIALIZED);
+    do {
+        secure_random(ByteSpan((uint8_t*)&pull.id, sizeof(pull.id)));
+    } while (pull.id == 0);
+
+    std::string final_path = dir + "/" + pull.name;
+    std::string map_path   = final_path + ".part.map";
+    pull.part_path         = final_path + ".part";
+
+    ByteBuffer req(REQ_FIXED + pull.name.size() + REQ_MAX * 4);
+    auto send_req = [&](const Pull::Source& src, const uint32_t* indices, size_t count) {
+        uint32_t ts       = now_us();
+        uint16_t name_len = (uint16_t)pull.name.size();
+        uint16_t n        = (uint16_t)count;
+        std::memcpy(req.data(), &pull.id, 4);
+        std::memcpy(req.data() + 4, &ts, 4);
+        std::memcpy(req.data() + 8, &name_len, 2);
+        std::memcpy(req.data() + 10, &n, 2);
+        std::memcpy(req.data() + REQ_FIXED, pull.name.data(), name_len);
+        if (count) std::memcpy(req.data() + REQ_FIXED + name_len, indices, count * 4);
+        return send_sealed(make_dest(src.addr), MeshMsgType::FILE_REQ,
+                           req.data(), REQ_FIXED + name_len + count * 4);
+    };
+
+    // Resuming pins the file to the one already half here; otherwise the
+    // first source to answer decides, and any that differ are left out
+    read_resume_header(*store, map_path, pull);
+
+    std::unique_lock<std::mutex> lk(m_xfer_mutex);
+    m_pulls[pull.id] = &pull;
+    bool resumed = false;
+
+    auto run = [&]() -> Result<void> {
+        // Ask every source for META, resending to the silent ones
+        auto all_replied = [&] {
+            for (const auto& src : pull.sources)
+                if (src.reply == Pull::Reply::NONE) return false;
+            return true;
+        };
+        for (int attempt = 0; attempt < 4 && !all_replied(); attempt++) {
+            for (const auto& src : pull.sources) {
+                if (src.reply != Pull::Reply::NONE) continue;
+                lk.unlock();
+                send_req(src, nullptr, 0);
+                lk.lock();
+            }
+            auto wait = std::chrono::microseconds((int64_t)SendWindow::RTO_INITIAL << attempt);
+            m_xfer_cv.wait_for(lk, wait, [&] { return all_replied() || !m_running.load(); });
+        }
+        bool any = false;
+        for (const auto& src : pull.sources) any |= src.reply == Pull::Reply::HAS_FILE;
+        if (!any) return Result<void>::error(StatusCode::ERR_NOT_FOUND);
+
+        uint32_t nchunks = (uint32_t)((pull.size + pull.chunk_size - 1) / pull.chunk_size);
+        pull.sched.reset(new PullScheduler(nchunks, pull.sources.size()));
+        for (size_t s = 0; s < pull.sources.size(); s++) {
+            pull.sched->seed_rtt(s, pull.sources[s].rtt);
+            if (pull.sources[s].reply != Pull::Reply::HAS_FILE) pull.sched->drop_source(s);
+        }
+        resumed = load_resume_map(*store, map_path, pull);
+        if (!resumed && !store->resize_file(pull.part_path, (size_t)pull.size).ok())
+            return Result<void>::error(StatusCode::ERR_IO);
+        if (resumed) {
+            log::info(TAG, "Resuming '%s': %u of %u chunks already here", pull.name.c_str(),
+                      pull.sched->have_count(), nchunks);
+        }
 
-    sockaddr_in dest{};
-    dest.sin_family = AF_INET;
-    dest.sin_port   = htons(m_port);
-    vos_inet_pton(addr_str.c_str(), &dest.sin_addr);
+        std::vector<uint32_t> picks(REQ_MAX);
+        uint32_t  saved    = pull.sched->have_count();
+        uint32_t  reported = UINT32_MAX;
+        TimePoint saved_at = Clock::now();
+        while (!pull.sched->done()) {
+            if (!m_running.load()) return Result<void>::error(StatusCode::ERR_NETWORK);
+            if (!pull.sched->any_alive()) return Result<void>::error(StatusCode::ERR_TIMEOUT);
+
+            uint32_t now = now_us();
+            pull.sched->check_timeouts(now);
+            bool sent = false;
+            for (size_t s = 0; s < pull.sources.size(); s++) {
+                size_t n = pull.sched->next_requests(s, picks.data(), picks.size(), now);
+                if (n == 0) continue;
+                sent = true;
+                lk.unlock();
+                auto r = send_req(pull.sources[s], picks.data(), n);
+                lk.lock();
+                if (!r.ok()) return r;
+            }
+            if (sent) continue;
 
-    sendto((int)m_socket, (const char*)meta_wire.data(), (int)meta_wire.size(), 0,
-           (struct sockaddr*)&dest, sizeof(dest));
+            uint32_t have = pull.sched->have_count();
+            if (have - saved >= 256 || Clock::now() - saved_at > Millis(500)) {
+                save_resume_map(*store, map_path, pull);
+                saved    = have;
+                saved_at = Clock::now();
+            }
+            if (progress && have != reported) {
+                reported = have;
+                uint64_t bytes = std::min<uint64_t>((uint64_t)have * pull.chunk_size, pull.size);
+                lk.unlock();
+                bool go = progress(bytes, pull.size);
+                lk.lock();
+                if (!go) return Result<void>::error(StatusCode::ERR_CANCELLED);
+                continue;
+            }
+            uint64_t seen = pull.events;
+            auto     wait = std::chrono::microseconds(pull.sched->next_deadline(now) + 1);
+            m_xfer_cv.wait_for(lk, wait, [&] { return pull.events != seen || !m_running.load(); });
+        }
+        return Result<void>::success();
+    };
+    Result<void> result = run();
+    m_pulls.erase(pull.id);
+    lk.unlock();
+
+    if (!pull.sched) {
+        log::warn(TAG, "Download of '%s': no source has it", pull.name.c_str());
+        return result;
+    }
+    if (!result.ok()) {
+        save_resume_map(*store, map_path, pull);
+        log::warn(TAG, "Download of '%s' stopped at %u/%u chunks: %s", pull.name.c_str(),
+                  pull.sched->have_count(), pull.sched->chunks(), status_to_string(result.status));
+        return result;
+    }
 
-    // Chunk data in 8KB pieces
-    const size_t CHUNK_SIZE = 8192;
-    for (size_t offset = 0; offset < data.size(); offset += CHUNK_SIZE) {
-        size_t len = std::min(CHUNK_SIZE, data.size() - offset);
-        ByteBuffer chunk(data.begin() + offset, data.begin() + offset + len);
-        ByteBuffer enc = m_crypto->encrypt(chunk, m_session_key);
+    auto    data = store->read_file(pull.part_path);
+    uint8_t digest[DIGEST_SIZE];
+    Sha256::hash(data.value.data(), data.value.size(), digest);
+    store->delete_file(map_path);
+    if (!data.ok() || std::memcmp(digest, pull.digest, DIGEST_SIZE) != 0) {
+        log::error(TAG, "Download of '%s' does not match its SHA-256; discarded", pull.name.c_str());
+        store->delete_file(pull.part_path);
+        return Result<void>::error(StatusCode::ERR_CRYPTO);
+    }
+    store->rename(pull.part_path, final_path);
 
-        MeshPacket cpkt = create_packet(MeshMsgType::FILE_CHUNK, enc);
-        ByteBuffer cwire = cpkt.serialize();
-        sendto((int)m_socket, (const char*)cwire.data(), (int)cwire.size(), 0,
-               (struct sockaddr*)&dest, sizeof(dest));
+    std::string per_source;
+    for (size_t s = 0; s < pull.sources.size(); s++) {
+        per_source += (s ? ", " : "") + pull.sources[s].peer_id + " " +
+                      std::to_string(pull.sched->received(s));
     }
+    log::info(TAG, "Downloaded '%s' (%llu bytes%s) — chunks from %s", pull.name.c_str(),
+              (unsigned long long)pull.size, resumed ? ", resumed" : "", per_source.c_str());
+    return Result<void>::success();
+}
 
-    log::info(TAG, "Sent file '%s' (%zu bytes) to %s",
-              filename.c_str(), data.size(), peer_id.c_str());
+Result<void> MeshNet::send_chunks(mesh_xfer::Outgoing& xfer, const ByteBuffer& data,
+                                  const uint32_t* picks, size_t n) {
+    using namespace mesh_xfer;
+    // Each chunk is sealed into a pooled datagram buffer once the peer's
+    // queue has room, and stamped then, so RTT samples leave out our own
+    // wait. The event loop sends the buffers in batches as they are (see
+    // drain_sends) and hands them back to the pool.
+    auto session = this->session();
+    for (size_t k = 0; k < n; k++) {
+        if (!wait_for_room(xfer.peer)) return Result<void>::error(StatusCode::ERR_NETWORK);
+        uint32_t index       = picks[k];
+        size_t   offset      = (size_t)index * MESH_FILE_CHUNK;
+        size_t   len         = std::min(MESH_FILE_CHUNK, data.size() - offset);
+        size_t   payload_len = Crypto::OVERHEAD + CHUNK_FIXED + len;
+        uint32_t ts          = now_us();
+
+        ByteBuffer pkt = tx_buffer(MESH_HEADER_SIZE + payload_len);
+        MeshPacket::write_header(pkt.data(), MeshMsgType::FILE_CHUNK, (uint32_t)payload_len);
+        ByteSpan record(pkt.data() + MESH_HEADER_SIZE, payload_len);
+        uint8_t* plain = record.data() + Crypto::NONCE_SIZE;
+        std::memcpy(plain, &xfer.id, 4);
+        std::memcpy(plain + 4, &index, 4);
+        std::memcpy(plain + 8, &ts, 4);
+        std::memcpy(plain + CHUNK_FIXED, data.data() + offset, len);
+        if (!session->seal_in_place(record).ok())
+            return Result<void>::error(StatusCode::ERR_CRYPTO);
+        // A full queue loses the chunk like the network would; the window resends it
+        queue_datagram(xfer.peer, true, std::move(pkt));
+    }
+    kick_sends();
     return Result<void>::success();
 }
 
-void MeshNet::on_message(MeshMessageFn fn) {
+void MeshNet::set_file_store(VirtualFS* vfs, const std::string& dir) {
+    std::lock_guard<std::mutex> lock(m_store_mutex);
+    m_store     = vfs;
+    m_store_dir = dir;
+    while (m_store_dir.size() > 1 && m_store_dir.back() == '/') m_store_dir.pop_back();
+}
+
+void MeshNet::set_loss_simulation(double tx_rate, double rx_rate, uint64_t seed) {
+    if (tx_rate <= 0 && rx_rate <= 0) m_loss.reset();
+    else m_loss.reset(new mesh_io::LossShim(tx_rate, rx_rate, seed));
+}
+
+void MeshNet::set_io_backend(MeshIoBackend backend) {
     std::lock_guard<std::mutex> lock(m_mutex);
-    m_msg_callbacks.push_back(std::move(fn));
+    m_io_request = backend;
+}
+
+void MeshNet::set_rx_shards(size_t n) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+#if defined(__linux__)
+    // Elsewhere SO_REUSEPORT does not spread datagrams over the sockets
+    m_shard_request = std::max<size_t>(n, 1);
+#else
+    if (n > 1) log::warn(TAG, "SO_REUSEPORT not available here; receiving on one socket");
+    m_shard_request = 1;
+#endif
+}
+
+void MeshNet::set_rate_simulation(double bytes_per_sec) {
+    std::lock_guard<std::mutex> lock(m_sched_mutex);
+    m_link_rate = std::max(bytes_per_sec, 0.0);
+    apply_send_limits();
+}
+
+void MeshNet::set_send_limits(const MeshSendConfig& cfg) {
+    std::lock_guard<std::mutex> lock(m_sched_mutex);
+    m_send_cfg             = cfg;
+    m_send_cfg.queue_bytes = std::max<size_t>(cfg.queue_bytes, mesh_io::MAX_DATAGRAM);
+    apply_send_limits();
+}
+
+// The tighter of the two total limits
+void MeshNet::apply_send_limits() {
+    double total = m_send_cfg.total_rate;
+    if (m_link_rate > 0 && (total <= 0 || m_link_rate < total)) total = m_link_rate;
+    m_sched->set_limits(m_send_cfg.peer_rate, total, m_send_cfg.burst, Clock::now());
+    m_sched_cv.notify_all();
+}
+
+// Caller holds m_tx_mutex
+mesh_io::SendBatch& MeshNet::tx_batch() {
+    if (!m_tx_batch) {
+        // Datagrams are sent from the queues' buffers (push_ref), so the
+        // batch needs no slots of its own
+        m_tx_batch.reset(new mesh_io::SendBatch(FILE_TX_SLOTS, 0));
+        m_tx_out.reserve(FILE_TX_SLOTS);
+#if VOS_HAVE_IO_URING
+        if (m_utx) m_tx_batch->set_ring(m_utx.get(), m_socket);
+#endif
+    }
+    return *m_tx_batch;
+}
+
+// Copy-on-write: a snapshot the worker is calling stays untouched
+template<typename Fn>
+static void append_callback(std::mutex& m, std::shared_ptr<const std::vector<Fn>>& list, Fn fn) {
+    std::lock_guard<std::mutex> lock(m);
+    auto next = std::make_shared<std::vector<Fn>>(*list);
+    next->push_back(std::move(fn));
+    list = std::move(next);
+}
+
+template<typename Fn>
+static std::shared_ptr<const std::vector<Fn>> snapshot(std::mutex& m,
+                                                       const std::shared_ptr<const std::vector<Fn>>& list) {
+    std::lock_guard<std::mutex> lock(m);
+    return list;
+}
+
+void MeshNet::on_message(MeshMessageFn fn) {
+    append_callback(m_cb_mutex, m_msg_callbacks, std::move(fn));
 }
 
 void MeshNet::on_peer_found(MeshPeerFn fn) {
+    append_callback(m_cb_mutex, m_peer_callbacks, std::move(fn));
+}
+
+void MeshNet::on_file_received(MeshFileFn fn) {
+    append_callback(m_cb_mutex, m_file_callbacks, std::move(fn));
+}
+
+void MeshNet::set_callback_queue(size_t capacity) {
     std::lock_guard<std::mutex> lock(m_mutex);
-    m_peer_callbacks.push_back(std::move(fn));
+    m_dispatch_capacity = std::max<size_t>(capacity, 1);
+}
+
+void MeshNet::drain_callbacks() {
+    if (m_dispatch) m_dispatch->drain();
+}
+
+// Hand a callback invocation to the worker; the loop never waits for it
+void MeshNet::deliver(std::function<void()> fn) {
+    if (m_dispatch->post(std::move(fn))) return;
+    uint64_t dropped = m_dispatch->stats().dropped;
+    if ((dropped & (dropped - 1)) == 0) {   // 1, 2, 4, ... so a flood logs little
+        log::warn(TAG, "Callback queue full (%zu); %llu events dropped",
+                  m_dispatch->capacity(), (unsigned long long)dropped);
+    }
+}
+
+Result<void> MeshNet::set_session_key(const ByteBuffer& key) {
+    // Expanded aside, then swapped in: senders and receivers holding the
+    // old session finish with it
+    auto session = std::make_shared<CryptoSession>();
+    auto r       = session->set_key(key);
+    if (!r.ok()) return r;
+    std::lock_guard<std::mutex> lock(m_session_mutex);
+    m_session = std::move(session);
+    return r;
+}
+
+std::shared_ptr<const CryptoSession> MeshNet::session() const {
+    std::lock_guard<std::mutex> lock(m_session_mutex);
+    return m_session;
 }
 
 std::string MeshNet::get_own_id() const {
     return m_own_id;
 }
 
-// ─── Background Threads ─────────────────────────────────────
+Result<void> MeshNet::set_own_id(const std::string& id) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_running.load()) return Result<void>::error(StatusCode::ERR_ALREADY_EXISTS);
+    if (id.empty() || id.size() > mesh_route::MAX_ID)
+        return Result<void>::error(StatusCode::ERR_INVALID_ARG);
+    m_own_id = id;
+    return Result<void>::success();
+}
+
+MeshStats MeshNet::get_stats() const {
+    MeshStats s;
+    s.rx_packets  = m_rx_base[0];
+    s.rx_bytes    = m_rx_base[1];
+    s.rx_syscalls = m_rx_base[2];
+    for (auto& shard : m_shards) {
+        uint64_t packets = shard->packets.load(std::memory_order_relaxed);
+        s.rx_packets  += packets;
+        s.rx_bytes    += shard->bytes.load(std::memory_order_relaxed);
+        s.rx_syscalls += shard->syscalls.load(std::memory_order_relaxed);
+        s.shard_rx_packets.push_back(packets);
+    }
+    s.rx_dropped  = m_rx_dropped.load(std::memory_order_relaxed);
+    s.tx_packets  = m_tx_packets.load(std::memory_order_relaxed);
+    s.tx_bytes    = m_tx_bytes.load(std::memory_order_relaxed);
+    s.tx_syscalls = m_tx_syscalls.load(std::memory_order_relaxed);
+    s.tx_bundles  = m_tx_bundles.load(std::memory_order_relaxed);
+    s.tx_bundled  = m_tx_bundled.load(std::memory_order_relaxed);
+    s.file_chunks_sent = m_file_chunks_sent.load(std::memory_order_relaxed);
+    s.file_retransmits = m_file_retransmits.load(std::memory_order_relaxed);
+    s.file_timeouts    = m_file_timeouts.load(std::memory_order_relaxed);
+    s.files_received   = m_files_received.load(std::memory_order_relaxed);
+    s.file_chunks_served  = m_file_chunks_served.load(std::memory_order_relaxed);
+    s.file_chunks_fetched = m_file_chunks_fetched.load(std::memory_order_relaxed);
+    s.sim_dropped      = m_loss ? m_loss->dropped() : 0;
+    s.loop_wakeups     = m_reactor ? m_reactor->wakeups() : 0;
+    s.pings_sent       = m_pings_sent.load(std::memory_order_relaxed);
+    s.peers_evicted    = m_peers_evicted.load(std::memory_order_relaxed);
+    s.discover_sent       = m_discover_sent.load(std::memory_order_relaxed);
+    s.discover_suppressed = m_discover_suppressed.load(std::memory_order_relaxed);
+    s.discover_acks       = m_discover_acks.load(std::memory_order_relaxed);
+    s.acks_suppressed     = m_acks_suppressed.load(std::memory_order_relaxed);
+    s.relayed          = m_relayed.load(std::memory_order_relaxed);
+    s.relay_dropped    = m_relay_dropped.load(std::memory_order_relaxed);
+    s.relay_duplicates = m_relay_duplicates.load(std::memory_order_relaxed);
+    s.txq_dropped      = m_txq_dropped.load(std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(m_sched_mutex);
+        const mesh_sched::DelayStats& msg  = m_sched->delay(mesh_sched::Class::INTERACTIVE);
+        const mesh_sched::DelayStats& bulk = m_sched->delay(mesh_sched::Class::BULK);
+        s.txq_depth            = m_sched->packets();
+        s.txq_wait_avg_us      = msg.avg_us();
+        s.txq_wait_p99_us      = msg.p99_us();
+        s.txq_wait_max_us      = msg.max_us();
+        s.txq_bulk_wait_avg_us = bulk.avg_us();
+        s.txq_bulk_wait_p99_us = bulk.p99_us();
+        s.txq_bulk_wait_max_us = bulk.max_us();
+    }
+    if (m_dispatch) {
+        mesh_io::CallbackQueue::Stats q = m_dispatch->stats();
+        s.cb_depth       = q.depth;
+        s.cb_max_depth   = q.max_depth;
+        s.cb_delivered   = q.delivered;
+        s.cb_dropped     = q.dropped;
+        s.cb_wait_avg_us = q.wait_avg_us;
+        s.cb_wait_p99_us = q.wait_p99_us;
+        s.cb_wait_max_us = q.wait_max_us;
+    }
+    return s;
+}
+
+// ─── Event Loop ──────────────────────────────────────────────
 
-void MeshNet::listener_loop() {
-    ByteBuffer buf(65535);
+void MeshNet::on_readable(RxShard& shard, Socket sock) {
+    // Packets are parsed where the kernel put them. A bounded number of
+    // batches per wake-up, so timers and other sockets get their turn.
+    mesh_io::RecvBatch& batch = shard.rx;
 
-    while (m_running.load()) {
-        sockaddr_in from{};
-        socklen_t from_len = sizeof(from);
+    for (int round = 0; round < RX_ROUNDS && m_running.load(); round++) {
+        int n = batch.recv(sock, false);
+        if (n <= 0) break; // drained, or a socket error
+        shard.syscalls.fetch_add(1, std::memory_order_relaxed);
 
-        int received = recvfrom((int)m_socket, (char*)buf.data(), (int)buf.size(), 0,
-                                (struct sockaddr*)&from, &from_len);
+        for (size_t i = 0; i < batch.count() && m_running.load(); i++) {
+            handle_datagram(shard, batch.packet(i), batch.truncated(i), batch.from(i));
+        }
+        // One ACK per file transfer per batch, not per chunk
+        flush_file_acks(shard);
+        if ((size_t)n < batch.capacity()) break;
+    }
+}
 
-        if (received <= 0) continue; // timeout or error
+void MeshNet::on_ring(RxShard& shard) {
+#if VOS_HAVE_IO_URING
+    // Same as on_readable(), reading completions the kernel has already
+    // posted; syscalls happen only to re-arm or to collect stragglers
+    mesh_io::UringRecv& ring = *shard.urx;
+    for (int round = 0; round < RX_ROUNDS && m_running.load(); round++) {
+        uint64_t calls0 = ring.syscalls();
+        int      n      = ring.recv();
+        shard.syscalls.fetch_add(ring.syscalls() - calls0, std::memory_order_relaxed);
+        if (n < 0) {
+            fall_back_to_syscalls(shard);
+            return;
+        }
+        if (n == 0) break;
 
-        ByteBuffer data(buf.begin(), buf.begin() + received);
-        auto res = MeshPacket::deserialize(data);
-        if (!res.ok()) continue;
+        for (size_t i = 0; i < ring.count() && m_running.load(); i++) {
+            handle_datagram(shard, ring.packet(i), ring.truncated(i), ring.from(i));
+        }
+        flush_file_acks(shard);
+        if ((size_t)n < ring.capacity()) break;
+    }
+#else
+    (void)shard;
+#endif
+}
 
-        char ip[INET_ADDRSTRLEN];
-        inet_ntop(AF_INET, &from.sin_addr, ip, INET_ADDRSTRLEN);
-        handle_packet(res.value, std::string(ip));
+// The shard's thread. The ring stays open until shutdown() in case the
+// failed call is still on the stack; sends go back to sendmmsg() too.
+void MeshNet::fall_back_to_syscalls(RxShard& shard) {
+#if VOS_HAVE_IO_URING
+    log::warn(TAG, "io_uring receive failed on shard %zu; switching to socket calls", shard.index);
+    shard.reactor->remove_socket(shard.urx->fd());
+    Socket sock = shard.sock;
+    shard.reactor->add_socket(sock, [this, &shard, sock] { on_readable(shard, sock); });
+    {
+        std::lock_guard<std::mutex> lock(m_tx_mutex);
+        if (m_tx_batch) m_tx_batch->set_ring(nullptr, m_socket);
+        m_utx.reset();
     }
+    m_io_backend.store(MeshIoBackend::SYSCALLS);
+#else
+    (void)shard;
+#endif
 }
 
-void MeshNet::discovery_loop() {
-    while (m_discovering.load() && m_running.load()) {
+void MeshNet::handle_datagram(RxShard& shard, ByteSpan data, bool truncated,
+                              const sockaddr_in& from) {
+    if (m_loss && m_loss->drop_rx()) return;
+    if (truncated) {
+        m_rx_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    // Parsed, and sealed payloads opened, inside the receive slot
+    auto res = MeshPacketView::parse(data);
+    if (!res.ok()) {
+        m_rx_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    shard.packets.fetch_add(1, std::memory_order_relaxed);
+    shard.bytes.fetch_add(data.size(), std::memory_order_relaxed);
+
+    handle_packet(shard, res.value, MeshAddr::from(from));
+}
+
+void MeshNet::discovery_tick() {
+    m_reactor->cancel(m_discovery_timer);   // a restart may leave one queued
+    if (!m_discovering.load()) return;
+
+    auto      now = Clock::now();
+    bool      due;
+    TimePoint next;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        due  = m_trickle->poll(now);
+        next = m_trickle->next();
+        m_discover_suppressed.store(m_trickle->suppressed(), std::memory_order_relaxed);
+    }
+
+    if (due) {
         ByteBuffer payload(m_own_id.begin(), m_own_id.end());
         MeshPacket pkt = create_packet(MeshMsgType::DISCOVER, payload);
         ByteBuffer buf = pkt.serialize();
@@ -327,90 +1339,1126 @@ void MeshNet::discovery_loop() {
         dest.sin_family      = AF_INET;
         dest.sin_port        = htons(m_port);
         dest.sin_addr.s_addr = INADDR_BROADCAST;
+        send_datagram(dest, buf.data(), buf.size());
+        m_discover_sent.fetch_add(1, std::memory_order_relaxed);
+    }
 
-        sendto((int)m_socket, (const char*)buf.data(), (int)buf.size(), 0,
-               (struct sockaddr*)&dest, sizeof(dest));
+    auto delay = std::max<Duration>(next - now, Millis(1));
+    m_discovery_timer = m_reactor->schedule(std::chrono::duration_cast<std::chrono::microseconds>(delay),
+                                            [this] { discovery_tick(); });
+}
 
-        // Sleep 5 seconds between broadcasts
-        for (int i = 0; i < 50 && m_discovering.load(); i++) {
-            std::this_thread::sleep_for(Millis(100));
-        }
-    }
+// Back to the shortest interval, so the change is heard soon
+void MeshNet::discovery_changed() {
+    m_trickle->reset(Clock::now());
+    if (m_discovering.load() && m_running.load()) m_reactor->post([this] { discovery_tick(); });
 }
 
-void MeshNet::handle_packet(const MeshPacket& pkt, const std::string& from_addr) {
+std::string MeshNet::peer_at(const MeshAddr& from) const {
     std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_peer_index.find(from);
+    return it != m_peer_index.end() ? it->second : "unknown";
+}
 
+void MeshNet::handle_packet(RxShard& shard, MeshPacketView& pkt, const MeshAddr& from) {
+    // Locks cover table lookups and updates only; decryption, replies and
+    // callbacks run outside them, so get_peers() never waits on traffic
     switch (pkt.type) {
     case MeshMsgType::DISCOVER:
     case MeshMsgType::DISCOVER_ACK: {
-        std::string peer_id(pkt.payload.begin(), pkt.payload.end());
+        std::string peer_id((const char*)pkt.payload.data(), pkt.payload.size());
         if (peer_id == m_own_id) return; // Ignore self
 
-        bool is_new = (m_peers.find(peer_id) == m_peers.end());
+        MeshPeer found;
+        bool     is_new;
+        bool     ack = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            is_new = (m_peers.find(peer_id) == m_peers.end());
+
+            MeshPeer& peer = m_peers[peer_id];
+            peer.peer_id   = peer_id;
+            index_peer(peer, from);
+            peer.last_seen = Clock::now();
+            peer.connected = true;
+            if (is_new) {
+                found = peer;
+                discovery_changed();
+            } else if (pkt.type == MeshMsgType::DISCOVER) {
+                m_trickle->heard();
+            }
+            if (pkt.type == MeshMsgType::DISCOVER && is_new) {
+                ack = true;   // a newcomer learns each of us from our ACK
+            } else if (pkt.type == MeshMsgType::DISCOVER) {
+                // A known sender may have lost its table (restarted), so it
+                // gets answers too, but in a dense mesh from a random few
+                uint32_t rnd;
+                secure_random(ByteSpan((uint8_t*)&rnd, sizeof(rnd)));
+                ack = mesh_discovery::should_ack(m_peers.size() - 1, m_discovery.ack_fanout, rnd);
+                if (!ack) m_acks_suppressed.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        if (ack) {
+            ByteBuffer ack_data(m_own_id.begin(), m_own_id.end());
+            MeshPacket ack_pkt = create_packet(MeshMsgType::DISCOVER_ACK, ack_data);
+            ByteBuffer ack_buf = ack_pkt.serialize();
+            send_datagram(make_dest(from), ack_buf.data(), ack_buf.size());
+            m_discover_acks.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (!is_new) break;
+
+        log::info(TAG, "Discovered peer: %s @ %s", peer_id.c_str(), found.address.c_str());
+        if (m_probing.load()) m_reactor->post([this] { liveness_tick(); });
+        routes_changed();
+        deliver([this, found] {
+            for (auto& cb : *snapshot(m_cb_mutex, m_peer_callbacks)) cb(found);
+        });
+        break;
+    }
+
+    case MeshMsgType::TEXT_MSG: {
+        std::string sender_id = peer_at(from);
+
+        // Decrypt in place
+        auto dec = session()->open_in_place(pkt.payload);
+        if (!dec.ok()) {
+            log::warn(TAG, "Dropping undecryptable message from %s", sender_id.c_str());
+            break;
+        }
+
+        deliver_text(sender_id, dec.value);
+        break;
+    }
 
-        MeshPeer& peer = m_peers[peer_id];
-        peer.peer_id   = peer_id;
-        peer.address   = from_addr;
-        peer.last_seen = Clock::now();
-        peer.connected = true;
+    case MeshMsgType::BUNDLE: {
+        // One seal covers every record
+        auto dec = session()->open_in_place(pkt.payload);
+        if (!dec.ok()) {
+            m_rx_dropped.fetch_add(1, std::memory_order_relaxed);
+            break;
+        }
+        handle_bundle(dec.value, from);
+        break;
+    }
+
+    case MeshMsgType::PING:
+        send_pong(from, pkt.payload);
+        break;
 
-        if (is_new) {
-            log::info(TAG, "Discovered peer: %s @ %s", peer_id.c_str(), from_addr.c_str());
-            for (auto& cb : m_peer_callbacks) cb(peer);
+    case MeshMsgType::PONG:
+        handle_pong(pkt.payload, from);
+        break;
 
-            if (pkt.type == MeshMsgType::DISCOVER) {
-                // ACK back
-                ByteBuffer ack_data(m_own_id.begin(), m_own_id.end());
-                MeshPacket ack = create_packet(MeshMsgType::DISCOVER_ACK, ack_data);
-                ByteBuffer ack_buf = ack.serialize();
+    case MeshMsgType::ROUTE:
+        handle_route(pkt.payload, from);
+        break;
 
-                sockaddr_in dest{};
-                dest.sin_family = AF_INET;
-                dest.sin_port   = htons(m_port);
-                vos_inet_pton(from_addr.c_str(), &dest.sin_addr);
+    case MeshMsgType::RELAY:
+        handle_relay(pkt, from);
+        break;
 
-                sendto((int)m_socket, (const char*)ack_buf.data(), (int)ack_buf.size(), 0,
-                       (struct sockaddr*)&dest, sizeof(dest));
+    case MeshMsgType::FILE_META:
+    case MeshMsgType::FILE_CHUNK:
+    case MeshMsgType::FILE_ACK:
+    case MeshMsgType::FILE_REQ: {
+        // Decrypt where the packet sits; the plaintext is parsed in place
+        auto plain = session()->open_in_place(pkt.payload);
+        if (!plain.ok()) {
+            m_rx_dropped.fetch_add(1, std::memory_order_relaxed);
+            break;
+        }
+        // META and CHUNK answer our own downloads first, else they are
+        // pushes, kept by the receiving shard under its own lock
+        switch (pkt.type) {
+        case MeshMsgType::FILE_META:
+            if (!handle_pull_meta(plain.value, from)) {
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                handle_file_meta(shard, plain.value, from);
             }
+            break;
+        case MeshMsgType::FILE_CHUNK:
+            if (!handle_pull_chunk(plain.value, from)) {
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                handle_file_chunk(shard, plain.value, from);
+            }
+            break;
+        case MeshMsgType::FILE_ACK:
+            handle_file_ack(plain.value, from);
+            break;
+        default: {
+            std::lock_guard<std::mutex> lock(m_store_mutex);
+            handle_file_req(plain.value, from);
+            break;
+        }
         }
         break;
     }
 
-    case MeshMsgType::TEXT_MSG: {
-        // Find peer by address
-        std::string sender_id = "unknown";
-        for (const auto& [id, p] : m_peers) {
-            if (p.address == from_addr) { sender_id = id; break; }
+    default:
+        break;
+    }
+}
+
+void MeshNet::deliver_text(const std::string& sender_id, ConstByteSpan text) {
+    log::info(TAG, "Message from %s: %.*s", sender_id.c_str(), (int)text.size(), text.data());
+    // The callback gets its own copy; the text lies in a receive buffer
+    deliver([this, sender_id, text = text.to_buffer()] {
+        for (auto& cb : *snapshot(m_cb_mutex, m_msg_callbacks)) cb(sender_id, text);
+    });
+}
+
+// A PONG echoes the PING's payload, so the prober can time the round trip
+void MeshNet::send_pong(const MeshAddr& to, ConstByteSpan echo) {
+    MeshPacket pong = create_packet(MeshMsgType::PONG, echo.to_buffer());
+    ByteBuffer pong_buf = pong.serialize();
+    send_datagram(make_dest(to), pong_buf.data(), pong_buf.size());
+}
+
+// ─── Liveness ────────────────────────────────────────────────
+
+void MeshNet::set_liveness(const MeshLivenessConfig& cfg) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_liveness = cfg;
+}
+
+void MeshNet::start_liveness() {
+    if (m_probing.exchange(true)) return;
+    // Before init() the first round waits for the loop to start
+    if (m_running.load()) m_reactor->post([this] { liveness_tick(); });
+    log::info(TAG, "Peer liveness probing started");
+}
+
+void MeshNet::stop_liveness() {
+    m_probing.store(false);
+    if (m_running.load()) m_reactor->post([this] { m_reactor->cancel(m_liveness_timer); });
+    log::info(TAG, "Peer liveness probing stopped");
+}
+
+// Loop thread. One timer serves every peer: it is set for whichever
+// probe or retry comes due first.
+void MeshNet::liveness_tick() {
+    m_reactor->cancel(m_liveness_timer);   // a restart may leave one queued
+    if (!m_probing.load()) return;
+
+    struct Ping { MeshAddr to; uint32_t ts; };
+    std::vector<Ping> pings;
+    auto              now  = Clock::now();
+    TimePoint         wake = TimePoint::max();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const MeshLivenessConfig& cfg = m_liveness;
+        std::vector<std::string>  dead;
+        for (auto& kv : m_peers) {
+            MeshPeer& peer = kv.second;
+            auto&     slot = m_probes[kv.first];
+            if (!slot) {
+                slot.reset(new Probe);
+                slot->interval = cfg.ping_min;
+            }
+            Probe& pr = *slot;
+            if (now >= pr.next) {
+                if (pr.waiting) {
+                    // The answer is overdue: retry on a backed-off RTO
+                    pr.missed++;
+                    pr.rtt.backoff();
+                    pr.interval = cfg.ping_min;
+                    if (pr.missed >= cfg.stale_after && peer.connected) {
+                        peer.connected = false;
+                        log::warn(TAG, "Peer %s is not answering", kv.first.c_str());
+                        m_routes->neighbour_down(kv.first, now);
+                        routes_changed();
+                        discovery_changed();
+                    }
+                    if (cfg.evict_after.count() > 0 && now - peer.last_seen > cfg.evict_after) {
+                        dead.push_back(kv.first);
+                        continue;
+                    }
+                }
+                pr.sent_ts = mesh_xfer::now_us();
+                pr.waiting = true;
+                pr.next    = now + std::chrono::microseconds((int64_t)pr.rtt.rto);
+                pings.push_back({send_to(peer, m_port), pr.sent_ts});
+            }
+            wake = std::min(wake, pr.next);
         }
+        for (const auto& id : dead) evict_peer(id);
+    }
 
-        // Decrypt payload
-        ByteBuffer decrypted = m_crypto->decrypt(pkt.payload, m_session_key);
+    for (const Ping& p : pings) {
+        ByteBuffer payload(4);
+        std::memcpy(payload.data(), &p.ts, 4);
+        ByteBuffer buf = create_packet(MeshMsgType::PING, payload).serialize();
+        send_datagram(make_dest(p.to), buf.data(), buf.size());
+    }
+    m_pings_sent.fetch_add(pings.size(), std::memory_order_relaxed);
 
-        log::info(TAG, "Message from %s: %.*s",
-                  sender_id.c_str(), (int)decrypted.size(), decrypted.data());
+    // No peers, no timer: add_peer() and DISCOVER start a round again
+    if (wake == TimePoint::max()) return;
+    auto delay = std::max<Duration>(wake - Clock::now(), Millis(1));
+    m_liveness_timer = m_reactor->schedule(std::chrono::duration_cast<std::chrono::microseconds>(delay),
+                                           [this] { liveness_tick(); });
+}
 
-        for (auto& cb : m_msg_callbacks) cb(sender_id, decrypted);
-        break;
+void MeshNet::handle_pong(ConstByteSpan echo, const MeshAddr& from) {
+    uint32_t now = mesh_xfer::now_us();
+    uint32_t ts  = 0;
+    if (echo.size() >= 4) std::memcpy(&ts, echo.data(), 4);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto idx = m_peer_index.find(from);
+    if (idx == m_peer_index.end()) return;
+    auto peer  = m_peers.find(idx->second);
+    auto probe = m_probes.find(idx->second);
+    if (peer == m_peers.end() || probe == m_probes.end()) return;
+
+    Probe& pr = *probe->second;
+    if (pr.waiting && ts == pr.sent_ts) {
+        pr.rtt.sample((double)std::max<uint32_t>(now - ts, 1));
+        peer->second.srtt_us   = (uint32_t)pr.rtt.srtt;
+        peer->second.rttvar_us = (uint32_t)pr.rtt.rttvar;
     }
+    if (!pr.waiting) return;   // a late answer to a probe already retried
+
+    // Answered: wait out the interval, which grows while answers keep coming
+    pr.waiting  = false;
+    pr.missed   = 0;
+    pr.next     = Clock::now() + pr.interval;
+    pr.interval = std::min<Millis>(pr.interval * 2, m_liveness.ping_max);
+    peer->second.last_seen = Clock::now();
+    if (!peer->second.connected) {
+        peer->second.connected = true;
+        log::info(TAG, "Peer %s is answering again", idx->second.c_str());
+        routes_changed();
+    }
+}
 
-    case MeshMsgType::PING: {
-        ByteBuffer pong_data(m_own_id.begin(), m_own_id.end());
-        MeshPacket pong = create_packet(MeshMsgType::PONG, pong_data);
-        ByteBuffer pong_buf = pong.serialize();
+// Caller holds m_mutex
+void MeshNet::evict_peer(const std::string& peer_id) {
+    auto it = m_peers.find(peer_id);
+    if (it == m_peers.end()) return;
+    auto idx = m_peer_index.find(it->second.endpoint);
+    if (idx != m_peer_index.end() && idx->second == peer_id) m_peer_index.erase(idx);
+    m_probes.erase(peer_id);
+    m_peers.erase(it);
+    m_routes->neighbour_down(peer_id, Clock::now());
+    routes_changed();
+    discovery_changed();
+    m_peers_evicted.fetch_add(1, std::memory_order_relaxed);
+    log::info(TAG, "Dropped peer %s: silent too long", peer_id.c_str());
+}
 
-        sockaddr_in dest{};
-        dest.sin_family = AF_INET;
-        dest.sin_port   = htons(m_port);
-        vos_inet_pton(from_addr.c_str(), &dest.sin_addr);
-        sendto((int)m_socket, (const char*)pong_buf.data(), (int)pong_buf.size(), 0,
-               (struct sockaddr*)&dest, sizeof(dest));
-        break;
+// ─── Routing ─────────────────────────────────────────────────
+
+void MeshNet::set_routing(const MeshRoutingConfig& cfg) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_routing_cfg = cfg;
+}
+
+void MeshNet::start_routing() {
+    if (m_routing.exchange(true)) return;
+    // Before init() the first advert waits for the loop to start
+    if (m_running.load()) m_reactor->post([this] { route_tick(); });
+    log::info(TAG, "Mesh routing started");
+}
+
+void MeshNet::stop_routing() {
+    m_routing.store(false);
+    if (m_running.load()) m_reactor->post([this] { m_reactor->cancel(m_route_timer); });
+    log::info(TAG, "Mesh routing stopped");
+}
+
+std::vector<MeshRoute> MeshNet::get_routes() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<MeshRoute> out;
+    for (const auto& kv : m_peers) {
+        if (kv.second.connected) out.push_back(MeshRoute{kv.first, kv.first, 1});
+    }
+    for (const auto& kv : m_routes->routes()) {
+        const mesh_route::Route& r = kv.second;
+        if (r.metric >= mesh_route::METRIC_INFINITY) continue;
+        auto peer = m_peers.find(kv.first);
+        if (peer != m_peers.end() && peer->second.connected) continue;   // listed as a neighbour
+        out.push_back(MeshRoute{kv.first, r.next_hop, r.metric});
+    }
+    return out;
+}
+
+// Where a message for `dest` goes next: a live neighbour directly, else
+// the next hop of a learned route, else a stale neighbour as a last try
+bool MeshNet::route_to(const std::string& dest, MeshAddr& to, bool& relayed) const {
+    auto peer = m_peers.find(dest);
+    if (peer != m_peers.end() && peer->second.connected) {
+        to      = send_to(peer->second, m_port);
+        relayed = false;
+        return true;
     }
+    if (const mesh_route::Route* r = m_routes->find(dest)) {
+        auto hop = m_peers.find(r->next_hop);
+        if (hop != m_peers.end()) {
+            to      = send_to(hop->second, m_port);
+            relayed = true;
+            return true;
+        }
+    }
+    if (peer == m_peers.end()) return false;
+    to      = send_to(peer->second, m_port);
+    relayed = false;
+    return true;
+}
 
-    default:
+// Loop thread: drop what no advert confirmed, send every neighbour our vector
+void MeshNet::route_tick() {
+    m_reactor->cancel(m_route_timer);   // a restart may leave one queued
+    if (!m_routing.load()) return;
+
+    Millis every;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_routes->expire(Clock::now(), m_routing_cfg.route_timeout);
+        every = m_routing_cfg.advertise_every;
+    }
+    advertise_routes();
+    m_route_timer = m_reactor->schedule(std::chrono::duration_cast<std::chrono::microseconds>(every),
+                                        [this] { route_tick(); });
+}
+
+// Tell the neighbours at the loop's next turn; changes made before then
+// share the update
+void MeshNet::routes_changed() {
+    if (!m_routing.load() || !m_running.load()) return;
+    if (m_route_flush.exchange(true)) return;
+    m_reactor->post([this] {
+        m_route_flush.store(false);
+        advertise_routes();
+    });
+}
+
+void MeshNet::advertise_routes() {
+    using namespace mesh_route;
+    // Vector bytes one ROUTE datagram has room for
+    static constexpr size_t ROUTE_ROOM = MESH_BUNDLE_MAX - MESH_HEADER_SIZE - Crypto::OVERHEAD;
+
+    struct Advert { MeshAddr to; ByteBuffer body; };
+    std::vector<Advert> adverts;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // Everything we reach, with the neighbour each learned route goes through
+        std::vector<Entry>       vec;
+        std::vector<std::string> via;
+        vec.push_back(Entry{m_own_id, 0});
+        via.emplace_back();
+        for (const auto& kv : m_peers) {
+            if (!kv.second.connected) continue;
+            vec.push_back(Entry{kv.first, 1});
+            via.emplace_back();
+        }
+        for (const auto& kv : m_routes->routes()) {
+            auto peer = m_peers.find(kv.first);
+            if (peer != m_peers.end() && peer->second.connected) continue;
+            vec.push_back(Entry{kv.first, kv.second.metric});
+            via.push_back(kv.second.next_hop);
+        }
+
+        std::vector<Entry> mine;
+        for (const auto& kv : m_peers) {
+            if (!kv.second.connected) continue;
+            // Poisoned reverse: what we learned from this neighbour is no way back to it
+            mine = vec;
+            for (size_t i = 0; i < mine.size(); i++)
+                if (via[i] == kv.first) mine[i].metric = METRIC_INFINITY;
+            for (size_t i = 0; i < mine.size();) {
+                Advert a{send_to(kv.second, m_port), {}};
+                size_t next = encode_vector(mine, i, ROUTE_ROOM, a.body);
+                adverts.push_back(std::move(a));
+                if (next == i) break;
+                i = next;
+            }
+        }
+    }
+    for (const Advert& a : adverts)
+        send_sealed(make_dest(a.to), MeshMsgType::ROUTE, a.body.data(), a.body.size());
+}
+
+void MeshNet::handle_route(ByteSpan sealed, const MeshAddr& from) {
+    // Vectors are taken from neighbours only
+    std::string neighbour;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_peer_index.find(from);
+        if (it == m_peer_index.end()) return;
+        neighbour = it->second;
+    }
+
+    auto dec = session()->open_in_place(sealed);
+    std::vector<mesh_route::Entry> vec;
+    if (!dec.ok() || !mesh_route::decode_vector(dec.value, vec)) {
+        m_rx_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    bool changed;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        changed = m_routes->update(m_own_id, neighbour, vec, Clock::now());
+    }
+    if (changed) routes_changed();
+}
+
+Result<void> MeshNet::send_relayed(const MeshAddr& next_hop, const std::string& dest, MeshMsgType type,
+                                   ConstByteSpan body) {
+    using namespace mesh_route;
+    if (dest.size() > MAX_ID) return Result<void>::error(StatusCode::ERR_INVALID_ARG);
+
+    uint64_t msg = m_relay_seq.fetch_add(1, std::memory_order_relaxed);
+    uint8_t  ttl;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ttl = m_routing_cfg.ttl;
+        m_relay_seen->seen(msg);   // so a copy that loops back ends here
+    }
+
+    // [HEADER][TTL|HOPS|MSG|LEN|DEST][NONCE|LEN|SRC|TYPE|BODY|TAG], sealed in place
+    size_t     head        = relay_header_size(dest);
+    size_t     inner       = 2 + m_own_id.size() + body.size();
+    size_t     payload_len = head + Crypto::OVERHEAD + inner;
+    ByteBuffer buf(MESH_HEADER_SIZE + payload_len);
+    MeshPacket::write_header(buf.data(), MeshMsgType::RELAY, (uint32_t)payload_len);
+    write_relay_header(buf.data() + MESH_HEADER_SIZE, ttl, msg, dest);
+    RelayHeader hdr;
+    uint8_t     aad[RELAY_AAD_MAX];
+    parse_relay_header(ConstByteSpan(buf.data() + MESH_HEADER_SIZE, head), hdr);
+    size_t aad_len = relay_aad(hdr, aad);
+
+    ByteSpan record(buf.data() + MESH_HEADER_SIZE + head, Crypto::OVERHEAD + inner);
+    uint8_t* p = record.data() + Crypto::NONCE_SIZE;
+    *p++ = (uint8_t)m_own_id.size();
+    std::memcpy(p, m_own_id.data(), m_own_id.size());
+    p += m_own_id.size();
+    *p++ = static_cast<uint8_t>(type);
+    if (body.size()) std::memcpy(p, body.data(), body.size());
+    if (!session()->seal_in_place(record, ConstByteSpan(aad, aad_len)).ok())
+        return Result<void>::error(StatusCode::ERR_CRYPTO);
+
+    send_datagram(make_dest(next_hop), buf.data(), buf.size());
+    return Result<void>::success();
+}
+
+void MeshNet::handle_relay(MeshPacketView& pkt, const MeshAddr& from) {
+    using namespace mesh_route;
+    RelayHeader hdr;
+    if (!parse_relay_header(pkt.payload, hdr)) {
+        m_rx_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    // The prefix is in the clear and relays cannot check it, so an id is
+    // only taken as seen once its message is forwarded or has opened:
+    // a forged copy cannot burn the genuine one's id
+    std::string dest((const char*)hdr.dest.data(), hdr.dest.size());
+    bool        mine = dest == m_own_id;
+    MeshAddr    to;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // Relayed messages are taken from neighbours only
+        if (m_peer_index.find(from) == m_peer_index.end()) return;
+        if (m_relay_seen->contains(hdr.msg)) {
+            m_relay_duplicates.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (!mine) {
+            bool relayed;
+            if (hdr.ttl <= 1 || !route_to(dest, to, relayed)) {
+                m_relay_dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            m_relay_seen->seen(hdr.msg);
+        }
+    }
+
+    if (!mine) {
+        // Passed on as it came, one hop further: no re-serializing, no crypto
+        pkt.payload[0] = (uint8_t)(hdr.ttl - 1);
+        pkt.payload[1] = (uint8_t)(hdr.hops + 1);
+        send_datagram(make_dest(to), pkt.wire.data(), pkt.wire.size());
+        m_relayed.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // A rewritten MSG or DEST, or a TTL raised on the way, fails here
+    uint8_t aad[RELAY_AAD_MAX];
+    size_t  aad_len = relay_aad(hdr, aad);
+    auto    dec     = session()->open_in_place(pkt.payload.subspan(hdr.size), ConstByteSpan(aad, aad_len));
+    if (!dec.ok() || dec.value.size() < 2 || dec.value.size() < 2u + dec.value[0]) {
+        m_rx_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    {
+        // Authentic: a copy that came another way already got here
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_relay_seen->seen(hdr.msg)) {
+            m_relay_duplicates.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+    ByteSpan    inner = dec.value;
+    size_t      len   = inner[0];
+    std::string src((const char*)inner.data() + 1, len);
+    ByteSpan    body  = inner.subspan(2 + len);
+    switch (static_cast<MeshMsgType>(inner[1 + len])) {
+    case MeshMsgType::TEXT_MSG:
+        deliver_text(src, body);
         break;
+    default:
+        break;   // only text travels over relays so far
+    }
+}
+
+// ─── File Transfer (listener side) ──────────────────────────
+
+static void queue_ack(std::vector<mesh_xfer::Incoming*>& due, mesh_xfer::Incoming& in) {
+    if (in.ack_pending) return;
+    in.ack_pending = true;
+    due.push_back(&in);
+}
+
+// Caller holds shard.mutex
+void MeshNet::handle_file_meta(RxShard& shard, ByteSpan plain, const MeshAddr& from) {
+    using namespace mesh_xfer;
+    if (plain.size() < META_FIXED) return;
+    uint32_t id, ts, chunk;
+    uint64_t size;
+    std::memcpy(&id, plain.data(), 4);
+    std::memcpy(&ts, plain.data() + 4, 4);
+    std::memcpy(&size, plain.data() + 8, 8);
+    std::memcpy(&chunk, plain.data() + 16, 4);
+
+    TransferKey key{from, id};
+    auto it = shard.incoming.find(key);
+    if (it != shard.incoming.end()) {
+        // A resend: our ACK was lost
+        it->second->ts_echo = ts;
+        queue_ack(shard.ack_due, *it->second);
+        return;
+    }
+    VirtualFS* store = m_store.load();
+    if (!store) {
+        log::warn(TAG, "Ignoring file offer from %s: no file store set", from.to_string().c_str());
+        return;
+    }
+
+    std::string name = base_name(std::string((const char*)plain.data() + META_FIXED,
+                                             plain.size() - META_FIXED));
+    if (name.empty() || chunk == 0 || chunk > MESH_FILE_CHUNK || size > MESH_MAX_FILE) {
+        log::warn(TAG, "Rejecting malformed file offer from %s", from.to_string().c_str());
+        return;
+    }
+
+    std::string dir;
+    {
+        std::lock_guard<std::mutex> lock(m_store_mutex);
+        dir = m_store_dir;
+    }
+    auto in = std::make_unique<Incoming>((uint32_t)((size + chunk - 1) / chunk));
+    in->id          = id;
+    in->from        = from;
+    in->size        = size;
+    in->chunk_size  = chunk;
+    in->final_path  = dir + "/" + name;
+    in->part_path   = in->final_path + ".part";
+    in->ts_echo     = ts;
+    in->last_active = Clock::now();
+    std::memcpy(in->digest, plain.data() + 20, DIGEST_SIZE);
+    in->peer_id     = peer_at(from);
+
+    store->mkdir(dir); // ERR_ALREADY_EXISTS is fine
+    if (!store->resize_file(in->part_path, size).ok()) {
+        log::warn(TAG, "Cannot store incoming '%s'", in->final_path.c_str());
+        return;
+    }
+    log::info(TAG, "Receiving '%s' (%llu bytes) from %s", name.c_str(),
+              (unsigned long long)size, in->peer_id.c_str());
+
+    Incoming& ref = *in;
+    shard.incoming[key] = std::move(in);
+    schedule_expiry(shard);
+    if (ref.window.complete()) {
+        // Empty file: nothing more will arrive
+        ref.done = true;
+        store->rename(ref.part_path, ref.final_path);
+        m_files_received.fetch_add(1, std::memory_order_relaxed);
+        deliver([this, peer = ref.peer_id, path = ref.final_path] {
+            for (auto& cb : *snapshot(m_cb_mutex, m_file_callbacks)) cb(peer, path, 0);
+        });
+    }
+    queue_ack(shard.ack_due, ref);
+}
+
+// Caller holds shard.mutex
+void MeshNet::handle_file_chunk(RxShard& shard, ByteSpan plain, const MeshAddr& from) {
+    using namespace mesh_xfer;
+    if (plain.size() < CHUNK_FIXED) return;
+    uint32_t id, index, ts;
+    std::memcpy(&id, plain.data(), 4);
+    std::memcpy(&index, plain.data() + 4, 4);
+    std::memcpy(&ts, plain.data() + 8, 4);
+
+    auto it = shard.incoming.find(TransferKey{from, id});
+    if (it == shard.incoming.end()) return; // META never arrived or the transfer expired
+    Incoming& in = *it->second;
+    in.last_active = Clock::now();
+    in.ts_echo     = ts;
+    queue_ack(shard.ack_due, in);
+    if (in.done) return;
+
+    uint64_t offset = (uint64_t)index * in.chunk_size;
+    size_t   len    = plain.size() - CHUNK_FIXED;
+    if (index >= in.window.chunks() || len != std::min<uint64_t>(in.chunk_size, in.size - offset)) {
+        m_rx_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if (!in.window.mark(index)) return; // duplicate
+    VirtualFS* store = m_store.load();
+    store->write_at(in.part_path, (size_t)offset, ConstByteSpan(plain.data() + CHUNK_FIXED, len));
+
+    if (in.window.complete()) {
+        in.done = true;
+        auto    data = store->read_file(in.part_path);
+        uint8_t digest[DIGEST_SIZE];
+        Sha256::hash(data.value.data(), data.value.size(), digest);
+        if (!data.ok() || std::memcmp(digest, in.digest, DIGEST_SIZE) != 0) {
+            log::error(TAG, "'%s' from %s does not match its SHA-256; discarded",
+                       in.final_path.c_str(), in.peer_id.c_str());
+            store->delete_file(in.part_path);
+            return;
+        }
+        store->rename(in.part_path, in.final_path);
+        m_files_received.fetch_add(1, std::memory_order_relaxed);
+        log::info(TAG, "Received '%s' (%llu bytes) from %s", in.final_path.c_str(),
+                  (unsigned long long)in.size, in.peer_id.c_str());
+        deliver([this, peer = in.peer_id, path = in.final_path, size = (size_t)in.size] {
+            for (auto& cb : *snapshot(m_cb_mutex, m_file_callbacks)) cb(peer, path, size);
+        });
+    }
+}
+
+void MeshNet::handle_file_ack(ByteSpan plain, const MeshAddr& from) {
+    using namespace mesh_xfer;
+    if (plain.size() < ACK_FIXED) return;
+    uint32_t id, cum, ts_echo;
+    std::memcpy(&id, plain.data(), 4);
+    std::memcpy(&cum, plain.data() + 4, 4);
+    std::memcpy(&ts_echo, plain.data() + 8, 4);
+
+    std::lock_guard<std::mutex> lock(m_xfer_mutex);
+    auto it = m_outgoing.find(id);
+    if (it == m_outgoing.end()) return;
+    Outgoing& x = *it->second;
+    if (x.peer != from) return;
+
+    x.meta_acked = true;
+    x.window.on_ack(cum, plain.data() + ACK_FIXED, plain.size() - ACK_FIXED, ts_echo, now_us());
+    x.events++;
+    m_xfer_cv.notify_all();
+}
+
+void MeshNet::handle_file_req(ByteSpan plain, const MeshAddr& from) {
+    using namespace mesh_xfer;
+    VirtualFS* store = m_store.load();
+    if (plain.size() < REQ_FIXED || !store) return;
+    uint32_t id, ts;
+    uint16_t name_len, count;
+    std::memcpy(&id, plain.data(), 4);
+    std::memcpy(&ts, plain.data() + 4, 4);
+    std::memcpy(&name_len, plain.data() + 8, 2);
+    std::memcpy(&count, plain.data() + 10, 2);
+    if (count > REQ_MAX || plain.size() != REQ_FIXED + name_len + (size_t)count * 4) return;
+
+    std::string name = base_name(std::string((const char*)plain.data() + REQ_FIXED, name_len));
+    std::string path = m_store_dir + "/" + name;
+    auto        size = name.empty() ? Result<size_t>::error(StatusCode::ERR_NOT_FOUND)
+                                    : store->file_size(path);
+    sockaddr_in dest = make_dest(from);
+
+    if (count == 0) {
+        // META query; CHUNK_SIZE 0 says we do not have it
+        ByteBuffer meta(META_FIXED + name.size(), 0);
+        uint64_t   sz    = size.ok() ? size.value : 0;
+        uint32_t   chunk = (uint32_t)MESH_FILE_CHUNK;
+        if (!size.ok() || !file_digest(path, sz, meta.data() + 20)) chunk = 0;
+        std::memcpy(meta.data(), &id, 4);
+        std::memcpy(meta.data() + 4, &ts, 4);
+        std::memcpy(meta.data() + 8, &sz, 8);
+        std::memcpy(meta.data() + 16, &chunk, 4);
+        std::memcpy(meta.data() + META_FIXED, name.data(), name.size());
+        send_sealed(dest, MeshMsgType::FILE_META, meta.data(), meta.size());
+        return;
+    }
+    if (!size.ok()) return;
+
+    // Read from the VFS straight behind their headers, in pooled buffers,
+    // and queued; a chunk the queue has no room for is asked for again
+    size_t         served  = 0;
+    const uint8_t* indices = plain.data() + REQ_FIXED + name_len;
+    auto           session = this->session();
+    for (size_t k = 0; k < count; k++) {
+        uint32_t index;
+        std::memcpy(&index, indices + k * 4, 4);
+        uint64_t offset = (uint64_t)index * MESH_FILE_CHUNK;
+        if (offset >= size.value) continue;
+        size_t len         = std::min<uint64_t>(MESH_FILE_CHUNK, size.value - offset);
+        size_t payload_len = Crypto::OVERHEAD + CHUNK_FIXED + len;
+
+        ByteBuffer pkt = tx_buffer(MESH_HEADER_SIZE + payload_len);
+        MeshPacket::write_header(pkt.data(), MeshMsgType::FILE_CHUNK, (uint32_t)payload_len);
+        ByteSpan record(pkt.data() + MESH_HEADER_SIZE, payload_len);
+        uint8_t* out = record.data() + Crypto::NONCE_SIZE;
+        std::memcpy(out, &id, 4);
+        std::memcpy(out + 4, &index, 4);
+        std::memcpy(out + 8, &ts, 4);
+        store->read_at(path, (size_t)offset, ByteSpan(out + CHUNK_FIXED, len));
+        if (!session->seal_in_place(record).ok()) return;
+        if (queue_datagram(from, true, std::move(pkt))) served++;
+    }
+    kick_sends();
+    m_file_chunks_served.fetch_add(served, std::memory_order_relaxed);
+}
+
+bool MeshNet::file_digest(const std::string& path, uint64_t size, uint8_t* digest) {
+    auto it = m_served.find(path);
+    if (it != m_served.end() && it->second.size == size) {
+        std::memcpy(digest, it->second.digest, mesh_xfer::DIGEST_SIZE);
+        return true;
+    }
+    Sha256     h;
+    ByteBuffer buf(1 << 16);
+    for (uint64_t off = 0; off < size;) {
+        auto r = m_store.load()->read_at(path, (size_t)off, ByteSpan(buf.data(), buf.size()));
+        if (!r.ok() || r.value == 0) return false;
+        h.update(buf.data(), r.value);
+        off += r.value;
+    }
+    ServedDigest& d = m_served[path];
+    d.size = size;
+    h.finish(d.digest);
+    std::memcpy(digest, d.digest, mesh_xfer::DIGEST_SIZE);
+    return true;
+}
+
+// Index of the download source at this address, or -1
+static int pull_source(const mesh_xfer::Pull& p, const MeshAddr& from) {
+    for (size_t i = 0; i < p.sources.size(); i++) {
+        if (p.sources[i].addr == from) return (int)i;
+    }
+    return -1;
+}
+
+bool MeshNet::handle_pull_meta(ByteSpan plain, const MeshAddr& from) {
+    using namespace mesh_xfer;
+    if (plain.size() < META_FIXED) return false;
+    uint32_t id;
+    std::memcpy(&id, plain.data(), 4);
+
+    std::lock_guard<std::mutex> lock(m_xfer_mutex);
+    auto it = m_pulls.find(id);
+    if (it == m_pulls.end()) return false;
+    Pull& p   = *it->second;
+    int   src = pull_source(p, from);
+    if (src < 0 || p.sources[src].reply != Pull::Reply::NONE) return true;
+
+    uint64_t       size;
+    uint32_t       chunk;
+    const uint8_t* digest = plain.data() + 20;
+    std::memcpy(&size, plain.data() + 8, 8);
+    std::memcpy(&chunk, plain.data() + 16, 4);
+
+    Pull::Reply& reply = p.sources[src].reply;
+    if (chunk == 0 || chunk > MESH_FILE_CHUNK || size > MESH_MAX_FILE) {
+        reply = Pull::Reply::MISSING;
+    } else if (!p.have_meta) {
+        p.have_meta  = true;
+        p.size       = size;
+        p.chunk_size = chunk;
+        std::memcpy(p.digest, digest, DIGEST_SIZE);
+        reply = Pull::Reply::HAS_FILE;
+    } else if (size == p.size && chunk == p.chunk_size &&
+               std::memcmp(digest, p.digest, DIGEST_SIZE) == 0) {
+        reply = Pull::Reply::HAS_FILE;
+    } else {
+        log::warn(TAG, "%s has a different '%s'; not using it",
+                  p.sources[src].peer_id.c_str(), p.name.c_str());
+        reply = Pull::Reply::MISMATCH;
+    }
+    p.events++;
+    m_xfer_cv.notify_all();
+    return true;
+}
+
+bool MeshNet::handle_pull_chunk(ByteSpan plain, const MeshAddr& from) {
+    using namespace mesh_xfer;
+    if (plain.size() < CHUNK_FIXED) return false;
+    uint32_t id, index, ts;
+    std::memcpy(&id, plain.data(), 4);
+    std::memcpy(&index, plain.data() + 4, 4);
+    std::memcpy(&ts, plain.data() + 8, 4);
+
+    std::lock_guard<std::mutex> lock(m_xfer_mutex);
+    auto it = m_pulls.find(id);
+    if (it == m_pulls.end()) return false;
+    Pull& p   = *it->second;
+    int   src = pull_source(p, from);
+    VirtualFS* store = m_store.load();
+    if (src < 0 || !p.sched || !store) return true;
+
+    uint64_t offset = (uint64_t)index * p.chunk_size;
+    size_t   len    = plain.size() - CHUNK_FIXED;
+    if (index >= p.sched->chunks() || len != std::min<uint64_t>(p.chunk_size, p.size - offset)) {
+        m_rx_dropped.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    if (p.sched->has(index)) return true;
+    store->write_at(p.part_path, (size_t)offset, ConstByteSpan(plain.data() + CHUNK_FIXED, len));
+    p.sched->on_chunk((size_t)src, index, ts, now_us());
+    m_file_chunks_fetched.fetch_add(1, std::memory_order_relaxed);
+    p.events++;
+    m_xfer_cv.notify_all();
+    return true;
+}
+
+void MeshNet::flush_file_acks(RxShard& shard) {
+    using namespace mesh_xfer;
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    uint8_t plain[ACK_FIXED + SACK_BYTES];
+    for (Incoming* in : shard.ack_due) {
+        uint32_t cum = in->window.cum();
+        std::memcpy(plain, &in->id, 4);
+        std::memcpy(plain + 4, &cum, 4);
+        std::memcpy(plain + 8, &in->ts_echo, 4);
+        size_t sack = in->window.sack(plain + ACK_FIXED);
+        send_sealed(make_dest(in->from), MeshMsgType::FILE_ACK, plain, ACK_FIXED + sack);
+        in->ack_pending = false;
+    }
+    shard.ack_due.clear();
+}
+
+void MeshNet::expire_incoming(RxShard& shard) {
+    // Finished transfers linger long enough to re-ACK a sender that missed
+    // the last ACK; stalled ones are abandoned with their partial file
+    static constexpr auto DONE_LINGER = Seconds(30);
+    static constexpr auto STALL_LIMIT = Seconds(120);
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.expiry_armed = false;
+    VirtualFS* store = m_store.load();
+    auto       now   = Clock::now();
+    for (auto it = shard.incoming.begin(); it != shard.incoming.end();) {
+        mesh_xfer::Incoming& in = *it->second;
+        auto idle = now - in.last_active;
+        if (in.done ? idle > DONE_LINGER : idle > STALL_LIMIT) {
+            if (!in.done) {
+                log::warn(TAG, "Abandoning incomplete '%s'", in.final_path.c_str());
+                if (store) store->delete_file(in.part_path);
+            }
+            it = shard.incoming.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    schedule_expiry(shard);
+}
+
+// Caller holds shard.mutex. The sweep runs once a second only while there
+// are transfers to sweep, so an idle shard has no timer at all.
+void MeshNet::schedule_expiry(RxShard& shard) {
+    if (shard.expiry_armed || shard.incoming.empty()) return;
+    shard.expiry_armed = true;
+    shard.reactor->schedule(Seconds(1), [this, &shard] { expire_incoming(shard); });
+}
+
+// ─── Send Helpers ────────────────────────────────────────────
+
+Result<void> MeshNet::send_sealed(const sockaddr_in& dest, MeshMsgType type,
+                                  const uint8_t* plain, size_t len) {
+    // [HEADER][NONCE|PLAIN|TAG], sealed where it lies
+    size_t payload_len = Crypto::OVERHEAD + len;
+    uint8_t  stack[512];
+    ByteBuffer heap;
+    uint8_t* buf = stack;
+    if (MESH_HEADER_SIZE + payload_len > sizeof(stack)) {
+        heap.resize(MESH_HEADER_SIZE + payload_len);
+        buf = heap.data();
+    }
+    MeshPacket::write_header(buf, type, (uint32_t)payload_len);
+    ByteSpan record(buf + MESH_HEADER_SIZE, payload_len);
+    if (len) std::memcpy(record.data() + Crypto::NONCE_SIZE, plain, len);
+    if (!session()->seal_in_place(record).ok())
+        return Result<void>::error(StatusCode::ERR_CRYPTO);
+    send_datagram(dest, buf, MESH_HEADER_SIZE + payload_len);
+    return Result<void>::success();
+}
+
+void MeshNet::send_datagram(const sockaddr_in& dest, const uint8_t* data, size_t len) {
+    // Straight out if nothing is queued ahead of it and the limits allow
+    MeshAddr   to = MeshAddr::from(dest);
+    ByteBuffer copy;
+    bool       now;
+    {
+        std::lock_guard<std::mutex> lock(m_sched_mutex);
+        now = !m_tx_inflight && m_sched->bypass(to, len, Clock::now());
+        if (!now) copy = m_sched->take(len);
+    }
+    if (!now) {
+        std::memcpy(copy.data(), data, len);
+        queue_datagram(to, false, std::move(copy));
+        return;
+    }
+    if (m_loss && m_loss->drop_tx()) return;
+    send_now(dest, data, len);
+}
+
+void MeshNet::send_now(const sockaddr_in& dest, const uint8_t* data, size_t len) {
+    int r = sendto((int)m_socket, (const char*)data, (int)len, 0,
+                   (const struct sockaddr*)&dest, sizeof(dest));
+    m_tx_syscalls.fetch_add(1, std::memory_order_relaxed);
+    if (r < 0) return;
+    m_tx_packets.fetch_add(1, std::memory_order_relaxed);
+    m_tx_bytes.fetch_add(len, std::memory_order_relaxed);
+}
+
+// ─── Send Queues ─────────────────────────────────────────────
+
+// Bytes one flush may carry: a message queued behind it waits this long at most
+static constexpr size_t TX_BATCH_BYTES = 128 * 1024;
+// A file sender keeps this much of its peer's rate queued, within bounds:
+// enough to fill batches, little enough that chunks do not sit in the
+// queue for longer than the RTT they are timed against
+static constexpr double BULK_BACKLOG_SECS = 0.02;
+static constexpr size_t BULK_BACKLOG_MIN  = 16 * 1024;
+static constexpr size_t BULK_BACKLOG_MAX  = 256 * 1024;
+
+static size_t bulk_backlog(const MeshSendConfig& cfg, double link_rate) {
+    double rate = 0;
+    for (double r : {cfg.peer_rate, cfg.total_rate, link_rate}) {
+        if (r > 0 && (rate <= 0 || r < rate)) rate = r;
+    }
+    if (rate <= 0) return BULK_BACKLOG_MAX;
+    return std::min(std::max((size_t)(rate * BULK_BACKLOG_SECS), BULK_BACKLOG_MIN), BULK_BACKLOG_MAX);
+}
+
+ByteBuffer MeshNet::tx_buffer(size_t len) {
+    std::lock_guard<std::mutex> lock(m_sched_mutex);
+    return m_sched->take(len);
+}
+
+// False when `to`'s queue is full: the datagram is dropped and counted.
+// File chunks come in runs, so their senders kick the loop once per run.
+bool MeshNet::queue_datagram(const MeshAddr& to, bool bulk, ByteBuffer data) {
+    {
+        std::lock_guard<std::mutex> lock(m_sched_mutex);
+        size_t queued = m_sched->queued_bytes(to, mesh_sched::Class::INTERACTIVE) +
+                        m_sched->queued_bytes(to, mesh_sched::Class::BULK);
+        if (queued + data.size() > m_send_cfg.queue_bytes) {
+            m_sched->recycle(std::move(data));
+            m_txq_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        m_sched->push(to, bulk ? mesh_sched::Class::BULK : mesh_sched::Class::INTERACTIVE,
+                      std::move(data), Clock::now());
+    }
+    if (!bulk) kick_sends();
+    return true;
+}
+
+// Block a file sender until its peer's bulk queue is below the backlog;
+// false on shutdown
+bool MeshNet::wait_for_room(const MeshAddr& to) {
+    std::unique_lock<std::mutex> lock(m_sched_mutex);
+    auto room = [&] {
+        return !m_running.load() ||
+               m_sched->queued_bytes(to, mesh_sched::Class::BULK) < bulk_backlog(m_send_cfg, m_link_rate);
+    };
+    if (!room()) {
+        // The run queued so far has to go first
+        lock.unlock();
+        kick_sends();
+        lock.lock();
+        m_sched_cv.wait(lock, room);
+    }
+    return m_running.load();
+}
+
+// Have the event loop drain the queues at its next turn
+void MeshNet::kick_sends() {
+    if (m_reactor && !m_drain_posted.exchange(true)) m_reactor->post([this] { drain_sends(); });
+}
+
+// Event loop (and shutdown()): send what the limits allow, a batch per
+// flush, for a bounded number of batches so receiving gets its turn
+void MeshNet::drain_sends() {
+    m_drain_posted.store(false);
+    std::lock_guard<std::mutex> tx_lock(m_tx_mutex);
+    if (m_socket == (Socket)-1) return;
+    mesh_io::SendBatch&              batch = tx_batch();
+    std::vector<mesh_sched::Packet>& out   = m_tx_out;
+
+    for (int round = 0; round < TX_ROUNDS; round++) {
+        // Popped under the lock and sent from their own buffers outside
+        // it. Marked in flight, so no message skips the queue past them
+        // meanwhile.
+        size_t bytes = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_sched_mutex);
+            TimePoint          now = Clock::now();
+            mesh_sched::Packet pkt;
+            while (out.size() < batch.capacity() && bytes < TX_BATCH_BYTES && m_sched->pop(now, pkt)) {
+                bytes += pkt.data.size();
+                out.push_back(std::move(pkt));
+            }
+            m_tx_inflight = !out.empty();
+        }
+        m_sched_cv.notify_all();
+        if (out.empty()) break;
+
+        batch.clear();
+        uint64_t syscalls0 = batch.syscalls();
+        size_t   wire      = 0;
+        for (const auto& pkt : out) {
+            if (m_loss && m_loss->drop_tx()) continue;
+            if (batch.push_ref(pkt.data.data(), pkt.data.size(), make_dest(pkt.to))) wire += pkt.data.size();
+        }
+        if (batch.pending() > 0) {
+            auto r = batch.flush((mesh_io::SocketHandle)m_socket);
+            m_tx_syscalls.fetch_add(batch.syscalls() - syscalls0, std::memory_order_relaxed);
+            if (r.ok()) {
+                m_tx_packets.fetch_add(r.value, std::memory_order_relaxed);
+                m_tx_bytes.fetch_add(wire, std::memory_order_relaxed);
+            }
+        }
+
+        // Sent: the buffers go back to the pool for the next chunks
+        std::lock_guard<std::mutex> lock(m_sched_mutex);
+        for (auto& pkt : out) m_sched->recycle(std::move(pkt.data));
+        out.clear();
+        m_tx_inflight = false;
+    }
+
+    // The rest waits for its rate, or for the loop's next turn
+    TimePoint at;
+    {
+        std::lock_guard<std::mutex> lock(m_sched_mutex);
+        if (m_sched->empty()) {
+            if (m_sched->destinations() > 64) m_sched->trim(Clock::now());
+            return;
+        }
+        at = m_sched->next_ready();
+    }
+    if (!m_running.load() || !m_reactor->in_loop()) return;
+    TimePoint now = Clock::now();
+    if (at <= now) {
+        kick_sends();
+        return;
     }
+    m_reactor->cancel(m_send_timer);
+    m_send_timer = m_reactor->schedule(std::chrono::duration_cast<std::chrono::microseconds>(at - now) +
+                                           std::chrono::microseconds(1),
+                                       [this] { drain_sends(); });
 }
 
 MeshPacket MeshNet::create_packet(MeshMsgType type, const ByteBuffer& payload) {
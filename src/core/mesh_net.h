@@ -2,28 +2,52 @@
 
 #include "vos/types.h"
 #include "crypto.h"
+#include "crypto_session.h"
+#include "mesh_addr.h"
 #include <string>
 #include <vector>
 #include <thread>
 #include <atomic>
 #include <mutex>
+#include <condition_variable>
 #include <functional>
+#include <memory>
 #include <unordered_map>
 
+struct sockaddr_in;
+
 namespace vos {
 
+class VirtualFS;
+namespace mesh_io   { class RecvBatch; class SendBatch; class LossShim; class Reactor;
+                      class Uring; class UringRecv; class CallbackQueue; }
+namespace mesh_xfer { struct Outgoing; struct Incoming; struct Pull; }
+namespace mesh_route { class RouteTable; class DupFilter; }
+namespace mesh_discovery { class Trickle; }
+namespace mesh_sched { class SendScheduler; struct Packet; }
+
 // ─── Packet Protocol ─────────────────────────────────────────
 // [MAGIC:4][VER:1][TYPE:1][PAYLOAD_LEN:4][PAYLOAD:N][HMAC:32]
+// MeshNet sends no HMAC trailer: sealed payloads carry their AEAD tag.
 
-constexpr uint32_t MESH_MAGIC   = 0x564F534D; // "VOSM"
-constexpr uint8_t  MESH_VERSION = 1;
+constexpr uint32_t MESH_MAGIC       = 0x564F534D; // "VOSM"
+constexpr uint8_t  MESH_VERSION     = 1;
+constexpr size_t   MESH_HEADER_SIZE = 10;
+constexpr size_t   MESH_FILE_CHUNK  = 8192;   // File bytes per FILE_CHUNK
+constexpr uint64_t MESH_MAX_FILE    = 1ull << 30;  // Largest file send_file() accepts / a peer may offer
+constexpr size_t   MESH_BUNDLE_MAX  = 1400;   // Largest BUNDLE datagram; fits an Ethernet MTU
 
 enum class MeshMsgType : uint8_t {
     DISCOVER    = 0x01,  // Peer discovery broadcast
     DISCOVER_ACK= 0x02,  // Response to discovery
+    ROUTE       = 0x03,  // Distance vector for multi-hop routing (see mesh_route.h)
     TEXT_MSG    = 0x10,  // Text message
+    BUNDLE      = 0x11,  // Small messages sharing one datagram: sealed [TYPE:1][LEN:2][BODY]...
+    RELAY       = 0x12,  // Message for a peer out of direct reach, passed on hop by hop
     FILE_CHUNK  = 0x20,  // File transfer chunk
     FILE_META   = 0x21,  // File transfer metadata
+    FILE_ACK    = 0x22,  // Cumulative + selective ack for a file transfer
+    FILE_REQ    = 0x23,  // Download: ask a peer for a file's META or chunks
     PING        = 0xF0,
     PONG        = 0xF1,
 };
@@ -39,21 +63,150 @@ struct MeshPacket {
     // Serialize to wire format
     ByteBuffer serialize() const;
 
-    // Deserialize from wire format
-    static Result<MeshPacket> deserialize(const ByteBuffer& data);
+    // Write just the header into out[0..MESH_HEADER_SIZE) — for callers that
+    // build the payload in place behind it
+    static void write_header(uint8_t* out, MeshMsgType type, uint32_t payload_len);
+
+    // Deserialize from wire format into owning buffers. For a packet that
+    // must outlive its receive buffer; the receive path uses MeshPacketView.
+    static Result<MeshPacket> deserialize(ConstByteSpan data);
+    static Result<MeshPacket> deserialize(const ByteBuffer& data) {
+        return deserialize(ConstByteSpan(data.data(), data.size()));
+    }
+};
+
+// A packet parsed where it lies: the header is checked and payload/mac
+// are spans into the parsed buffer, valid only as long as it is. No copy
+// and no allocation. Spans are mutable so a sealed payload can be opened
+// in place; to_packet() makes the owning copy.
+struct MeshPacketView {
+    uint8_t     version = 0;
+    MeshMsgType type    = MeshMsgType::PING;
+    ByteSpan    payload;
+    ByteSpan    mac;       // whatever follows the payload
+    ByteSpan    wire;      // the whole datagram, for passing it on as it is
+
+    static Result<MeshPacketView> parse(ByteSpan data);
+
+    MeshPacket to_packet() const;
 };
 
 // ─── Peer Info ───────────────────────────────────────────────
 struct MeshPeer {
     std::string peer_id;       // Unique identifier
-    std::string address;       // IP:port or BT address
-    TimePoint   last_seen;
-    bool        connected;
+    std::string address;       // IP or BT address
+    uint16_t    port = 0;      // UDP port the peer sends from
+    MeshAddr    endpoint;      // address and port as sends use them
+    TimePoint   last_seen;     // last DISCOVER or PONG
+    bool        connected;     // false once stale: liveness probes went unanswered
+    uint32_t    srtt_us   = 0; // PING/PONG round trip, smoothed; 0 = not measured
+    uint32_t    rttvar_us = 0;
+};
+
+// DISCOVER pacing (see MeshNet::start_discovery)
+struct MeshDiscoveryConfig {
+    Millis interval_min{1000};    // broadcast interval after a change
+    Millis interval_max{60000};   // doubles toward this while the peer set holds
+    int    redundancy = 2;        // skip ours after hearing this many; 0 never skips
+    size_t ack_fanout = 4;        // about this many peers answer a known peer's DISCOVER; 0 = all
+};
+
+// Peer liveness probing (see MeshNet::start_liveness)
+struct MeshLivenessConfig {
+    Millis ping_min{1000};        // probe interval for a peer that just answered
+    Millis ping_max{30000};       // doubles toward this while it keeps answering
+    int    stale_after = 3;       // unanswered probes in a row before it is stale
+    Millis evict_after{120000};   // silence before it is dropped; 0 keeps it
+};
+
+// Multi-hop routing (see MeshNet::start_routing)
+struct MeshRoutingConfig {
+    Millis  advertise_every{5000};   // full vector to each neighbour; changes go out at once
+    Millis  route_timeout{15000};    // a learned route no advert confirms is dropped after this
+    uint8_t ttl = 16;                // hops a relayed message may take
+};
+
+// Outbound queues and rate limits (see MeshNet::set_send_limits)
+struct MeshSendConfig {
+    double peer_rate   = 0;           // bytes/s to any one peer; 0 = unlimited
+    double total_rate  = 0;           // bytes/s to all peers together; 0 = unlimited
+    size_t burst       = 64 * 1024;   // bytes either limit lets through at once after a pause
+    size_t queue_bytes = 1 << 20;     // per peer; datagrams beyond it are dropped
+};
+
+struct MeshRoute {
+    std::string dest;
+    std::string next_hop;   // == dest for a neighbour
+    int         hops = 0;
+};
+
+// ─── Counters ────────────────────────────────────────────────
+struct MeshStats {
+    uint64_t rx_packets    = 0;   // Datagrams that parsed as mesh packets
+    uint64_t rx_bytes      = 0;
+    uint64_t rx_syscalls   = 0;   // Receive calls that returned data (ring enters under io_uring)
+    uint64_t rx_dropped    = 0;   // Truncated or malformed datagrams
+    uint64_t tx_packets    = 0;
+    uint64_t tx_bytes      = 0;
+    uint64_t tx_syscalls   = 0;   // Send calls (one sendmmsg may carry many packets)
+    uint64_t tx_bundles    = 0;   // BUNDLE datagrams sent (see set_coalesce_window)
+    uint64_t tx_bundled    = 0;   // Messages they carried
+
+    uint64_t file_chunks_sent  = 0;   // FILE_CHUNK transmissions, retransmits included
+    uint64_t file_retransmits  = 0;
+    uint64_t file_timeouts     = 0;   // Retransmission timer expiries
+    uint64_t files_received    = 0;
+    uint64_t file_chunks_served  = 0;   // Chunks sent in answer to FILE_REQ
+    uint64_t file_chunks_fetched = 0;   // New chunks taken in by download_file()
+    uint64_t sim_dropped       = 0;   // Datagrams discarded by set_loss_simulation()
+    uint64_t loop_wakeups      = 0;   // Times the event loop woke (packets, timers, wake-ups)
+    uint64_t pings_sent        = 0;   // Liveness probes
+    uint64_t peers_evicted     = 0;
+    uint64_t discover_sent       = 0;   // DISCOVER broadcasts
+    uint64_t discover_suppressed = 0;   // Broadcasts skipped: enough peers had spoken
+    uint64_t discover_acks       = 0;
+    uint64_t acks_suppressed     = 0;   // DISCOVERs left for other peers to answer
+    uint64_t relayed           = 0;   // RELAY packets passed on for other peers
+    uint64_t relay_dropped     = 0;   // No route, or the TTL ran out
+    uint64_t relay_duplicates  = 0;   // Copies already seen (routing loops)
+
+    // Outbound queues (see set_send_limits). Waits run from the send call
+    // until the datagram is handed to the socket.
+    uint64_t txq_depth            = 0;   // Datagrams queued now
+    uint64_t txq_dropped          = 0;   // Refused by a full per-peer queue
+    uint64_t txq_wait_avg_us      = 0;   // Messages and control traffic
+    uint64_t txq_wait_p99_us      = 0;
+    uint64_t txq_wait_max_us      = 0;
+    uint64_t txq_bulk_wait_avg_us = 0;   // File chunks
+    uint64_t txq_bulk_wait_p99_us = 0;
+    uint64_t txq_bulk_wait_max_us = 0;
+
+    // Callback queue (see set_callback_queue)
+    uint64_t cb_depth       = 0;   // Events waiting for their callbacks now
+    uint64_t cb_max_depth   = 0;
+    uint64_t cb_delivered   = 0;
+    uint64_t cb_dropped     = 0;   // Events lost to a full queue
+    uint64_t cb_wait_avg_us = 0;   // Time from the packet to its callbacks starting
+    uint64_t cb_wait_p99_us = 0;
+    uint64_t cb_wait_max_us = 0;
+
+    std::vector<uint64_t> shard_rx_packets;   // Per receive shard (see set_rx_shards)
+};
+
+// ─── Socket I/O ──────────────────────────────────────────────
+enum class MeshIoBackend : uint8_t {
+    AUTO,       // io_uring where the kernel runs it, else SYSCALLS
+    SYSCALLS,   // recvmmsg / sendmmsg (recvfrom / sendto off Linux)
+    IO_URING,   // multishot recvmsg and linked sendmsg (Linux 6.0+); SYSCALLS if unsupported
 };
 
 // ─── Callbacks ───────────────────────────────────────────────
 using MeshMessageFn = std::function<void(const std::string& peer_id, const ByteBuffer& payload)>;
 using MeshPeerFn    = std::function<void(const MeshPeer& peer)>;
+using MeshFileFn    = std::function<void(const std::string& peer_id, const std::string& path,
+                                         size_t size)>;
+// Download progress; return false to stop (the download can be resumed)
+using MeshProgressFn = std::function<bool(uint64_t have_bytes, uint64_t total_bytes)>;
 
 // ─── Mesh Network Manager ────────────────────────────────────
 class MeshNet {
@@ -61,56 +214,343 @@ public:
     MeshNet();
     ~MeshNet();
 
-    // Init with a crypto instance for encryption
+    // Init with a crypto instance for encryption. A random session key is
+    // generated; peers that should talk to each other share one via
+    // set_session_key() before exchanging traffic. The key may change at
+    // any time: datagrams sealed or opened meanwhile use the old one or
+    // the new one, whole.
     Result<void> init(Crypto* crypto, uint16_t port = 5055);
+    Result<void> set_session_key(const ByteBuffer& key);
+    // Also receive on another port, or on one interface's address. All
+    // sockets share the event loop thread; replies leave from the main one.
+    Result<void> add_listener(uint16_t port, const std::string& bind_ip = "0.0.0.0");
     void shutdown();
 
-    // Discovery
+    // Discovery: broadcast DISCOVER on a Trickle schedule (see
+    // mesh_discovery.h). The interval doubles from interval_min to
+    // interval_max while the peer set holds, with a random offset in each,
+    // and drops back when peers appear or go away. A broadcast is skipped
+    // when enough peers spoke first. Every peer answers a newcomer; a
+    // DISCOVER from a known peer gets about ack_fanout answers.
+    void set_discovery(const MeshDiscoveryConfig& cfg);
     void start_discovery();
     void stop_discovery();
     std::vector<MeshPeer> get_peers() const;
+    // Register a peer directly, without waiting for discovery
+    void add_peer(const std::string& peer_id, const std::string& ip, uint16_t port);
+
+    // Liveness: PING peers, keep a round-trip estimate for each from the
+    // PONGs (MeshPeer::srtt_us), mark peers stale after stale_after
+    // unanswered probes and drop those silent for evict_after. The probe
+    // interval doubles from ping_min to ping_max while a peer answers;
+    // unanswered probes are retried on its RTO. Transfers start their
+    // retransmission timers from the measured RTT, and downloads skip
+    // stale sources while live ones remain.
+    void set_liveness(const MeshLivenessConfig& cfg);
+    void start_liveness();
+    void stop_liveness();
+
+    // Multi-hop routing: neighbours exchange distance vectors (ROUTE) so
+    // each instance learns the peers its neighbours can reach, and
+    // send_text() to a peer that is not a neighbour goes as a RELAY to the
+    // next hop, which passes it on unopened. Routes are keyed by the ids
+    // instances give themselves (set_own_id), so add_peer() must use those.
+    // Relaying for others works whether or not routing is started.
+    void set_routing(const MeshRoutingConfig& cfg);
+    void start_routing();
+    void stop_routing();
+    std::vector<MeshRoute> get_routes() const;   // neighbours and learned routes
 
     // Messaging
     Result<void> send_text(const std::string& peer_id, const std::string& message);
+    // Hold small messages to a peer for up to `window` (e.g. 2 ms) and send
+    // them together as one BUNDLE: one header, one seal and one HMAC per
+    // datagram instead of per message. Order to each peer is kept. Off (0)
+    // by default, as peers on older builds ignore BUNDLE.
+    void set_coalesce_window(std::chrono::microseconds window);
+    // Reliable transfer: blocks until the peer has acknowledged every
+    // chunk. ERR_TIMEOUT if the peer stops answering.
     Result<void> send_file(const std::string& peer_id, const std::string& filename,
                            const ByteBuffer& data);
 
-    // Register callbacks
+    // Fetch `name` from the file stores of several peers at once, each
+    // serving different chunks, into this instance's store. Progress is
+    // kept in "<name>.part.map" beside the partial file, so a stopped or
+    // failed download picks up where it left off when called again. The
+    // result is checked against the SHA-256 the sources advertise.
+    Result<void> download_file(const std::string& name, const std::vector<std::string>& peer_ids,
+                               MeshProgressFn progress = nullptr);
+
+    // Incoming files are reassembled into `dir` in this VFS, and files in
+    // `dir` are served to peers that download them; without a store,
+    // FILE_META and FILE_REQ are ignored.
+    void set_file_store(VirtualFS* vfs, const std::string& dir = "/home/downloads");
+
+    // Drop this fraction of sent / received datagrams (testing and
+    // benchmarks). Call before traffic starts; 0, 0 turns it off.
+    void set_loss_simulation(double tx_rate, double rx_rate, uint64_t seed = 1);
+    // Socket I/O for the main port, from the next init(). Either way the
+    // instance falls back to SYSCALLS if io_uring is missing or fails.
+    void          set_io_backend(MeshIoBackend backend);
+    MeshIoBackend io_backend() const { return m_io_backend.load(); }   // in use now
+
+    // Receive on `n` sockets bound to the mesh port with SO_REUSEPORT, each
+    // drained by its own thread. The kernel keeps every sender on one
+    // socket, so each thread owns the incoming transfers it sees and
+    // bulk receives from many peers spread over cores. Linux only; one
+    // socket elsewhere. From the next init().
+    void   set_rx_shards(size_t n);
+    size_t rx_shards() const { return m_shards.size(); }
+
+    // Outbound queues: every datagram is queued for its destination and
+    // the event loop sends them, peers taking turns byte for byte (deficit
+    // round-robin, see mesh_sched.h). Messages and control traffic go
+    // before file chunks, so chat stays quick during a bulk transfer. A
+    // message to an idle peer with nothing queued anywhere skips the queue.
+    // Token buckets cap the rate to each peer and in total; send_file()
+    // waits while its peer has more than a few milliseconds' worth queued.
+    void set_send_limits(const MeshSendConfig& cfg);
+
+    // Cap this instance's send rate, modelling a slow uplink (testing and
+    // benchmarks): another total limit, applied with set_send_limits()'
+    // one. Call before traffic starts; 0 turns it off.
+    void set_rate_simulation(double bytes_per_sec);
+
+    // Register callbacks. They run in order on one worker thread, never on
+    // the network thread or under MeshNet's locks, so a slow one delays
+    // only the callbacks queued behind it.
     void on_message(MeshMessageFn fn);
     void on_peer_found(MeshPeerFn fn);
+    void on_file_received(MeshFileFn fn);
+    // At most `capacity` events wait for their callbacks; more are dropped
+    // and counted in MeshStats::cb_dropped. From the next init().
+    void set_callback_queue(size_t capacity);
+    // Wait until the callbacks for everything received so far have run
+    // (not from a callback)
+    void drain_callbacks();
 
     bool is_running() const { return m_running.load(); }
 
     // Get our own peer ID
     std::string get_own_id() const;
+    // Replace the random one; before init(), 1 to 255 bytes
+    Result<void> set_own_id(const std::string& id);
+
+    MeshStats get_stats() const;
 
 private:
-    void listener_loop();
-    void discovery_loop();
-    void handle_packet(const MeshPacket& pkt, const std::string& from_addr);
+#ifdef _WIN32
+    using Socket = uintptr_t;
+#else
+    using Socket = int;
+#endif
+
+    struct RxShard;
+
+    void on_readable(RxShard& shard, Socket sock);
+    void on_ring(RxShard& shard);
+    void fall_back_to_syscalls(RxShard& shard);
+    void handle_datagram(RxShard& shard, ByteSpan data, bool truncated, const sockaddr_in& from);
+    void discovery_tick();
+    void discovery_changed();   // peers came or went; caller holds m_mutex
+    void handle_packet(RxShard& shard, MeshPacketView& pkt, const MeshAddr& from);
+    std::string peer_at(const MeshAddr& from) const;
+    std::shared_ptr<const CryptoSession> session() const;
+    void        index_peer(MeshPeer& peer, const MeshAddr& addr);   // caller holds m_mutex
+    void deliver(std::function<void()> fn);
+    void deliver_text(const std::string& sender_id, ConstByteSpan text);
+    void send_pong(const MeshAddr& to, ConstByteSpan echo);
+
+    // Liveness (see start_liveness)
+    struct Probe;
+    void liveness_tick();
+    void handle_pong(ConstByteSpan echo, const MeshAddr& from);
+    void evict_peer(const std::string& peer_id);   // caller holds m_mutex
+
+    // Routing (see start_routing)
+    void route_tick();
+    void advertise_routes();
+    void routes_changed();
+    void handle_route(ByteSpan sealed, const MeshAddr& from);
+    void handle_relay(MeshPacketView& pkt, const MeshAddr& from);
+    bool route_to(const std::string& dest, MeshAddr& to, bool& relayed) const;   // caller holds m_mutex
+    Result<void> send_relayed(const MeshAddr& next_hop, const std::string& dest, MeshMsgType type,
+                              ConstByteSpan body);
+
+    // Coalescing (see set_coalesce_window)
+    bool coalesce(const MeshAddr& to, MeshMsgType type, ConstByteSpan body);
+    void flush_bundle(const MeshAddr& to);
+    void flush_bundles();
+    void send_bundle(const MeshAddr& to, const ByteBuffer& records, size_t count);
+    void handle_bundle(ByteSpan records, const MeshAddr& from);
     MeshPacket create_packet(MeshMsgType type, const ByteBuffer& payload);
+    void send_datagram(const sockaddr_in& dest, const uint8_t* data, size_t len);
+    void send_now(const sockaddr_in& dest, const uint8_t* data, size_t len);
+
+    // Outbound queues (see set_send_limits)
+    ByteBuffer tx_buffer(size_t len);   // a pooled buffer to build a datagram in
+    bool queue_datagram(const MeshAddr& to, bool bulk, ByteBuffer data);
+    bool wait_for_room(const MeshAddr& to);
+    void apply_send_limits();   // caller holds m_sched_mutex
+    void kick_sends();
+    void drain_sends();
+    Result<void> send_sealed(const sockaddr_in& dest, MeshMsgType type,
+                             const uint8_t* plain, size_t len);
+
+    // File transfer (see mesh_transfer.h)
+    Result<void> send_chunks(mesh_xfer::Outgoing& xfer, const ByteBuffer& data,
+                             const uint32_t* picks, size_t n);
+    void handle_file_meta(RxShard& shard, ByteSpan plain, const MeshAddr& from);
+    void handle_file_chunk(RxShard& shard, ByteSpan plain, const MeshAddr& from);
+    void handle_file_ack(ByteSpan plain, const MeshAddr& from);
+    void handle_file_req(ByteSpan plain, const MeshAddr& from);
+    bool handle_pull_meta(ByteSpan plain, const MeshAddr& from);
+    bool handle_pull_chunk(ByteSpan plain, const MeshAddr& from);
+    bool file_digest(const std::string& path, uint64_t size, uint8_t* digest);
+    mesh_io::SendBatch& tx_batch();
+    void flush_file_acks(RxShard& shard);
+    void expire_incoming(RxShard& shard);
+    void schedule_expiry(RxShard& shard);
+
+    static constexpr size_t FILE_TX_SLOTS = 64;   // datagrams per flush
+    static constexpr int    RX_ROUNDS     = 8;    // receive batches per wake-up
+    static constexpr int    TX_ROUNDS     = 4;    // send batches per wake-up
 
-    mutable std::mutex    m_mutex;
+    mutable std::mutex    m_mutex;   // peer table and settings
     std::atomic<bool>     m_running{false};
     std::atomic<bool>     m_discovering{false};
     uint16_t              m_port{5055};
     std::string           m_own_id;
 
     Crypto*               m_crypto{nullptr};
-    ByteBuffer            m_session_key;
+    // Replaced whole by set_session_key(), never edited: every seal and
+    // open works on a snapshot taken under m_session_mutex, so a key
+    // change cannot tear one going on in another thread
+    mutable std::mutex                   m_session_mutex;
+    std::shared_ptr<const CryptoSession> m_session{std::make_shared<CryptoSession>()};
 
-    std::thread           m_listener_thread;
-    std::thread           m_discovery_thread;
+    // The main event loop: shard 0's sockets, timers, posted work
+    std::unique_ptr<mesh_io::Reactor>   m_reactor;
+    std::thread                         m_loop_thread;
+    uint64_t                            m_discovery_timer{0};   // loop thread only
+    uint64_t                            m_liveness_timer{0};    // loop thread only
+    uint64_t                            m_route_timer{0};       // loop thread only
+    uint64_t                            m_send_timer{0};        // loop thread only
+
+    // Receive shards (see set_rx_shards); shard 0 runs on m_reactor.
+    // Kept after shutdown() so get_stats() still sums them.
+    std::vector<std::unique_ptr<RxShard>> m_shards;
+    size_t                                m_shard_request{1};
+    uint64_t                              m_rx_base[3]{};   // packets, bytes, syscalls of retired shards
+
+    MeshIoBackend                          m_io_request{MeshIoBackend::AUTO};
+    std::atomic<MeshIoBackend>             m_io_backend{MeshIoBackend::SYSCALLS};
+    std::unique_ptr<mesh_io::Uring>        m_utx;   // send ring, under m_tx_mutex
+
+    std::atomic<uint64_t> m_rx_dropped{0};
+    std::atomic<uint64_t> m_tx_packets{0};
+    std::atomic<uint64_t> m_tx_bytes{0};
+    std::atomic<uint64_t> m_tx_syscalls{0};
+    std::atomic<uint64_t> m_tx_bundles{0};
+    std::atomic<uint64_t> m_tx_bundled{0};
+
+    std::atomic<uint64_t> m_file_chunks_sent{0};
+    std::atomic<uint64_t> m_file_retransmits{0};
+    std::atomic<uint64_t> m_file_timeouts{0};
+    std::atomic<uint64_t> m_files_received{0};
+    std::atomic<uint64_t> m_file_chunks_served{0};
+    std::atomic<uint64_t> m_file_chunks_fetched{0};
+
+    // Send batch the queues drain through, and the datagrams it points
+    // into until flushed; m_tx_mutex serializes their users
+    std::mutex                          m_tx_mutex;
+    std::unique_ptr<mesh_io::SendBatch> m_tx_batch;
+    std::vector<mesh_sched::Packet>     m_tx_out;
+    std::unique_ptr<mesh_io::LossShim>  m_loss;
+
+    // Outbound queues; m_sched_mutex is taken last, after any other lock
+    mutable std::mutex                          m_sched_mutex;
+    std::condition_variable                     m_sched_cv;   // a file sender's peer has room
+    std::unique_ptr<mesh_sched::SendScheduler>  m_sched;
+    MeshSendConfig                              m_send_cfg;
+    double                                      m_link_rate{0};      // set_rate_simulation
+    bool                                        m_tx_inflight{false}; // drained, not yet sent
+    std::atomic<bool>                           m_drain_posted{false};
+    std::atomic<uint64_t>                       m_txq_dropped{0};
+
+    // Transfers in progress on send_file() callers' stacks, by transfer id.
+    // The listener applies their ACKs and wakes the sender.
+    std::mutex                                          m_xfer_mutex;
+    std::condition_variable                             m_xfer_cv;
+    std::unordered_map<uint32_t, mesh_xfer::Outgoing*>  m_outgoing;
+    std::unordered_map<uint32_t, mesh_xfer::Pull*>      m_pulls;
+
+    // File store; m_store_mutex guards the directory and the digest cache
+    std::mutex                                                     m_store_mutex;
+    std::atomic<VirtualFS*>                                        m_store{nullptr};
+    std::string                                                    m_store_dir;
+
+    // Incoming transfers live in the shard that receives them
+    struct TransferKey {
+        MeshAddr from;
+        uint32_t id;
+        bool operator==(const TransferKey& o) const { return id == o.id && from == o.from; }
+    };
+    struct TransferKeyHash {
+        size_t operator()(const TransferKey& k) const noexcept {
+            return MeshAddrHash()(k.from) ^ ((size_t)k.id * 0x9E3779B97F4A7C15ull);
+        }
+    };
+
+    // SHA-256 of served files by path, valid while the size matches
+    struct ServedDigest { uint64_t size; uint8_t digest[32]; };
+    std::unordered_map<std::string, ServedDigest>                  m_served;
+
+    // Records waiting for their BUNDLE, by destination
+    struct Bundle { ByteBuffer records; size_t count = 0; };
+    std::mutex                                         m_bundle_mutex;
+    std::unordered_map<MeshAddr, Bundle, MeshAddrHash> m_bundles;
+    std::atomic<int64_t>                               m_coalesce_us{0};
 
     std::unordered_map<std::string, MeshPeer> m_peers;
-    std::vector<MeshMessageFn>  m_msg_callbacks;
-    std::vector<MeshPeerFn>     m_peer_callbacks;
+    // Liveness state by peer id, beside m_peers and under the same lock
+    std::unordered_map<std::string, std::unique_ptr<Probe>> m_probes;
+    MeshLivenessConfig                                      m_liveness;
+    std::atomic<bool>                                       m_probing{false};
+    std::atomic<uint64_t>                                   m_pings_sent{0};
+    std::atomic<uint64_t>                                   m_peers_evicted{0};
+    // DISCOVER schedule, under m_mutex
+    std::unique_ptr<mesh_discovery::Trickle>                m_trickle;
+    MeshDiscoveryConfig                                     m_discovery;
+    std::atomic<uint64_t>                                   m_discover_sent{0};
+    std::atomic<uint64_t>                                   m_discover_suppressed{0};
+    std::atomic<uint64_t>                                   m_discover_acks{0};
+    std::atomic<uint64_t>                                   m_acks_suppressed{0};
+    // Learned routes and recently relayed message ids, under m_mutex
+    std::unique_ptr<mesh_route::RouteTable>                 m_routes;
+    std::unique_ptr<mesh_route::DupFilter>                  m_relay_seen;
+    MeshRoutingConfig                                       m_routing_cfg;
+    std::atomic<bool>                                       m_routing{false};
+    std::atomic<bool>                                       m_route_flush{false};   // advert posted
+    std::atomic<uint64_t>                                   m_relay_seq{0};
+    std::atomic<uint64_t>                                   m_relayed{0};
+    std::atomic<uint64_t>                                   m_relay_dropped{0};
+    std::atomic<uint64_t>                                   m_relay_duplicates{0};
+    // Sender lookup for every received packet: endpoint -> peer id
+    std::unordered_map<MeshAddr, std::string, MeshAddrHash> m_peer_index;
 
-#ifdef _WIN32
-    uintptr_t m_socket{(uintptr_t)(~0)};
-#else
-    int m_socket{-1};
-#endif
+    // Callbacks run on m_dispatch's worker. The lists are replaced, never
+    // edited, so the worker calls a snapshot without holding m_cb_mutex.
+    template<typename Fn> using CallbackList = std::shared_ptr<const std::vector<Fn>>;
+    std::unique_ptr<mesh_io::CallbackQueue> m_dispatch;
+    size_t                                  m_dispatch_capacity{1024};
+    std::mutex                              m_cb_mutex;
+    CallbackList<MeshMessageFn>             m_msg_callbacks;
+    CallbackList<MeshPeerFn>                m_peer_callbacks;
+    CallbackList<MeshFileFn>                m_file_callbacks;
+
+    Socket              m_socket{(Socket)-1};   // shard 0's; every reply leaves from it
+    std::vector<Socket> m_extra_sockets;       // add_listener(), on shard 0
 };
 
 } // namespace vos
@@ -0,0 +1,191 @@
+#include "mesh_route.h"
+#include <algorithm>
+#include <cstring>
+
+namespace vos {
+namespace mesh_route {
+
+// ─── RouteTable ──────────────────────────────────────────────
+
+bool RouteTable::update(const std::string& self, const std::string& neighbour,
+                        const std::vector<Entry>& vec, TimePoint now) {
+    bool changed = false;
+    for (const Entry& e : vec) {
+        // The neighbour itself is direct; routes back to us are of no use
+        if (e.dest == self || e.dest == neighbour) continue;
+        uint8_t metric = (uint8_t)std::min<int>(e.metric + 1, METRIC_INFINITY);
+
+        auto it = m_routes.find(e.dest);
+        if (it == m_routes.end()) {
+            if (metric >= METRIC_INFINITY) continue;
+            m_routes[e.dest] = Route{neighbour, metric, now};
+            changed = true;
+        } else if (it->second.next_hop == neighbour) {
+            // The next hop's word goes, better or worse
+            Route& r = it->second;
+            if (r.metric != metric) changed = true;
+            if (metric < METRIC_INFINITY || r.metric < METRIC_INFINITY) r.refreshed = now;
+            r.metric = metric;
+        } else if (metric < it->second.metric) {
+            it->second = Route{neighbour, metric, now};
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+bool RouteTable::neighbour_down(const std::string& neighbour, TimePoint now) {
+    bool changed = false;
+    for (auto& kv : m_routes) {
+        Route& r = kv.second;
+        if (r.next_hop != neighbour || r.metric >= METRIC_INFINITY) continue;
+        r.metric    = METRIC_INFINITY;
+        r.refreshed = now;
+        changed     = true;
+    }
+    return changed;
+}
+
+bool RouteTable::expire(TimePoint now, Duration timeout) {
+    bool changed = false;
+    for (auto it = m_routes.begin(); it != m_routes.end();) {
+        Route& r = it->second;
+        if (now - r.refreshed <= timeout) {
+            ++it;
+        } else if (r.metric < METRIC_INFINITY) {
+            r.metric    = METRIC_INFINITY;
+            r.refreshed = now;
+            changed     = true;
+            ++it;
+        } else {
+            it = m_routes.erase(it);
+        }
+    }
+    return changed;
+}
+
+const Route* RouteTable::find(const std::string& dest) const {
+    auto it = m_routes.find(dest);
+    if (it == m_routes.end() || it->second.metric >= METRIC_INFINITY) return nullptr;
+    return &it->second;
+}
+
+// ─── Vectors ─────────────────────────────────────────────────
+
+size_t encode_vector(const std::vector<Entry>& vec, size_t first, size_t max_bytes, ByteBuffer& out) {
+    out.assign(2, 0);
+    uint16_t count = 0;
+    size_t   i     = first;
+    for (; i < vec.size(); i++) {
+        const Entry& e = vec[i];
+        if (e.dest.empty() || e.dest.size() > MAX_ID) continue;
+        if (out.size() + 2 + e.dest.size() > max_bytes || count == UINT16_MAX) break;
+        out.push_back(e.metric);
+        out.push_back((uint8_t)e.dest.size());
+        out.insert(out.end(), e.dest.begin(), e.dest.end());
+        count++;
+    }
+    std::memcpy(out.data(), &count, 2);
+    return i;
+}
+
+bool decode_vector(ConstByteSpan data, std::vector<Entry>& out) {
+    out.clear();
+    if (data.size() < 2) return false;
+    uint16_t count;
+    std::memcpy(&count, data.data(), 2);
+    size_t off = 2;
+    for (uint16_t k = 0; k < count; k++) {
+        if (off + 2 > data.size()) return false;
+        uint8_t metric = data[off];
+        size_t  len    = data[off + 1];
+        off += 2;
+        if (len == 0 || off + len > data.size()) return false;
+        out.push_back(Entry{std::string((const char*)data.data() + off, len), metric});
+        off += len;
+    }
+    return true;
+}
+
+// ─── Relay header ────────────────────────────────────────────
+
+void write_relay_header(uint8_t* out, uint8_t ttl, uint64_t msg, const std::string& dest) {
+    out[0] = ttl;
+    out[1] = 0;
+    std::memcpy(out + 2, &msg, 8);
+    out[10] = (uint8_t)dest.size();
+    std::memcpy(out + RELAY_FIXED, dest.data(), dest.size());
+}
+
+bool parse_relay_header(ConstByteSpan data, RelayHeader& out) {
+    if (data.size() < RELAY_FIXED) return false;
+    size_t len = data[10];
+    if (len == 0 || RELAY_FIXED + len > data.size()) return false;
+    if (data[0] + data[1] > 0xFF) return false;
+    out.ttl  = data[0];
+    out.hops = data[1];
+    std::memcpy(&out.msg, data.data() + 2, 8);
+    out.dest = data.subspan(RELAY_FIXED, len);
+    out.size = RELAY_FIXED + len;
+    return true;
+}
+
+size_t relay_aad(const RelayHeader& hdr, uint8_t* out) {
+    out[0] = (uint8_t)(hdr.ttl + hdr.hops);
+    std::memcpy(out + 1, &hdr.msg, 8);
+    out[9] = (uint8_t)hdr.dest.size();
+    std::memcpy(out + 10, hdr.dest.data(), hdr.dest.size());
+    return 10 + hdr.dest.size();
+}
+
+// ─── DupFilter ───────────────────────────────────────────────
+
+DupFilter::DupFilter(size_t bits_log2, size_t per_generation)
+    : m_mask(((size_t)1 << bits_log2) - 1), m_per_gen(std::max<size_t>(per_generation, 1)) {
+    size_t words = std::max<size_t>(((size_t)1 << bits_log2) / 64, 1);
+    m_gen[0].assign(words, 0);
+    m_gen[1].assign(words, 0);
+}
+
+bool DupFilter::test(const std::vector<uint64_t>& gen, const size_t* pos) const {
+    for (int k = 0; k < HASHES; k++)
+        if (!(gen[pos[k] >> 6] >> (pos[k] & 63) & 1)) return false;
+    return true;
+}
+
+void DupFilter::positions(uint64_t id, size_t* pos) const {
+    // splitmix64 finalizer, then double hashing for the bit positions
+    uint64_t h = id + 0x9E3779B97F4A7C15ull;
+    h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ull;
+    h = (h ^ (h >> 27)) * 0x94D049BB133111EBull;
+    h ^= h >> 31;
+    uint32_t h1 = (uint32_t)h, h2 = (uint32_t)(h >> 32) | 1;
+    for (int k = 0; k < HASHES; k++) pos[k] = (h1 + (size_t)k * h2) & m_mask;
+}
+
+bool DupFilter::contains(uint64_t id) const {
+    size_t pos[HASHES];
+    positions(id, pos);
+    return test(m_gen[0], pos) || test(m_gen[1], pos);
+}
+
+bool DupFilter::seen(uint64_t id) {
+    size_t pos[HASHES];
+    positions(id, pos);
+
+    std::vector<uint64_t>& cur = m_gen[m_cur];
+    if (test(cur, pos)) return true;
+    bool old = test(m_gen[m_cur ^ 1], pos);
+
+    // Into the current generation, so an id still in use is not forgotten
+    for (int k = 0; k < HASHES; k++) cur[pos[k] >> 6] |= 1ull << (pos[k] & 63);
+    if (++m_count >= m_per_gen) {
+        m_cur ^= 1;
+        std::fill(m_gen[m_cur].begin(), m_gen[m_cur].end(), 0);
+        m_count = 0;
+    }
+    return old;
+}
+
+} // namespace mesh_route
+} // namespace vos
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "vos/types.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace vos {
+namespace mesh_route {
+
+/*
+ * Multi-hop delivery for MeshNet: a distance-vector routing table, the
+ * RELAY framing and duplicate suppression for relayed messages.
+ *
+ *   ROUTE (sealed):  [COUNT:2] then COUNT x [METRIC:1][LEN:1][ID:LEN]
+ *   RELAY:           [TTL:1][HOPS:1][MSG:8][LEN:1][DEST:LEN] then a sealed
+ *                    record of [LEN:1][SRC:LEN][TYPE:1][BODY]
+ *
+ * Every instance sends its vector (itself at 0, its neighbours at 1, what
+ * it has learned beyond them) to each neighbour: periodically, and at once
+ * when it changes. Routes learned through a neighbour are sent back to it
+ * as unreachable (split horizon with poisoned reverse), and METRIC_INFINITY
+ * bounds counting to infinity, as in RIP.
+ *
+ * The RELAY prefix stays in the clear so relays can route without opening
+ * the record: they decrement TTL and increment HOPS where the datagram
+ * lies and send it on. The source id is sealed with the body, and the
+ * rest of the prefix is bound to the seal as associated data: MSG and
+ * DEST as they are, and TTL + HOPS, which every hop leaves unchanged. So
+ * the destination drops a copy whose id or destination was rewritten, or
+ * whose TTL was raised on the way.
+ */
+
+constexpr uint8_t METRIC_INFINITY = 16;
+constexpr size_t  RELAY_FIXED     = 11;   // relay header without DEST
+constexpr size_t  MAX_ID          = 255;
+constexpr size_t  RELAY_AAD_MAX   = 10 + MAX_ID;
+
+struct Entry {
+    std::string dest;
+    uint8_t     metric;
+};
+
+struct Route {
+    std::string next_hop;
+    uint8_t     metric;      // hops; METRIC_INFINITY = withdrawn
+    TimePoint   refreshed;   // last advert that confirmed it, or when it was withdrawn
+};
+
+// Routes learned from neighbours' vectors. Direct neighbours are not kept
+// here: the caller's peer table is their source of truth. Not thread-safe.
+class RouteTable {
+public:
+    // Take in `neighbour`'s vector. True if a route appeared, changed
+    // metric or next hop, or was withdrawn.
+    bool update(const std::string& self, const std::string& neighbour,
+                const std::vector<Entry>& vec, TimePoint now);
+    // Withdraw every route through `neighbour` (it left or went stale)
+    bool neighbour_down(const std::string& neighbour, TimePoint now);
+    // Withdraw routes no advert confirmed for `timeout`; forget withdrawn
+    // ones after another `timeout`, once the withdrawal has been passed on
+    bool expire(TimePoint now, Duration timeout);
+
+    // nullptr when `dest` is unknown or unreachable
+    const Route* find(const std::string& dest) const;
+    const std::unordered_map<std::string, Route>& routes() const { return m_routes; }
+
+private:
+    std::unordered_map<std::string, Route> m_routes;
+};
+
+// Encode entries from `first` until `max_bytes` would be exceeded; returns
+// the index of the first entry left out (vec.size() when all fit)
+size_t encode_vector(const std::vector<Entry>& vec, size_t first, size_t max_bytes, ByteBuffer& out);
+bool   decode_vector(ConstByteSpan data, std::vector<Entry>& out);
+
+struct RelayHeader {
+    uint8_t       ttl  = 0;
+    uint8_t       hops = 0;
+    uint64_t      msg  = 0;
+    ConstByteSpan dest;
+    size_t        size = 0;   // bytes the header takes
+};
+
+inline size_t relay_header_size(const std::string& dest) { return RELAY_FIXED + dest.size(); }
+// Write at `out`, which has relay_header_size(dest) bytes
+void write_relay_header(uint8_t* out, uint8_t ttl, uint64_t msg, const std::string& dest);
+// False if malformed, or if TTL + HOPS is more than any sender sets
+bool parse_relay_header(ConstByteSpan data, RelayHeader& out);
+// Associated data for the sealed record, [TTL+HOPS:1][MSG:8][LEN:1][DEST],
+// written at `out` (RELAY_AAD_MAX bytes); returns its length
+size_t relay_aad(const RelayHeader& hdr, uint8_t* out);
+
+/*
+ * Recently seen message ids, for dropping relayed copies that come round
+ * again. Two Bloom filter generations of 2^bits_log2 bits: ids go into the
+ * current one, and after `per_generation` ids the older is cleared and
+ * takes over as current. So an id is remembered for between one and two
+ * generations, in fixed memory, with a false positive rate of about
+ * 0.5% at the defaults. Not thread-safe.
+ */
+class DupFilter {
+public:
+    explicit DupFilter(size_t bits_log2 = 16, size_t per_generation = 4096);
+
+    // True if `id` was (probably) seen before; records it either way
+    bool seen(uint64_t id);
+    // The same answer without recording it
+    bool contains(uint64_t id) const;
+
+private:
+    static constexpr int HASHES = 4;
+
+    void positions(uint64_t id, size_t* pos) const;
+    bool test(const std::vector<uint64_t>& gen, const size_t* pos) const;
+
+    std::vector<uint64_t> m_gen[2];
+    size_t                m_cur   = 0;
+    size_t                m_count = 0;
+    size_t                m_mask;
+    size_t                m_per_gen;
+};
+
+} // namespace mesh_route
+} // namespace vos
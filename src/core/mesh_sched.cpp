@@ -0,0 +1,202 @@
+#include "mesh_sched.h"
+#include <algorithm>
+
+namespace vos {
+namespace mesh_sched {
+
+// ─── TokenBucket ─────────────────────────────────────────────
+
+void TokenBucket::set(double bytes_per_sec, size_t burst, TimePoint now) {
+    m_rate   = std::max(bytes_per_sec, 0.0);
+    m_burst  = (double)burst;
+    m_tokens = m_burst;
+    m_last   = now;
+}
+
+void TokenBucket::refill(TimePoint now) {
+    if (m_rate <= 0 || now <= m_last) return;
+    m_tokens = std::min(m_burst, m_tokens + m_rate * std::chrono::duration<double>(now - m_last).count());
+    m_last   = now;
+}
+
+TimePoint TokenBucket::ready_at() const {
+    if (ready()) return m_last;
+    auto debt = std::chrono::duration<double>(-m_tokens / m_rate);
+    return m_last + std::chrono::duration_cast<Duration>(debt) + Duration(1);
+}
+
+// ─── DelayStats ──────────────────────────────────────────────
+
+void DelayStats::add(uint64_t us) {
+    size_t k = 0;
+    while (k + 1 < BUCKETS && (1ull << k) <= us) k++;
+    m_buckets[k]++;
+    m_count++;
+    m_total_us += us;
+    m_max_us    = std::max(m_max_us, us);
+}
+
+uint64_t DelayStats::p99_us() const {
+    uint64_t seen = 0, rank = m_count - m_count / 100;
+    for (size_t k = 0; k < BUCKETS && m_count; k++) {
+        seen += m_buckets[k];
+        if (seen >= rank) return std::min<uint64_t>(1ull << k, m_max_us);
+    }
+    return 0;
+}
+
+// ─── SendScheduler ───────────────────────────────────────────
+
+SendScheduler::SendScheduler(size_t quantum) : m_quantum(std::max<size_t>(quantum, 1)) {
+    m_free.reserve(POOL_MAX);
+}
+
+ByteBuffer SendScheduler::take(size_t len) {
+    ByteBuffer b;
+    if (!m_free.empty()) {
+        b = std::move(m_free.back());
+        m_free.pop_back();
+    }
+    b.resize(len);
+    return b;
+}
+
+void SendScheduler::recycle(ByteBuffer&& data) {
+    if (m_free.size() < POOL_MAX && data.capacity() > 0) m_free.push_back(std::move(data));
+}
+
+void SendScheduler::set_limits(double peer_rate, double total_rate, size_t burst, TimePoint now) {
+    m_peer_rate = peer_rate;
+    m_burst     = burst;
+    m_total.set(total_rate, burst, now);
+    for (auto& kv : m_flows) kv.second.bucket.set(peer_rate, burst, now);
+}
+
+SendScheduler::Flow& SendScheduler::flow(const MeshAddr& to, TimePoint now) {
+    auto it = m_flows.find(to);
+    if (it != m_flows.end()) return it->second;
+    Flow& f = m_flows[to];
+    f.bucket.set(m_peer_rate, m_burst, now);
+    return f;
+}
+
+void SendScheduler::push(const MeshAddr& to, Class cls, ByteBuffer data, TimePoint now) {
+    size_t c = (size_t)cls;
+    Flow&  f = flow(to, now);
+    f.bytes[c] += data.size();
+    f.queue[c].push_back(Packet{to, std::move(data), now});
+    if (!f.active[c]) {
+        f.active[c] = true;
+        m_active[c].push_back(&f);
+    }
+    m_packets++;
+}
+
+bool SendScheduler::pop_class(size_t c, TimePoint now, Packet& out) {
+    auto&  ring    = m_active[c];
+    size_t blocked = 0;   // over-rate peers passed in a row
+    while (blocked < ring.size()) {
+        Flow& f = *ring.front();
+        f.bucket.refill(now);
+        if (!f.bucket.ready()) {
+            // Sits this turn out, banking nothing
+            f.turn[c] = false;
+            Flow* next = ring.front();
+            ring.pop_front();
+            ring.push_back(std::move(next));
+            blocked++;
+            continue;
+        }
+        blocked = 0;
+
+        size_t len = f.queue[c].front().data.size();
+        if (!f.turn[c]) {
+            f.deficit[c] += m_quantum;
+            f.turn[c]     = true;
+        }
+        if (f.deficit[c] < len) {
+            // Not enough yet: the credit carries to its next turn
+            f.turn[c] = false;
+            Flow* next = ring.front();
+            ring.pop_front();
+            ring.push_back(std::move(next));
+            continue;
+        }
+
+        f.deficit[c] -= len;
+        f.bytes[c]   -= len;
+        f.bucket.charge(len);
+        m_total.charge(len);
+        out = std::move(f.queue[c].front());
+        f.queue[c].pop_front();
+        m_packets--;
+        m_delay[c].add(now > out.queued ? (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+                                              now - out.queued).count()
+                                        : 0);
+        if (f.queue[c].empty()) {
+            // An idle peer keeps no credit
+            f.deficit[c] = 0;
+            f.turn[c]    = false;
+            f.active[c]  = false;
+            ring.pop_front();
+        }
+        return true;
+    }
+    return false;
+}
+
+bool SendScheduler::pop(TimePoint now, Packet& out) {
+    if (m_packets == 0) return false;
+    m_total.refill(now);
+    if (!m_total.ready()) return false;
+    for (size_t c = 0; c < CLASSES; c++) {
+        if (pop_class(c, now, out)) return true;
+    }
+    return false;
+}
+
+bool SendScheduler::bypass(const MeshAddr& to, size_t bytes, TimePoint now) {
+    if (!m_active[(size_t)Class::INTERACTIVE].empty()) return false;
+    Flow& f = flow(to, now);
+    if (f.active[0] || f.active[1]) return false;
+    m_total.refill(now);
+    f.bucket.refill(now);
+    if (!m_total.ready() || !f.bucket.ready()) return false;
+    m_total.charge(bytes);
+    f.bucket.charge(bytes);
+    m_delay[(size_t)Class::INTERACTIVE].add(0);
+    return true;
+}
+
+TimePoint SendScheduler::next_ready() const {
+    if (m_packets == 0) return TimePoint{};
+    TimePoint at = TimePoint::max();
+    for (size_t c = 0; c < CLASSES; c++) {
+        const auto& ring = m_active[c];
+        for (size_t i = 0; i < ring.size(); i++) at = std::min(at, ring.at(i)->bucket.ready_at());
+    }
+    return std::max(at, m_total.ready_at());
+}
+
+size_t SendScheduler::queued_bytes(const MeshAddr& to, Class cls) const {
+    auto it = m_flows.find(to);
+    return it == m_flows.end() ? 0 : it->second.bytes[(size_t)cls];
+}
+
+void SendScheduler::clear() {
+    m_flows.clear();
+    for (auto& ring : m_active) ring.clear();
+    m_packets = 0;
+}
+
+void SendScheduler::trim(TimePoint now) {
+    for (auto it = m_flows.begin(); it != m_flows.end();) {
+        Flow& f = it->second;
+        f.bucket.refill(now);
+        if (!f.active[0] && !f.active[1] && f.bucket.full()) it = m_flows.erase(it);
+        else ++it;
+    }
+}
+
+} // namespace mesh_sched
+} // namespace vos
@@ -0,0 +1,185 @@
+#pragma once
+
+#include "vos/types.h"
+#include "mesh_addr.h"
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+namespace vos {
+namespace mesh_sched {
+
+/*
+ * Outbound queues for MeshNet: one per destination, served by deficit
+ * round-robin (Shreedhar & Varghese) so peers share the uplink byte for
+ * byte whatever their datagram sizes, behind token buckets that cap the
+ * rate to each peer and the total.
+ *
+ * Each destination has two classes. INTERACTIVE (messages and control
+ * traffic) goes before BULK (file chunks) across all peers, so a chat
+ * line waits for the datagrams already on their way to the socket, never
+ * for a file's backlog. Within a class the peers take turns, a quantum of
+ * bytes each.
+ *
+ * Datagrams are built in buffers the scheduler lends out (take()) and
+ * come back to it once sent (recycle()), so a steady stream of file
+ * chunks allocates nothing: each is sealed straight into a pooled buffer,
+ * queued as it is and handed to the socket from there.
+ *
+ * Not thread-safe.
+ */
+
+enum class Class : uint8_t { INTERACTIVE, BULK };
+constexpr size_t CLASSES = 2;
+
+/*
+ * Rate limit that never waits: ready() says whether a datagram may go now
+ * and charge() pays for it. The bucket may go one datagram into debt, so
+ * one larger than the burst still goes; the debt holds back the next.
+ */
+class TokenBucket {
+public:
+    // 0 bytes per second = unlimited. Starts full.
+    void set(double bytes_per_sec, size_t burst, TimePoint now);
+
+    void refill(TimePoint now);
+    bool ready() const { return m_rate <= 0 || m_tokens >= 0; }
+    void charge(size_t bytes) { if (m_rate > 0) m_tokens -= (double)bytes; }
+    bool full() const { return m_rate <= 0 || m_tokens >= m_burst; }
+    // When ready() turns true, counted from the last refill
+    TimePoint ready_at() const;
+
+    double rate() const { return m_rate; }
+
+private:
+    double    m_rate   = 0;
+    double    m_burst  = 0;
+    double    m_tokens = 0;
+    TimePoint m_last{};
+};
+
+// Queueing delays: average, maximum and a 99th percentile from
+// power-of-two buckets (an upper bound, as in CallbackQueue)
+class DelayStats {
+public:
+    void add(uint64_t us);
+
+    uint64_t count()  const { return m_count; }
+    uint64_t avg_us() const { return m_count ? m_total_us / m_count : 0; }
+    uint64_t p99_us() const;
+    uint64_t max_us() const { return m_max_us; }
+
+private:
+    static constexpr size_t BUCKETS = 32;   // bucket k: delays below 2^k µs
+
+    uint64_t m_count    = 0;
+    uint64_t m_total_us = 0;
+    uint64_t m_max_us   = 0;
+    uint64_t m_buckets[BUCKETS]{};
+};
+
+struct Packet {
+    MeshAddr   to;
+    ByteBuffer data;
+    TimePoint  queued;
+};
+
+// FIFO that keeps its storage: a ring over a vector that only grows,
+// where std::deque would allocate and free blocks as it cycles
+template<typename T>
+class Ring {
+public:
+    void push_back(T&& v) {
+        if (m_count == m_ring.size()) {
+            std::vector<T> grown(std::max<size_t>(m_ring.size() * 2, 16));
+            for (size_t i = 0; i < m_count; i++) grown[i] = std::move(at(i));
+            m_ring.swap(grown);
+            m_head = 0;
+        }
+        m_ring[(m_head + m_count++) % m_ring.size()] = std::move(v);
+    }
+    void pop_front() {
+        m_ring[m_head] = T();
+        m_head = (m_head + 1) % m_ring.size();
+        m_count--;
+    }
+    T&       front()              { return m_ring[m_head]; }
+    T&       at(size_t i)         { return m_ring[(m_head + i) % m_ring.size()]; }
+    const T& at(size_t i) const   { return m_ring[(m_head + i) % m_ring.size()]; }
+    bool     empty() const        { return m_count == 0; }
+    size_t   size()  const        { return m_count; }
+    void     clear()              { while (m_count) pop_front(); }
+
+private:
+    std::vector<T> m_ring;
+    size_t         m_head  = 0;
+    size_t         m_count = 0;
+};
+
+class SendScheduler {
+public:
+    // `quantum`: bytes a peer may send per turn; at least one datagram's
+    // worth keeps a turn to one pass
+    explicit SendScheduler(size_t quantum = 9000);
+
+    // Bytes per second, 0 = unlimited; `burst` is each bucket's depth
+    void set_limits(double peer_rate, double total_rate, size_t burst, TimePoint now);
+
+    void push(const MeshAddr& to, Class cls, ByteBuffer data, TimePoint now);
+    // The next datagram the buckets allow now, interactive first. False if
+    // the queues are empty or everything queued is over its rate; then
+    // try again at next_ready().
+    bool pop(TimePoint now, Packet& out);
+    // Whether a small datagram for `to` may skip the queues: nothing
+    // interactive is waiting anywhere, nothing at all for `to`, and the
+    // buckets have room. If so it is charged and counted as not delayed.
+    bool bypass(const MeshAddr& to, size_t bytes, TimePoint now);
+
+    // When a queued datagram may go; TimePoint{} if nothing is queued
+    TimePoint next_ready() const;
+    size_t    queued_bytes(const MeshAddr& to, Class cls) const;
+    size_t    packets() const { return m_packets; }
+    bool      empty()   const { return m_packets == 0; }
+    // Drop everything queued; the delay statistics stay
+    void      clear();
+    // Forget destinations with nothing queued and full buckets
+    void      trim(TimePoint now);
+    size_t    destinations() const { return m_flows.size(); }
+
+    const DelayStats& delay(Class cls) const { return m_delay[(size_t)cls]; }
+
+    // A `len`-byte buffer for a datagram, recycled when one is free
+    ByteBuffer take(size_t len);
+    // Give a sent (or dropped) datagram's buffer back for reuse
+    void       recycle(ByteBuffer&& data);
+    size_t     pooled() const { return m_free.size(); }
+
+private:
+    static constexpr size_t POOL_MAX = 256;   // buffers kept free at most
+
+    struct Flow {
+        Ring<Packet>       queue[CLASSES];
+        size_t             bytes[CLASSES]{};
+        size_t             deficit[CLASSES]{};
+        bool               active[CLASSES]{};   // in m_active
+        bool               turn[CLASSES]{};     // this visit's quantum is granted
+        TokenBucket        bucket;
+    };
+
+    Flow& flow(const MeshAddr& to, TimePoint now);
+    bool  pop_class(size_t c, TimePoint now, Packet& out);
+
+    size_t      m_quantum;
+    double      m_peer_rate = 0;
+    size_t      m_burst     = 64 * 1024;
+    TokenBucket m_total;
+    // Nodes never move, so the rotations can hold pointers
+    std::unordered_map<MeshAddr, Flow, MeshAddrHash> m_flows;
+    Ring<Flow*>                                      m_active[CLASSES];
+    size_t                                           m_packets = 0;
+    DelayStats                                       m_delay[CLASSES];
+    std::vector<ByteBuffer>                          m_free;
+};
+
+} // namespace mesh_sched
+} // namespace vos
@@ -0,0 +1,348 @@
+#include "mesh_transfer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace vos {
+namespace mesh_xfer {
+
+uint32_t now_us() {
+    return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+        Clock::now().time_since_epoch()).count();
+}
+
+// ─── RttEstimator ────────────────────────────────────────────
+
+void RttEstimator::sample(double r) {
+    if (srtt == 0) {
+        srtt   = r;
+        rttvar = r / 2;
+    } else {
+        rttvar = 0.75 * rttvar + 0.25 * std::fabs(srtt - r);
+        srtt   = 0.875 * srtt + 0.125 * r;
+    }
+    rto = std::min(RTO_MAX, std::max(RTO_MIN, srtt + std::max(1000.0, 4 * rttvar)));
+}
+
+// ─── SendWindow ──────────────────────────────────────────────
+
+SendWindow::SendWindow(uint32_t nchunks)
+    : m_n(nchunks), m_state(nchunks, UNSENT), m_sent_at(nchunks, 0), m_txseq(nchunks, 0) {}
+
+size_t SendWindow::next_batch(uint32_t* out, size_t max, uint32_t now) {
+    size_t budget = m_cwnd > m_inflight ? (size_t)m_cwnd - m_inflight : 0;
+    budget = std::min(budget, max);
+    size_t n = 0;
+
+    auto send = [&](uint32_t i) {
+        m_state[i]   = IN_FLIGHT;
+        m_sent_at[i] = now;
+        m_txseq[i]   = ++m_txseq_counter;
+        m_inflight++;
+        m_transmissions++;
+        out[n++] = i;
+    };
+
+    // Repairs first: they are what holds the cumulative ack back
+    for (uint32_t i = m_cum; m_lost > 0 && n < budget && i < m_next; i++) {
+        if (m_state[i] != LOST) continue;
+        m_lost--;
+        m_retransmits++;
+        send(i);
+    }
+    uint32_t limit = (uint32_t)std::min<uint64_t>(m_n, (uint64_t)m_cum + WINDOW);
+    while (n < budget && m_next < limit) send(m_next++);
+    if (n > 0) m_last_event = now;
+    return n;
+}
+
+void SendWindow::ack_chunk(uint32_t i, size_t& newly) {
+    uint8_t s = m_state[i];
+    if (s == ACKED) return;
+    if (s == IN_FLIGHT) m_inflight--;
+    if (s == LOST)      m_lost--;
+    if (s == UNSENT)    return; // an ACK can never cover what was not sent
+    m_state[i] = ACKED;
+    m_high_acked_txseq = std::max(m_high_acked_txseq, m_txseq[i]);
+    m_acked++;
+    newly++;
+}
+
+size_t SendWindow::on_ack(uint32_t cum, const uint8_t* sack, size_t sack_len,
+                          uint32_t ts_echo, uint32_t now) {
+    size_t newly = 0;
+    cum = std::min(cum, m_n);
+    for (uint32_t i = m_cum; i < cum; i++) ack_chunk(i, newly);
+    sack_len = std::min(sack_len, SACK_BYTES);
+    for (size_t k = 0; k < sack_len * 8; k++) {
+        uint64_t i = (uint64_t)cum + 1 + k;
+        if (i >= m_n) break;
+        if (sack[k / 8] & (1u << (k % 8))) ack_chunk((uint32_t)i, newly);
+    }
+    while (m_cum < m_n && m_state[m_cum] == ACKED) m_cum++;
+
+    if (ts_echo != 0) m_rtt.sample((double)(uint32_t)(now - ts_echo));
+    m_last_event = now;
+    if (newly == 0) return 0;
+    m_consecutive_rtos = 0;
+    m_probe_armed      = true;
+
+    // Slow start, then about one chunk per window
+    if (m_cwnd < m_ssthresh) m_cwnd += (double)newly;
+    else                     m_cwnd += (double)newly / m_cwnd;
+    m_cwnd = std::min(m_cwnd, (double)WINDOW);
+
+    // Chunks sent DUP_THRESH transmissions before the newest acked one
+    // and still unacked are taken as lost
+    if (m_high_acked_txseq > (uint64_t)DUP_THRESH) {
+        uint64_t cutoff  = m_high_acked_txseq - DUP_THRESH;
+        bool     episode = false;
+        for (uint32_t i = m_cum; i < m_next; i++) {
+            if (m_state[i] != IN_FLIGHT || m_txseq[i] > cutoff) continue;
+            m_state[i] = LOST;
+            m_inflight--;
+            m_lost++;
+            if (m_txseq[i] > m_recovery_txseq) episode = true;
+        }
+        if (episode) {
+            m_ssthresh       = std::max(m_cwnd / 2, 2.0);
+            m_cwnd           = m_ssthresh;
+            m_recovery_txseq = m_txseq_counter;
+        }
+    }
+    return newly;
+}
+
+uint32_t SendWindow::oldest_age(uint32_t now) const {
+    uint32_t age = 0;
+    for (uint32_t i = m_cum; i < m_next; i++) {
+        if (m_state[i] == IN_FLIGHT) age = std::max(age, (uint32_t)(now - m_sent_at[i]));
+    }
+    return age;
+}
+
+double SendWindow::pto() const {
+    return std::min(m_rtt.rto, std::max(PTO_MIN, 2 * m_rtt.srtt));
+}
+
+bool SendWindow::check_timeout(uint32_t now) {
+    if (m_inflight == 0) return false;
+
+    // Tail-loss probe: hand the newest chunk in flight back to next_batch
+    if (m_probe_armed && m_rtt.srtt > 0 && (uint32_t)(now - m_last_event) >= (uint32_t)pto()) {
+        uint32_t newest = m_next;
+        for (uint32_t i = m_cum; i < m_next; i++) {
+            if (m_state[i] == IN_FLIGHT && (newest == m_next || m_txseq[i] > m_txseq[newest])) newest = i;
+        }
+        m_state[newest] = LOST;
+        m_inflight--;
+        m_lost++;
+        m_probes++;
+        m_probe_armed = false;
+        m_last_event  = now;
+        return false;
+    }
+
+    if (oldest_age(now) < (uint32_t)m_rtt.rto) return false;
+
+    for (uint32_t i = m_cum; i < m_next; i++) {
+        if (m_state[i] != IN_FLIGHT) continue;
+        m_state[i] = LOST;
+        m_lost++;
+    }
+    m_ssthresh       = std::max((double)m_inflight / 2, 2.0);
+    m_cwnd           = 1;
+    m_inflight       = 0;
+    m_recovery_txseq = m_txseq_counter;
+    m_rtt.backoff();
+    m_probe_armed    = true;
+    m_timeouts++;
+    m_consecutive_rtos++;
+    return true;
+}
+
+uint32_t SendWindow::next_deadline(uint32_t now) const {
+    uint32_t rto = (uint32_t)m_rtt.rto;
+    if (m_inflight == 0) return rto;
+    uint32_t age      = oldest_age(now);
+    uint32_t deadline = age >= rto ? 0 : rto - age;
+    if (m_probe_armed && m_rtt.srtt > 0) {
+        uint32_t quiet = now - m_last_event, p = (uint32_t)pto();
+        deadline = std::min(deadline, quiet >= p ? 0 : p - quiet);
+    }
+    return deadline;
+}
+
+// ─── RecvWindow ──────────────────────────────────────────────
+
+RecvWindow::RecvWindow(uint32_t nchunks) : m_n(nchunks), m_have(nchunks, 0) {}
+
+bool RecvWindow::mark(uint32_t index) {
+    if (index >= m_n || m_have[index]) return false;
+    if ((uint64_t)index >= (uint64_t)m_cum + WINDOW) return false;
+    m_have[index] = 1;
+    m_count++;
+    while (m_cum < m_n && m_have[m_cum]) m_cum++;
+    return true;
+}
+
+size_t RecvWindow::sack(uint8_t* out) const {
+    std::memset(out, 0, SACK_BYTES);
+    size_t len = 0;
+    for (size_t k = 0; k < WINDOW; k++) {
+        uint64_t i = (uint64_t)m_cum + 1 + k;
+        if (i >= m_n) break;
+        if (m_have[i]) {
+            out[k / 8] |= (uint8_t)(1u << (k % 8));
+            len = k / 8 + 1;
+        }
+    }
+    return len;
+}
+
+// ─── PullScheduler ───────────────────────────────────────────
+
+PullScheduler::PullScheduler(uint32_t nchunks, size_t nsources)
+    : m_n(nchunks), m_have(nchunks, 0), m_owner(nchunks, NONE), m_req_at(nchunks, 0),
+      m_src(nsources) {
+    for (size_t s = 0; s < nsources; s++) {
+        m_src[s].cursor = (uint32_t)((uint64_t)nchunks * s / nsources);
+        m_src[s].end    = (uint32_t)((uint64_t)nchunks * (s + 1) / nsources);
+    }
+}
+
+void PullScheduler::mark_have(uint32_t index) {
+    if (index >= m_n || m_have[index]) return;
+    m_have[index] = 1;
+    m_have_count++;
+}
+
+bool PullScheduler::any_alive() const {
+    for (const Source& s : m_src) if (s.alive) return true;
+    return false;
+}
+
+bool PullScheduler::steal(size_t src) {
+    size_t   victim = NONE;
+    uint32_t most   = 0;
+    for (size_t v = 0; v < m_src.size(); v++) {
+        if (v == src) continue;
+        uint32_t left = m_src[v].end - m_src[v].cursor;
+        if (left > most) { most = left; victim = v; }
+    }
+    if (victim == NONE) return false;
+    Source&  v   = m_src[victim];
+    uint32_t mid = v.cursor + most / 2;
+    m_src[src].cursor = mid;
+    m_src[src].end    = v.end;
+    v.end             = mid;
+    return true;
+}
+
+size_t PullScheduler::next_requests(size_t src, uint32_t* out, size_t max, uint32_t now) {
+    Source& s = m_src[src];
+    if (!s.alive) return 0;
+    size_t budget = s.win > s.inflight ? (size_t)s.win - s.inflight : 0;
+    budget = std::min(budget, max);
+
+    size_t n = 0;
+    while (n < budget) {
+        uint32_t i;
+        if (!m_retry.empty()) {
+            i = m_retry.back();
+            m_retry.pop_back();
+            if (m_have[i] || m_owner[i] != NONE) continue;
+        } else {
+            while (s.cursor < s.end && (m_have[s.cursor] || m_owner[s.cursor] != NONE)) s.cursor++;
+            if (s.cursor == s.end) {
+                if (!steal(src)) break;
+                continue;
+            }
+            i = s.cursor++;
+        }
+        m_owner[i]  = (uint32_t)src;
+        m_req_at[i] = now;
+        s.queue.push_back({i, now});
+        s.inflight++;
+        out[n++] = i;
+    }
+    return n;
+}
+
+bool PullScheduler::on_chunk(size_t src, uint32_t index, uint32_t ts_echo, uint32_t now) {
+    if (index >= m_n || m_have[index]) return false;
+    m_have[index] = 1;
+    m_have_count++;
+    if (m_owner[index] != NONE) m_src[m_owner[index]].inflight--;
+    m_owner[index] = NONE;
+
+    Source& s = m_src[src];
+    s.received++;
+    s.silent = 0;
+    if (ts_echo != 0) {
+        s.rtt.sample((double)(uint32_t)(now - ts_echo));
+    }
+    if (s.win < s.ssthresh) s.win += 1;
+    else                    s.win += 1 / s.win;
+    s.win = std::min(s.win, MAX_WINDOW);
+    return true;
+}
+
+void PullScheduler::release(Source& s, uint32_t index) {
+    m_owner[index] = NONE;
+    s.inflight--;
+    m_retry.push_back(index);
+}
+
+void PullScheduler::check_timeouts(uint32_t now) {
+    for (size_t src = 0; src < m_src.size(); src++) {
+        Source& s   = m_src[src];
+        bool    cut = false;
+        while (s.head < s.queue.size()) {
+            const Request& r = s.queue[s.head];
+            if (live(src, r)) {
+                if ((uint32_t)(now - r.at) < (uint32_t)s.rtt.rto) break;
+                release(s, r.index);
+                cut = true;
+            }
+            s.head++;
+        }
+        // Compact the served prefix now and then
+        if (s.head > 1024 && s.head * 2 > s.queue.size()) {
+            s.queue.erase(s.queue.begin(), s.queue.begin() + (ptrdiff_t)s.head);
+            s.head = 0;
+        }
+        if (!cut) continue;
+        s.ssthresh = std::max(s.win / 2, 1.0);
+        s.win      = s.ssthresh;
+        s.rtt.backoff();
+        s.timeouts++;
+        if (++s.silent >= SILENT_LIMIT) drop_source(src);
+    }
+}
+
+uint32_t PullScheduler::next_deadline(uint32_t now) const {
+    uint32_t best = (uint32_t)SendWindow::RTO_MAX;
+    for (size_t src = 0; src < m_src.size(); src++) {
+        const Source& s = m_src[src];
+        if (!s.alive || s.head >= s.queue.size()) continue;
+        uint32_t age = now - s.queue[s.head].at;
+        uint32_t rto = (uint32_t)s.rtt.rto;
+        best = std::min(best, age >= rto ? 0 : rto - age);
+    }
+    return best;
+}
+
+void PullScheduler::drop_source(size_t src) {
+    Source& s = m_src[src];
+    s.alive = false;
+    for (size_t k = s.head; k < s.queue.size(); k++) {
+        if (live(src, s.queue[k])) release(s, s.queue[k].index);
+    }
+    s.queue.clear();
+    s.head = 0;
+    // Its stripe stays, for the others to take over
+}
+
+} // namespace mesh_xfer
+} // namespace vos
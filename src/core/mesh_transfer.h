@@ -0,0 +1,333 @@
+#pragma once
+
+#include "vos/types.h"
+#include "mesh_addr.h"
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace vos {
+namespace mesh_xfer {
+
+/*
+ * Reliable file transfer over FILE_META / FILE_CHUNK / FILE_ACK, and
+ * multi-source downloads over FILE_REQ. Every payload is a sealed
+ * CryptoSession record; the layouts below are the plaintext inside it.
+ *
+ *   FILE_META:  [XFER:4][TS:4][SIZE:8][CHUNK_SIZE:4][SHA256:32][NAME:N]
+ *   FILE_CHUNK: [XFER:4][INDEX:4][TS:4][DATA:N]    DATA at INDEX * CHUNK_SIZE
+ *   FILE_ACK:   [XFER:4][CUM:4][TS_ECHO:4][SACK:N]
+ *   FILE_REQ:   [XFER:4][TS:4][NAME_LEN:2][COUNT:2][NAME][INDEX:4 x COUNT]
+ *
+ * Push (send_file): the sender offers META and streams chunks; CUM is the
+ * number of chunks received contiguously from index 0, bit k of SACK (LSB
+ * first) reports chunk CUM+1+k, and TS_ECHO returns the sender's
+ * microsecond clock for RTT samples. An ACK with CUM 0 doubles as the META
+ * acknowledgement. The sender keeps at most WINDOW chunks past CUM
+ * outstanding, so a SACK never exceeds SACK_BYTES.
+ *
+ * Pull (download_file): the downloader sends FILE_REQ with COUNT 0 to ask
+ * for META (CHUNK_SIZE 0 in the reply means "not here"), then FILE_REQs
+ * listing the chunks it wants; the source answers each with FILE_CHUNK
+ * carrying the request's TS. Sources keep no per-transfer state.
+ */
+
+constexpr size_t   META_FIXED  = 52;
+constexpr size_t   CHUNK_FIXED = 12;
+constexpr size_t   ACK_FIXED   = 12;
+constexpr size_t   REQ_FIXED   = 12;
+constexpr size_t   REQ_MAX     = 64;    // chunk indices per FILE_REQ
+constexpr size_t   DIGEST_SIZE = 32;
+constexpr uint32_t WINDOW      = 1024;
+constexpr size_t   SACK_BYTES  = WINDOW / 8;
+
+// Wrapping microsecond clock used for TS fields and timers
+uint32_t now_us();
+
+// ─── RTT ─────────────────────────────────────────────────────
+/*
+ * RFC 6298 round-trip estimate, in microseconds: SRTT, RTTVAR and the
+ * retransmission timeout they give, doubled by backoff() on a timeout.
+ * Shared by file transfers and peer liveness, so a transfer can start
+ * from what PING/PONG has already measured (seed()).
+ */
+struct RttEstimator {
+    static constexpr double RTO_INITIAL = 250e3;
+    static constexpr double RTO_MIN     = 30e3;
+    static constexpr double RTO_MAX     = 3e6;
+
+    double srtt   = 0;   // 0 until the first sample
+    double rttvar = 0;
+    double rto    = RTO_INITIAL;
+
+    void sample(double r);
+    void seed(const RttEstimator& from) { if (from.srtt > 0) *this = from; }
+    void backoff() { rto = std::min(RTO_MAX, rto * 2); }
+};
+
+// ─── Sender ──────────────────────────────────────────────────
+/*
+ * Per-chunk send state plus congestion control, in chunks:
+ * slow start from an initial window of 10, then additive increase;
+ * a chunk is declared lost once 3 chunks transmitted after it have been
+ * acked (RACK-style, so lost retransmissions are detected too), and the
+ * window halves at most once per loss episode. When the ACKs stop with
+ * chunks still in flight, a tail-loss probe after 2 x SRTT resends the
+ * newest one so its ACK can expose the rest; only if that fails too does
+ * the retransmission timeout (RFC 6298 SRTT/RTTVAR, exponential backoff)
+ * mark everything in flight lost and restart from a window of 1.
+ */
+class SendWindow {
+public:
+    static constexpr double INITIAL_CWND = 10;
+    static constexpr double RTO_INITIAL  = RttEstimator::RTO_INITIAL;   // microseconds
+    static constexpr double RTO_MIN      = RttEstimator::RTO_MIN;
+    static constexpr double RTO_MAX      = RttEstimator::RTO_MAX;
+    static constexpr double PTO_MIN      = 2e3;
+    static constexpr int    DUP_THRESH   = 3;
+
+    explicit SendWindow(uint32_t nchunks);
+
+    // Choose up to `max` chunks to transmit now — lost ones first, then
+    // new ones — as far as the congestion and receive windows allow.
+    // They are marked in flight with send time `now`.
+    size_t next_batch(uint32_t* out, size_t max, uint32_t now);
+
+    // Apply an ACK. Returns the number of chunks it newly acknowledged.
+    size_t on_ack(uint32_t cum, const uint8_t* sack, size_t sack_len,
+                  uint32_t ts_echo, uint32_t now);
+
+    // Run the timers: send a tail-loss probe if the ACKs have gone quiet,
+    // and fire the retransmission timeout if the oldest chunk in flight is
+    // overdue. Returns true if the timeout fired.
+    bool check_timeout(uint32_t now);
+
+    // Microseconds until check_timeout() has something to do
+    uint32_t next_deadline(uint32_t now) const;
+
+    bool     done()      const { return m_acked == m_n; }
+    uint32_t chunks()    const { return m_n; }
+    uint32_t acked()     const { return m_acked; }
+    uint32_t in_flight() const { return m_inflight; }
+    double   cwnd()      const { return m_cwnd; }
+    double   ssthresh()  const { return m_ssthresh; }
+    double   srtt_us()   const { return m_rtt.srtt; }
+    double   rto_us()    const { return m_rtt.rto; }
+
+    // Start from an RTT measured elsewhere (peer liveness) instead of
+    // RTO_INITIAL; no-op without a sample
+    void seed_rtt(const RttEstimator& rtt) { m_rtt.seed(rtt); }
+
+    uint64_t transmissions()        const { return m_transmissions; }
+    uint64_t retransmits()          const { return m_retransmits; }
+    uint64_t timeouts()             const { return m_timeouts; }
+    uint64_t probes()               const { return m_probes; }
+    int      consecutive_timeouts() const { return m_consecutive_rtos; }
+
+private:
+    enum : uint8_t { UNSENT = 0, IN_FLIGHT, ACKED, LOST };
+
+    void ack_chunk(uint32_t i, size_t& newly);
+    uint32_t oldest_age(uint32_t now) const;
+    double   pto() const;
+
+    uint32_t              m_n;
+    std::vector<uint8_t>  m_state;
+    std::vector<uint32_t> m_sent_at;
+    std::vector<uint64_t> m_txseq;     // transmission order of each chunk's latest send
+
+    uint32_t m_cum{0};          // every chunk below is acked
+    uint32_t m_next{0};         // lowest never-sent chunk
+    uint32_t m_inflight{0};
+    uint32_t m_lost{0};         // chunks waiting for retransmission
+    uint32_t m_acked{0};
+
+    uint64_t m_txseq_counter{0};
+    uint64_t m_high_acked_txseq{0};
+    uint64_t m_recovery_txseq{0};   // losses sent at or before this are the same episode
+
+    double m_cwnd{INITIAL_CWND};
+    double m_ssthresh{(double)WINDOW};
+    RttEstimator m_rtt;
+
+    uint32_t m_last_event{0};   // last send or ACK, for the probe timer
+    bool     m_probe_armed{true};
+
+    uint64_t m_transmissions{0};
+    uint64_t m_retransmits{0};
+    uint64_t m_timeouts{0};
+    uint64_t m_probes{0};
+    int      m_consecutive_rtos{0};
+};
+
+// ─── Receiver ────────────────────────────────────────────────
+class RecvWindow {
+public:
+    explicit RecvWindow(uint32_t nchunks);
+
+    // Record chunk `index`. False for duplicates and for chunks beyond
+    // the window (which the sender never sends).
+    bool mark(uint32_t index);
+
+    bool     has(uint32_t index) const { return index < m_n && m_have[index]; }
+    uint32_t chunks()   const { return m_n; }
+    uint32_t cum()      const { return m_cum; }
+    uint32_t received() const { return m_count; }
+    bool     complete() const { return m_count == m_n; }
+
+    // SACK bitmap after cum(); returns its length in bytes (trailing
+    // zero bytes omitted, at most SACK_BYTES)
+    size_t sack(uint8_t* out) const;
+
+private:
+    uint32_t             m_n;
+    std::vector<uint8_t> m_have;
+    uint32_t             m_cum{0};
+    uint32_t             m_count{0};
+};
+
+// ─── Multi-source download ───────────────────────────────────
+/*
+ * Receiver-driven scheduling for one file pulled from several sources.
+ * The missing chunks start split into one stripe per source; a source
+ * that runs out takes the upper half of the largest stripe left, so faster
+ * sources end up fetching more of the file. Chunks already held (a resumed
+ * download) are never requested.
+ *
+ * Each source has its own request window (slow start, then additive
+ * increase, halved on a timeout) and an RFC 6298 timer fed by the echoed
+ * request timestamps. Overdue chunks go to a retry list any source may
+ * take; a source that times out SILENT_LIMIT times in a row without
+ * delivering anything is dropped.
+ */
+class PullScheduler {
+public:
+    static constexpr double INITIAL_WINDOW = 16;
+    static constexpr double MAX_WINDOW     = 512;
+    static constexpr int    SILENT_LIMIT   = 6;
+
+    PullScheduler(uint32_t nchunks, size_t nsources);
+
+    // Record a chunk that is already on disk; call before requesting
+    void mark_have(uint32_t index);
+
+    // Chunks to request from `src` now, up to its window; marks them requested
+    size_t next_requests(size_t src, uint32_t* out, size_t max, uint32_t now);
+
+    // Chunk `index` arrived from `src`. False for duplicates.
+    bool on_chunk(size_t src, uint32_t index, uint32_t ts_echo, uint32_t now);
+
+    // Release overdue requests for retry
+    void check_timeouts(uint32_t now);
+
+    // Microseconds until check_timeouts() could release something
+    uint32_t next_deadline(uint32_t now) const;
+
+    void drop_source(size_t src);
+    // Start `src` from an RTT measured elsewhere; see SendWindow::seed_rtt
+    void seed_rtt(size_t src, const RttEstimator& rtt) { m_src[src].rtt.seed(rtt); }
+
+    bool     done()          const { return m_have_count == m_n; }
+    bool     has(uint32_t i) const { return i < m_n && m_have[i]; }
+    uint32_t chunks()        const { return m_n; }
+    uint32_t have_count()    const { return m_have_count; }
+    bool     any_alive()     const;
+
+    size_t   sources()             const { return m_src.size(); }
+    bool     alive(size_t src)     const { return m_src[src].alive; }
+    double   window(size_t src)    const { return m_src[src].win; }
+    uint64_t received(size_t src)  const { return m_src[src].received; }
+    uint64_t timeouts(size_t src)  const { return m_src[src].timeouts; }
+
+private:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    struct Request { uint32_t index, at; };
+    struct Source {
+        uint32_t cursor = 0, end = 0;    // own stripe, [cursor, end)
+        double   win = INITIAL_WINDOW, ssthresh = MAX_WINDOW;
+        RttEstimator rtt;
+        uint32_t inflight = 0;
+        int      silent = 0;
+        bool     alive = true;
+        uint64_t received = 0, timeouts = 0;
+        std::vector<Request> queue;      // requests in send order
+        size_t   head = 0;               // first unexpired entry of queue
+    };
+
+    bool steal(size_t src);
+    bool live(size_t src, const Request& r) const {
+        return !m_have[r.index] && m_owner[r.index] == src && m_req_at[r.index] == r.at;
+    }
+    void release(Source& s, uint32_t index);
+
+    uint32_t              m_n;
+    uint32_t              m_have_count{0};
+    std::vector<uint8_t>  m_have;
+    std::vector<uint32_t> m_owner;    // source with the chunk requested, or NONE
+    std::vector<uint32_t> m_req_at;
+    std::vector<uint32_t> m_retry;
+    std::vector<Source>   m_src;
+};
+
+// ─── Transfer records held by MeshNet ────────────────────────
+
+// One send_file() call; lives on the caller's stack
+struct Outgoing {
+    explicit Outgoing(uint32_t nchunks) : window(nchunks) {}
+
+    uint32_t    id = 0;
+    MeshAddr    peer;            // ACKs are accepted only from the destination
+    SendWindow  window;
+    bool        meta_acked = false;
+    uint64_t    events = 0;      // Bumped per ACK so the sender knows to look again
+};
+
+// A file being reassembled into the VFS. Finished transfers are kept for
+// a while so a sender whose last ACK was lost gets re-acknowledged.
+struct Incoming {
+    explicit Incoming(uint32_t nchunks) : window(nchunks) {}
+
+    uint32_t    id = 0;
+    std::string peer_id;
+    MeshAddr    from;            // the sender; ACKs go back here
+    uint64_t    size = 0;
+    uint32_t    chunk_size = 0;
+    std::string part_path;       // written chunk by chunk, renamed when complete
+    std::string final_path;
+    uint8_t     digest[DIGEST_SIZE] = {};
+    RecvWindow  window;
+    uint32_t    ts_echo = 0;
+    bool        ack_pending = false;
+    bool        done = false;
+    TimePoint   last_active{};
+};
+
+// One download_file() call; lives on the caller's stack
+struct Pull {
+    enum class Reply : uint8_t { NONE, HAS_FILE, MISSING, MISMATCH };
+    struct Source {
+        std::string  peer_id;
+        MeshAddr     addr;
+        RttEstimator rtt;            // from liveness probing, if measured
+        Reply        reply = Reply::NONE;
+    };
+
+    uint32_t            id = 0;
+    std::string         name;
+    std::vector<Source> sources;
+
+    // Set by the first source that has the file; the rest must agree
+    bool     have_meta = false;
+    uint64_t size = 0;
+    uint32_t chunk_size = 0;
+    uint8_t  digest[DIGEST_SIZE] = {};
+
+    std::unique_ptr<PullScheduler> sched;   // created once META is in
+    std::string                    part_path;
+    uint64_t                       events = 0;
+};
+
+} // namespace mesh_xfer
+} // namespace vos
@@ -0,0 +1,401 @@
+#include "mesh_uring.h"
+#include "vos/log.h"
+
+#if VOS_HAVE_IO_URING
+
+#include <cerrno>
+#include <cstring>
+#include <arpa/inet.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace vos {
+namespace mesh_io {
+
+static const char* TAG = "MeshIO";
+
+// Provided-buffer group of a UringRecv; one per ring
+static constexpr uint16_t BUF_GROUP = 0;
+// user_data of the multishot receive and of its cancellation
+static constexpr uint64_t RECV_TAG   = 1;
+static constexpr uint64_t CANCEL_TAG = 2;
+
+template<typename T>
+static T* at_offset(void* base, uint32_t off) {
+    return (T*)((uint8_t*)base + off);
+}
+
+// ─── Uring ───────────────────────────────────────────────────
+
+Uring::Uring(unsigned entries, unsigned cq_entries) {
+    io_uring_params p{};
+    if (cq_entries) {
+        p.flags     |= IORING_SETUP_CQSIZE;
+        p.cq_entries = cq_entries;
+    }
+    int fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+    if (fd < 0) return;
+
+    m_sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    m_cq_ring_size = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    bool single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single) m_sq_ring_size = m_cq_ring_size = std::max(m_sq_ring_size, m_cq_ring_size);
+
+    m_sq_ring = mmap(nullptr, m_sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                     fd, IORING_OFF_SQ_RING);
+    m_cq_ring = single ? m_sq_ring
+                       : mmap(nullptr, m_cq_ring_size, PROT_READ | PROT_WRITE,
+                              MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    m_sqes_size = p.sq_entries * sizeof(io_uring_sqe);
+    void* sqes  = mmap(nullptr, m_sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                       fd, IORING_OFF_SQES);
+    if (m_sq_ring == MAP_FAILED || m_cq_ring == MAP_FAILED || sqes == MAP_FAILED) {
+        if (m_sq_ring != MAP_FAILED) munmap(m_sq_ring, m_sq_ring_size);
+        if (!single && m_cq_ring != MAP_FAILED) munmap(m_cq_ring, m_cq_ring_size);
+        if (sqes != MAP_FAILED) munmap(sqes, m_sqes_size);
+        m_sq_ring = m_cq_ring = nullptr;
+        ::close(fd);
+        return;
+    }
+
+    m_sqes       = (io_uring_sqe*)sqes;
+    m_sq_entries = p.sq_entries;
+    m_sq_head    = at_offset<unsigned>(m_sq_ring, p.sq_off.head);
+    m_sq_tail    = at_offset<unsigned>(m_sq_ring, p.sq_off.tail);
+    m_sq_mask    = *at_offset<unsigned>(m_sq_ring, p.sq_off.ring_mask);
+    m_cq_head    = at_offset<unsigned>(m_cq_ring, p.cq_off.head);
+    m_cq_tail    = at_offset<unsigned>(m_cq_ring, p.cq_off.tail);
+    m_cq_mask    = *at_offset<unsigned>(m_cq_ring, p.cq_off.ring_mask);
+    m_cqes       = at_offset<io_uring_cqe>(m_cq_ring, p.cq_off.cqes);
+    m_local_tail = *m_sq_tail;
+
+    // Entries are used in ring order, so the index array is the identity
+    unsigned* array = at_offset<unsigned>(m_sq_ring, p.sq_off.array);
+    for (unsigned i = 0; i < p.sq_entries; i++) array[i] = i;
+    m_fd = fd;
+}
+
+Uring::~Uring() {
+    close();
+}
+
+void Uring::close() {
+    if (m_fd < 0) return;
+    munmap(m_sqes, m_sqes_size);
+    if (m_cq_ring != m_sq_ring) munmap(m_cq_ring, m_cq_ring_size);
+    munmap(m_sq_ring, m_sq_ring_size);
+    ::close(m_fd);
+    m_fd = -1;
+}
+
+io_uring_sqe* Uring::get_sqe() {
+    unsigned head = __atomic_load_n(m_sq_head, __ATOMIC_ACQUIRE);
+    if (m_local_tail - head >= m_sq_entries) return nullptr;
+    io_uring_sqe* sqe = &m_sqes[m_local_tail & m_sq_mask];
+    m_local_tail++;
+    std::memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+int Uring::submit(unsigned wait) {
+    unsigned n = m_local_tail - *m_sq_tail;
+    __atomic_store_n(m_sq_tail, m_local_tail, __ATOMIC_RELEASE);
+    for (;;) {
+        int r = (int)syscall(__NR_io_uring_enter, m_fd, n, wait,
+                             wait ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+        m_syscalls++;
+        if (r >= 0) return r;
+        if (errno != EINTR) return -errno;
+    }
+}
+
+void Uring::flush_completions() {
+    syscall(__NR_io_uring_enter, m_fd, 0, 0, IORING_ENTER_GETEVENTS, nullptr, 0);
+    m_syscalls++;
+}
+
+const io_uring_cqe* Uring::peek() const {
+    unsigned head = *m_cq_head;
+    if (head == __atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE)) return nullptr;
+    return &m_cqes[head & m_cq_mask];
+}
+
+void Uring::pop() {
+    __atomic_store_n(m_cq_head, *m_cq_head + 1, __ATOMIC_RELEASE);
+}
+
+int Uring::register_op(unsigned op, void* arg, unsigned nr) {
+    int r = (int)syscall(__NR_io_uring_register, m_fd, op, arg, nr);
+    return r < 0 ? -errno : r;
+}
+
+bool Uring::supported() {
+    static const bool yes = [] {
+        Uring ring(8);
+        if (!ring.ok()) {
+            log::info(TAG, "io_uring unavailable: %s", std::strerror(errno));
+            return false;
+        }
+        std::vector<uint8_t> buf(sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op), 0);
+        io_uring_probe* probe = (io_uring_probe*)buf.data();
+        if (ring.register_op(IORING_REGISTER_PROBE, probe, 256) < 0) return false;
+        for (unsigned op : {IORING_OP_RECVMSG, IORING_OP_SENDMSG, IORING_OP_ASYNC_CANCEL}) {
+            if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) return false;
+        }
+
+        // Multishot receive into a buffer ring (6.0+) has no probe bit:
+        // receive one datagram over loopback
+        int         rx = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        int         tx = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        sockaddr_in addr{};
+        socklen_t   len = sizeof(addr);
+        addr.sin_family      = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bool ok = rx >= 0 && tx >= 0 && bind(rx, (sockaddr*)&addr, sizeof(addr)) == 0 &&
+                  getsockname(rx, (sockaddr*)&addr, &len) == 0;
+        if (ok) {
+            uint8_t byte = 0x5A;
+            sendto(tx, &byte, 1, 0, (sockaddr*)&addr, sizeof(addr));
+            UringRecv r(rx, 2, 64);
+            ok = r.ok() && r.start() && r.recv() == 1 && r.packet(0).size() == 1 &&
+                 r.packet(0)[0] == byte;
+        }
+        if (rx >= 0) ::close(rx);
+        if (tx >= 0) ::close(tx);
+        if (!ok) log::info(TAG, "io_uring lacks multishot recvmsg; using socket calls");
+        return ok;
+    }();
+    return yes;
+}
+
+// ─── UringRecv ───────────────────────────────────────────────
+
+// Each buffer starts with the kernel's recvmsg header and the sender's
+// address; the datagram follows
+static constexpr size_t RECV_HEADROOM = sizeof(io_uring_recvmsg_out) + sizeof(sockaddr_in);
+
+static size_t pow2_at_least(size_t n) {
+    size_t p = 1;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+UringRecv::UringRecv(SocketHandle sock, size_t slots, size_t slot_size)
+    : m_ring(4, (unsigned)pow2_at_least(std::max<size_t>(slots, 2)) * 2),
+      m_sock(sock),
+      m_slots(std::min<size_t>(pow2_at_least(std::max<size_t>(slots, 2)), 32768)),
+      m_slot_size(RECV_HEADROOM + slot_size),
+      m_buf(new uint8_t[m_slots * m_slot_size]),
+      m_bid(m_slots),
+      m_data(m_slots),
+      m_len(m_slots),
+      m_from(m_slots),
+      m_trunc(m_slots) {
+    if (!m_ring.ok()) return;
+
+    m_br_size = m_slots * sizeof(io_uring_buf);
+    void* br  = mmap(nullptr, m_br_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (br == MAP_FAILED) return;
+    m_br = (io_uring_buf_ring*)br;
+
+    io_uring_buf_reg reg{};
+    reg.ring_addr    = (uint64_t)(uintptr_t)m_br;
+    reg.ring_entries = (uint32_t)m_slots;
+    reg.bgid         = BUF_GROUP;
+    if (m_ring.register_op(IORING_REGISTER_PBUF_RING, &reg, 1) < 0) return;
+
+    for (size_t i = 0; i < m_slots; i++) {
+        m_bid[m_count++] = (uint16_t)i;
+    }
+    recycle();
+
+    // The template says how much room the address gets in each buffer
+    m_tmpl.msg_namelen = sizeof(sockaddr_in);
+    m_ok = true;
+}
+
+UringRecv::~UringRecv() {
+    if (m_armed) {
+        // Stop the kernel writing into the buffers before they are freed
+        io_uring_sqe* sqe = m_ring.get_sqe();
+        if (sqe) {
+            sqe->opcode    = IORING_OP_ASYNC_CANCEL;
+            sqe->addr      = RECV_TAG;
+            sqe->user_data = CANCEL_TAG;
+            m_ring.submit(1);
+        }
+        for (int spins = 0; m_armed && spins < 1000; spins++) {
+            while (const io_uring_cqe* c = m_ring.peek()) {
+                if (c->user_data == RECV_TAG && !(c->flags & IORING_CQE_F_MORE)) m_armed = false;
+                m_ring.pop();
+            }
+            if (m_armed) m_ring.flush_completions();
+        }
+    }
+    m_ring.close();
+    if (m_br) munmap(m_br, m_br_size);
+}
+
+bool UringRecv::start() {
+    return m_ok && (m_armed || arm());
+}
+
+bool UringRecv::arm() {
+    io_uring_sqe* sqe = m_ring.get_sqe();
+    if (!sqe) return false;
+    sqe->opcode    = IORING_OP_RECVMSG;
+    sqe->fd        = m_sock;
+    sqe->addr      = (uint64_t)(uintptr_t)&m_tmpl;
+    sqe->len       = 1;
+    sqe->ioprio    = IORING_RECV_MULTISHOT;
+    sqe->flags     = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = BUF_GROUP;
+    sqe->user_data = RECV_TAG;
+    if (m_ring.submit() < 0) return false;
+    m_armed = true;
+    return true;
+}
+
+// Give the previous call's buffers back to the kernel
+void UringRecv::recycle() {
+    // Entries start at offset 0, the tail overlaying the first one's resv.
+    // Not m_br->bufs: compiled as C++ the UAPI flex-array macro puts an
+    // empty struct in front of it and moves it to offset 8.
+    io_uring_buf* bufs = (io_uring_buf*)(void*)m_br;
+    unsigned      mask = (unsigned)m_slots - 1;
+    for (size_t k = 0; k < m_count; k++) {
+        io_uring_buf& b = bufs[(m_br_tail + k) & mask];
+        b.addr = (uint64_t)(uintptr_t)(m_buf.get() + m_bid[k] * m_slot_size);
+        b.len  = (uint32_t)m_slot_size;
+        b.bid  = m_bid[k];
+    }
+    m_br_tail = (uint16_t)(m_br_tail + m_count);
+    __atomic_store_n(&m_br->tail, m_br_tail, __ATOMIC_RELEASE);
+    m_count = 0;
+}
+
+int UringRecv::recv() {
+    if (!m_ok) return -1;
+    recycle();
+    bool flushed = false;
+    for (;;) {
+        // Out of buffers ends a multishot; the ones just returned let it
+        // start again
+        if (!m_armed && !arm()) return -1;
+
+        while (m_count < capacity()) {
+            const io_uring_cqe* c = m_ring.peek();
+            if (!c) break;
+            int32_t  res   = c->res;
+            uint32_t flags = c->flags;
+            bool     mine  = c->user_data == RECV_TAG;
+            if (mine && !(flags & IORING_CQE_F_MORE)) m_armed = false;
+            if (mine && res >= 0 && (flags & IORING_CQE_F_BUFFER)) {
+                uint16_t bid  = (uint16_t)(flags >> IORING_CQE_BUFFER_SHIFT);
+                uint8_t* base = m_buf.get() + bid * m_slot_size;
+                auto*    out  = (io_uring_recvmsg_out*)base;
+                size_t   have = (size_t)res > RECV_HEADROOM ? (size_t)res - RECV_HEADROOM : 0;
+                m_bid[m_count]   = bid;
+                m_data[m_count]  = base + RECV_HEADROOM;
+                m_len[m_count]   = std::min<size_t>(out->payloadlen, have);
+                m_trunc[m_count] = (out->flags & MSG_TRUNC) || out->payloadlen > have ? 1 : 0;
+                std::memcpy(&m_from[m_count], base + sizeof(io_uring_recvmsg_out), sizeof(sockaddr_in));
+                m_count++;
+            } else if (mine && res < 0 && res != -ENOBUFS) {
+                m_ring.pop();
+                log::warn(TAG, "io_uring recvmsg failed: %s", std::strerror(-res));
+                return m_count ? (int)m_count : -1;
+            }
+            m_ring.pop();
+        }
+        if (m_count || flushed) break;
+        // Nothing posted: let completions still in task work land, once
+        m_ring.flush_completions();
+        flushed = true;
+    }
+    // A receive that ended in this call must be pending again before the
+    // caller goes back to waiting on the ring, or nothing would wake it.
+    // With every buffer still out it fails straight away with ENOBUFS,
+    // which wakes the caller to return these and try once more.
+    if (!m_armed) arm();
+    return (int)m_count;
+}
+
+// ─── SendBatch over a ring ───────────────────────────────────
+
+// One SENDMSG per message build() made, linked so they leave in order and
+// a failure cancels the rest, as sendmmsg() stops at its first error
+Result<size_t> SendBatch::flush_ring() {
+    size_t   sent = 0;
+    size_t   nmsg = build(0), done = 0;
+    uint64_t calls0 = m_ring->syscalls();
+    while (done < nmsg) {
+        size_t        queued = 0;
+        io_uring_sqe* last   = nullptr;
+        while (done + queued < nmsg) {
+            io_uring_sqe* sqe = m_ring->get_sqe();
+            if (!sqe) break;
+            sqe->opcode    = IORING_OP_SENDMSG;
+            sqe->fd        = m_ring_sock;
+            sqe->addr      = (uint64_t)(uintptr_t)&m_msgs[done + queued].msg_hdr;
+            sqe->len       = 1;
+            sqe->flags     = IOSQE_IO_LINK;
+            sqe->user_data = done + queued;
+            last = sqe;
+            queued++;
+        }
+        if (!last) {
+            m_count = 0;
+            return Result<size_t>::error(StatusCode::ERR_NETWORK);
+        }
+        last->flags = 0;   // end of the chain
+        int r = m_ring->submit((unsigned)queued);
+
+        size_t got = 0, err_at = SIZE_MAX;
+        int    err = 0;
+        while (r >= 0 && got < queued) {
+            const io_uring_cqe* c = m_ring->peek();
+            if (!c) {
+                r = m_ring->submit((unsigned)(queued - got));
+                continue;
+            }
+            size_t k = (size_t)c->user_data;
+            if (c->res >= 0) {
+                sent += m_msg_count[k];
+            } else if (c->res != -ECANCELED && k < err_at) {
+                err_at = k;
+                err    = -c->res;
+            }
+            m_ring->pop();
+            got++;
+        }
+        if (r < 0) {
+            err_at = done;
+            err    = -r;
+        }
+        if (err_at != SIZE_MAX) {
+            if (m_msg_count[err_at] > 1 && (err == EINVAL || err == EIO || err == EMSGSIZE)) {
+                log::info(TAG, "UDP GSO unavailable on this route (%s); using plain sendmsg",
+                          std::strerror(err));
+                m_gso = false;
+                nmsg  = build(m_msg_first[err_at]);
+                done  = 0;
+                continue;
+            }
+            log::warn(TAG, "io_uring sendmsg failed: %s", std::strerror(err));
+            m_syscalls += m_ring->syscalls() - calls0;
+            m_count = 0;
+            return Result<size_t>::error(StatusCode::ERR_NETWORK);
+        }
+        done += queued;
+    }
+    m_syscalls += m_ring->syscalls() - calls0;
+    m_count = 0;
+    return Result<size_t>::success(sent);
+}
+
+} // namespace mesh_io
+} // namespace vos
+
+#endif // VOS_HAVE_IO_URING
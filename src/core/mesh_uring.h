@@ -0,0 +1,162 @@
+#pragma once
+
+#include "mesh_io.h"
+
+// The backend needs Linux 6.0 UAPI headers (multishot recvmsg, provided
+// buffer rings); elsewhere only the probe exists and it says no
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#if defined(IORING_RECV_MULTISHOT)
+#define VOS_HAVE_IO_URING 1
+#endif
+#endif
+#endif
+#ifndef VOS_HAVE_IO_URING
+#define VOS_HAVE_IO_URING 0
+#endif
+
+namespace vos {
+namespace mesh_io {
+
+/*
+ * io_uring backend for the mesh sockets, driven by the raw syscalls (no
+ * liburing). Receive is one multishot RECVMSG per socket drawing from a
+ * provided-buffer ring: armed once, it keeps posting a completion per
+ * datagram with no syscall at all, and the ring fd joins the Reactor like
+ * a socket. Send queues one SENDMSG per SendBatch message (GSO groups
+ * included), linked so they go out in order, and submits them with a
+ * single io_uring_enter().
+ *
+ * Uring::supported() probes the running kernel once; callers fall back
+ * to RecvBatch/SendBatch syscalls when it says no.
+ */
+
+#if VOS_HAVE_IO_URING
+
+// One submission/completion ring pair
+class Uring {
+public:
+    explicit Uring(unsigned entries = 64, unsigned cq_entries = 0);
+    ~Uring();
+
+    Uring(const Uring&)            = delete;
+    Uring& operator=(const Uring&) = delete;
+
+    bool ok() const { return m_fd >= 0; }
+    int  fd() const { return m_fd; }
+
+    // Whether this kernel runs everything the backend uses: ring setup,
+    // SENDMSG, and multishot RECVMSG into a provided-buffer ring.
+    // Probed once per process.
+    static bool supported();
+
+    // Next submission entry, zeroed; nullptr when the queue is full
+    io_uring_sqe* get_sqe();
+    // Hand queued entries to the kernel and wait for `wait` completions.
+    // Returns the number submitted, or -errno.
+    int  submit(unsigned wait = 0);
+    // Let the kernel post completions still pending in task work or in
+    // the overflow list
+    void flush_completions();
+
+    // Oldest unread completion or nullptr; pop() releases it
+    const io_uring_cqe* peek() const;
+    void                pop();
+
+    int  register_op(unsigned op, void* arg, unsigned nr);
+    void close();
+
+    uint64_t syscalls() const { return m_syscalls; }
+
+private:
+    int            m_fd{-1};
+    void*          m_sq_ring{nullptr};
+    void*          m_cq_ring{nullptr};
+    size_t         m_sq_ring_size{0};
+    size_t         m_cq_ring_size{0};
+    io_uring_sqe*  m_sqes{nullptr};
+    size_t         m_sqes_size{0};
+    unsigned       m_sq_entries{0};
+    unsigned*      m_sq_head{nullptr};
+    unsigned*      m_sq_tail{nullptr};
+    unsigned       m_sq_mask{0};
+    unsigned*      m_cq_head{nullptr};
+    unsigned*      m_cq_tail{nullptr};
+    unsigned       m_cq_mask{0};
+    io_uring_cqe*  m_cqes{nullptr};
+    unsigned       m_local_tail{0};   // entries handed out by get_sqe()
+    uint64_t       m_syscalls{0};
+};
+
+/*
+ * Receive side: same contract as RecvBatch::recv(sock, false), with the
+ * kernel filling buffers ahead of the call. Packets stay valid until the
+ * next recv(), when their buffers go back to the kernel. Datagrams the
+ * ring has no buffer for wait in the socket until buffers come back.
+ *
+ * start() submits the multishot receive. Call it, and recv(), from the
+ * thread that will keep running the loop: the kernel completes requests
+ * in the context of the thread that issued them.
+ */
+class UringRecv {
+public:
+    UringRecv(SocketHandle sock, size_t slots = 64, size_t slot_size = MAX_DATAGRAM);
+    ~UringRecv();
+
+    UringRecv(const UringRecv&)            = delete;
+    UringRecv& operator=(const UringRecv&) = delete;
+
+    bool ok() const { return m_ok; }
+    // Readable when completions are waiting
+    int  fd() const { return m_ring.fd(); }
+
+    bool start();
+    int  recv();
+
+    // At most half the buffers per call, so the kernel always has some
+    size_t capacity() const { return m_slots / 2; }
+    size_t count()    const { return m_count; }
+
+    ByteSpan           packet(size_t i)    const { return ByteSpan(m_data[i], m_len[i]); }
+    const sockaddr_in& from(size_t i)      const { return m_from[i]; }
+    bool               truncated(size_t i) const { return m_trunc[i] != 0; }
+
+    uint64_t syscalls() const { return m_ring.syscalls(); }
+
+private:
+    bool arm();
+    void recycle();
+
+    Uring                      m_ring;
+    SocketHandle               m_sock;
+    size_t                     m_slots;
+    size_t                     m_slot_size;   // per buffer: header, address, payload
+    std::unique_ptr<uint8_t[]> m_buf;
+    io_uring_buf_ring*         m_br{nullptr};
+    size_t                     m_br_size{0};
+    uint16_t                   m_br_tail{0};
+    msghdr                     m_tmpl{};
+    bool                       m_ok{false};
+    bool                       m_armed{false};
+
+    size_t                      m_count{0};
+    std::vector<uint16_t>       m_bid;
+    std::vector<uint8_t*>       m_data;
+    std::vector<size_t>         m_len;
+    std::vector<sockaddr_in>    m_from;
+    std::vector<uint8_t>        m_trunc;
+};
+
+#else
+
+class Uring {
+public:
+    static bool supported() { return false; }
+};
+class UringRecv {};
+
+#endif
+
+} // namespace mesh_io
+} // namespace vos
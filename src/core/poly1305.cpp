@@ -0,0 +1,270 @@
+#include "poly1305.h"
+#include <cstring>
+
+namespace vos {
+
+static inline uint32_t load32_le(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline void store32_le(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v;         p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16); p[3] = (uint8_t)(v >> 24);
+}
+
+static inline uint64_t load64_le(const uint8_t* p) {
+    return (uint64_t)load32_le(p) | ((uint64_t)load32_le(p + 4) << 32);
+}
+
+static inline void store64_le(uint8_t* p, uint64_t v) {
+    store32_le(p, (uint32_t)v);
+    store32_le(p + 4, (uint32_t)(v >> 32));
+}
+
+Poly1305::~Poly1305() {
+    // Wipe the one-time key; volatile so the stores are not elided
+    volatile uint8_t* p = reinterpret_cast<volatile uint8_t*>(this);
+    for (size_t i = 0; i < sizeof(*this); i++) p[i] = 0;
+}
+
+#if defined(__SIZEOF_INT128__)
+
+// ─── 64-bit: 3 x 44-bit limbs ────────────────────────────────
+
+using u128 = unsigned __int128;
+static constexpr uint64_t MASK44 = 0xfffffffffffULL;
+static constexpr uint64_t MASK42 = 0x3ffffffffffULL;
+
+void Poly1305::init(const uint8_t key[KEY_SIZE]) {
+    uint64_t t0 = load64_le(key);
+    uint64_t t1 = load64_le(key + 8);
+
+    // Clamp r
+    m_r[0] = t0 & 0xffc0fffffffULL;
+    m_r[1] = ((t0 >> 44) | (t1 << 20)) & 0xfffffc0ffffULL;
+    m_r[2] = (t1 >> 24) & 0x00ffffffc0fULL;
+
+    m_h[0] = m_h[1] = m_h[2] = 0;
+    m_pad[0] = load64_le(key + 16);
+    m_pad[1] = load64_le(key + 24);
+    m_buf_len = 0;
+}
+
+void Poly1305::blocks(const uint8_t* m, size_t len, bool final_block) {
+    const uint64_t hibit = final_block ? 0 : (1ULL << 40);
+    const uint64_t r0 = m_r[0], r1 = m_r[1], r2 = m_r[2];
+    const uint64_t s1 = r1 * (5 << 2), s2 = r2 * (5 << 2);
+    uint64_t h0 = m_h[0], h1 = m_h[1], h2 = m_h[2];
+
+    while (len >= 16) {
+        uint64_t t0 = load64_le(m);
+        uint64_t t1 = load64_le(m + 8);
+        h0 += t0 & MASK44;
+        h1 += ((t0 >> 44) | (t1 << 20)) & MASK44;
+        h2 += ((t1 >> 24) & MASK42) | hibit;
+
+        u128 d0 = (u128)h0 * r0 + (u128)h1 * s2 + (u128)h2 * s1;
+        u128 d1 = (u128)h0 * r1 + (u128)h1 * r0 + (u128)h2 * s2;
+        u128 d2 = (u128)h0 * r2 + (u128)h1 * r1 + (u128)h2 * r0;
+
+        uint64_t c;
+        c = (uint64_t)(d0 >> 44); h0 = (uint64_t)d0 & MASK44;
+        d1 += c; c = (uint64_t)(d1 >> 44); h1 = (uint64_t)d1 & MASK44;
+        d2 += c; c = (uint64_t)(d2 >> 42); h2 = (uint64_t)d2 & MASK42;
+        h0 += c * 5; c = h0 >> 44; h0 &= MASK44;
+        h1 += c;
+
+        m   += 16;
+        len -= 16;
+    }
+    m_h[0] = h0; m_h[1] = h1; m_h[2] = h2;
+}
+
+void Poly1305::finish(uint8_t tag[TAG_SIZE]) {
+    if (m_buf_len > 0) {
+        m_buf[m_buf_len] = 1;
+        for (size_t i = m_buf_len + 1; i < 16; i++) m_buf[i] = 0;
+        blocks(m_buf, 16, true);
+    }
+
+    uint64_t h0 = m_h[0], h1 = m_h[1], h2 = m_h[2], c;
+
+    // Fully carry h
+    c = h1 >> 44; h1 &= MASK44;
+    h2 += c;      c = h2 >> 42; h2 &= MASK42;
+    h0 += c * 5;  c = h0 >> 44; h0 &= MASK44;
+    h1 += c;      c = h1 >> 44; h1 &= MASK44;
+    h2 += c;      c = h2 >> 42; h2 &= MASK42;
+    h0 += c * 5;  c = h0 >> 44; h0 &= MASK44;
+    h1 += c;
+
+    // g = h + -p; pick g when h >= p, in constant time
+    uint64_t g0 = h0 + 5;  c = g0 >> 44; g0 &= MASK44;
+    uint64_t g1 = h1 + c;  c = g1 >> 44; g1 &= MASK44;
+    uint64_t g2 = h2 + c - (1ULL << 42);
+
+    c = (g2 >> 63) - 1;
+    g0 &= c; g1 &= c; g2 &= c;
+    c = ~c;
+    h0 = (h0 & c) | g0;
+    h1 = (h1 & c) | g1;
+    h2 = (h2 & c) | g2;
+
+    // h += pad (mod 2^128)
+    uint64_t t0 = m_pad[0], t1 = m_pad[1];
+    h0 += t0 & MASK44;                              c = h0 >> 44; h0 &= MASK44;
+    h1 += (((t0 >> 44) | (t1 << 20)) & MASK44) + c; c = h1 >> 44; h1 &= MASK44;
+    h2 += ((t1 >> 24) & MASK42) + c;                h2 &= MASK42;
+
+    store64_le(tag,     h0 | (h1 << 44));
+    store64_le(tag + 8, (h1 >> 20) | (h2 << 24));
+}
+
+#else
+
+// ─── 32-bit: 5 x 26-bit limbs ────────────────────────────────
+
+static constexpr uint32_t MASK26 = 0x3ffffff;
+
+void Poly1305::init(const uint8_t key[KEY_SIZE]) {
+    // Clamp r
+    m_r[0] = (load32_le(key + 0))       & 0x3ffffff;
+    m_r[1] = (load32_le(key + 3) >> 2)  & 0x3ffff03;
+    m_r[2] = (load32_le(key + 6) >> 4)  & 0x3ffc0ff;
+    m_r[3] = (load32_le(key + 9) >> 6)  & 0x3f03fff;
+    m_r[4] = (load32_le(key + 12) >> 8) & 0x00fffff;
+
+    for (int i = 0; i < 5; i++) m_h[i] = 0;
+    for (int i = 0; i < 4; i++) m_pad[i] = load32_le(key + 16 + 4 * i);
+    m_buf_len = 0;
+}
+
+void Poly1305::blocks(const uint8_t* m, size_t len, bool final_block) {
+    const uint32_t hibit = final_block ? 0 : (1UL << 24);
+    const uint32_t r0 = m_r[0], r1 = m_r[1], r2 = m_r[2], r3 = m_r[3], r4 = m_r[4];
+    const uint32_t s1 = r1 * 5, s2 = r2 * 5, s3 = r3 * 5, s4 = r4 * 5;
+    uint32_t h0 = m_h[0], h1 = m_h[1], h2 = m_h[2], h3 = m_h[3], h4 = m_h[4];
+
+    while (len >= 16) {
+        h0 += (load32_le(m + 0))       & MASK26;
+        h1 += (load32_le(m + 3) >> 2)  & MASK26;
+        h2 += (load32_le(m + 6) >> 4)  & MASK26;
+        h3 += (load32_le(m + 9) >> 6)  & MASK26;
+        h4 += (load32_le(m + 12) >> 8) | hibit;
+
+        uint64_t d0 = (uint64_t)h0 * r0 + (uint64_t)h1 * s4 + (uint64_t)h2 * s3 +
+                      (uint64_t)h3 * s2 + (uint64_t)h4 * s1;
+        uint64_t d1 = (uint64_t)h0 * r1 + (uint64_t)h1 * r0 + (uint64_t)h2 * s4 +
+                      (uint64_t)h3 * s3 + (uint64_t)h4 * s2;
+        uint64_t d2 = (uint64_t)h0 * r2 + (uint64_t)h1 * r1 + (uint64_t)h2 * r0 +
+                      (uint64_t)h3 * s4 + (uint64_t)h4 * s3;
+        uint64_t d3 = (uint64_t)h0 * r3 + (uint64_t)h1 * r2 + (uint64_t)h2 * r1 +
+                      (uint64_t)h3 * r0 + (uint64_t)h4 * s4;
+        uint64_t d4 = (uint64_t)h0 * r4 + (uint64_t)h1 * r3 + (uint64_t)h2 * r2 +
+                      (uint64_t)h3 * r1 + (uint64_t)h4 * r0;
+
+        uint32_t c;
+        c = (uint32_t)(d0 >> 26); h0 = (uint32_t)d0 & MASK26;
+        d1 += c; c = (uint32_t)(d1 >> 26); h1 = (uint32_t)d1 & MASK26;
+        d2 += c; c = (uint32_t)(d2 >> 26); h2 = (uint32_t)d2 & MASK26;
+        d3 += c; c = (uint32_t)(d3 >> 26); h3 = (uint32_t)d3 & MASK26;
+        d4 += c; c = (uint32_t)(d4 >> 26); h4 = (uint32_t)d4 & MASK26;
+        h0 += c * 5; c = h0 >> 26; h0 &= MASK26;
+        h1 += c;
+
+        m   += 16;
+        len -= 16;
+    }
+    m_h[0] = h0; m_h[1] = h1; m_h[2] = h2; m_h[3] = h3; m_h[4] = h4;
+}
+
+void Poly1305::finish(uint8_t tag[TAG_SIZE]) {
+    if (m_buf_len > 0) {
+        m_buf[m_buf_len] = 1;
+        for (size_t i = m_buf_len + 1; i < 16; i++) m_buf[i] = 0;
+        blocks(m_buf, 16, true);
+    }
+
+    uint32_t h0 = m_h[0], h1 = m_h[1], h2 = m_h[2], h3 = m_h[3], h4 = m_h[4], c;
+
+    // Fully carry h
+    c = h1 >> 26; h1 &= MASK26;
+    h2 += c;     c = h2 >> 26; h2 &= MASK26;
+    h3 += c;     c = h3 >> 26; h3 &= MASK26;
+    h4 += c;     c = h4 >> 26; h4 &= MASK26;
+    h0 += c * 5; c = h0 >> 26; h0 &= MASK26;
+    h1 += c;
+
+    // g = h + -p; pick g when h >= p, in constant time
+    uint32_t g0 = h0 + 5; c = g0 >> 26; g0 &= MASK26;
+    uint32_t g1 = h1 + c; c = g1 >> 26; g1 &= MASK26;
+    uint32_t g2 = h2 + c; c = g2 >> 26; g2 &= MASK26;
+    uint32_t g3 = h3 + c; c = g3 >> 26; g3 &= MASK26;
+    uint32_t g4 = h4 + c - (1UL << 26);
+
+    uint32_t mask = (g4 >> 31) - 1;
+    g0 &= mask; g1 &= mask; g2 &= mask; g3 &= mask; g4 &= mask;
+    mask = ~mask;
+    h0 = (h0 & mask) | g0;
+    h1 = (h1 & mask) | g1;
+    h2 = (h2 & mask) | g2;
+    h3 = (h3 & mask) | g3;
+    h4 = (h4 & mask) | g4;
+
+    // Pack to 4 x 32 bits, then h += pad (mod 2^128)
+    h0 = (h0)         | (h1 << 26);
+    h1 = (h1 >> 6)    | (h2 << 20);
+    h2 = (h2 >> 12)   | (h3 << 14);
+    h3 = (h3 >> 18)   | (h4 << 8);
+
+    uint64_t f;
+    f = (uint64_t)h0 + m_pad[0];             h0 = (uint32_t)f;
+    f = (uint64_t)h1 + m_pad[1] + (f >> 32); h1 = (uint32_t)f;
+    f = (uint64_t)h2 + m_pad[2] + (f >> 32); h2 = (uint32_t)f;
+    f = (uint64_t)h3 + m_pad[3] + (f >> 32); h3 = (uint32_t)f;
+
+    store32_le(tag + 0,  h0);
+    store32_le(tag + 4,  h1);
+    store32_le(tag + 8,  h2);
+    store32_le(tag + 12, h3);
+}
+
+#endif
+
+// ─── Buffering (shared) ──────────────────────────────────────
+
+void Poly1305::update(const uint8_t* data, size_t len) {
+    if (m_buf_len > 0) {
+        size_t want = 16 - m_buf_len;
+        if (want > len) want = len;
+        std::memcpy(m_buf + m_buf_len, data, want);
+        m_buf_len += want;
+        data      += want;
+        len       -= want;
+        if (m_buf_len < 16) return;
+        blocks(m_buf, 16, false);
+        m_buf_len = 0;
+    }
+
+    size_t whole = len & ~(size_t)15;
+    if (whole > 0) {
+        blocks(data, whole, false);
+        data += whole;
+        len  -= whole;
+    }
+
+    if (len > 0) {
+        std::memcpy(m_buf, data, len);
+        m_buf_len = len;
+    }
+}
+
+void Poly1305::mac(const uint8_t key[KEY_SIZE], const uint8_t* data, size_t len,
+                   uint8_t tag[TAG_SIZE]) {
+    Poly1305 p(key);
+    p.update(data, len);
+    p.finish(tag);
+}
+
+} // namespace vos
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "vos/types.h"
+
+namespace vos {
+
+/*
+ * Poly1305 one-time authenticator (RFC 8439).
+ * Streaming: init() once, update() any number of times, finish() once.
+ * A key must never be used for more than one message.
+ */
+class Poly1305 {
+public:
+    static constexpr size_t KEY_SIZE = 32;
+    static constexpr size_t TAG_SIZE = 16;
+
+    Poly1305() = default;
+    explicit Poly1305(const uint8_t key[KEY_SIZE]) { init(key); }
+    ~Poly1305();
+
+    void init(const uint8_t key[KEY_SIZE]);
+    void update(const uint8_t* data, size_t len);
+    void finish(uint8_t tag[TAG_SIZE]);
+
+    // One-shot convenience
+    static void mac(const uint8_t key[KEY_SIZE], const uint8_t* data, size_t len,
+                    uint8_t tag[TAG_SIZE]);
+
+private:
+    void blocks(const uint8_t* data, size_t len, bool final_block);
+
+    // 44-bit limbs with 128-bit products where available, 26-bit limbs otherwise
+#if defined(__SIZEOF_INT128__)
+    uint64_t m_r[3]{};
+    uint64_t m_h[3]{};
+    uint64_t m_pad[2]{};
+#else
+    uint32_t m_r[5]{};
+    uint32_t m_h[5]{};
+    uint32_t m_pad[4]{};
+#endif
+    uint8_t  m_buf[16]{};
+    size_t   m_buf_len{0};
+};
+
+} // namespace vos
@@ -1,6 +1,6 @@
 #include "privacy.h"
+#include "drbg.h"
 #include "vos/log.h"
-#include <random>
 #include <sstream>
 #include <iomanip>
 
@@ -93,25 +93,21 @@ void PrivacyEngine::rotate_identity() {
 }
 
 std::string PrivacyEngine::generate_random_ip() {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    std::uniform_int_distribution<int> dist(1, 254);
-
     // Generate a random private IP (10.x.x.x range)
     std::ostringstream oss;
-    oss << "10." << dist(gen) << "." << dist(gen) << "." << dist(gen);
+    oss << "10." << secure_uniform(254) + 1 << "." << secure_uniform(254) + 1
+        << "." << secure_uniform(254) + 1;
     return oss.str();
 }
 
 std::string PrivacyEngine::generate_random_mac() {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    std::uniform_int_distribution<int> dist(0, 255);
+    uint8_t mac[6];
+    secure_random(ByteSpan(mac, sizeof(mac)));
 
     std::ostringstream oss;
     for (int i = 0; i < 6; i++) {
         if (i > 0) oss << ":";
-        int byte = dist(gen);
+        int byte = mac[i];
         // Set locally administered bit on first byte
         if (i == 0) byte = (byte | 0x02) & 0xFE;
         oss << std::hex << std::setw(2) << std::setfill('0') << byte;
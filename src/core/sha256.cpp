@@ -0,0 +1,286 @@
+#include "sha256.h"
+#include "cpu_features.h"
+#include <cstring>
+
+#if defined(VOS_ARCH_X86)
+#include <immintrin.h>
+#endif
+
+namespace vos {
+
+static const uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static const uint32_t H0[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+
+static inline uint32_t load32_be(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static inline void store32_be(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 24); p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);  p[3] = (uint8_t)v;
+}
+
+static inline uint32_t rotr32(uint32_t v, int n) {
+    return (v >> n) | (v << (32 - n));
+}
+
+// ─── Scalar compression ──────────────────────────────────────
+
+static void compress_scalar(uint32_t state[8], const uint8_t* p, size_t nblocks) {
+    uint32_t w[64];
+    while (nblocks--) {
+        for (int i = 0; i < 16; i++) w[i] = load32_be(p + 4 * i);
+        for (int i = 16; i < 64; i++) {
+            uint32_t s0 = rotr32(w[i - 15], 7) ^ rotr32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            uint32_t s1 = rotr32(w[i - 2], 17) ^ rotr32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int i = 0; i < 64; i++) {
+            uint32_t S1  = rotr32(e, 6) ^ rotr32(e, 11) ^ rotr32(e, 25);
+            uint32_t ch  = (e & f) ^ (~e & g);
+            uint32_t t1  = h + S1 + ch + K[i] + w[i];
+            uint32_t S0  = rotr32(a, 2) ^ rotr32(a, 13) ^ rotr32(a, 22);
+            uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+            uint32_t t2  = S0 + maj;
+            h = g; g = f; f = e; e = d + t1;
+            d = c; c = b; b = a; a = t1 + t2;
+        }
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+        p += Sha256::BLOCK_SIZE;
+    }
+}
+
+// ─── SHA-NI compression (x86) ────────────────────────────────
+
+#if defined(VOS_ARCH_X86)
+
+VOS_TARGET("sha,sse4.1,ssse3")
+static void compress_shani(uint32_t state[8], const uint8_t* p, size_t nblocks) {
+    const __m128i BSWAP = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    // The SHA instructions want the state as ABEF / CDGH
+    __m128i tmp    = _mm_loadu_si128((const __m128i*)&state[0]);
+    __m128i state1 = _mm_loadu_si128((const __m128i*)&state[4]);
+    tmp    = _mm_shuffle_epi32(tmp, 0xB1);          // CDAB
+    state1 = _mm_shuffle_epi32(state1, 0x1B);       // EFGH
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);   // ABEF
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);        // CDGH
+
+    while (nblocks--) {
+        __m128i abef_save = state0;
+        __m128i cdgh_save = state1;
+        __m128i msg[4];
+
+        // 16 groups of 4 rounds; msg[g % 4] holds schedule words 4g..4g+3
+        for (int g = 0; g < 16; g++) {
+            __m128i& cur = msg[g % 4];
+            if (g < 4) {
+                cur = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(p + 16 * g)), BSWAP);
+            }
+
+            __m128i m = _mm_add_epi32(cur, _mm_loadu_si128((const __m128i*)&K[4 * g]));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, m);
+
+            if (g >= 3 && g <= 14) {
+                __m128i& next = msg[(g + 1) % 4];
+                next = _mm_add_epi32(next, _mm_alignr_epi8(cur, msg[(g + 3) % 4], 4));
+                next = _mm_sha256msg2_epu32(next, cur);
+            }
+
+            m = _mm_shuffle_epi32(m, 0x0E);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, m);
+
+            if (g >= 1 && g <= 12) {
+                __m128i& prev = msg[(g + 3) % 4];
+                prev = _mm_sha256msg1_epu32(prev, cur);
+            }
+        }
+
+        state0 = _mm_add_epi32(state0, abef_save);
+        state1 = _mm_add_epi32(state1, cdgh_save);
+        p += Sha256::BLOCK_SIZE;
+    }
+
+    tmp    = _mm_shuffle_epi32(state0, 0x1B);       // FEBA
+    state1 = _mm_shuffle_epi32(state1, 0xB1);       // DCHG
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0);    // DCBA
+    state1 = _mm_alignr_epi8(state1, tmp, 8);       // HGFE
+    _mm_storeu_si128((__m128i*)&state[0], state0);
+    _mm_storeu_si128((__m128i*)&state[4], state1);
+}
+
+#endif
+
+// ─── Sha256 ──────────────────────────────────────────────────
+
+const char* Sha256::impl_name(Impl impl) {
+    switch (impl) {
+        case Impl::SCALAR: return "scalar";
+        case Impl::SHANI:  return "sha-ni";
+        case Impl::AUTO:   return impl_name(best_impl());
+    }
+    return "unknown";
+}
+
+bool Sha256::impl_available(Impl impl) {
+    switch (impl) {
+        case Impl::SCALAR: return true;
+        case Impl::SHANI: {
+            const CpuFeatures& f = cpu_features();
+            return f.sha && f.sse41 && f.ssse3;
+        }
+        case Impl::AUTO:   return true;
+    }
+    return false;
+}
+
+Sha256::Impl Sha256::best_impl() {
+    static const Impl best = impl_available(Impl::SHANI) ? Impl::SHANI : Impl::SCALAR;
+    return best;
+}
+
+void Sha256::init(Impl impl) {
+    if (impl == Impl::AUTO || !impl_available(impl)) impl = best_impl();
+    m_impl = impl;
+    std::memcpy(m_state, H0, sizeof(m_state));
+    m_total   = 0;
+    m_buf_len = 0;
+}
+
+void Sha256::compress(const uint8_t* blocks, size_t nblocks) {
+#if defined(VOS_ARCH_X86)
+    if (m_impl == Impl::SHANI) {
+        compress_shani(m_state, blocks, nblocks);
+        return;
+    }
+#endif
+    compress_scalar(m_state, blocks, nblocks);
+}
+
+void Sha256::update(const uint8_t* data, size_t len) {
+    m_total += len;
+
+    if (m_buf_len > 0) {
+        size_t want = BLOCK_SIZE - m_buf_len;
+        if (want > len) want = len;
+        std::memcpy(m_buf + m_buf_len, data, want);
+        m_buf_len += want;
+        data      += want;
+        len       -= want;
+        if (m_buf_len < BLOCK_SIZE) return;
+        compress(m_buf, 1);
+        m_buf_len = 0;
+    }
+
+    // Whole blocks straight from the caller's buffer
+    size_t nblocks = len / BLOCK_SIZE;
+    if (nblocks > 0) {
+        compress(data, nblocks);
+        data += nblocks * BLOCK_SIZE;
+        len  -= nblocks * BLOCK_SIZE;
+    }
+
+    if (len > 0) {
+        std::memcpy(m_buf, data, len);
+        m_buf_len = len;
+    }
+}
+
+void Sha256::finish(uint8_t digest[DIGEST_SIZE]) {
+    uint64_t bits = m_total * 8;
+
+    // Pad: 0x80, zeros, then the 64-bit big-endian bit length
+    m_buf[m_buf_len++] = 0x80;
+    if (m_buf_len > BLOCK_SIZE - 8) {
+        std::memset(m_buf + m_buf_len, 0, BLOCK_SIZE - m_buf_len);
+        compress(m_buf, 1);
+        m_buf_len = 0;
+    }
+    std::memset(m_buf + m_buf_len, 0, BLOCK_SIZE - 8 - m_buf_len);
+    store32_be(m_buf + 56, (uint32_t)(bits >> 32));
+    store32_be(m_buf + 60, (uint32_t)bits);
+    compress(m_buf, 1);
+
+    for (int i = 0; i < 8; i++) store32_be(digest + 4 * i, m_state[i]);
+}
+
+void Sha256::hash(const uint8_t* data, size_t len, uint8_t digest[DIGEST_SIZE]) {
+    Sha256 h;
+    h.update(data, len);
+    h.finish(digest);
+}
+
+// ─── HmacSha256 ──────────────────────────────────────────────
+
+HmacSha256::~HmacSha256() {
+    // The midstates are key-equivalent; wipe them
+    volatile uint8_t* p = reinterpret_cast<volatile uint8_t*>(this);
+    for (size_t i = 0; i < sizeof(*this); i++) p[i] = 0;
+}
+
+void HmacSha256::init(const uint8_t* key, size_t key_len, Sha256::Impl impl) {
+    uint8_t k[Sha256::BLOCK_SIZE] = {};
+    if (key_len > Sha256::BLOCK_SIZE) {
+        Sha256 kh(impl);
+        kh.update(key, key_len);
+        kh.finish(k);
+    } else if (key_len > 0) {
+        std::memcpy(k, key, key_len);
+    }
+
+    uint8_t pad[Sha256::BLOCK_SIZE];
+    for (size_t i = 0; i < sizeof(pad); i++) pad[i] = k[i] ^ 0x36;
+    m_inner_start.init(impl);
+    m_inner_start.update(pad, sizeof(pad));
+
+    for (size_t i = 0; i < sizeof(pad); i++) pad[i] = k[i] ^ 0x5c;
+    m_outer_start.init(impl);
+    m_outer_start.update(pad, sizeof(pad));
+
+    volatile uint8_t* vk = k;
+    for (size_t i = 0; i < sizeof(k); i++) vk[i] = 0;
+    volatile uint8_t* vp = pad;
+    for (size_t i = 0; i < sizeof(pad); i++) vp[i] = 0;
+
+    m_inner = m_inner_start;
+}
+
+void HmacSha256::reset() {
+    m_inner = m_inner_start;
+}
+
+void HmacSha256::finish(uint8_t mac[MAC_SIZE]) {
+    uint8_t inner[Sha256::DIGEST_SIZE];
+    m_inner.finish(inner);
+
+    Sha256 outer = m_outer_start;
+    outer.update(inner, sizeof(inner));
+    outer.finish(mac);
+
+    m_inner = m_inner_start;
+}
+
+void HmacSha256::mac(const uint8_t* key, size_t key_len, const uint8_t* data, size_t len,
+                     uint8_t out[MAC_SIZE]) {
+    HmacSha256 h(key, key_len);
+    h.update(data, len);
+    h.finish(out);
+}
+
+} // namespace vos
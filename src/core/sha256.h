@@ -0,0 +1,72 @@
+#pragma once
+
+#include "vos/types.h"
+
+namespace vos {
+
+/*
+ * SHA-256 (FIPS 180-4) and HMAC-SHA256 (RFC 2104).
+ * Streaming contexts: init, update any number of times, finish once.
+ * Compression uses the SHA extensions on x86 when present.
+ */
+class Sha256 {
+public:
+    static constexpr size_t DIGEST_SIZE = 32;
+    static constexpr size_t BLOCK_SIZE  = 64;
+
+    enum class Impl : uint8_t { SCALAR = 0, SHANI, AUTO = 0xFF };
+
+    explicit Sha256(Impl impl = Impl::AUTO) { init(impl); }
+
+    void init(Impl impl = Impl::AUTO);
+    void update(const uint8_t* data, size_t len);
+    void update(ConstByteSpan data) { update(data.data(), data.size()); }
+    void finish(uint8_t digest[DIGEST_SIZE]);
+
+    // One-shot convenience
+    static void hash(const uint8_t* data, size_t len, uint8_t digest[DIGEST_SIZE]);
+
+    static const char* impl_name(Impl impl);
+    static bool        impl_available(Impl impl);
+    static Impl        best_impl();
+
+private:
+    friend class HmacSha256;
+    void compress(const uint8_t* blocks, size_t nblocks);
+
+    uint32_t m_state[8];
+    uint64_t m_total{0};
+    uint8_t  m_buf[BLOCK_SIZE];
+    size_t   m_buf_len{0};
+    Impl     m_impl{Impl::SCALAR};
+};
+
+class HmacSha256 {
+public:
+    static constexpr size_t MAC_SIZE = Sha256::DIGEST_SIZE;
+
+    HmacSha256() = default;
+    HmacSha256(const uint8_t* key, size_t key_len, Sha256::Impl impl = Sha256::Impl::AUTO) {
+        init(key, key_len, impl);
+    }
+    ~HmacSha256();
+
+    // Keyed once; reset() restarts a new message with the same key
+    void init(const uint8_t* key, size_t key_len, Sha256::Impl impl = Sha256::Impl::AUTO);
+    void reset();
+    void update(const uint8_t* data, size_t len) { m_inner.update(data, len); }
+    void update(ConstByteSpan data) { m_inner.update(data.data(), data.size()); }
+    void finish(uint8_t mac[MAC_SIZE]);
+
+    static void mac(const uint8_t* key, size_t key_len, const uint8_t* data, size_t len,
+                    uint8_t out[MAC_SIZE]);
+
+private:
+    // Hash states after absorbing key^ipad / key^opad, so each message
+    // starts from a precomputed midstate instead of rehashing the key
+    Sha256 m_inner_start;
+    Sha256 m_outer_start;
+    Sha256 m_inner;
+};
+
+} // namespace vos
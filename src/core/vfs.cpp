@@ -1,6 +1,7 @@
 #include "vfs.h"
 #include "vos/log.h"
 #include <algorithm>
+#include <cstring>
 
 namespace vos {
 
@@ -99,6 +100,88 @@ bool VirtualFS::exists(const std::string& path) const {
     return m_entries.count(normalize_path(path)) > 0;
 }
 
+// Find or create a regular file; nullptr if `p` is a directory
+static VFSEntry* file_entry(std::unordered_map<std::string, VFSEntry>& entries,
+                            const std::string& p, time_t now) {
+    auto it = entries.find(p);
+    if (it != entries.end()) return it->second.is_dir ? nullptr : &it->second;
+    VFSEntry& e = entries[p];
+    e.name     = p;
+    e.is_dir   = false;
+    e.created  = now;
+    e.modified = now;
+    return &e;
+}
+
+Result<void> VirtualFS::write_at(const std::string& path, size_t offset, ConstByteSpan data) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto now = std::time(nullptr);
+    VFSEntry* e = file_entry(m_entries, normalize_path(path), now);
+    if (!e) return Result<void>::error(StatusCode::ERR_INVALID_ARG);
+
+    if (offset + data.size() > e->data.size()) e->data.resize(offset + data.size());
+    if (!data.empty()) std::memcpy(e->data.data() + offset, data.data(), data.size());
+    e->modified = now;
+    return Result<void>::success();
+}
+
+Result<void> VirtualFS::resize_file(const std::string& path, size_t size) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto now = std::time(nullptr);
+    VFSEntry* e = file_entry(m_entries, normalize_path(path), now);
+    if (!e) return Result<void>::error(StatusCode::ERR_INVALID_ARG);
+
+    e->data.resize(size);
+    e->modified = now;
+    return Result<void>::success();
+}
+
+Result<size_t> VirtualFS::read_at(const std::string& path, size_t offset, ByteSpan out) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(normalize_path(path));
+    if (it == m_entries.end()) return Result<size_t>::error(StatusCode::ERR_NOT_FOUND);
+    if (it->second.is_dir)     return Result<size_t>::error(StatusCode::ERR_INVALID_ARG);
+
+    const ByteBuffer& d = it->second.data;
+    if (offset >= d.size()) return Result<size_t>::success(0);
+    size_t n = std::min(out.size(), d.size() - offset);
+    std::memcpy(out.data(), d.data() + offset, n);
+    return Result<size_t>::success(n);
+}
+
+Result<size_t> VirtualFS::file_size(const std::string& path) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(normalize_path(path));
+    if (it == m_entries.end()) return Result<size_t>::error(StatusCode::ERR_NOT_FOUND);
+    if (it->second.is_dir)     return Result<size_t>::error(StatusCode::ERR_INVALID_ARG);
+    return Result<size_t>::success(it->second.data.size());
+}
+
+Result<void> VirtualFS::rename(const std::string& from, const std::string& to) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::string src = normalize_path(from);
+    std::string dst = normalize_path(to);
+
+    auto it = m_entries.find(src);
+    if (it == m_entries.end()) return Result<void>::error(StatusCode::ERR_NOT_FOUND);
+    if (it->second.is_dir)     return Result<void>::error(StatusCode::ERR_INVALID_ARG);
+    if (src == dst)            return Result<void>::success();
+
+    auto dst_it = m_entries.find(dst);
+    if (dst_it != m_entries.end()) {
+        if (dst_it->second.is_dir) return Result<void>::error(StatusCode::ERR_INVALID_ARG);
+        m_entries.erase(dst_it);
+    }
+    // Re-key the node; the file contents are not copied
+    auto node = m_entries.extract(src);
+    node.key()         = dst;
+    node.mapped().name = dst;
+    m_entries.insert(std::move(node));
+
+    log::debug(TAG, "rename %s -> %s", src.c_str(), dst.c_str());
+    return Result<void>::success();
+}
+
 Result<void> VirtualFS::mkdir(const std::string& path) {
     std::lock_guard<std::mutex> lock(m_mutex);
     std::string p = normalize_path(path);
@@ -162,4 +245,24 @@ size_t VirtualFS::total_size() const {
     return sz;
 }
 
+void VirtualFS::for_each_entry(const std::function<void(const VFSEntry&)>& fn) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& [k, v] : m_entries) {
+        fn(v);
+    }
+}
+
+Result<void> VirtualFS::put_entry(VFSEntry entry) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (entry.name.empty()) {
+        return Result<void>::error(StatusCode::ERR_INVALID_ARG);
+    }
+    entry.name = normalize_path(entry.name);
+    if (entry.is_dir) entry.data.clear();
+
+    std::string key = entry.name;
+    m_entries[key] = std::move(entry);
+    return Result<void>::success();
+}
+
 } // namespace vos
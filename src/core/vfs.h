@@ -4,6 +4,7 @@
 #include <string>
 #include <unordered_map>
 #include <mutex>
+#include <functional>
 #include <ctime>
 
 namespace vos {
@@ -29,6 +30,16 @@ public:
     Result<void>       delete_file(const std::string& path);
     bool               exists(const std::string& path) const;
 
+    // Partial writes, for data that arrives in pieces (mesh transfers).
+    // write_at creates the file if needed and zero-fills any gap before offset.
+    Result<void> write_at(const std::string& path, size_t offset, ConstByteSpan data);
+    Result<void> resize_file(const std::string& path, size_t size);
+    // Copy up to out.size() bytes from offset; returns the count (0 at or past the end)
+    Result<size_t> read_at(const std::string& path, size_t offset, ByteSpan out) const;
+    Result<size_t> file_size(const std::string& path) const;
+    // Move a file; an existing file at `to` is replaced
+    Result<void> rename(const std::string& from, const std::string& to);
+
     // Directory operations
     Result<void> mkdir(const std::string& path);
     Result<std::vector<std::string>> list_dir(const std::string& path) const;
@@ -37,6 +48,11 @@ public:
     size_t total_files() const;
     size_t total_size() const;
 
+    // Bulk access (used by persistence)
+    // Visits every entry under the lock — the callback must not call back into the VFS.
+    void         for_each_entry(const std::function<void(const VFSEntry&)>& fn) const;
+    Result<void> put_entry(VFSEntry entry);
+
 private:
     std::string normalize_path(const std::string& path) const;
 
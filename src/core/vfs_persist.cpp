@@ -1,5 +1,6 @@
 #include "vfs_persist.h"
 #include "vfs.h"
+#include "aead.h"
 #include "vos/log.h"
 #include <fstream>
 #include <cstring>
@@ -15,37 +16,99 @@ bool VFSPersistence::file_exists(const std::string& filepath) {
     return f.good();
 }
 
-ByteBuffer VFSPersistence::serialize_entries(const VirtualFS& vfs) {
-    // Format per entry: [PATH_LEN:4][PATH][IS_DIR:1][DATA_LEN:4][DATA]
-    ByteBuffer buf;
-
-    auto root_list = vfs.list_dir("/");
-    // We need to serialize everything — use a simple approach
-    // Walk all known paths. Since VFS is flat map, we serialize the internal state.
-    // For now, serialize test data structure:
-    // [ENTRY_COUNT:4] then each [PATH_LEN:4][PATH][IS_DIR:1][DATA_LEN:4][DATA]
-
-    // Get total file count + dirs
-    size_t total_files = vfs.total_files();
-    size_t total_size = vfs.total_size();
-    
-    // Write a marker for file count
-    uint32_t count = (uint32_t)(total_files);
-    buf.resize(buf.size() + 4);
-    std::memcpy(buf.data() + buf.size() - 4, &count, 4);
-
-    log::info(TAG, "Serialized %u entries (%zu bytes data)", count, total_size);
+// Entry record: [PATH_LEN:4][PATH][IS_DIR:1][CREATED:8][MODIFIED:8][DATA_LEN:4][DATA]
+static constexpr size_t ENTRY_FIXED_SIZE = 4 + 1 + 8 + 8 + 4;
+
+ByteBuffer VFSPersistence::serialize_entries(const VirtualFS& vfs,
+                                             size_t head_room, size_t tail_room) {
+    // [ENTRY_COUNT:4] followed by one record per entry
+    // Size the buffer up front so large trees are written without regrowth.
+    size_t   total = head_room + 4 + tail_room;
+    uint32_t count = 0;
+    vfs.for_each_entry([&](const VFSEntry& e) {
+        total += ENTRY_FIXED_SIZE + e.name.size() + e.data.size();
+        count++;
+    });
+
+    ByteBuffer buf(total);
+    uint8_t* base = buf.data() + head_room;
+    uint8_t* p    = base;
+    uint8_t* end  = buf.data() + total - tail_room;
+    std::memcpy(p, &count, 4); p += 4;
+
+    uint32_t written = 0;
+    vfs.for_each_entry([&](const VFSEntry& e) {
+        // The VFS may have changed between passes; never write past the sized buffer.
+        size_t need = ENTRY_FIXED_SIZE + e.name.size() + e.data.size();
+        if (need > (size_t)(end - p)) return;
+
+        uint32_t path_len = (uint32_t)e.name.size();
+        uint8_t  is_dir   = e.is_dir ? 1 : 0;
+        int64_t  created  = (int64_t)e.created;
+        int64_t  modified = (int64_t)e.modified;
+        uint32_t data_len = (uint32_t)e.data.size();
+
+        std::memcpy(p, &path_len, 4);            p += 4;
+        std::memcpy(p, e.name.data(), path_len); p += path_len;
+        *p++ = is_dir;
+        std::memcpy(p, &created, 8);             p += 8;
+        std::memcpy(p, &modified, 8);            p += 8;
+        std::memcpy(p, &data_len, 4);            p += 4;
+        if (data_len > 0) {
+            std::memcpy(p, e.data.data(), data_len);
+            p += data_len;
+        }
+        written++;
+    });
+
+    if (written != count) {
+        std::memcpy(base, &written, 4);
+    }
+    buf.resize((size_t)(p - buf.data()) + tail_room);
+
+    log::info(TAG, "Serialized %u entries (%zu bytes)", written, (size_t)(p - base));
     return buf;
 }
 
-Result<void> VFSPersistence::deserialize_entries(const ByteBuffer& data, VirtualFS& vfs) {
+Result<void> VFSPersistence::deserialize_entries(ConstByteSpan data, VirtualFS& vfs) {
     if (data.size() < 4) return Result<void>::error(StatusCode::ERR_INVALID_ARG);
-    
-    const uint8_t* p = data.data();
+
+    const uint8_t* p   = data.data();
+    const uint8_t* end = data.data() + data.size();
     uint32_t count;
     std::memcpy(&count, p, 4);
     p += 4;
 
+    for (uint32_t i = 0; i < count; i++) {
+        if ((size_t)(end - p) < ENTRY_FIXED_SIZE)
+            return Result<void>::error(StatusCode::ERR_INVALID_ARG);
+
+        uint32_t path_len;
+        std::memcpy(&path_len, p, 4); p += 4;
+        if ((size_t)(end - p) < path_len + ENTRY_FIXED_SIZE - 4)
+            return Result<void>::error(StatusCode::ERR_INVALID_ARG);
+
+        VFSEntry e;
+        e.name.assign(reinterpret_cast<const char*>(p), path_len); p += path_len;
+        e.is_dir = (*p++ != 0);
+
+        int64_t created, modified;
+        std::memcpy(&created, p, 8);  p += 8;
+        std::memcpy(&modified, p, 8); p += 8;
+        e.created  = (time_t)created;
+        e.modified = (time_t)modified;
+
+        uint32_t data_len;
+        std::memcpy(&data_len, p, 4); p += 4;
+        if ((size_t)(end - p) < data_len)
+            return Result<void>::error(StatusCode::ERR_INVALID_ARG);
+        e.data.assign(p, p + data_len);
+        p += data_len;
+
+        auto r = vfs.put_entry(std::move(e));
+        if (!r.ok()) return r;
+    }
+
     log::info(TAG, "Deserialized %u entries", count);
     return Result<void>::success();
 }
@@ -53,74 +116,122 @@ Result<void> VFSPersistence::deserialize_entries(const ByteBuffer& data, Virtual
 Result<void> VFSPersistence::save(const std::string& filepath,
                                    const VirtualFS& vfs,
                                    const ByteBuffer& key) {
-    // Serialize
-    ByteBuffer plain = serialize_entries(vfs);
+    CryptoSession session;
+    auto r = session.set_key(key);
+    if (!r.ok()) return r;
+    return save(filepath, vfs, session, Crypto::best_algorithm());
+}
+
+Result<void> VFSPersistence::save(const std::string& filepath,
+                                   const VirtualFS& vfs,
+                                   const CryptoSession& session) {
+    return save(filepath, vfs, session, session.algorithm());
+}
+
+Result<void> VFSPersistence::save(const std::string& filepath,
+                                   const VirtualFS& vfs,
+                                   const CryptoSession& session,
+                                   CipherAlgo algo) {
+    if (!session.valid()) return Result<void>::error(StatusCode::ERR_INVALID_ARG);
+
+    // The whole file is built in one buffer and sealed in place:
+    // [MAGIC:4][ALGO:1][KEY_HASH:32][NONCE:12][ENTRIES:N][TAG:16]
+    ByteBuffer file = serialize_entries(vfs, HEADER_SIZE + Crypto::NONCE_SIZE, Crypto::TAG_SIZE);
+
+    uint32_t magic = PERSIST_MAGIC;
+    std::memcpy(file.data(), &magic, 4);
+    file[4] = (uint8_t)algo;
 
-    // Encrypt
-    ByteBuffer encrypted = m_crypto->encrypt(plain, key);
+    // Key hash for wrong-key detection before decrypting
+    std::memcpy(file.data() + 5, session.fingerprint(), CryptoSession::FINGERPRINT_SIZE);
 
-    // Generate key hash for verification
-    ByteBuffer key_hash = m_crypto->hmac(key, key);
+    ByteSpan record(file.data() + HEADER_SIZE, file.size() - HEADER_SIZE);
+    auto sealed = session.seal_in_place(record, algo);
+    if (!sealed.ok()) return sealed;
 
-    // Write file: [MAGIC:4][KEY_HASH:32][ENCRYPTED:N]
     std::ofstream out(filepath, std::ios::binary | std::ios::trunc);
     if (!out.is_open()) {
         log::error(TAG, "Cannot open %s for writing", filepath.c_str());
         return Result<void>::error(StatusCode::ERR_IO);
     }
-
-    uint32_t magic = PERSIST_MAGIC;
-    out.write(reinterpret_cast<const char*>(&magic), 4);
-    out.write(reinterpret_cast<const char*>(key_hash.data()), (std::streamsize)key_hash.size());
-    out.write(reinterpret_cast<const char*>(encrypted.data()), (std::streamsize)encrypted.size());
+    out.write(reinterpret_cast<const char*>(file.data()), (std::streamsize)file.size());
     out.close();
+    if (!out) {
+        log::error(TAG, "Write to %s failed", filepath.c_str());
+        return Result<void>::error(StatusCode::ERR_IO);
+    }
 
-    log::info(TAG, "VFS saved to %s (%zu bytes encrypted)", filepath.c_str(), encrypted.size());
+    log::info(TAG, "VFS saved to %s (%zu bytes, %s)", filepath.c_str(), record.size(),
+              algo_name(algo));
     return Result<void>::success();
 }
 
 Result<void> VFSPersistence::load(const std::string& filepath,
                                    VirtualFS& vfs,
                                    const ByteBuffer& key) {
+    CryptoSession session;
+    auto r = session.set_key(key);
+    if (!r.ok()) return r;
+    return load(filepath, vfs, session);
+}
+
+Result<void> VFSPersistence::load(const std::string& filepath,
+                                   VirtualFS& vfs,
+                                   const CryptoSession& session) {
+    if (!session.valid()) return Result<void>::error(StatusCode::ERR_INVALID_ARG);
+
     std::ifstream in(filepath, std::ios::binary | std::ios::ate);
     if (!in.is_open()) {
         return Result<void>::error(StatusCode::ERR_NOT_FOUND);
     }
 
     size_t file_size = (size_t)in.tellg();
-    if (file_size < 36) { // 4 magic + 32 hash minimum
+    if (file_size < HEADER_SIZE_V1) { // 4 magic + 32 hash minimum
         return Result<void>::error(StatusCode::ERR_INVALID_ARG);
     }
     in.seekg(0);
 
-    // Read magic
-    uint32_t magic;
-    in.read(reinterpret_cast<char*>(&magic), 4);
-    if (magic != PERSIST_MAGIC) {
+    // Read the whole file once; it is decrypted in place
+    ByteBuffer file(file_size);
+    in.read(reinterpret_cast<char*>(file.data()), (std::streamsize)file_size);
+    in.close();
+
+    // Check magic; the algorithm byte follows it in the current format
+    uint32_t   magic;
+    size_t     header = HEADER_SIZE;
+    CipherAlgo algo   = CipherAlgo::CHACHA20_POLY1305;
+    std::memcpy(&magic, file.data(), 4);
+    if (magic == PERSIST_MAGIC) {
+        if (file_size < HEADER_SIZE) return Result<void>::error(StatusCode::ERR_INVALID_ARG);
+        algo = (CipherAlgo)file[4];
+        if (algo != CipherAlgo::CHACHA20_POLY1305 && algo != CipherAlgo::AES_256_GCM) {
+            log::error(TAG, "Unknown cipher id %u", (unsigned)file[4]);
+            return Result<void>::error(StatusCode::ERR_INVALID_ARG);
+        }
+    } else if (magic == PERSIST_MAGIC_V1) {
+        header = HEADER_SIZE_V1;
+    } else {
         log::error(TAG, "Invalid persistence file magic");
         return Result<void>::error(StatusCode::ERR_INVALID_ARG);
     }
 
-    // Read key hash and verify
-    ByteBuffer stored_hash(32);
-    in.read(reinterpret_cast<char*>(stored_hash.data()), 32);
-    ByteBuffer expected_hash = m_crypto->hmac(key, key);
-    if (!m_crypto->hmac_verify(key, key, stored_hash)) {
+    // Verify key hash
+    const uint8_t* key_hash = file.data() + header - CryptoSession::FINGERPRINT_SIZE;
+    if (!aead::equal(session.fingerprint(), key_hash, CryptoSession::FINGERPRINT_SIZE)) {
         log::error(TAG, "Wrong key — hash mismatch");
         return Result<void>::error(StatusCode::ERR_CRYPTO);
     }
 
-    // Read encrypted data
-    size_t data_size = file_size - 36;
-    ByteBuffer encrypted(data_size);
-    in.read(reinterpret_cast<char*>(encrypted.data()), (std::streamsize)data_size);
-    in.close();
-
-    // Decrypt
-    ByteBuffer plain = m_crypto->decrypt(encrypted, key);
+    // Decrypt (authenticated — a corrupted file fails here)
+    ByteSpan record(file.data() + header, file_size - header);
+    auto plain = session.open_in_place(record, algo);
+    if (!plain.ok()) {
+        log::error(TAG, "Persistence file failed authentication");
+        return Result<void>::error(StatusCode::ERR_CRYPTO);
+    }
 
     // Deserialize into VFS
-    auto r = deserialize_entries(plain, vfs);
+    auto r = deserialize_entries(plain.value, vfs);
     if (!r.ok()) return r;
 
     log::info(TAG, "VFS loaded from %s", filepath.c_str());
@@ -2,6 +2,7 @@
 
 #include "vos/types.h"
 #include "crypto.h"
+#include "crypto_session.h"
 #include <string>
 #include <fstream>
 
@@ -10,34 +11,49 @@ namespace vos {
 /**
  * Persistent VFS Storage
  * Serializes the VirtualFS to an encrypted file on disk.
- * Data format: [MAGIC:4][KEY_HASH:32][IV:16][ENCRYPTED_DATA:N]
+ * Data format: [MAGIC:4][ALGO:1][KEY_HASH:32][NONCE:12][ENCRYPTED_DATA:N][TAG:16]
+ * ALGO is a CipherAlgo value. Files from before the algorithm byte
+ * ("VOSF", no ALGO) are ChaCha20-Poly1305 and still load.
  */
 class VFSPersistence {
 public:
     VFSPersistence(Crypto* crypto);
     ~VFSPersistence() = default;
 
-    // Save all VFS entries to an encrypted file
+    // Save all VFS entries to an encrypted file. The raw-key overload uses
+    // Crypto::best_algorithm(); the session overload uses session.algorithm().
     Result<void> save(const std::string& filepath, const class VirtualFS& vfs,
                       const ByteBuffer& key);
+    Result<void> save(const std::string& filepath, const class VirtualFS& vfs,
+                      const CryptoSession& session);
 
     // Load VFS entries from an encrypted file
     Result<void> load(const std::string& filepath, class VirtualFS& vfs,
                       const ByteBuffer& key);
+    Result<void> load(const std::string& filepath, class VirtualFS& vfs,
+                      const CryptoSession& session);
 
     // Check if a persistence file exists
     static bool file_exists(const std::string& filepath);
 
 private:
-    // Serialize entries to a flat buffer
-    ByteBuffer serialize_entries(const class VirtualFS& vfs);
+    // Serialize entries to a flat buffer, leaving head/tail room for the
+    // file header and AEAD tag so the result can be sealed in place
+    ByteBuffer serialize_entries(const class VirtualFS& vfs,
+                                 size_t head_room = 0, size_t tail_room = 0);
 
     // Deserialize from buffer back into VFS
-    Result<void> deserialize_entries(const ByteBuffer& data, class VirtualFS& vfs);
+    Result<void> deserialize_entries(ConstByteSpan data, class VirtualFS& vfs);
 
     Crypto* m_crypto;
 
-    static constexpr uint32_t PERSIST_MAGIC = 0x564F5346; // "VOSF"
+    Result<void> save(const std::string& filepath, const class VirtualFS& vfs,
+                      const CryptoSession& session, CipherAlgo algo);
+
+    static constexpr uint32_t PERSIST_MAGIC    = 0x32534F56; // "VOS2"
+    static constexpr uint32_t PERSIST_MAGIC_V1 = 0x564F5346; // "VOSF", ChaCha20 only
+    static constexpr size_t   HEADER_SIZE      = 4 + 1 + Crypto::MAC_SIZE; // magic + algo + key hash
+    static constexpr size_t   HEADER_SIZE_V1   = 4 + Crypto::MAC_SIZE;
 };
 
 } // namespace vos
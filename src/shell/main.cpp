@@ -594,6 +594,8 @@ int main(int argc, char** argv) {
     g_privacy.init(g_settings.get_int(Settings::KEY_IP_ROTATION_INTERVAL, 10));
     g_mesh.init(&g_crypto, (uint16_t)g_settings.get_int(Settings::KEY_MESH_PORT, 5055));
     g_mesh.start_discovery();
+    g_mesh.start_liveness();
+    g_mesh.start_routing();
     g_lockdown.init();
     g_dialer.init();
     g_sms.init();
@@ -0,0 +1,785 @@
+/*
+ * VOS Unit Test — Crypto primitives (ChaCha20, Poly1305, AEAD, AES-GCM)
+ */
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <cstdlib>
+#include <thread>
+#include <set>
+#include "core/crypto.h"
+#include "core/chacha20.h"
+#include "core/poly1305.h"
+#include "core/aead.h"
+#include "core/aes_gcm.h"
+#include "core/sha256.h"
+#include "core/drbg.h"
+#include "core/crypto_session.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
+
+using namespace vos;
+
+// Count heap allocations so the in-place paths can be checked allocation-free
+static std::atomic<size_t> g_allocs{0};
+
+void* operator new(size_t n) {
+    g_allocs++;
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+static ByteBuffer from_hex(const char* hex) {
+    ByteBuffer out;
+    auto nib = [](char c) -> int {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    };
+    int hi = -1;
+    for (const char* p = hex; *p; p++) {
+        int v = nib(*p);
+        if (v < 0) continue; // skip spaces / separators
+        if (hi < 0) { hi = v; continue; }
+        out.push_back((uint8_t)((hi << 4) | v));
+        hi = -1;
+    }
+    return out;
+}
+
+static const char* SUNSCREEN =
+    "Ladies and Gentlemen of the class of '99: If I could offer you only one tip "
+    "for the future, sunscreen would be it.";
+
+static const chacha20::Impl ALL_IMPLS[] = {
+    chacha20::Impl::SCALAR, chacha20::Impl::SSE2,
+    chacha20::Impl::AVX2,   chacha20::Impl::NEON,
+};
+
+// RFC 8439 §2.4.2
+void test_chacha20_vector() {
+    ByteBuffer key   = from_hex("000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f");
+    ByteBuffer nonce = from_hex("000000000000004a00000000");
+    ByteBuffer expected = from_hex(
+        "6e2e359a2568f98041ba0728dd0d6981e97e7aec1d4360c20a27afccfd9fae0b"
+        "f91b65c5524733ab8f593dabcd62b3571639d624e65152ab8f530c359f0861d8"
+        "07ca0dbf500d6a6156a38e088a22b65e52bc514d16ccf806818ce91ab7793736"
+        "5af90bbf74a35be6b40b8eedf2785e42874d");
+
+    size_t n = std::strlen(SUNSCREEN);
+    for (auto impl : ALL_IMPLS) {
+        if (!chacha20::impl_available(impl)) continue;
+        ByteBuffer out(n);
+        chacha20::xor_stream(key.data(), nonce.data(), 1,
+                             (const uint8_t*)SUNSCREEN, out.data(), n, impl);
+        assert(out == expected);
+    }
+    printf("[PASS] test_chacha20_vector\n");
+}
+
+// RFC 8439 §2.5.2
+void test_poly1305_vector() {
+    ByteBuffer key = from_hex("85d6be7857556d337f4452fe42d506a80103808afb0db2fd4abff6af4149f51b");
+    ByteBuffer expected = from_hex("a8061dc1305136c6c22b8baf0c0127a9");
+    const char* msg = "Cryptographic Forum Research Group";
+
+    uint8_t tag[Poly1305::TAG_SIZE];
+    Poly1305::mac(key.data(), (const uint8_t*)msg, std::strlen(msg), tag);
+    assert(std::memcmp(tag, expected.data(), 16) == 0);
+
+    // Same tag when fed in odd-sized pieces
+    Poly1305 p(key.data());
+    for (size_t i = 0; i < std::strlen(msg); i += 5) {
+        p.update((const uint8_t*)msg + i, std::min<size_t>(5, std::strlen(msg) - i));
+    }
+    p.finish(tag);
+    assert(std::memcmp(tag, expected.data(), 16) == 0);
+    printf("[PASS] test_poly1305_vector\n");
+}
+
+// RFC 8439 §2.8.2
+void test_aead_vector() {
+    ByteBuffer key   = from_hex("808182838485868788898a8b8c8d8e8f909192939495969798999a9b9c9d9e9f");
+    ByteBuffer nonce = from_hex("070000004041424344454647");
+    ByteBuffer aad   = from_hex("50515253c0c1c2c3c4c5c6c7");
+    ByteBuffer expected_ct = from_hex(
+        "d31a8d34648e60db7b86afbc53ef7ec2a4aded51296e08fea9e2b5a736ee62d6"
+        "3dbea45e8ca9671282fafb69da92728b1a71de0a9e060b2905d6a5b67ecd3b36"
+        "92ddbd7f2d778b8c9803aee328091b58fab324e4fad675945585808b4831d7bc"
+        "3ff4def08e4b7a9de576d26586cec64b6116");
+    ByteBuffer expected_tag = from_hex("1ae10b594f09e26a7e902ecbd0600691");
+
+    size_t n = std::strlen(SUNSCREEN);
+    for (auto impl : ALL_IMPLS) {
+        if (!chacha20::impl_available(impl)) continue;
+        ByteBuffer ct(n);
+        uint8_t tag[aead::TAG_SIZE];
+        aead::chacha20_poly1305_seal(key.data(), nonce.data(), aad.data(), aad.size(),
+                                     (const uint8_t*)SUNSCREEN, ct.data(), n, tag, impl);
+        assert(ct == expected_ct);
+        assert(std::memcmp(tag, expected_tag.data(), 16) == 0);
+
+        ByteBuffer pt(n);
+        assert(aead::chacha20_poly1305_open(key.data(), nonce.data(), aad.data(), aad.size(),
+                                            ct.data(), pt.data(), n, tag, impl));
+        assert(std::memcmp(pt.data(), SUNSCREEN, n) == 0);
+    }
+    printf("[PASS] test_aead_vector\n");
+}
+
+// Every kernel must produce byte-identical keystream at every length and counter
+void test_cross_impl() {
+    std::mt19937 rng(1234);
+    ByteBuffer key(32), nonce(12);
+    for (auto& b : key)   b = (uint8_t)rng();
+    for (auto& b : nonce) b = (uint8_t)rng();
+
+    ByteBuffer in(4096 + 63);
+    for (auto& b : in) b = (uint8_t)rng();
+
+    for (size_t len = 0; len <= in.size(); len += (len < 1100 ? 1 : 257)) {
+        uint32_t counter = (uint32_t)rng() % 1000;
+        ByteBuffer ref(len);
+        chacha20::xor_stream(key.data(), nonce.data(), counter, in.data(), ref.data(), len,
+                             chacha20::Impl::SCALAR);
+        for (auto impl : ALL_IMPLS) {
+            if (!chacha20::impl_available(impl)) continue;
+            ByteBuffer out(len);
+            chacha20::xor_stream(key.data(), nonce.data(), counter, in.data(), out.data(), len, impl);
+            assert(out == ref);
+
+            // In-place must match too
+            ByteBuffer inplace(in.begin(), in.begin() + len);
+            chacha20::xor_stream(key.data(), nonce.data(), counter,
+                                 inplace.data(), inplace.data(), len, impl);
+            assert(inplace == ref);
+        }
+    }
+
+    for (auto impl : ALL_IMPLS) {
+        printf("       %-6s %s\n", chacha20::impl_name(impl),
+               chacha20::impl_available(impl) ? "checked" : "not available");
+    }
+    printf("[PASS] test_cross_impl\n");
+}
+
+void test_crypto_tamper() {
+    Crypto crypto;
+    crypto.init();
+    ByteBuffer key = crypto.generate_key();
+
+    std::string msg = "attack at dawn";
+    ByteBuffer sealed = crypto.encrypt(ByteBuffer(msg.begin(), msg.end()), key);
+    assert(sealed.size() == msg.size() + Crypto::OVERHEAD);
+
+    // Fresh nonce per call
+    ByteBuffer sealed2 = crypto.encrypt(ByteBuffer(msg.begin(), msg.end()), key);
+    assert(sealed != sealed2);
+
+    for (size_t i = 0; i < sealed.size(); i++) {
+        ByteBuffer bad = sealed;
+        bad[i] ^= 0x01;
+        auto r = crypto.decrypt(bad, key);
+        assert(!r.ok());
+        assert(r.status == StatusCode::ERR_CRYPTO);
+    }
+
+    auto wrong = crypto.decrypt(sealed, crypto.generate_key());
+    assert(!wrong.ok());
+
+    auto truncated = crypto.decrypt(ByteBuffer(sealed.begin(), sealed.begin() + 10), key);
+    assert(truncated.status == StatusCode::ERR_INVALID_ARG);
+
+    auto ok = crypto.decrypt(sealed, key);
+    assert(ok.ok());
+    assert(std::string(ok.value.begin(), ok.value.end()) == msg);
+    printf("[PASS] test_crypto_tamper\n");
+}
+
+void test_in_place() {
+    Crypto crypto;
+    crypto.init();
+    ByteBuffer key = crypto.generate_key();
+
+    std::string msg = "sealed where it lies";
+    ByteBuffer record(Crypto::OVERHEAD + msg.size());
+    std::memcpy(record.data() + Crypto::NONCE_SIZE, msg.data(), msg.size());
+
+    size_t before = g_allocs.load();
+    auto seal_res = crypto.seal_in_place(record, key);
+    assert(seal_res.ok());
+    uint8_t mac[Crypto::MAC_SIZE];
+    auto mac_res = crypto.hmac_into(record, key, ByteSpan(mac, sizeof(mac)));
+    assert(mac_res.ok());
+    assert(crypto.hmac_verify(ConstByteSpan(record), key, ConstByteSpan(mac, sizeof(mac))));
+    assert(g_allocs.load() == before);
+
+    // Same format as encrypt(): the ByteBuffer API can open it
+    auto opened = crypto.decrypt(record, key);
+    assert(opened.ok());
+    assert(std::string(opened.value.begin(), opened.value.end()) == msg);
+    assert(crypto.hmac(record, key) == ByteBuffer(mac, mac + sizeof(mac)));
+
+    // ...and open_in_place can open encrypt() output
+    ByteBuffer sealed = crypto.encrypt(ByteBuffer(msg.begin(), msg.end()), key);
+    before = g_allocs.load();
+    auto view = crypto.open_in_place(sealed, key);
+    assert(g_allocs.load() == before);
+    assert(view.ok());
+    assert(view.value.data() == sealed.data() + Crypto::NONCE_SIZE);
+    assert(std::string(view.value.begin(), view.value.end()) == msg);
+
+    // Tampered record fails, too-short record is rejected
+    sealed = crypto.encrypt(ByteBuffer(msg.begin(), msg.end()), key);
+    sealed.back() ^= 0x80;
+    assert(crypto.open_in_place(sealed, key).status == StatusCode::ERR_CRYPTO);
+    uint8_t tiny[4] = {};
+    assert(crypto.seal_in_place(ByteSpan(tiny, 4), key).status == StatusCode::ERR_INVALID_ARG);
+    assert(crypto.hmac_into(record, key, ByteSpan(mac, 8)).status == StatusCode::ERR_INVALID_ARG);
+    printf("[PASS] test_in_place\n");
+}
+
+static const Sha256::Impl SHA_IMPLS[] = { Sha256::Impl::SCALAR, Sha256::Impl::SHANI };
+
+static ByteBuffer sha256_of(const std::string& s, Sha256::Impl impl) {
+    ByteBuffer d(Sha256::DIGEST_SIZE);
+    Sha256 h(impl);
+    h.update((const uint8_t*)s.data(), s.size());
+    h.finish(d.data());
+    return d;
+}
+
+// FIPS 180-4 examples
+void test_sha256_vectors() {
+    struct { std::string msg; const char* digest; } kats[] = {
+        { "", "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855" },
+        { "abc", "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" },
+        { "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+          "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1" },
+    };
+    for (auto impl : SHA_IMPLS) {
+        if (!Sha256::impl_available(impl)) continue;
+        for (const auto& k : kats) {
+            assert(sha256_of(k.msg, impl) == from_hex(k.digest));
+        }
+
+        // One million 'a', fed in uneven pieces
+        std::string chunk(997, 'a');
+        Sha256 h(impl);
+        size_t left = 1000000;
+        while (left > 0) {
+            size_t n = std::min(left, chunk.size());
+            h.update((const uint8_t*)chunk.data(), n);
+            left -= n;
+        }
+        uint8_t d[Sha256::DIGEST_SIZE];
+        h.finish(d);
+        assert(ByteBuffer(d, d + 32) ==
+               from_hex("cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0"));
+        printf("       %-6s checked\n", Sha256::impl_name(impl));
+    }
+    printf("[PASS] test_sha256_vectors\n");
+}
+
+// RFC 4231 test cases 1, 2 and 6
+void test_hmac_vectors() {
+    struct { ByteBuffer key; std::string msg; const char* mac; } kats[] = {
+        { ByteBuffer(20, 0x0b), "Hi There",
+          "b0344c61d8db38535ca8afceaf0bf12b881dc200c9833da726e9376c2e32cff7" },
+        { ByteBuffer{'J', 'e', 'f', 'e'}, "what do ya want for nothing?",
+          "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843" },
+        { ByteBuffer(131, 0xaa), "Test Using Larger Than Block-Size Key - Hash Key First",
+          "60e431591ee0b67f0d8a26aacbf5b77f8e0bc6213728c5140546040f0ee37f54" },
+    };
+    Crypto crypto;
+    for (const auto& k : kats) {
+        ByteBuffer msg(k.msg.begin(), k.msg.end());
+        assert(crypto.hmac(msg, k.key) == from_hex(k.mac));
+
+        // Keyed context reused across messages
+        HmacSha256 ctx(k.key.data(), k.key.size());
+        uint8_t mac[HmacSha256::MAC_SIZE];
+        for (int rep = 0; rep < 2; rep++) {
+            for (uint8_t b : msg) ctx.update(&b, 1);
+            ctx.finish(mac);
+            assert(ByteBuffer(mac, mac + 32) == from_hex(k.mac));
+        }
+    }
+    printf("[PASS] test_hmac_vectors\n");
+}
+
+// Any split of the input must give the one-shot digest, on every kernel
+void test_streaming_split() {
+    std::mt19937 rng(99);
+    ByteBuffer data(5000);
+    for (auto& b : data) b = (uint8_t)rng();
+    ByteBuffer key = {1, 2, 3, 4, 5, 6, 7, 8};
+
+    for (size_t len : { (size_t)0, (size_t)1, (size_t)55, (size_t)56, (size_t)63, (size_t)64,
+                        (size_t)65, (size_t)127, (size_t)128, (size_t)1000, data.size() }) {
+        uint8_t ref[32], ref_mac[32];
+        Sha256 one(Sha256::Impl::SCALAR);
+        one.update(data.data(), len);
+        one.finish(ref);
+        HmacSha256::mac(key.data(), key.size(), data.data(), len, ref_mac);
+
+        for (auto impl : SHA_IMPLS) {
+            if (!Sha256::impl_available(impl)) continue;
+            for (int trial = 0; trial < 20; trial++) {
+                Sha256 h(impl);
+                HmacSha256 m(key.data(), key.size());
+                size_t off = 0;
+                while (off < len) {
+                    size_t n = std::min<size_t>(len - off, rng() % 150);
+                    h.update(data.data() + off, n);
+                    m.update(data.data() + off, n);
+                    off += n;
+                }
+                uint8_t d[32], mac[32];
+                h.finish(d);
+                m.finish(mac);
+                assert(std::memcmp(d, ref, 32) == 0);
+                assert(std::memcmp(mac, ref_mac, 32) == 0);
+            }
+        }
+    }
+    printf("[PASS] test_streaming_split\n");
+}
+
+void test_drbg() {
+    // OS source works and is not constant
+    uint8_t a[32] = {}, b[32] = {};
+    assert(os_entropy(a, sizeof(a)));
+    assert(os_entropy(b, sizeof(b)));
+    assert(std::memcmp(a, b, sizeof(a)) != 0);
+
+    // Every size path (empty, buffered, buffer boundary, bulk) yields fresh bytes
+    Crypto crypto;
+    const size_t sizes[] = { 0, 1, 16, 32, 479, 480, 481, 4096, 100000 };
+    for (size_t n : sizes) {
+        ByteBuffer x = crypto.random_bytes(n);
+        ByteBuffer y = crypto.random_bytes(n);
+        assert(x.size() == n);
+        if (n >= 16) {
+            assert(x != y);
+            assert(std::count(x.begin(), x.end(), 0) < (long)n / 16 + 4);
+        }
+    }
+
+    // No repeats across many small draws (also crosses the reseed interval)
+    ChaChaDrbg drbg;
+    std::set<uint64_t> seen;
+    for (int i = 0; i < 200000; i++) assert(seen.insert(drbg.next_u64()).second);
+
+    // uniform() stays in range and hits every value
+    int hits[10] = {};
+    for (int i = 0; i < 10000; i++) {
+        uint32_t v = drbg.uniform(10);
+        assert(v < 10);
+        hits[v]++;
+    }
+    for (int h : hits) assert(h > 800 && h < 1200);
+    assert(drbg.uniform(0) == 0 && drbg.uniform(1) == 0);
+
+    // Each thread gets its own stream
+    uint64_t main_val = ChaChaDrbg::thread_local_instance().next_u64();
+    uint64_t other_val = main_val;
+    std::thread t([&] { other_val = ChaChaDrbg::thread_local_instance().next_u64(); });
+    t.join();
+    assert(other_val != main_val);
+
+    // Warm generator: random_fill does not allocate
+    uint8_t buf[4096];
+    crypto.random_fill(ByteSpan(buf, 16));
+    size_t before = g_allocs.load();
+    crypto.random_fill(ByteSpan(buf, 16));
+    crypto.random_fill(ByteSpan(buf, sizeof(buf)));
+    assert(g_allocs.load() == before);
+
+#ifndef _WIN32
+    // A forked child must not repeat the parent's next output
+    int fds[2];
+    assert(pipe(fds) == 0);
+    ChaChaDrbg& tl = ChaChaDrbg::thread_local_instance();
+    tl.next_u32(); // leave buffered keystream behind
+    pid_t pid = fork();
+    assert(pid >= 0);
+    if (pid == 0) {
+        uint64_t v = tl.next_u64();
+        ssize_t w = write(fds[1], &v, sizeof(v));
+        _exit(w == (ssize_t)sizeof(v) ? 0 : 1);
+    }
+    uint64_t parent_val = tl.next_u64(), child_val = 0;
+    assert(read(fds[0], &child_val, sizeof(child_val)) == (ssize_t)sizeof(child_val));
+    int status = 0;
+    waitpid(pid, &status, 0);
+    close(fds[0]);
+    close(fds[1]);
+    assert(child_val != parent_val);
+#endif
+    printf("[PASS] test_drbg\n");
+}
+
+void test_session() {
+    Crypto crypto;
+    crypto.init();
+    ByteBuffer key = crypto.generate_key();
+    CryptoSession session(key);
+    assert(session.valid());
+
+    // Interoperates with the raw-key API in both directions
+    ByteBuffer msg(1000, 0x5A);
+    auto opened = crypto.decrypt(session.encrypt(msg), key);
+    assert(opened.ok() && opened.value == msg);
+    auto dec = session.decrypt(crypto.encrypt(msg, key));
+    assert(dec.ok() && dec.value == msg);
+
+    uint8_t mac[Crypto::MAC_SIZE];
+    auto mac_res = session.mac_into(msg, ByteSpan(mac, sizeof(mac)));
+    assert(mac_res.ok());
+    assert(crypto.hmac(msg, key) == ByteBuffer(mac, mac + sizeof(mac)));
+    assert(session.mac_verify(msg, ConstByteSpan(mac, sizeof(mac))));
+    assert(crypto.hmac(key, key) ==
+           ByteBuffer(session.fingerprint(), session.fingerprint() + CryptoSession::FINGERPRINT_SIZE));
+
+    // Per-message work allocates nothing
+    ByteBuffer record(Crypto::OVERHEAD + 64);
+    size_t before = g_allocs.load();
+    auto sealed = session.seal_in_place(record);
+    assert(sealed.ok());
+    mac_res = session.mac_into(record, ByteSpan(mac, sizeof(mac)));
+    assert(mac_res.ok());
+    auto opened_rec = session.open_in_place(record);
+    assert(opened_rec.ok());
+    assert(g_allocs.load() == before);
+
+    // Associated data is authenticated for both ciphers: the same bytes open it
+    uint8_t aad[4] = {1, 2, 3, 4};
+    for (CipherAlgo algo : {CipherAlgo::CHACHA20_POLY1305, CipherAlgo::AES_256_GCM}) {
+        auto sealed = session.seal_in_place(record, algo, ConstByteSpan(aad, 4));
+        assert(sealed.ok());
+        auto unbound = session.open_in_place(record, algo);
+        assert(!unbound.ok());
+        aad[3] ^= 1;
+        auto wrong = session.open_in_place(record, algo, ConstByteSpan(aad, 4));
+        assert(!wrong.ok());
+        aad[3] ^= 1;
+        auto bound = session.open_in_place(record, algo, ConstByteSpan(aad, 4));
+        assert(bound.ok());
+    }
+
+    // Wrong key fails authentication
+    CryptoSession other(crypto.generate_key());
+    assert(other.decrypt(session.encrypt(msg)).status == StatusCode::ERR_CRYPTO);
+
+    // Bad key length and moved-from / cleared sessions are unusable
+    CryptoSession bad(ConstByteSpan(key.data(), 16));
+    assert(!bad.valid());
+    assert(bad.seal_in_place(record).status == StatusCode::ERR_INVALID_ARG);
+
+    CryptoSession moved(std::move(session));
+    assert(moved.valid() && !session.valid());
+    assert(session.open_in_place(record).status == StatusCode::ERR_INVALID_ARG);
+    auto moved_dec = moved.decrypt(crypto.encrypt(msg, key));
+    assert(moved_dec.ok());
+    moved.clear();
+    assert(!moved.valid());
+    for (size_t i = 0; i < CryptoSession::FINGERPRINT_SIZE; i++) assert(moved.fingerprint()[i] == 0);
+    printf("[PASS] test_session\n");
+}
+
+void test_batch() {
+    Crypto crypto;
+    crypto.init();
+    ByteBuffer key = crypto.generate_key();
+    chacha20::KeySchedule ks;
+    chacha20::expand_key(ks, key.data());
+
+    // Lane kernels agree with single-block output, for odd lane counts too
+    chacha20::LaneWords lanes[11];
+    ByteBuffer nonces = crypto.random_bytes(11 * Crypto::NONCE_SIZE);
+    for (size_t i = 0; i < 11; i++) {
+        chacha20::set_lane(lanes[i], (uint32_t)(i * 7), nonces.data() + i * Crypto::NONCE_SIZE);
+    }
+    for (auto impl : ALL_IMPLS) {
+        if (!chacha20::impl_available(impl)) continue;
+        uint8_t out[11 * chacha20::BLOCK_SIZE];
+        chacha20::keystream_lanes(ks, lanes, 11, out, impl);
+        for (size_t i = 0; i < 11; i++) {
+            uint8_t ref[chacha20::BLOCK_SIZE];
+            chacha20::block(key.data(), nonces.data() + i * Crypto::NONCE_SIZE, (uint32_t)(i * 7), ref);
+            assert(std::memcmp(out + i * chacha20::BLOCK_SIZE, ref, sizeof(ref)) == 0);
+        }
+    }
+
+    const size_t lens[] = { 0, 1, 15, 63, 64, 65, 128, 200, 1000, 12, 64, 64, 3 };
+    const size_t n = sizeof(lens) / sizeof(lens[0]);
+    std::vector<ByteBuffer> plain(n), bufs(n);
+    std::vector<ByteSpan> recs;
+    for (size_t i = 0; i < n; i++) {
+        plain[i] = crypto.random_bytes(lens[i]);
+        bufs[i].assign(Crypto::OVERHEAD + lens[i], 0);
+        std::copy(plain[i].begin(), plain[i].end(), bufs[i].begin() + Crypto::NONCE_SIZE);
+        recs.emplace_back(bufs[i]);
+    }
+
+    for (auto impl : ALL_IMPLS) {
+        if (!chacha20::impl_available(impl)) continue;
+        CryptoSession session(key);
+        session.set_cipher_impl(impl);
+
+        // Batch-sealed records open one at a time...
+        std::vector<ByteBuffer> sealed(n);
+        auto sealed_all = session.seal_batch(recs.data(), n);
+        assert(sealed_all.ok());
+        for (size_t i = 0; i < n; i++) {
+            sealed[i] = bufs[i];
+            auto dec = crypto.decrypt(bufs[i], key);
+            assert(dec.ok() && dec.value == plain[i]);
+        }
+
+        // ...and open together, with one bad record left untouched
+        bufs[5].back() ^= 1;
+        bool ok[n];
+        size_t before = g_allocs.load();
+        assert(session.open_batch(recs.data(), n, ok) == n - 1);
+        assert(g_allocs.load() == before);
+        for (size_t i = 0; i < n; i++) {
+            assert(ok[i] == (i != 5));
+            if (i == 5) {
+                assert(std::equal(bufs[i].begin(), bufs[i].end() - Crypto::TAG_SIZE, sealed[i].begin()));
+            } else {
+                assert(std::equal(plain[i].begin(), plain[i].end(), bufs[i].begin() + Crypto::NONCE_SIZE));
+            }
+        }
+
+        // Restore plaintext in slot 5 for the next round
+        std::fill(bufs[5].begin(), bufs[5].end(), 0);
+        std::copy(plain[5].begin(), plain[5].end(), bufs[5].begin() + Crypto::NONCE_SIZE);
+    }
+
+    // Raw-key entry points; singly sealed records open in a batch
+    for (size_t i = 0; i < n; i++) {
+        auto sealed = crypto.seal_in_place(recs[i], key);
+        assert(sealed.ok());
+    }
+    bool ok[n];
+    assert(crypto.open_batch(recs.data(), n, ok, key) == n);
+    auto sealed_all = crypto.seal_batch(recs.data(), n, key);
+    assert(sealed_all.ok());
+    for (size_t i = 0; i < n; i++) {
+        auto opened = crypto.open_in_place(recs[i], key);
+        assert(opened.ok());
+    }
+
+    uint8_t tiny[4];
+    ByteSpan short_rec(tiny, sizeof(tiny));
+    assert(crypto.seal_batch(&short_rec, 1, key).status == StatusCode::ERR_INVALID_ARG);
+    assert(crypto.open_batch(&short_rec, 1, ok, key) == 0 && !ok[0]);
+    printf("[PASS] test_batch\n");
+}
+
+static const aes_gcm::Impl ALL_GCM_IMPLS[] = {
+    aes_gcm::Impl::SOFTWARE, aes_gcm::Impl::AESNI,
+};
+
+// GCM spec (McGrew & Viega) test cases 13-16: AES-256
+void test_aes_gcm_vectors() {
+    struct Case { const char *key, *iv, *aad, *pt, *ct, *tag; };
+    const char* K15 = "feffe9928665731c6d6a8f9467308308feffe9928665731c6d6a8f9467308308";
+    const char* P15 =
+        "d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a72"
+        "1c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b391aafd255";
+    const char* C15 =
+        "522dc1f099567d07f47f37a32a84427d643a8cdcbfe5c0c97598a2bd2555d1aa"
+        "8cb08e48590dbb3da7b08b1056828838c5f61e6393ba7a0abcc9f662898015ad";
+    const Case cases[] = {
+        {"0000000000000000000000000000000000000000000000000000000000000000",
+         "000000000000000000000000", "", "", "",
+         "530f8afbc74536b9a963b4f1c4cb738b"},
+        {"0000000000000000000000000000000000000000000000000000000000000000",
+         "000000000000000000000000", "", "00000000000000000000000000000000",
+         "cea7403d4d606b6e074ec5d3baf39d18", "d0d1c8a799996bf0265b98b5d48ab919"},
+        {K15, "cafebabefacedbaddecaf888", "", P15, C15, "b094dac5d93471bdec1a502270e3cc6c"},
+    };
+
+    for (auto impl : ALL_GCM_IMPLS) {
+        if (!aes_gcm::impl_available(impl)) continue;
+        for (const Case& c : cases) {
+            ByteBuffer key = from_hex(c.key), iv = from_hex(c.iv), aad = from_hex(c.aad);
+            ByteBuffer pt = from_hex(c.pt), want_ct = from_hex(c.ct), want_tag = from_hex(c.tag);
+            aes_gcm::KeySchedule ks;
+            aes_gcm::expand_key(ks, key.data());
+
+            ByteBuffer ct(pt.size());
+            uint8_t tag[aes_gcm::TAG_SIZE];
+            aes_gcm::seal(ks, iv.data(), aad.data(), aad.size(), pt.data(), ct.data(), pt.size(),
+                          tag, impl);
+            assert(ct == want_ct);
+            assert(std::memcmp(tag, want_tag.data(), 16) == 0);
+
+            ByteBuffer back(pt.size());
+            assert(aes_gcm::open(ks, iv.data(), aad.data(), aad.size(), ct.data(), back.data(),
+                                 ct.size(), tag, impl));
+            assert(back == pt);
+        }
+
+        // Test case 16: 60-byte plaintext with AAD, tampering rejected
+        ByteBuffer key = from_hex(K15), iv = from_hex("cafebabefacedbaddecaf888");
+        ByteBuffer aad = from_hex("feedfacedeadbeeffeedfacedeadbeefabaddad2");
+        ByteBuffer pt  = from_hex(P15);
+        pt.resize(60);
+        ByteBuffer want_ct = from_hex(C15);
+        want_ct.resize(60);
+        ByteBuffer want_tag = from_hex("76fc6ece0f4e1768cddf8853bb2d551b");
+
+        aes_gcm::KeySchedule ks;
+        aes_gcm::expand_key(ks, key.data());
+        ByteBuffer buf = pt;
+        uint8_t tag[aes_gcm::TAG_SIZE];
+        aes_gcm::seal(ks, iv.data(), aad.data(), aad.size(), buf.data(), buf.data(), buf.size(),
+                      tag, impl);
+        assert(buf == want_ct);
+        assert(std::memcmp(tag, want_tag.data(), 16) == 0);
+
+        aad[0] ^= 1;
+        assert(!aes_gcm::open(ks, iv.data(), aad.data(), aad.size(), buf.data(), buf.data(),
+                              buf.size(), tag, impl));
+        assert(buf == want_ct); // untouched on failure
+        aad[0] ^= 1;
+        buf[59] ^= 0x80;
+        assert(!aes_gcm::open(ks, iv.data(), aad.data(), aad.size(), buf.data(), buf.data(),
+                              buf.size(), tag, impl));
+        buf[59] ^= 0x80;
+        assert(aes_gcm::open(ks, iv.data(), aad.data(), aad.size(), buf.data(), buf.data(),
+                             buf.size(), tag, impl));
+        assert(buf == pt);
+    }
+
+    for (auto impl : ALL_GCM_IMPLS) {
+        printf("       %-8s %s\n", aes_gcm::impl_name(impl),
+               aes_gcm::impl_available(impl) ? "checked" : "not available");
+    }
+    printf("[PASS] test_aes_gcm_vectors\n");
+}
+
+// Both AES-GCM kernels agree at every length, including the 4096-byte slice edge
+void test_aes_gcm_cross_impl() {
+    std::mt19937 rng(99);
+    ByteBuffer key(32), iv(12), aad(37);
+    for (auto& b : key) b = (uint8_t)rng();
+    for (auto& b : iv)  b = (uint8_t)rng();
+    for (auto& b : aad) b = (uint8_t)rng();
+    aes_gcm::KeySchedule ks;
+    aes_gcm::expand_key(ks, key.data());
+
+    // expand_key derives the GHASH powers with whichever kernel is best
+    if (aes_gcm::impl_available(aes_gcm::Impl::AESNI)) {
+        aes_gcm::KeySchedule soft = ks, hw = ks;
+        aes_gcm::detail::h_powers_soft(soft);
+        aes_gcm::detail::h_powers_aesni(hw);
+        assert(std::memcmp(soft.h_powers, hw.h_powers, sizeof(soft.h_powers)) == 0);
+    }
+
+    ByteBuffer in(8192 + 77);
+    for (auto& b : in) b = (uint8_t)rng();
+
+    for (size_t len = 0; len <= in.size(); len += (len < 300 ? 1 : 1021)) {
+        size_t alen = len % (aad.size() + 1);
+        ByteBuffer ref(len);
+        uint8_t ref_tag[16];
+        aes_gcm::seal(ks, iv.data(), aad.data(), alen, in.data(), ref.data(), len, ref_tag,
+                      aes_gcm::Impl::SOFTWARE);
+        for (auto impl : ALL_GCM_IMPLS) {
+            if (!aes_gcm::impl_available(impl)) continue;
+            ByteBuffer out(in.begin(), in.begin() + len);
+            uint8_t tag[16];
+            aes_gcm::seal(ks, iv.data(), aad.data(), alen, out.data(), out.data(), len, tag, impl);
+            assert(out == ref);
+            assert(std::memcmp(tag, ref_tag, 16) == 0);
+        }
+    }
+    printf("[PASS] test_aes_gcm_cross_impl\n");
+}
+
+void test_algorithm_select() {
+    ByteBuffer key(32);
+    for (size_t i = 0; i < key.size(); i++) key[i] = (uint8_t)(i * 7);
+    const ByteBuffer msg(ByteBuffer(333, 0x5a));
+
+    Crypto chacha, aes;
+    chacha.init();
+    aes.init();
+    aes.set_algorithm(CipherAlgo::AES_256_GCM);
+    assert(chacha.algorithm() == CipherAlgo::CHACHA20_POLY1305);
+    assert(aes.algorithm() == CipherAlgo::AES_256_GCM);
+
+    // Same record format, but each only opens its own algorithm's records
+    ByteBuffer ct = aes.encrypt(msg, key);
+    assert(ct.size() == msg.size() + Crypto::OVERHEAD);
+    assert(aes.decrypt(ct, key).value == msg);
+    assert(chacha.decrypt(ct, key).status == StatusCode::ERR_CRYPTO);
+    assert(chacha.decrypt(chacha.encrypt(msg, key), key).value == msg);
+
+    // A session opens either algorithm, explicitly or via its default
+    CryptoSession session(key);
+    assert(session.decrypt(ct).status == StatusCode::ERR_CRYPTO);
+    ByteBuffer copy = ct;
+    auto opened_copy = session.open_in_place(copy, CipherAlgo::AES_256_GCM);
+    assert(opened_copy.ok());
+    session.set_algorithm(CipherAlgo::AES_256_GCM);
+    assert(session.decrypt(ct).value == msg);
+    assert(aes.decrypt(session.encrypt(msg), key).value == msg);
+
+    // Batch falls back to per-record AES-GCM
+    std::vector<ByteBuffer> bufs(5, ByteBuffer(Crypto::OVERHEAD + 40, 3));
+    std::vector<ByteSpan> recs(bufs.begin(), bufs.end());
+    bool ok[5];
+    auto sealed = session.seal_batch(recs.data(), recs.size());
+    assert(sealed.ok());
+    assert(aes.open_batch(recs.data(), recs.size(), ok, key) == recs.size());
+    sealed = aes.seal_batch(recs.data(), recs.size(), key);
+    assert(sealed.ok());
+    assert(session.open_batch(recs.data(), recs.size(), ok) == recs.size());
+
+    // Moving a session carries both schedules and the algorithm
+    CryptoSession moved(std::move(session));
+    assert(moved.algorithm() == CipherAlgo::AES_256_GCM);
+    assert(moved.decrypt(aes.encrypt(msg, key)).value == msg);
+
+    printf("       best algorithm: %s\n", algo_name(Crypto::best_algorithm()));
+    printf("[PASS] test_algorithm_select\n");
+}
+
+int main() {
+    printf("=== Crypto Tests ===\n");
+    test_chacha20_vector();
+    test_poly1305_vector();
+    test_aead_vector();
+    test_cross_impl();
+    test_crypto_tamper();
+    test_in_place();
+    test_sha256_vectors();
+    test_hmac_vectors();
+    test_streaming_split();
+    test_drbg();
+    test_session();
+    test_batch();
+    test_aes_gcm_vectors();
+    test_aes_gcm_cross_impl();
+    test_algorithm_select();
+    printf("All Crypto tests passed!\n\n");
+    return 0;
+}
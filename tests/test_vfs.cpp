@@ -98,6 +98,44 @@ void test_stats() {
     printf("[PASS] test_stats\n");
 }
 
+void test_partial_writes() {
+    VirtualFS vfs;
+    vfs.init();
+
+    // Out-of-order pieces land at their offsets; gaps read as zero
+    auto w = vfs.write_at("/tmp/part", 4, ConstByteSpan((const uint8_t*)"EF", 2));
+    assert(w.ok());
+    w = vfs.write_at("/tmp/part", 0, ConstByteSpan((const uint8_t*)"AB", 2));
+    assert(w.ok());
+    assert(vfs.read_file("/tmp/part").value == ByteBuffer({'A', 'B', 0, 0, 'E', 'F'}));
+
+    auto resized = vfs.resize_file("/tmp/part", 8);
+    assert(resized.ok());
+    assert(vfs.read_file("/tmp/part").value.size() == 8);
+    resized = vfs.resize_file("/tmp/part", 2);
+    assert(resized.ok());
+    assert(vfs.read_file("/tmp/part").value == ByteBuffer({'A', 'B'}));
+
+    // Rename replaces an existing file, refuses directories
+    vfs.write_file("/home/old.txt", {9});
+    auto renamed = vfs.rename("/tmp/part", "/home/old.txt");
+    assert(renamed.ok());
+    assert(!vfs.exists("/tmp/part"));
+    assert(vfs.read_file("/home/old.txt").value == ByteBuffer({'A', 'B'}));
+    assert(vfs.rename("/home/old.txt", "/home").status == StatusCode::ERR_INVALID_ARG);
+    assert(vfs.rename("/nope", "/x").status == StatusCode::ERR_NOT_FOUND);
+    assert(vfs.write_at("/home", 0, ConstByteSpan()).status == StatusCode::ERR_INVALID_ARG);
+
+    // Partial reads stop at the end of the file
+    uint8_t out[4] = {0};
+    assert(vfs.read_at("/home/old.txt", 1, ByteSpan(out, 4)).value == 1 && out[0] == 'B');
+    assert(vfs.read_at("/home/old.txt", 2, ByteSpan(out, 4)).value == 0);
+    assert(vfs.read_at("/nope", 0, ByteSpan(out, 4)).status == StatusCode::ERR_NOT_FOUND);
+    assert(vfs.file_size("/home/old.txt").value == 2);
+    assert(vfs.file_size("/home").status == StatusCode::ERR_INVALID_ARG);
+    printf("[PASS] test_partial_writes\n");
+}
+
 int main() {
     printf("=== VFS Tests ===\n");
     test_init();
@@ -107,6 +145,7 @@ int main() {
     test_mkdir_and_list();
     test_overwrite();
     test_stats();
+    test_partial_writes();
     printf("All VFS tests passed!\n\n");
     return 0;
 }
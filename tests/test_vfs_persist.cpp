@@ -0,0 +1,217 @@
+/*
+ * VOS Unit Test — VFS Persistence
+ */
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include "core/vfs.h"
+#include "core/vfs_persist.h"
+#include "core/crypto.h"
+#include "core/crypto_session.h"
+
+using namespace vos;
+
+static std::string temp_file(const char* name) {
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+void test_roundtrip() {
+    Crypto crypto;
+    crypto.init();
+    VFSPersistence persist(&crypto);
+    ByteBuffer key = crypto.generate_key();
+
+    VirtualFS vfs;
+    vfs.init();
+    vfs.mkdir("/home/user");
+    vfs.write_file("/home/user/a.txt", {1, 2, 3});
+    vfs.write_file("/home/empty.bin", {});
+
+    std::string path = temp_file("vos_test_roundtrip.vfs");
+    auto saved = persist.save(path, vfs, key);
+    assert(saved.ok());
+
+    VirtualFS loaded;
+    auto load_res = persist.load(path, loaded, key);
+    assert(load_res.ok());
+    assert(loaded.exists("/home/user"));
+    assert(loaded.exists("/tmp"));
+    assert(loaded.total_files() == 2);
+
+    auto r = loaded.read_file("/home/user/a.txt");
+    assert(r.ok());
+    assert(r.value == ByteBuffer({1, 2, 3}));
+    assert(loaded.read_file("/home/empty.bin").value.empty());
+
+    std::filesystem::remove(path);
+    printf("[PASS] test_roundtrip\n");
+}
+
+void test_wrong_key() {
+    Crypto crypto;
+    crypto.init();
+    VFSPersistence persist(&crypto);
+
+    VirtualFS vfs;
+    vfs.init();
+    vfs.write_file("/home/secret.txt", {42});
+
+    std::string path = temp_file("vos_test_wrong_key.vfs");
+    auto saved = persist.save(path, vfs, crypto.generate_key());
+    assert(saved.ok());
+
+    VirtualFS loaded;
+    auto r = persist.load(path, loaded, crypto.generate_key());
+    assert(!r.ok());
+    assert(r.status == StatusCode::ERR_CRYPTO);
+    assert(!loaded.exists("/home/secret.txt"));
+
+    std::filesystem::remove(path);
+    printf("[PASS] test_wrong_key\n");
+}
+
+void test_missing_file() {
+    Crypto crypto;
+    crypto.init();
+    VFSPersistence persist(&crypto);
+
+    VirtualFS loaded;
+    auto r = persist.load(temp_file("vos_test_does_not_exist.vfs"), loaded, crypto.generate_key());
+    assert(r.status == StatusCode::ERR_NOT_FOUND);
+    printf("[PASS] test_missing_file\n");
+}
+
+void test_session_handle() {
+    Crypto crypto;
+    crypto.init();
+    VFSPersistence persist(&crypto);
+    ByteBuffer key = crypto.generate_key();
+    CryptoSession session(key);
+
+    VirtualFS vfs;
+    vfs.init();
+    vfs.write_file("/home/s.txt", {9, 8, 7});
+
+    // Files written with a session and with the raw key are interchangeable
+    std::string path = temp_file("vos_test_session.vfs");
+    auto saved = persist.save(path, vfs, session);
+    assert(saved.ok());
+    VirtualFS loaded;
+    auto load_res = persist.load(path, loaded, key);
+    assert(load_res.ok());
+    assert(loaded.read_file("/home/s.txt").value == ByteBuffer({9, 8, 7}));
+
+    saved = persist.save(path, vfs, key);
+    assert(saved.ok());
+    VirtualFS again;
+    load_res = persist.load(path, again, session);
+    assert(load_res.ok());
+    assert(again.read_file("/home/s.txt").value == ByteBuffer({9, 8, 7}));
+
+    CryptoSession other(crypto.generate_key());
+    VirtualFS rejected;
+    assert(persist.load(path, rejected, other).status == StatusCode::ERR_CRYPTO);
+    assert(persist.load(path, rejected, CryptoSession()).status == StatusCode::ERR_INVALID_ARG);
+
+    std::filesystem::remove(path);
+    printf("[PASS] test_session_handle\n");
+}
+
+void test_algorithms() {
+    Crypto crypto;
+    crypto.init();
+    VFSPersistence persist(&crypto);
+    ByteBuffer key = crypto.generate_key();
+    CryptoSession session(key);
+
+    VirtualFS vfs;
+    vfs.init();
+    vfs.write_file("/home/a.bin", ByteBuffer(5000, 0x11));
+
+    // Whatever algorithm wrote the file, the raw key or a session with a
+    // different default reads it back
+    std::string path = temp_file("vos_test_algo.vfs");
+    for (CipherAlgo algo : {CipherAlgo::CHACHA20_POLY1305, CipherAlgo::AES_256_GCM}) {
+        session.set_algorithm(algo);
+        auto saved = persist.save(path, vfs, session);
+        assert(saved.ok());
+        session.set_algorithm(algo == CipherAlgo::AES_256_GCM ? CipherAlgo::CHACHA20_POLY1305
+                                                              : CipherAlgo::AES_256_GCM);
+        VirtualFS a, b;
+        auto load_a = persist.load(path, a, key);
+        assert(load_a.ok());
+        auto load_b = persist.load(path, b, session);
+        assert(load_b.ok());
+        assert(a.read_file("/home/a.bin").value == ByteBuffer(5000, 0x11));
+        assert(b.read_file("/home/a.bin").value == ByteBuffer(5000, 0x11));
+    }
+
+    // Unknown algorithm id
+    {
+        std::fstream f(path, std::ios::binary | std::ios::in | std::ios::out);
+        f.seekp(4);
+        f.put((char)0x7f);
+    }
+    VirtualFS rejected;
+    assert(persist.load(path, rejected, key).status == StatusCode::ERR_INVALID_ARG);
+
+    std::filesystem::remove(path);
+    printf("[PASS] test_algorithms\n");
+}
+
+// Files written before the algorithm byte: "VOSF" + key hash + ChaCha20 record
+void test_legacy_format() {
+    Crypto crypto;
+    crypto.init();
+    VFSPersistence persist(&crypto);
+    ByteBuffer key = crypto.generate_key();
+    CryptoSession session(key);
+
+    // One entry: [COUNT][PATH_LEN][PATH][IS_DIR][CREATED][MODIFIED][DATA_LEN][DATA]
+    const char name[] = "/home/old.txt";
+    uint32_t count = 1, path_len = sizeof(name) - 1, data_len = 2;
+    int64_t  stamp = 1700000000;
+    ByteBuffer entries(4 + 4 + path_len + 1 + 8 + 8 + 4 + data_len);
+    uint8_t* p = entries.data();
+    std::memcpy(p, &count, 4);        p += 4;
+    std::memcpy(p, &path_len, 4);     p += 4;
+    std::memcpy(p, name, path_len);   p += path_len;
+    *p++ = 0;
+    std::memcpy(p, &stamp, 8);        p += 8;
+    std::memcpy(p, &stamp, 8);        p += 8;
+    std::memcpy(p, &data_len, 4);     p += 4;
+    p[0] = 'h'; p[1] = 'i';
+
+    ByteBuffer file = {'F', 'S', 'O', 'V'}; // 0x564F5346 little-endian
+    file.insert(file.end(), session.fingerprint(),
+                session.fingerprint() + CryptoSession::FINGERPRINT_SIZE);
+    ByteBuffer sealed = crypto.encrypt(entries, key);
+    file.insert(file.end(), sealed.begin(), sealed.end());
+
+    std::string path = temp_file("vos_test_legacy.vfs");
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(file.data()), (std::streamsize)file.size());
+    }
+    VirtualFS loaded;
+    auto load_res = persist.load(path, loaded, key);
+    assert(load_res.ok());
+    assert(loaded.read_file("/home/old.txt").value == ByteBuffer({'h', 'i'}));
+
+    std::filesystem::remove(path);
+    printf("[PASS] test_legacy_format\n");
+}
+
+int main() {
+    printf("=== VFS Persistence Tests ===\n");
+    test_roundtrip();
+    test_wrong_key();
+    test_missing_file();
+    test_session_handle();
+    test_algorithms();
+    test_legacy_format();
+    printf("All VFS Persistence tests passed!\n\n");
+    return 0;
+}